@@ -0,0 +1,92 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "llama_tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Short-string tokenization benchmark
+//
+// Measures the fixed per-call cost of llama_tokenizer_tokenize() on inputs
+// under 64 bytes, the shape of high-QPS embedding and classification
+// traffic, for every add_special / parse_special combination.
+
+#define ITERATIONS 200000
+
+static const char* const inputs[] = {
+    "",
+    "a",
+    "Hello",
+    "Hello world",
+    "How do I reset my password?",
+    "search: cheap flights to Lisbon",
+    "The quick brown fox jumps over the lazy dog.",
+    "caf\xC3\xA9 na\xC3\xAFve r\xC3\xA9sum\xC3\xA9",
+    "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87",
+    "user_id=12345&session=abcdef0123456789&lang=en",
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double bench_calls(const llama_tokenizer_t* tokenizer, llama_token* tokens, int32_t n_max_tokens,
+                          bool add_special, bool parse_special) {
+    const size_t n_inputs = sizeof(inputs) / sizeof(inputs[0]);
+    int32_t lengths[sizeof(inputs) / sizeof(inputs[0])];
+    for (size_t i = 0; i < n_inputs; i++) {
+        lengths[i] = (int32_t)strlen(inputs[i]);
+    }
+
+    volatile int32_t sink = 0;
+    double start = now_seconds();
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        size_t i = (size_t)iter % n_inputs;
+        sink += llama_tokenizer_tokenize(tokenizer, inputs[i], lengths[i], tokens, n_max_tokens,
+                                         add_special, parse_special);
+    }
+    double elapsed = now_seconds() - start;
+    (void)sink;
+    return elapsed / ITERATIONS * 1e9;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        return 1;
+    }
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", argv[1]);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+
+    llama_token tokens[256];
+
+    printf("=== Short-String Tokenization Benchmark ===\n");
+    printf("Model: %s\n", argv[1]);
+    printf("Inputs: %zu strings under 64 bytes, %d calls per row\n\n",
+           sizeof(inputs) / sizeof(inputs[0]), ITERATIONS);
+    printf("  %-12s %-14s %-10s %10s\n", "add_special", "parse_special", "mode", "ns/call");
+
+    for (int add = 0; add <= 1; add++) {
+        for (int parse = 0; parse <= 1; parse++) {
+            double fill_ns = bench_calls(tokenizer, tokens, 256, add, parse);
+            double count_ns = bench_calls(tokenizer, NULL, 0, add, parse);
+            printf("  %-12s %-14s %-10s %10.1f\n", add ? "true" : "false", parse ? "true" : "false", "fill", fill_ns);
+            printf("  %-12s %-14s %-10s %10.1f\n", add ? "true" : "false", parse ? "true" : "false", "count", count_ns);
+        }
+    }
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+    return 0;
+}
@@ -0,0 +1,127 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "llama_tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Special-token scanning benchmark
+//
+// Tokenizes prose with control tokens interspersed, with and without
+// parse_special. With the single-pass automaton the parse_special=true
+// cost should stay close to parse_special=false no matter how many added
+// tokens the vocab has; use a vocab with 256+ added tokens (e.g. Llama 3
+// reserved tokens) to see the difference against older builds.
+
+#define TARGET_TEXT_BYTES (1 << 20)
+#define SPECIAL_EVERY_BYTES 256
+#define MIN_ITERATIONS 5
+#define MIN_SECONDS 2.0
+
+static const char* prose =
+    "The quick brown fox jumps over the lazy dog. Tokenizers split text into "
+    "pieces drawn from a fixed vocabulary, and added tokens mark turns, tools "
+    "and images in chat transcripts. ";
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void run(llama_tokenizer_t* tokenizer, const char* label, const char* text, int32_t text_len,
+                llama_token* tokens, int32_t n_max, bool parse_special) {
+    int iterations = 0;
+    int32_t n_tokens = 0;
+    double start = now_seconds();
+    double elapsed = 0.0;
+
+    while (iterations < MIN_ITERATIONS || elapsed < MIN_SECONDS) {
+        n_tokens = llama_tokenizer_tokenize(tokenizer, text, text_len, tokens, n_max, false, parse_special);
+        iterations++;
+        elapsed = now_seconds() - start;
+    }
+
+    double per_call = elapsed / iterations;
+    printf("%-34s %10d tokens %10.2f ms/call %10.2f MB/s\n",
+           label, n_tokens, per_call * 1e3, (double)text_len / per_call / 1e6);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        return 1;
+    }
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", argv[1]);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+
+    // Collect control token texts to sprinkle into the input
+    int32_t n_vocab = llama_tokenizer_vocab_size(tokenizer);
+    int32_t n_control = 0;
+    const char** control_texts = malloc(n_vocab * sizeof(const char*));
+    for (llama_token id = 0; id < n_vocab; id++) {
+        const char* piece = llama_tokenizer_token_get_text(tokenizer, id);
+        if (llama_tokenizer_is_control(tokenizer, id) && piece && piece[0]) {
+            control_texts[n_control++] = piece;
+        }
+    }
+
+    printf("=== Special Token Scanning Benchmark ===\n");
+    printf("Model: %s\n", argv[1]);
+    printf("Vocab size: %d, control tokens: %d\n", n_vocab, n_control);
+    if (n_control < 256) {
+        printf("Note: fewer than 256 control tokens; use a vocab with many added tokens for a representative run\n");
+    }
+
+    // Build the input text
+    size_t capacity = TARGET_TEXT_BYTES + 4096;
+    char* text = malloc(capacity);
+    size_t len = 0;
+    size_t prose_len = strlen(prose);
+    int32_t next_special = 0;
+    while (len < TARGET_TEXT_BYTES) {
+        size_t chunk = 0;
+        while (chunk < SPECIAL_EVERY_BYTES) {
+            memcpy(text + len + chunk, prose, prose_len);
+            chunk += prose_len;
+        }
+        len += chunk;
+        if (n_control > 0) {
+            const char* special = control_texts[next_special++ % n_control];
+            size_t special_len = strlen(special);
+            if (special_len < 1024) {
+                memcpy(text + len, special, special_len);
+                len += special_len;
+            }
+        }
+    }
+
+    int32_t n_max = llama_tokenizer_tokenize(tokenizer, text, (int32_t)len, NULL, 0, false, true);
+    int32_t n_max_plain = llama_tokenizer_tokenize(tokenizer, text, (int32_t)len, NULL, 0, false, false);
+    if (n_max_plain > n_max) {
+        n_max = n_max_plain;
+    }
+    llama_token* tokens = malloc((size_t)n_max * sizeof(llama_token));
+
+    printf("Input: %zu bytes\n\n", len);
+    run(tokenizer, "parse_special=true  (count only)", text, (int32_t)len, NULL, 0, true);
+    run(tokenizer, "parse_special=true  (fill)", text, (int32_t)len, tokens, n_max, true);
+    run(tokenizer, "parse_special=false (count only)", text, (int32_t)len, NULL, 0, false);
+    run(tokenizer, "parse_special=false (fill)", text, (int32_t)len, tokens, n_max, false);
+
+    free(tokens);
+    free(text);
+    free(control_texts);
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+    return 0;
+}
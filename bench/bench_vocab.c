@@ -0,0 +1,106 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "llama_tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Per-vocab tokenization benchmark
+//
+// Pass one model per vocab type (e.g. a Llama 2 / Gemma SPM model, a T5
+// UGM model, a BPE model) to compare tokenize throughput across them on
+// English prose, source code and multilingual text.
+
+#define TARGET_TEXT_BYTES (256 * 1024)
+#define MIN_ITERATIONS 5
+#define MIN_SECONDS 1.0
+
+typedef struct {
+    const char* name;
+    const char* sample;
+} corpus;
+
+static const corpus corpora[] = {
+    { "prose",
+      "The committee reviewed the proposal in detail and, after a lengthy discussion, "
+      "agreed to postpone the final decision until the next quarterly meeting. " },
+    { "code",
+      "static int parse(const char* s, size_t n) {\n    for (size_t i = 0; i < n; ++i) {\n"
+      "        if (s[i] == '\\n') { return (int)i; }\n    }\n    return -1;\n}\n" },
+    { "multilingual",
+      "Caf\xC3\xA9 cr\xC3\xA8me br\xC3\xBBl\xC3\xA9" "e. \xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82, "
+      "\xD0\xBC\xD0\xB8\xD1\x80! \xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87\xE7\xAB\xA0\xE3\x80\x82 "
+      "\xF0\x9F\x98\x80 " },
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static char* repeat_sample(const char* sample, size_t target, size_t* out_len) {
+    size_t sample_len = strlen(sample);
+    size_t copies = (target + sample_len - 1) / sample_len;
+    char* text = malloc(copies * sample_len);
+    for (size_t i = 0; i < copies; i++) {
+        memcpy(text + i * sample_len, sample, sample_len);
+    }
+    *out_len = copies * sample_len;
+    return text;
+}
+
+static void bench_model(const char* model_path) {
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(model_path);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", model_path);
+        return;
+    }
+
+    printf("\nModel: %s (vocab size %d)\n", model_path, llama_tokenizer_vocab_size(tokenizer));
+
+    for (size_t c = 0; c < sizeof(corpora) / sizeof(corpora[0]); c++) {
+        size_t len = 0;
+        char* text = repeat_sample(corpora[c].sample, TARGET_TEXT_BYTES, &len);
+        int32_t n_tokens = llama_tokenizer_tokenize(tokenizer, text, (int32_t)len, NULL, 0, false, false);
+        llama_token* tokens = malloc((size_t)(n_tokens > 0 ? n_tokens : 1) * sizeof(llama_token));
+
+        int iterations = 0;
+        double start = now_seconds();
+        double elapsed = 0.0;
+        while (iterations < MIN_ITERATIONS || elapsed < MIN_SECONDS) {
+            llama_tokenizer_tokenize(tokenizer, text, (int32_t)len, tokens, n_tokens, false, false);
+            iterations++;
+            elapsed = now_seconds() - start;
+        }
+
+        double per_call = elapsed / iterations;
+        printf("  %-14s %9d tokens %9.2f ms/call %9.2f MB/s %12.0f tokens/s\n",
+               corpora[c].name, n_tokens, per_call * 1e3,
+               (double)len / per_call / 1e6, (double)n_tokens / per_call);
+
+        free(tokens);
+        free(text);
+    }
+
+    llama_tokenizer_destroy(tokenizer);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path> [model_path...]\n", argv[0]);
+        return 1;
+    }
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    printf("=== Per-Vocab Tokenization Benchmark ===\n");
+    for (int i = 1; i < argc; i++) {
+        bench_model(argv[i]);
+    }
+
+    llama_tokenizer_free_backend();
+    return 0;
+}
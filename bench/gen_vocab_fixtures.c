@@ -0,0 +1,683 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Synthetic vocab-only GGUF generator
+//
+// Writes vocab-only model files for each vocab type (SPM, BPE, WPM, UGM)
+// at realistic sizes, so benchmarks and the perf regression targets run
+// without downloading a model. Pieces are built from a deterministic
+// syllable generator plus Latin, Greek, Cyrillic, kana, CJK and emoji
+// characters; every multi-character piece is reachable through a chain of
+// shorter pieces (and, for BPE, merges), so the tokenizers do real work.
+// The vocab ends in a block of added special tokens, half control and
+// half user-defined.
+//
+// The files carry the minimal "llama" architecture hyperparameters that
+// llama.cpp needs to load a vocab-only model; they contain no tensors.
+
+#define GGUF_VERSION 3
+#define GGUF_ALIGNMENT 32
+
+// gguf_type values
+enum {
+    GGUF_TYPE_UINT32 = 4,
+    GGUF_TYPE_INT32 = 5,
+    GGUF_TYPE_FLOAT32 = 6,
+    GGUF_TYPE_BOOL = 7,
+    GGUF_TYPE_STRING = 8,
+    GGUF_TYPE_ARRAY = 9,
+};
+
+// llama_token_type values
+enum {
+    TOKEN_TYPE_NORMAL = 1,
+    TOKEN_TYPE_UNKNOWN = 2,
+    TOKEN_TYPE_CONTROL = 3,
+    TOKEN_TYPE_USER_DEFINED = 4,
+    TOKEN_TYPE_UNUSED = 5,
+    TOKEN_TYPE_BYTE = 6,
+};
+
+typedef enum {
+    VOCAB_SPM,
+    VOCAB_BPE,
+    VOCAB_WPM,
+    VOCAB_UGM,
+} vocab_kind;
+
+static const char* const vocab_names[] = { "spm", "bpe", "wpm", "ugm" };
+static const char* const tokenizer_models[] = { "llama", "gpt2", "bert", "t5" };
+
+// U+2581, the word-initial marker of SPM, UGM and GGUF WordPiece vocabs
+static const char word_marker[] = "\xE2\x96\x81";
+
+// ---------------------------------------------------------------------------
+// Vocab under construction
+
+typedef struct {
+    char** texts;
+    float* scores;
+    int32_t* types;
+    int32_t n;
+    int32_t cap;
+
+    char** merges;  // BPE only
+    int32_t n_merges;
+
+    // Open-addressing set of token texts -> index + 1
+    int32_t* slots;
+    uint32_t slot_mask;
+} vocab;
+
+static uint64_t hash_string(const char* s) {
+    uint64_t h = 1469598103934665603ull;
+    for (; *s; s++) {
+        h = (h ^ (unsigned char)*s) * 1099511628211ull;
+    }
+    return h;
+}
+
+static char* copy_string(const char* s) {
+    size_t len = strlen(s);
+    char* out = malloc(len + 1);
+    if (!out) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    memcpy(out, s, len + 1);
+    return out;
+}
+
+static int vocab_init(vocab* v, int32_t cap) {
+    memset(v, 0, sizeof(*v));
+    v->cap = cap;
+    v->texts = calloc((size_t)cap, sizeof(char*));
+    v->scores = calloc((size_t)cap, sizeof(float));
+    v->types = calloc((size_t)cap, sizeof(int32_t));
+    v->merges = calloc((size_t)cap, sizeof(char*));
+    uint32_t n_slots = 1;
+    while (n_slots < (uint32_t)cap * 4) {
+        n_slots <<= 1;
+    }
+    v->slots = calloc(n_slots, sizeof(int32_t));
+    v->slot_mask = n_slots - 1;
+    return v->texts && v->scores && v->types && v->merges && v->slots ? 0 : -1;
+}
+
+static void vocab_free(vocab* v) {
+    for (int32_t i = 0; i < v->n; i++) {
+        free(v->texts[i]);
+    }
+    for (int32_t i = 0; i < v->n_merges; i++) {
+        free(v->merges[i]);
+    }
+    free(v->texts);
+    free(v->scores);
+    free(v->types);
+    free(v->merges);
+    free(v->slots);
+}
+
+// Index of text, or -1
+static int32_t vocab_find(const vocab* v, const char* text) {
+    for (uint32_t i = (uint32_t)hash_string(text) & v->slot_mask;; i = (i + 1) & v->slot_mask) {
+        if (v->slots[i] == 0) {
+            return -1;
+        }
+        if (strcmp(v->texts[v->slots[i] - 1], text) == 0) {
+            return v->slots[i] - 1;
+        }
+    }
+}
+
+// Adds text unless present or full; returns its index, or -1 if full
+static int32_t vocab_add(vocab* v, const char* text, float score, int32_t type) {
+    uint32_t i = (uint32_t)hash_string(text) & v->slot_mask;
+    for (; v->slots[i] != 0; i = (i + 1) & v->slot_mask) {
+        if (strcmp(v->texts[v->slots[i] - 1], text) == 0) {
+            return v->slots[i] - 1;
+        }
+    }
+    if (v->n == v->cap) {
+        return -1;
+    }
+    v->texts[v->n] = copy_string(text);
+    v->scores[v->n] = score;
+    v->types[v->n] = type;
+    v->slots[i] = ++v->n;
+    return v->n - 1;
+}
+
+// ---------------------------------------------------------------------------
+// Text generation
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 2685821657736338717ull) >> 32);
+}
+
+static size_t utf8_encode(uint32_t cpt, char* out) {
+    if (cpt < 0x80) {
+        out[0] = (char)cpt;
+        return 1;
+    }
+    if (cpt < 0x800) {
+        out[0] = (char)(0xC0 | (cpt >> 6));
+        out[1] = (char)(0x80 | (cpt & 0x3F));
+        return 2;
+    }
+    if (cpt < 0x10000) {
+        out[0] = (char)(0xE0 | (cpt >> 12));
+        out[1] = (char)(0x80 | ((cpt >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cpt & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cpt >> 18));
+    out[1] = (char)(0x80 | ((cpt >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cpt >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cpt & 0x3F));
+    return 4;
+}
+
+// Characters every vocab gets as single-character pieces
+static const uint32_t char_ranges[][2] = {
+    { 0x21, 0x7E },      // printable ASCII
+    { 0xC0, 0xFF },      // Latin-1 letters
+    { 0x391, 0x3C9 },    // Greek
+    { 0x410, 0x44F },    // Cyrillic
+    { 0x2010, 0x2027 },  // dashes, quotes, ellipsis
+    { 0x3041, 0x3096 },  // Hiragana
+    { 0x4E00, 0x55FF },  // common CJK ideographs
+    { 0x1F600, 0x1F64F },// emoji
+};
+
+static const char* const common_words[] = {
+    "the", "of", "and", "to", "in", "is", "that", "for", "it", "as", "was", "with", "be", "by", "on",
+    "not", "he", "this", "are", "or", "his", "from", "at", "which", "but", "have", "an", "had", "they",
+    "you", "were", "their", "one", "all", "we", "can", "her", "has", "there", "been", "if", "more",
+    "when", "will", "would", "who", "so", "no", "int", "return", "const", "char", "void", "static",
+    "struct", "size_t", "for", "while", "if", "else", "def", "self", "None", "True", "False", "import",
+    "function", "var", "let", "class", "public", "private", "new", "null", "true", "false", "printf",
+};
+
+static const char* const onsets[] = {
+    "", "b", "c", "d", "f", "g", "h", "j", "k", "l", "m", "n", "p", "r", "s", "t", "v", "w", "z",
+    "st", "tr", "ch", "sh", "th", "pr", "gr", "bl", "cl", "qu",
+};
+static const char* const nuclei[] = { "a", "e", "i", "o", "u", "ai", "ea", "ou", "io", "y" };
+static const char* const codas[] = { "", "", "n", "r", "s", "t", "l", "m", "nd", "st", "ng", "ck", "x" };
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+static void random_syllable(char* out) {
+    strcpy(out, onsets[rng_next() % COUNT(onsets)]);
+    strcat(out, nuclei[rng_next() % COUNT(nuclei)]);
+    strcat(out, codas[rng_next() % COUNT(codas)]);
+}
+
+// 1-4 syllables, occasionally capitalized
+static void random_word(char* out) {
+    out[0] = '\0';
+    int n = 1 + (int)(rng_next() % 4);
+    for (int i = 0; i < n; i++) {
+        char syllable[16];
+        random_syllable(syllable);
+        strcat(out, syllable);
+    }
+    if (rng_next() % 8 == 0 && out[0] >= 'a' && out[0] <= 'z') {
+        out[0] = (char)(out[0] - 'a' + 'A');
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Piece construction per vocab type
+
+// GPT-2 byte-to-unicode mapping used by byte-level BPE vocabs
+static char byte_chars[256][3];
+
+static void init_byte_chars(void) {
+    int n = 0;
+    for (int b = 0; b < 256; b++) {
+        uint32_t cpt;
+        if ((b >= 0x21 && b <= 0x7E) || (b >= 0xA1 && b <= 0xAC) || (b >= 0xAE && b <= 0xFF)) {
+            cpt = (uint32_t)b;
+        } else {
+            cpt = 256 + (uint32_t)n++;
+        }
+        size_t len = utf8_encode(cpt, byte_chars[b]);
+        byte_chars[b][len] = '\0';
+    }
+}
+
+// Score for the next normal piece: earlier (shorter, more common) pieces
+// score higher, as in a trained vocab
+static float next_score(const vocab* v) {
+    return -2.0f - 10.0f * (float)v->n / (float)v->cap;
+}
+
+// BPE: add every prefix of text as a token, each built by one merge of
+// the previous prefix with the next byte
+static void add_bpe_chain(vocab* v, int32_t limit, const char* text) {
+    char prefix[256] = "";
+    size_t prefix_len = 0;
+    for (size_t i = 0; text[i] && v->n < limit; i++) {
+        const char* byte = byte_chars[(unsigned char)text[i]];
+        if (prefix_len + strlen(byte) + 1 > sizeof(prefix)) {
+            return;
+        }
+        char merged[256];
+        snprintf(merged, sizeof(merged), "%s%s", prefix, byte);
+        if (i > 0 && vocab_find(v, merged) < 0) {
+            char merge[520];
+            snprintf(merge, sizeof(merge), "%s %s", prefix, byte);
+            vocab_add(v, merged, next_score(v), TOKEN_TYPE_NORMAL);
+            v->merges[v->n_merges++] = copy_string(merge);
+        }
+        memcpy(prefix, merged, strlen(merged) + 1);
+        prefix_len = strlen(prefix);
+    }
+}
+
+// SPM, UGM and WPM: add every prefix of text (whole characters only)
+static void add_prefix_chain(vocab* v, int32_t limit, const char* marker, const char* text) {
+    char piece[256];
+    size_t base = (size_t)snprintf(piece, sizeof(piece), "%s", marker);
+    size_t len = strlen(text);
+    for (size_t i = 0; i < len && v->n < limit; i++) {
+        if (((unsigned char)text[i + 1] & 0xC0) == 0x80) {
+            continue;  // not at a character boundary yet
+        }
+        if (base + i + 2 > sizeof(piece)) {
+            return;
+        }
+        memcpy(piece + base, text, i + 1);
+        piece[base + i + 1] = '\0';
+        vocab_add(v, piece, next_score(v), TOKEN_TYPE_NORMAL);
+    }
+}
+
+static void add_text(vocab* v, vocab_kind kind, int32_t limit, const char* text, int word_initial) {
+    if (kind == VOCAB_BPE) {
+        char spaced[256];
+        snprintf(spaced, sizeof(spaced), "%s%s", word_initial ? " " : "", text);
+        add_bpe_chain(v, limit, spaced);
+    } else {
+        add_prefix_chain(v, limit, word_initial ? word_marker : "", text);
+    }
+}
+
+static void add_leading_tokens(vocab* v, vocab_kind kind) {
+    switch (kind) {
+        case VOCAB_SPM: {
+            vocab_add(v, "<unk>", 0.0f, TOKEN_TYPE_UNKNOWN);
+            vocab_add(v, "<s>", 0.0f, TOKEN_TYPE_CONTROL);
+            vocab_add(v, "</s>", 0.0f, TOKEN_TYPE_CONTROL);
+            for (int b = 0; b < 256; b++) {
+                char text[8];
+                snprintf(text, sizeof(text), "<0x%02X>", b);
+                vocab_add(v, text, 0.0f, TOKEN_TYPE_BYTE);
+            }
+            break;
+        }
+        case VOCAB_BPE:
+            for (int b = 0; b < 256; b++) {
+                vocab_add(v, byte_chars[b], 0.0f, TOKEN_TYPE_NORMAL);
+            }
+            break;
+        case VOCAB_WPM:
+            // llama.cpp's BERT defaults: PAD 0, UNK 100, CLS 101, SEP 102, MASK 103
+            vocab_add(v, "[PAD]", 0.0f, TOKEN_TYPE_CONTROL);
+            for (int i = 1; i < 100; i++) {
+                char text[16];
+                snprintf(text, sizeof(text), "[unused%d]", i - 1);
+                vocab_add(v, text, 0.0f, TOKEN_TYPE_UNUSED);
+            }
+            vocab_add(v, "[UNK]", 0.0f, TOKEN_TYPE_UNKNOWN);
+            vocab_add(v, "[CLS]", 0.0f, TOKEN_TYPE_CONTROL);
+            vocab_add(v, "[SEP]", 0.0f, TOKEN_TYPE_CONTROL);
+            vocab_add(v, "[MASK]", 0.0f, TOKEN_TYPE_CONTROL);
+            break;
+        case VOCAB_UGM:
+            // llama.cpp's T5 defaults: PAD 0, EOS 1, UNK 2
+            vocab_add(v, "<pad>", 0.0f, TOKEN_TYPE_CONTROL);
+            vocab_add(v, "</s>", 0.0f, TOKEN_TYPE_CONTROL);
+            vocab_add(v, "<unk>", 0.0f, TOKEN_TYPE_UNKNOWN);
+            break;
+    }
+}
+
+static int build_vocab(vocab* v, vocab_kind kind, int32_t n_tokens, int32_t n_specials) {
+    if (vocab_init(v, n_tokens) != 0) {
+        return -1;
+    }
+    rng_state = 0x9E3779B97F4A7C15ull ^ ((uint64_t)kind << 32) ^ (uint64_t)n_tokens;
+
+    add_leading_tokens(v, kind);
+    const int32_t limit = n_tokens - n_specials;
+
+    // Single characters, word-initial and (for WPM, continuation) plain
+    if (kind != VOCAB_BPE) {
+        vocab_add(v, word_marker, next_score(v), TOKEN_TYPE_NORMAL);
+    }
+    for (size_t r = 0; r < COUNT(char_ranges) && v->n < limit; r++) {
+        for (uint32_t cpt = char_ranges[r][0]; cpt <= char_ranges[r][1] && v->n < limit; cpt++) {
+            char text[8];
+            text[utf8_encode(cpt, text)] = '\0';
+            add_text(v, kind, limit, text, 0);
+            if (kind == VOCAB_WPM) {
+                add_text(v, kind, limit, text, 1);
+            }
+        }
+    }
+
+    // Frequent words, then generated words and their syllables until full
+    for (size_t i = 0; i < COUNT(common_words) && v->n < limit; i++) {
+        add_text(v, kind, limit, common_words[i], 1);
+        add_text(v, kind, limit, common_words[i], 0);
+    }
+    const char* const whitespace[] = { "  ", "    ", "        ", "\n", "\n\n", "\t" };
+    for (size_t i = 0; i < COUNT(whitespace) && v->n < limit && kind == VOCAB_BPE; i++) {
+        add_text(v, kind, limit, whitespace[i], 0);
+    }
+    for (uint32_t stalled = 0; v->n < limit && stalled < 1000000;) {
+        const int32_t before = v->n;
+        char word[96];
+        random_word(word);
+        add_text(v, kind, limit, word, 1);
+        if (rng_next() % 2 == 0) {
+            char syllable[16];
+            random_syllable(syllable);
+            add_text(v, kind, limit, syllable, 0);
+        }
+        stalled = (v->n == before) ? stalled + 1 : 0;
+    }
+    if (v->n < limit) {
+        fprintf(stderr, "Could not generate %d distinct pieces\n", limit);
+        return -1;
+    }
+
+    // Added special tokens: half control, half user-defined
+    for (int32_t i = 0; v->n < n_tokens; i++) {
+        char text[64];
+        const int control = i % 2 == 0;
+        switch (kind) {
+            case VOCAB_WPM:
+                snprintf(text, sizeof(text), control ? "[SPECIAL_%d]" : "[USER_%d]", i);
+                break;
+            case VOCAB_UGM:
+                snprintf(text, sizeof(text), control ? "<extra_id_%d>" : "<user_%d>", i);
+                break;
+            default:
+                snprintf(text, sizeof(text), control ? "<|reserved_special_token_%d|>" : "<|user_token_%d|>", i);
+                break;
+        }
+        vocab_add(v, text, 0.0f, control ? TOKEN_TYPE_CONTROL : TOKEN_TYPE_USER_DEFINED);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// GGUF writer
+
+typedef struct {
+    FILE* f;
+    uint64_t written;
+    uint64_t n_kv;
+    int failed;
+} gguf_writer;
+
+static void put(gguf_writer* w, const void* data, size_t size) {
+    if (!w->failed && fwrite(data, 1, size, w->f) != size) {
+        w->failed = 1;
+    }
+    w->written += size;
+}
+
+static void put_u32(gguf_writer* w, uint32_t v) {
+    put(w, &v, sizeof(v));
+}
+
+static void put_u64(gguf_writer* w, uint64_t v) {
+    put(w, &v, sizeof(v));
+}
+
+static void put_string(gguf_writer* w, const char* s) {
+    const uint64_t len = strlen(s);
+    put_u64(w, len);
+    put(w, s, (size_t)len);
+}
+
+static void put_key(gguf_writer* w, const char* key, uint32_t type) {
+    put_string(w, key);
+    put_u32(w, type);
+    w->n_kv++;
+}
+
+static void kv_string(gguf_writer* w, const char* key, const char* value) {
+    put_key(w, key, GGUF_TYPE_STRING);
+    put_string(w, value);
+}
+
+static void kv_u32(gguf_writer* w, const char* key, uint32_t value) {
+    put_key(w, key, GGUF_TYPE_UINT32);
+    put_u32(w, value);
+}
+
+static void kv_f32(gguf_writer* w, const char* key, float value) {
+    put_key(w, key, GGUF_TYPE_FLOAT32);
+    put(w, &value, sizeof(value));
+}
+
+static void kv_bool(gguf_writer* w, const char* key, int value) {
+    const uint8_t b = value ? 1 : 0;
+    put_key(w, key, GGUF_TYPE_BOOL);
+    put(w, &b, 1);
+}
+
+static void kv_array(gguf_writer* w, const char* key, uint32_t type, uint64_t n, const void* data, size_t elem) {
+    put_key(w, key, GGUF_TYPE_ARRAY);
+    put_u32(w, type);
+    put_u64(w, n);
+    put(w, data, (size_t)n * elem);
+}
+
+static void kv_string_array(gguf_writer* w, const char* key, char* const* values, uint64_t n) {
+    put_key(w, key, GGUF_TYPE_ARRAY);
+    put_u32(w, GGUF_TYPE_STRING);
+    put_u64(w, n);
+    for (uint64_t i = 0; i < n; i++) {
+        put_string(w, values[i]);
+    }
+}
+
+static int write_gguf(const char* path, const vocab* v, vocab_kind kind) {
+    gguf_writer w = { fopen(path, "wb"), 0, 0, 0 };
+    if (!w.f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return -1;
+    }
+
+    put(&w, "GGUF", 4);
+    put_u32(&w, GGUF_VERSION);
+    put_u64(&w, 0);  // tensors
+    put_u64(&w, 0);  // key/value pairs, patched below
+
+    char name[64];
+    snprintf(name, sizeof(name), "synthetic-%s-%d", vocab_names[kind], v->n);
+    kv_string(&w, "general.architecture", "llama");
+    kv_string(&w, "general.name", name);
+    kv_u32(&w, "general.alignment", GGUF_ALIGNMENT);
+    kv_u32(&w, "llama.vocab_size", (uint32_t)v->n);
+    kv_u32(&w, "llama.context_length", 4096);
+    kv_u32(&w, "llama.embedding_length", 64);
+    kv_u32(&w, "llama.block_count", 1);
+    kv_u32(&w, "llama.feed_forward_length", 128);
+    kv_u32(&w, "llama.attention.head_count", 1);
+    kv_u32(&w, "llama.attention.head_count_kv", 1);
+    kv_u32(&w, "llama.rope.dimension_count", 64);
+    kv_f32(&w, "llama.attention.layer_norm_rms_epsilon", 1e-5f);
+    kv_string(&w, "tokenizer.ggml.model", tokenizer_models[kind]);
+    kv_string_array(&w, "tokenizer.ggml.tokens", v->texts, (uint64_t)v->n);
+
+    if (kind != VOCAB_BPE) {
+        kv_array(&w, "tokenizer.ggml.scores", GGUF_TYPE_FLOAT32, (uint64_t)v->n, v->scores, sizeof(float));
+    }
+    switch (kind) {
+        case VOCAB_SPM:
+            kv_bool(&w, "tokenizer.ggml.add_bos_token", 1);
+            kv_bool(&w, "tokenizer.ggml.add_space_prefix", 1);
+            break;
+        case VOCAB_BPE: {
+            // BOS/EOS are the first two added special tokens
+            const int32_t first_special = vocab_find(v, "<|reserved_special_token_0|>");
+            kv_string(&w, "tokenizer.ggml.pre", "default");
+            kv_string_array(&w, "tokenizer.ggml.merges", v->merges, (uint64_t)v->n_merges);
+            kv_u32(&w, "tokenizer.ggml.bos_token_id", (uint32_t)first_special);
+            kv_u32(&w, "tokenizer.ggml.eos_token_id", (uint32_t)first_special + 2);
+            kv_bool(&w, "tokenizer.ggml.add_bos_token", 1);
+            break;
+        }
+        case VOCAB_WPM:
+            break;
+        case VOCAB_UGM:
+            kv_bool(&w, "tokenizer.ggml.add_eos_token", 1);
+            kv_bool(&w, "tokenizer.ggml.add_space_prefix", 1);
+            kv_bool(&w, "tokenizer.ggml.remove_extra_whitespaces", 1);
+            break;
+    }
+    kv_array(&w, "tokenizer.ggml.token_type", GGUF_TYPE_INT32, (uint64_t)v->n, v->types, sizeof(int32_t));
+
+    // Empty, aligned data section
+    static const char zeros[GGUF_ALIGNMENT] = { 0 };
+    put(&w, zeros, (GGUF_ALIGNMENT - w.written % GGUF_ALIGNMENT) % GGUF_ALIGNMENT);
+
+    if (fseek(w.f, 16, SEEK_SET) != 0) {
+        w.failed = 1;
+    }
+    put_u64(&w, w.n_kv);
+
+    const int failed = w.failed | (fclose(w.f) != 0);
+    if (failed) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+
+static int parse_count(const char* s, int32_t* out) {
+    char* end;
+    long v = strtol(s, &end, 10);
+    if (*end == 'k' || *end == 'K') {
+        v *= 1000;
+        end++;
+    }
+    if (end == s || *end != '\0' || v <= 0 || v > (1 << 24)) {
+        return -1;
+    }
+    *out = (int32_t)v;
+    return 0;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "Usage: %s <output_dir> [options]\n", argv0);
+    fprintf(stderr, "  --types LIST       comma-separated subset of spm,bpe,wpm,ugm (default: all)\n");
+    fprintf(stderr, "  --sizes LIST       comma-separated vocab sizes, k suffix allowed (default: 32k,128k,256k)\n");
+    fprintf(stderr, "  --specials N       added special tokens per vocab (default: 1024)\n");
+    fprintf(stderr, "Writes <output_dir>/synthetic-<type>-<size>.gguf\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* out_dir = argv[1];
+
+    int types[4] = { 1, 1, 1, 1 };
+    int32_t sizes[16] = { 32000, 128000, 256000 };
+    int n_sizes = 3;
+    int32_t n_specials = 1024;
+
+    for (int i = 2; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        char* value = argv[++i];
+        if (strcmp(argv[i - 1], "--types") == 0) {
+            memset(types, 0, sizeof(types));
+            for (char* tok = strtok(value, ","); tok; tok = strtok(NULL, ",")) {
+                int found = 0;
+                for (int k = 0; k < 4; k++) {
+                    if (strcmp(tok, vocab_names[k]) == 0) {
+                        types[k] = found = 1;
+                    }
+                }
+                if (!found) {
+                    usage(argv[0]);
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i - 1], "--sizes") == 0) {
+            n_sizes = 0;
+            for (char* tok = strtok(value, ","); tok; tok = strtok(NULL, ",")) {
+                if (n_sizes == 16 || parse_count(tok, &sizes[n_sizes++]) != 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i - 1], "--specials") == 0) {
+            if (parse_count(value, &n_specials) != 0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    init_byte_chars();
+
+    for (int k = 0; k < 4; k++) {
+        if (!types[k]) {
+            continue;
+        }
+        for (int s = 0; s < n_sizes; s++) {
+            // Room for the leading tokens, every character and a few words
+            if (sizes[s] < n_specials + 4096) {
+                fprintf(stderr, "Vocab size %d is too small for %d special tokens\n", sizes[s], n_specials);
+                return 1;
+            }
+            vocab v;
+            if (build_vocab(&v, (vocab_kind)k, sizes[s], n_specials) != 0) {
+                vocab_free(&v);
+                return 1;
+            }
+
+            char path[4096];
+            if (sizes[s] % 1000 == 0) {
+                snprintf(path, sizeof(path), "%s/synthetic-%s-%dk.gguf", out_dir, vocab_names[k], sizes[s] / 1000);
+            } else {
+                snprintf(path, sizeof(path), "%s/synthetic-%s-%d.gguf", out_dir, vocab_names[k], sizes[s]);
+            }
+            int rc = write_gguf(path, &v, (vocab_kind)k);
+            if (rc == 0) {
+                printf("%s: %d tokens, %d special, %d merges\n", path, v.n, n_specials, v.n_merges);
+            }
+            vocab_free(&v);
+            if (rc != 0) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
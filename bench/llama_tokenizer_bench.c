@@ -0,0 +1,571 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "llama_tokenizer.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Benchmark suite
+//
+// Throughput (MB/s, tokens/s) and per-call latency percentiles for
+// tokenize, count-only tokenize, the count estimate, detokenize and
+// token_to_piece, across input-size classes, thread counts and flag
+// combinations. Results are printed as a table and, with --json, written
+// as JSON so runs can be compared, e.g. before and after a llama.cpp
+// submodule bump.
+//
+// Every thread runs the same case on the shared input with its own output
+// buffer, so multi-thread rows show how the wrapper scales under
+// contention rather than how fast one input can be split up.
+
+#define MAX_THREADS 64
+#define MAX_SAMPLES_PER_THREAD (1 << 18)      // also caps calls per thread
+#define PIECE_BUFFER 1024
+#define MAX_OUTPUT_BYTES ((size_t)1 << 30)    // per case, across all threads
+
+typedef enum {
+    OP_TOKENIZE,
+    OP_COUNT,
+    OP_DETOKENIZE,
+    OP_TOKEN_TO_PIECE,
+    OP_ESTIMATE,
+    OP_COUNT_OPS,
+} bench_op;
+
+static const char* const op_names[] = { "tokenize", "count", "detokenize", "token_to_piece", "estimate" };
+
+static const size_t size_classes[] = {
+    16, 256, 4 << 10, 64 << 10, 1 << 20, 16 << 20, 100 << 20,
+};
+#define N_SIZE_CLASSES (sizeof(size_classes) / sizeof(size_classes[0]))
+
+// Mixed prose, code and multilingual text, repeated up to each size class
+static const char corpus[] =
+    "The committee reviewed the proposal in detail and, after a lengthy discussion, "
+    "agreed to postpone the final decision until the next quarterly meeting.\n"
+    "static int parse(const char* s, size_t n) {\n    for (size_t i = 0; i < n; ++i) {\n"
+    "        if (s[i] == '\\n') { return (int)i; }\n    }\n    return -1;\n}\n"
+    "Caf\xC3\xA9 cr\xC3\xA8me br\xC3\xBBl\xC3\xA9" "e. \xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82, "
+    "\xD0\xBC\xD0\xB8\xD1\x80! \xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87\xE7\xAB\xA0\xE3\x80\x82 "
+    "\xF0\x9F\x98\x80 1234567890 3.14159 user_id=12345&lang=en\n";
+
+typedef struct {
+    double min_seconds;
+    size_t max_size;
+    int threads[MAX_THREADS];
+    int n_threads;
+    const char* json_path;
+} bench_options;
+
+// One size class, shared read-only by all threads
+typedef struct {
+    const llama_tokenizer_t* tokenizer;
+    const char* text;
+    int32_t text_len;
+    const llama_token* tokens;  // text tokenized without specials
+    int32_t n_tokens;
+} bench_input;
+
+typedef struct {
+    bench_op op;
+    size_t size_class;
+    int n_threads;
+    bool flag_a;  // add_special, or remove_special for detokenize
+    bool flag_b;  // parse_special, or unparse_special for detokenize
+    uint64_t calls;
+    uint64_t bytes;
+    uint64_t tokens;
+    double seconds;
+    double p50_ns;
+    double p99_ns;
+    double p999_ns;
+} bench_result;
+
+typedef struct {
+    const bench_input* input;
+    const bench_result* config;
+    double min_seconds;
+    pthread_barrier_t* barrier;
+    uint64_t* samples;
+    size_t n_samples;
+    uint64_t calls;
+    uint64_t bytes;
+    uint64_t tokens;
+    double start;
+    double end;
+    int failed;
+} worker_state;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Repeat the corpus to len bytes, cut back to a UTF-8 character boundary
+static char* make_text(size_t len, int32_t* out_len) {
+    const size_t corpus_len = sizeof(corpus) - 1;
+    char* text = malloc(len + 1);
+    if (!text) {
+        return NULL;
+    }
+    for (size_t pos = 0; pos < len; pos += corpus_len) {
+        size_t n = len - pos < corpus_len ? len - pos : corpus_len;
+        memcpy(text + pos, corpus, n);
+    }
+    // Don't end on a partial character: the byte after the cut must start one
+    while (len > 0 && ((unsigned char)corpus[len % corpus_len] & 0xC0) == 0x80) {
+        len--;
+    }
+    text[len] = '\0';
+    *out_len = (int32_t)len;
+    return text;
+}
+
+static size_t output_bytes(const bench_input* input, bench_op op) {
+    switch (op) {
+        case OP_TOKENIZE:
+            return (size_t)(input->n_tokens + 2) * sizeof(llama_token) + 64;
+        case OP_DETOKENIZE:
+            return (size_t)input->text_len * 2 + 64;
+        case OP_TOKEN_TO_PIECE:
+            return PIECE_BUFFER;
+        default:
+            return 0;
+    }
+}
+
+static void* worker_main(void* arg) {
+    worker_state* w = (worker_state*)arg;
+    const bench_input* in = w->input;
+    const bench_result* c = w->config;
+
+    const size_t out_size = output_bytes(in, c->op);
+    void* out = out_size ? malloc(out_size) : NULL;
+    if (out_size && !out) {
+        w->failed = 1;
+    }
+
+    pthread_barrier_wait(w->barrier);
+    if (w->failed) {
+        return NULL;
+    }
+
+    volatile int32_t sink = 0;
+    size_t piece = 0;
+    w->start = now_seconds();
+    do {
+        int32_t result = 0;
+        const uint64_t t0 = now_ns();
+        switch (c->op) {
+            case OP_TOKENIZE:
+                result = llama_tokenizer_tokenize(in->tokenizer, in->text, in->text_len, (llama_token*)out,
+                                                  (int32_t)(out_size / sizeof(llama_token)), c->flag_a, c->flag_b);
+                break;
+            case OP_COUNT:
+                result = llama_tokenizer_tokenize(in->tokenizer, in->text, in->text_len, NULL, 0,
+                                                  c->flag_a, c->flag_b);
+                break;
+            case OP_ESTIMATE:
+                result = llama_tokenizer_estimate_count(in->tokenizer, in->text, in->text_len, c->flag_a,
+                                                        NULL, NULL);
+                break;
+            case OP_DETOKENIZE:
+                result = llama_tokenizer_detokenize(in->tokenizer, in->tokens, in->n_tokens, (char*)out,
+                                                    (int32_t)out_size, c->flag_a, c->flag_b);
+                break;
+            default:
+                result = llama_tokenizer_token_to_piece(in->tokenizer, in->tokens[piece], (char*)out,
+                                                        (int32_t)out_size);
+                piece = (piece + 1) % (size_t)in->n_tokens;
+                break;
+        }
+        const uint64_t t1 = now_ns();
+        if (result < 0) {
+            w->failed = 1;
+            break;
+        }
+        w->samples[w->n_samples++] = t1 - t0;
+        w->calls++;
+        sink += result;
+        if (c->op == OP_DETOKENIZE || c->op == OP_TOKEN_TO_PIECE) {
+            w->bytes += (uint64_t)result;
+            w->tokens += c->op == OP_DETOKENIZE ? (uint64_t)in->n_tokens : 1;
+        } else {
+            w->bytes += (uint64_t)in->text_len;
+            w->tokens += (uint64_t)result;
+        }
+    } while (w->n_samples < MAX_SAMPLES_PER_THREAD && now_seconds() - w->start < w->min_seconds);
+    w->end = now_seconds();
+    (void)sink;
+
+    free(out);
+    return NULL;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const uint64_t* sorted, size_t n, double p) {
+    if (n == 0) {
+        return 0.0;
+    }
+    size_t rank = (size_t)(p * (double)n + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > n) {
+        rank = n;
+    }
+    return (double)sorted[rank - 1];
+}
+
+// Returns 0 on success, 1 if the case was skipped, -1 on failure
+static int run_case(const bench_input* input, const bench_options* opts, bench_result* r) {
+    if (output_bytes(input, r->op) * (size_t)r->n_threads > MAX_OUTPUT_BYTES) {
+        return 1;
+    }
+    if ((r->op == OP_DETOKENIZE || r->op == OP_TOKEN_TO_PIECE) && input->n_tokens == 0) {
+        return 1;
+    }
+
+    worker_state workers[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, (unsigned)r->n_threads);
+
+    int ok = 1;
+    for (int t = 0; t < r->n_threads; t++) {
+        memset(&workers[t], 0, sizeof(workers[t]));
+        workers[t].input = input;
+        workers[t].config = r;
+        workers[t].min_seconds = opts->min_seconds;
+        workers[t].barrier = &barrier;
+        workers[t].samples = malloc(MAX_SAMPLES_PER_THREAD * sizeof(uint64_t));
+        if (!workers[t].samples) {
+            workers[t].failed = 1;
+        }
+    }
+    for (int t = 0; t < r->n_threads; t++) {
+        // Threads already started would wait on the barrier forever
+        if (pthread_create(&threads[t], NULL, worker_main, &workers[t]) != 0) {
+            fprintf(stderr, "Failed to start %d threads\n", r->n_threads);
+            exit(1);
+        }
+    }
+    for (int t = 0; t < r->n_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+
+    size_t n_samples = 0;
+    double start = 0.0;
+    double end = 0.0;
+    r->calls = r->bytes = r->tokens = 0;
+    for (int t = 0; t < r->n_threads; t++) {
+        ok = ok && !workers[t].failed;
+        n_samples += workers[t].n_samples;
+        r->calls += workers[t].calls;
+        r->bytes += workers[t].bytes;
+        r->tokens += workers[t].tokens;
+        if (t == 0 || workers[t].start < start) {
+            start = workers[t].start;
+        }
+        if (t == 0 || workers[t].end > end) {
+            end = workers[t].end;
+        }
+    }
+    r->seconds = end - start;
+
+    uint64_t* all = ok ? malloc((n_samples ? n_samples : 1) * sizeof(uint64_t)) : NULL;
+    if (all) {
+        size_t pos = 0;
+        for (int t = 0; t < r->n_threads; t++) {
+            memcpy(all + pos, workers[t].samples, workers[t].n_samples * sizeof(uint64_t));
+            pos += workers[t].n_samples;
+        }
+        qsort(all, n_samples, sizeof(uint64_t), compare_u64);
+        r->p50_ns = percentile(all, n_samples, 0.50);
+        r->p99_ns = percentile(all, n_samples, 0.99);
+        r->p999_ns = percentile(all, n_samples, 0.999);
+        free(all);
+    } else {
+        ok = 0;
+    }
+    for (int t = 0; t < r->n_threads; t++) {
+        free(workers[t].samples);
+    }
+    return ok ? 0 : -1;
+}
+
+static const char* size_label(size_t size, char* buf, size_t buf_size) {
+    if (size >= (1 << 20) && size % (1 << 20) == 0) {
+        snprintf(buf, buf_size, "%zuMiB", size >> 20);
+    } else if (size >= (1 << 10) && size % (1 << 10) == 0) {
+        snprintf(buf, buf_size, "%zuKiB", size >> 10);
+    } else {
+        snprintf(buf, buf_size, "%zuB", size);
+    }
+    return buf;
+}
+
+static void print_row(FILE* out, const bench_result* r) {
+    char size[16];
+    char flags[8];
+    if (r->op == OP_TOKEN_TO_PIECE) {
+        snprintf(flags, sizeof(flags), "-");
+    } else {
+        snprintf(flags, sizeof(flags), "%d%d", r->flag_a, r->flag_b);
+    }
+    const double mb_s = r->seconds > 0 ? (double)r->bytes / r->seconds / 1e6 : 0.0;
+    const double mtok_s = r->seconds > 0 ? (double)r->tokens / r->seconds / 1e6 : 0.0;
+    fprintf(out, "  %-15s %8s %4d %5s %10.2f %10.3f %11.2f %11.2f %11.2f\n",
+           op_names[r->op], size_label(r->size_class, size, sizeof(size)), r->n_threads, flags,
+           mb_s, mtok_s, r->p50_ns / 1e3, r->p99_ns / 1e3, r->p999_ns / 1e3);
+    fflush(out);
+}
+
+static void json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fprintf(f, "\\%c", *s);
+        } else if ((unsigned char)*s < 0x20) {
+            fprintf(f, "\\u%04x", (unsigned char)*s);
+        } else {
+            fputc(*s, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static int write_json(const char* path, const char* model_path, const llama_tokenizer_t* tokenizer,
+                      const bench_options* opts, const bench_result* results, size_t n_results) {
+    FILE* f = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return -1;
+    }
+    fprintf(f, "{\n  \"schema_version\": 1,\n  \"model\": ");
+    json_string(f, model_path);
+    fprintf(f, ",\n  \"vocab_size\": %d,\n", llama_tokenizer_vocab_size(tokenizer));
+    fprintf(f, "  \"native_kernel\": %s,\n", llama_tokenizer_uses_native_kernel(tokenizer) ? "true" : "false");
+    fprintf(f, "  \"min_seconds\": %g,\n  \"results\": [\n", opts->min_seconds);
+    for (size_t i = 0; i < n_results; i++) {
+        const bench_result* r = &results[i];
+        const bool detok = r->op == OP_DETOKENIZE;
+        fprintf(f, "    {\"op\": \"%s\", \"size_bytes\": %zu, \"threads\": %d, ",
+                op_names[r->op], r->size_class, r->n_threads);
+        if (r->op != OP_TOKEN_TO_PIECE) {
+            fprintf(f, "\"%s\": %s, \"%s\": %s, ",
+                    detok ? "remove_special" : "add_special", r->flag_a ? "true" : "false",
+                    detok ? "unparse_special" : "parse_special", r->flag_b ? "true" : "false");
+        }
+        fprintf(f, "\"calls\": %llu, \"bytes\": %llu, \"tokens\": %llu, \"seconds\": %.6f, ",
+                (unsigned long long)r->calls, (unsigned long long)r->bytes, (unsigned long long)r->tokens,
+                r->seconds);
+        fprintf(f, "\"mb_per_s\": %.3f, \"tokens_per_s\": %.1f, ",
+                r->seconds > 0 ? (double)r->bytes / r->seconds / 1e6 : 0.0,
+                r->seconds > 0 ? (double)r->tokens / r->seconds : 0.0);
+        fprintf(f, "\"p50_ns\": %.0f, \"p99_ns\": %.0f, \"p999_ns\": %.0f}%s\n",
+                r->p50_ns, r->p99_ns, r->p999_ns, i + 1 < n_results ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    if (f != stdout) {
+        fclose(f);
+    }
+    return 0;
+}
+
+// Accepts a plain byte count or a K/M/G suffix
+static int parse_size(const char* s, size_t* out) {
+    char* end;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (end == s) {
+        return -1;
+    }
+    if (*end == 'K' || *end == 'k') {
+        v <<= 10;
+        end++;
+    } else if (*end == 'M' || *end == 'm') {
+        v <<= 20;
+        end++;
+    } else if (*end == 'G' || *end == 'g') {
+        v <<= 30;
+        end++;
+    }
+    if (*end != '\0') {
+        return -1;
+    }
+    *out = (size_t)v;
+    return 0;
+}
+
+static int parse_threads(const char* s, bench_options* opts) {
+    opts->n_threads = 0;
+    while (*s) {
+        char* end;
+        long n = strtol(s, &end, 10);
+        if (end == s || n < 1 || n > MAX_THREADS || opts->n_threads == MAX_THREADS) {
+            return -1;
+        }
+        opts->threads[opts->n_threads++] = (int)n;
+        s = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return -1;
+        }
+    }
+    return opts->n_threads > 0 ? 0 : -1;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "Usage: %s <model_path> [options]\n", argv0);
+    fprintf(stderr, "  --json FILE        also write results as JSON (\"-\" for stdout)\n");
+    fprintf(stderr, "  --threads LIST     comma-separated thread counts (default: 1 and all CPUs)\n");
+    fprintf(stderr, "  --max-size BYTES   largest input size class, K/M/G suffixes allowed (default: 100M)\n");
+    fprintf(stderr, "  --min-time SEC     minimum run time per case (default: 0.2)\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* model_path = argv[1];
+
+    bench_options opts;
+    opts.min_seconds = 0.2;
+    opts.max_size = (size_t)100 << 20;
+    opts.json_path = NULL;
+    opts.n_threads = 1;
+    opts.threads[0] = 1;
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_cpus > 1) {
+        opts.threads[opts.n_threads++] = n_cpus < MAX_THREADS ? (int)n_cpus : MAX_THREADS;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int bad = value == NULL;
+        if (!bad && strcmp(arg, "--json") == 0) {
+            opts.json_path = value;
+        } else if (!bad && strcmp(arg, "--threads") == 0) {
+            bad = parse_threads(value, &opts) != 0;
+        } else if (!bad && strcmp(arg, "--max-size") == 0) {
+            bad = parse_size(value, &opts.max_size) != 0;
+        } else if (!bad && strcmp(arg, "--min-time") == 0) {
+            opts.min_seconds = atof(value);
+            bad = opts.min_seconds < 0;
+        } else {
+            bad = 1;
+        }
+        if (bad) {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(model_path);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", model_path);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+
+    // The table goes to stderr when JSON goes to stdout
+    FILE* table = (opts.json_path && strcmp(opts.json_path, "-") == 0) ? stderr : stdout;
+
+    fprintf(table, "=== Tokenizer Benchmark Suite ===\n");
+    fprintf(table, "Model: %s\n", model_path);
+    fprintf(table, "Native kernel: %s\n", llama_tokenizer_uses_native_kernel(tokenizer) ? "yes" : "no");
+    fprintf(table, "Minimum time per case: %.2f s; flags are add/parse_special (remove/unparse for detokenize)\n\n",
+            opts.min_seconds);
+    fprintf(table, "  %-15s %8s %4s %5s %10s %10s %11s %11s %11s\n",
+           "op", "size", "thr", "flags", "MB/s", "Mtok/s", "p50 us", "p99 us", "p999 us");
+
+    const size_t max_results = N_SIZE_CLASSES * (size_t)opts.n_threads * 15;
+    bench_result* results = calloc(max_results, sizeof(bench_result));
+    size_t n_results = 0;
+    int status = 0;
+
+    for (size_t s = 0; s < N_SIZE_CLASSES && size_classes[s] <= opts.max_size && status == 0; s++) {
+        bench_input input;
+        memset(&input, 0, sizeof(input));
+        input.tokenizer = tokenizer;
+        char* text = make_text(size_classes[s], &input.text_len);
+        int32_t n = text ? llama_tokenizer_tokenize(tokenizer, text, input.text_len, NULL, 0, false, false) : -1;
+        llama_token* tokens = n >= 0 ? malloc(((size_t)n + 1) * sizeof(llama_token)) : NULL;
+        if (!tokens || llama_tokenizer_tokenize(tokenizer, text, input.text_len, tokens, n, false, false) != n) {
+            fprintf(stderr, "Failed to prepare the %zu-byte input\n", size_classes[s]);
+            free(text);
+            free(tokens);
+            status = 1;
+            break;
+        }
+        input.text = text;
+        input.tokens = tokens;
+        input.n_tokens = n;
+
+        for (int t = 0; t < opts.n_threads && status == 0; t++) {
+            for (int op = 0; op < OP_COUNT_OPS && status == 0; op++) {
+                // token_to_piece takes no flags; estimate only add_special
+                const int n_flag_sets = op == OP_TOKEN_TO_PIECE ? 1 : op == OP_ESTIMATE ? 2 : 4;
+                for (int flags = 0; flags < n_flag_sets; flags++) {
+                    bench_result* r = &results[n_results];
+                    memset(r, 0, sizeof(*r));
+                    r->op = (bench_op)op;
+                    r->size_class = size_classes[s];
+                    r->n_threads = opts.threads[t];
+                    r->flag_a = (flags & 1) != 0;
+                    r->flag_b = (flags & 2) != 0;
+                    int rc = run_case(&input, &opts, r);
+                    if (rc < 0) {
+                        fprintf(stderr, "Case failed: %s, %zu bytes, %d threads\n",
+                                op_names[op], size_classes[s], opts.threads[t]);
+                        status = 1;
+                        break;
+                    }
+                    if (rc == 0) {
+                        print_row(table, r);
+                        n_results++;
+                    } else {
+                        fprintf(table, "  %-15s %8zu %4d  skipped (no tokens, or output buffers over 1 GiB)\n",
+                                op_names[op], size_classes[s], opts.threads[t]);
+                        break;
+                    }
+                }
+            }
+        }
+
+        free(text);
+        free(tokens);
+    }
+
+    if (status == 0 && opts.json_path) {
+        status = write_json(opts.json_path, model_path, tokenizer, &opts, results, n_results) != 0;
+    }
+
+    free(results);
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+    return status;
+}
@@ -0,0 +1,319 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Perf regression gate
+//
+// Compares a llama_tokenizer_bench JSON result file against a stored
+// baseline and exits non-zero when any case regressed past the configured
+// tolerances: throughput (MB/s) dropping, or per-call latency rising.
+// Cases are matched on op, size class, thread count and flags; cases only
+// in one file are reported and skipped. Latencies under a floor are not
+// compared, since timer resolution dominates them.
+//
+// Only the flat schema the bench writes is parsed, not general JSON.
+
+#define MAX_CASES 4096
+
+typedef struct {
+    char key[96];
+    double mb_per_s;
+    double latency_ns;
+} bench_case;
+
+typedef struct {
+    int schema_version;
+    int vocab_size;
+    bool native_kernel;
+    size_t n_cases;
+    bench_case cases[MAX_CASES];
+} bench_file;
+
+typedef struct {
+    double throughput_tolerance;  // percent
+    double latency_tolerance;     // percent
+    double latency_floor_ns;
+    const char* latency_metric;   // "p50_ns", "p99_ns" or "p999_ns"
+} compare_options;
+
+static char* read_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return NULL;
+    }
+    char* data = NULL;
+    size_t size = 0;
+    size_t cap = 0;
+    for (;;) {
+        if (size + 4096 + 1 > cap) {
+            cap = cap ? cap * 2 : 65536;
+            char* grown = realloc(data, cap);
+            if (!grown) {
+                free(data);
+                fclose(f);
+                return NULL;
+            }
+            data = grown;
+        }
+        size_t n = fread(data + size, 1, cap - size - 1, f);
+        size += n;
+        if (n == 0) {
+            break;
+        }
+    }
+    fclose(f);
+    data[size] = '\0';
+    return data;
+}
+
+// Value of "key" between begin and end, or NULL
+static const char* find_field(const char* begin, const char* end, const char* key) {
+    char quoted[64];
+    int n = snprintf(quoted, sizeof(quoted), "\"%s\"", key);
+    for (const char* p = begin; p && p < end; p++) {
+        p = strstr(p, quoted);
+        if (!p || p >= end) {
+            return NULL;
+        }
+        const char* v = p + n;
+        while (*v == ' ' || *v == '\t' || *v == '\n' || *v == '\r') {
+            v++;
+        }
+        if (*v == ':') {
+            v++;
+            while (*v == ' ' || *v == '\t' || *v == '\n' || *v == '\r') {
+                v++;
+            }
+            return v;
+        }
+    }
+    return NULL;
+}
+
+static int field_number(const char* begin, const char* end, const char* key, double* out) {
+    const char* v = find_field(begin, end, key);
+    if (!v) {
+        return -1;
+    }
+    char* num_end;
+    *out = strtod(v, &num_end);
+    return num_end == v ? -1 : 0;
+}
+
+// 1 for true, 0 for false, -1 if absent
+static int field_bool(const char* begin, const char* end, const char* key) {
+    const char* v = find_field(begin, end, key);
+    if (!v) {
+        return -1;
+    }
+    return strncmp(v, "true", 4) == 0 ? 1 : 0;
+}
+
+static int field_string(const char* begin, const char* end, const char* key, char* out, size_t out_size) {
+    const char* v = find_field(begin, end, key);
+    if (!v || *v != '"') {
+        return -1;
+    }
+    const char* close = strchr(v + 1, '"');
+    if (!close || close > end || (size_t)(close - v - 1) >= out_size) {
+        return -1;
+    }
+    memcpy(out, v + 1, (size_t)(close - v - 1));
+    out[close - v - 1] = '\0';
+    return 0;
+}
+
+static int parse_bench_file(const char* path, const char* latency_metric, bench_file* out) {
+    char* data = read_file(path);
+    if (!data) {
+        return -1;
+    }
+    const char* data_end = data + strlen(data);
+    memset(out, 0, sizeof(*out));
+
+    double v;
+    const char* results = find_field(data, data_end, "results");
+    if (field_number(data, data_end, "schema_version", &v) != 0 || !results || *results != '[') {
+        fprintf(stderr, "%s: not a llama_tokenizer_bench JSON file\n", path);
+        free(data);
+        return -1;
+    }
+    out->schema_version = (int)v;
+    if (out->schema_version != 1) {
+        fprintf(stderr, "%s: unsupported schema_version %d\n", path, out->schema_version);
+        free(data);
+        return -1;
+    }
+    // The header fields precede "results"; limit the search to them
+    out->vocab_size = field_number(data, results, "vocab_size", &v) == 0 ? (int)v : 0;
+    out->native_kernel = field_bool(data, results, "native_kernel") == 1;
+
+    for (const char* p = strchr(results, '{'); p; p = strchr(p, '{')) {
+        const char* end = strchr(p, '}');
+        if (!end) {
+            break;
+        }
+        if (out->n_cases == MAX_CASES) {
+            fprintf(stderr, "%s: more than %d cases\n", path, MAX_CASES);
+            free(data);
+            return -1;
+        }
+        char op[32];
+        double size_bytes;
+        double threads;
+        bench_case* c = &out->cases[out->n_cases];
+        if (field_string(p, end, "op", op, sizeof(op)) != 0 ||
+            field_number(p, end, "size_bytes", &size_bytes) != 0 ||
+            field_number(p, end, "threads", &threads) != 0 ||
+            field_number(p, end, "mb_per_s", &c->mb_per_s) != 0 ||
+            field_number(p, end, latency_metric, &c->latency_ns) != 0) {
+            fprintf(stderr, "%s: malformed result entry\n", path);
+            free(data);
+            return -1;
+        }
+        // Tokenize rows carry add/parse_special, detokenize rows remove/unparse_special
+        int flag_a = field_bool(p, end, "add_special");
+        int flag_b = field_bool(p, end, "parse_special");
+        if (flag_a < 0) {
+            flag_a = field_bool(p, end, "remove_special");
+            flag_b = field_bool(p, end, "unparse_special");
+        }
+        snprintf(c->key, sizeof(c->key), "%s size=%.0f threads=%.0f flags=%c%c", op, size_bytes, threads,
+                 flag_a < 0 ? '-' : '0' + flag_a, flag_b < 0 ? '-' : '0' + flag_b);
+        out->n_cases++;
+        p = end;
+    }
+    free(data);
+    return 0;
+}
+
+static const bench_case* find_case(const bench_file* file, const char* key) {
+    for (size_t i = 0; i < file->n_cases; i++) {
+        if (strcmp(file->cases[i].key, key) == 0) {
+            return &file->cases[i];
+        }
+    }
+    return NULL;
+}
+
+static double percent_change(double baseline, double current) {
+    return baseline > 0 ? (current - baseline) / baseline * 100.0 : 0.0;
+}
+
+// Number of regressed cases
+static int compare(const bench_file* baseline, const bench_file* current, const compare_options* opts) {
+    int regressions = 0;
+    int compared = 0;
+
+    printf("%-48s %12s %12s %8s %12s %12s %8s\n", "case", "base MB/s", "MB/s", "delta", "base ns", "ns", "delta");
+    for (size_t i = 0; i < baseline->n_cases; i++) {
+        const bench_case* b = &baseline->cases[i];
+        const bench_case* c = find_case(current, b->key);
+        if (!c) {
+            printf("%-48s missing from current results\n", b->key);
+            continue;
+        }
+        compared++;
+
+        const double throughput_delta = percent_change(b->mb_per_s, c->mb_per_s);
+        const double latency_delta = percent_change(b->latency_ns, c->latency_ns);
+        const bool throughput_bad = throughput_delta < -opts->throughput_tolerance;
+        const bool latency_checked = b->latency_ns >= opts->latency_floor_ns;
+        const bool latency_bad = latency_checked && latency_delta > opts->latency_tolerance;
+
+        printf("%-48s %12.2f %12.2f %+7.1f%% %12.0f %12.0f ", b->key, b->mb_per_s, c->mb_per_s, throughput_delta,
+               b->latency_ns, c->latency_ns);
+        if (latency_checked) {
+            printf("%+7.1f%%", latency_delta);
+        } else {
+            printf("%8s", "-");
+        }
+        if (throughput_bad || latency_bad) {
+            printf("  REGRESSION");
+            regressions++;
+        }
+        printf("\n");
+    }
+    for (size_t i = 0; i < current->n_cases; i++) {
+        if (!find_case(baseline, current->cases[i].key)) {
+            printf("%-48s not in baseline\n", current->cases[i].key);
+        }
+    }
+
+    printf("\n%d cases compared, %d regressed (tolerances: throughput -%.1f%%, %s +%.1f%% above %.0f ns)\n",
+           compared, regressions, opts->throughput_tolerance, opts->latency_metric, opts->latency_tolerance,
+           opts->latency_floor_ns);
+    return regressions;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "Usage: %s <baseline.json> <current.json> [options]\n", argv0);
+    fprintf(stderr, "  --throughput-tolerance PCT   allowed MB/s drop (default: 10)\n");
+    fprintf(stderr, "  --latency-tolerance PCT      allowed latency rise (default: 25)\n");
+    fprintf(stderr, "  --latency-metric NAME        p50, p99 or p999 (default: p50)\n");
+    fprintf(stderr, "  --latency-floor NS           skip latency checks for faster cases (default: 500)\n");
+    fprintf(stderr, "Exit status: 0 within tolerance, 1 regression, 2 bad input\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    compare_options opts;
+    opts.throughput_tolerance = 10.0;
+    opts.latency_tolerance = 25.0;
+    opts.latency_floor_ns = 500.0;
+    opts.latency_metric = "p50_ns";
+
+    for (int i = 3; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        char* end = NULL;
+        int bad = value == NULL;
+        if (!bad && strcmp(arg, "--throughput-tolerance") == 0) {
+            opts.throughput_tolerance = strtod(value, &end);
+        } else if (!bad && strcmp(arg, "--latency-tolerance") == 0) {
+            opts.latency_tolerance = strtod(value, &end);
+        } else if (!bad && strcmp(arg, "--latency-floor") == 0) {
+            opts.latency_floor_ns = strtod(value, &end);
+        } else if (!bad && strcmp(arg, "--latency-metric") == 0) {
+            if (strcmp(value, "p50") == 0) {
+                opts.latency_metric = "p50_ns";
+            } else if (strcmp(value, "p99") == 0) {
+                opts.latency_metric = "p99_ns";
+            } else if (strcmp(value, "p999") == 0) {
+                opts.latency_metric = "p999_ns";
+            } else {
+                bad = 1;
+            }
+        } else {
+            bad = 1;
+        }
+        if (!bad && end && (end == value || *end != '\0' || strtod(value, NULL) < 0)) {
+            bad = 1;
+        }
+        if (bad) {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+
+    static bench_file baseline;
+    static bench_file current;
+    if (parse_bench_file(argv[1], opts.latency_metric, &baseline) != 0 ||
+        parse_bench_file(argv[2], opts.latency_metric, &current) != 0) {
+        return 2;
+    }
+    if (baseline.vocab_size != current.vocab_size || baseline.native_kernel != current.native_kernel) {
+        fprintf(stderr, "Warning: baseline and current runs used different vocabs or kernels "
+                        "(vocab_size %d vs %d, native %d vs %d)\n",
+                baseline.vocab_size, current.vocab_size, baseline.native_kernel, current.native_kernel);
+    }
+
+    return compare(&baseline, &current, &opts) > 0 ? 1 : 0;
+}
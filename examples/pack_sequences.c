@@ -0,0 +1,295 @@
+#include "llama_tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Pack documents into fixed-length training sequences
+//
+// Reads documents from files (or stdin), tokenizes them in batches on a
+// thread pool and writes <prefix>-NNNNN.bin/.idx shards; see the
+// llama_tokenizer_packer_* functions for the file layout.
+
+#define READ_BLOCK ((size_t)16 << 20)
+
+typedef enum {
+    FORMAT_LINES,   // one document per line
+    FORMAT_NUL,     // documents separated by NUL bytes
+    FORMAT_FILE,    // each input file is one document
+} input_format;
+
+typedef struct {
+    llama_tokenizer_packer_t* packer;
+    int32_t batch_size;
+    const char** texts;
+    int32_t* lens;
+    int32_t n;
+    int failed;
+} doc_batch;
+
+static void print_usage(const char* program) {
+    printf("Usage: %s <model.gguf> <output_prefix> [options] [input files...]\n", program);
+    printf("\n");
+    printf("Reads stdin when no input file is given.\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  --seq-len N        tokens per sequence (default: 2048)\n");
+    printf("  --shard-seqs N     sequences per shard (default: 32768)\n");
+    printf("  --threads N        tokenizer threads (default: all CPUs)\n");
+    printf("  --batch N          documents per tokenize batch (default: 4096)\n");
+    printf("  --format F         lines, nul or file (default: lines)\n");
+    printf("  --token-bytes N    2 or 4 (default: 2 when the vocab fits)\n");
+    printf("  --no-separator     nothing between documents unless the vocab adds EOS\n");
+    printf("  --drop-partial     drop the last sequence instead of padding it\n");
+    printf("\n");
+    printf("Example:\n");
+    printf("  %s model.gguf shards/train --seq-len 4096 corpus-*.txt\n", program);
+    printf("\n");
+}
+
+// Tokenize and pack what is queued; the documents' memory may be reused after
+static void flush_batch(doc_batch* b) {
+    if (b->n > 0 && !b->failed &&
+        llama_tokenizer_packer_add(b->packer, b->texts, b->lens, b->n) != 0) {
+        fprintf(stderr, "Error: packing failed (write error?)\n");
+        b->failed = 1;
+    }
+    b->n = 0;
+}
+
+// Queue one document; the caller must flush before its memory changes
+static void add_doc(doc_batch* b, const char* text, size_t len) {
+    if (len == 0 || len > INT32_MAX) {
+        return;
+    }
+    b->texts[b->n] = text;
+    b->lens[b->n] = (int32_t)len;
+    b->n++;
+}
+
+// Split a stream on a delimiter, carrying the unfinished document from
+// one read to the next
+static int pack_stream(doc_batch* b, FILE* f, char delimiter) {
+    size_t capacity = READ_BLOCK;
+    char* buffer = malloc(capacity);
+    size_t carry = 0;
+    if (!buffer) {
+        return -1;
+    }
+    for (;;) {
+        if (capacity - carry < READ_BLOCK / 2) {
+            // A single document longer than the buffer: grow it
+            char* grown = realloc(buffer, capacity * 2);
+            if (!grown) {
+                free(buffer);
+                return -1;
+            }
+            buffer = grown;
+            capacity *= 2;
+        }
+        const size_t got = fread(buffer + carry, 1, capacity - carry, f);
+        const size_t end = carry + got;
+        size_t start = 0;
+        for (size_t i = 0; i < end; i++) {
+            if (buffer[i] == delimiter) {
+                add_doc(b, buffer + start, i - start);
+                start = i + 1;
+                if (b->n == b->batch_size) {
+                    flush_batch(b);
+                }
+            }
+        }
+        if (got == 0) {
+            add_doc(b, buffer + start, end - start);
+            flush_batch(b);
+            break;
+        }
+        // Documents point into the buffer, so pack them before moving the tail
+        flush_batch(b);
+        carry = end - start;
+        memmove(buffer, buffer + start, carry);
+    }
+    const int read_error = ferror(f);
+    free(buffer);
+    return read_error || b->failed ? -1 : 0;
+}
+
+// Whole file as one document, kept until the batch is packed
+static char* read_file(FILE* f, size_t* len) {
+    size_t capacity = READ_BLOCK;
+    size_t size = 0;
+    char* data = malloc(capacity);
+    while (data) {
+        size += fread(data + size, 1, capacity - size, f);
+        if (size < capacity) {
+            break;
+        }
+        char* grown = realloc(data, capacity * 2);
+        if (!grown) {
+            free(data);
+            return NULL;
+        }
+        data = grown;
+        capacity *= 2;
+    }
+    if (data && ferror(f)) {
+        free(data);
+        return NULL;
+    }
+    *len = size;
+    return data;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const char* model_path = argv[1];
+    const char* prefix = argv[2];
+    llama_tokenizer_packer_params params = llama_tokenizer_packer_default_params();
+    int32_t n_threads = 0;
+    int32_t batch_size = 4096;
+    input_format format = FORMAT_LINES;
+    int first_input = argc;
+
+    for (int i = 3; i < argc; i++) {
+        const char* arg = argv[i];
+        const int has_value = i + 1 < argc;
+        if (strcmp(arg, "--seq-len") == 0 && has_value) {
+            params.seq_len = atoi(argv[++i]);
+        } else if (strcmp(arg, "--shard-seqs") == 0 && has_value) {
+            params.shard_sequences = atoll(argv[++i]);
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            n_threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--batch") == 0 && has_value) {
+            batch_size = atoi(argv[++i]);
+        } else if (strcmp(arg, "--token-bytes") == 0 && has_value) {
+            params.token_bytes = atoi(argv[++i]);
+        } else if (strcmp(arg, "--format") == 0 && has_value) {
+            const char* name = argv[++i];
+            if (strcmp(name, "lines") == 0) {
+                format = FORMAT_LINES;
+            } else if (strcmp(name, "nul") == 0) {
+                format = FORMAT_NUL;
+            } else if (strcmp(name, "file") == 0) {
+                format = FORMAT_FILE;
+            } else {
+                fprintf(stderr, "Error: unknown format %s\n", name);
+                return 1;
+            }
+        } else if (strcmp(arg, "--no-separator") == 0) {
+            params.add_separator = false;
+        } else if (strcmp(arg, "--drop-partial") == 0) {
+            params.drop_partial = true;
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            fprintf(stderr, "Error: unknown option %s\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            first_input = i;
+            break;
+        }
+    }
+    if (batch_size <= 0 || params.seq_len <= 0 || params.shard_sequences <= 0) {
+        fprintf(stderr, "Error: --batch, --seq-len and --shard-seqs must be positive\n");
+        return 1;
+    }
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(model_path);
+    if (!tokenizer) {
+        fprintf(stderr, "Error: Failed to create tokenizer\n");
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+    llama_tokenizer_threadpool_params pool_params = llama_tokenizer_threadpool_default_params();
+    pool_params.n_threads = n_threads;
+    llama_tokenizer_threadpool_t* pool = llama_tokenizer_threadpool_create(&pool_params);
+    llama_tokenizer_packer_t* packer = pool ? llama_tokenizer_packer_create(tokenizer, pool, prefix, &params) : NULL;
+    doc_batch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.packer = packer;
+    batch.batch_size = batch_size;
+    batch.texts = malloc((size_t)batch_size * sizeof(const char*));
+    batch.lens = malloc((size_t)batch_size * sizeof(int32_t));
+    int status = 0;
+    if (!packer || !batch.texts || !batch.lens) {
+        fprintf(stderr, "Error: Failed to create the packer (check the options)\n");
+        status = 1;
+    }
+
+    const int n_inputs = first_input < argc ? argc - first_input : 1;
+    char** file_docs = status == 0 && format == FORMAT_FILE ? calloc((size_t)batch_size, sizeof(char*)) : NULL;
+    for (int k = 0; k < n_inputs && status == 0; k++) {
+        const char* path = first_input < argc ? argv[first_input + k] : NULL;
+        FILE* f = path ? fopen(path, "rb") : stdin;
+        if (!f) {
+            fprintf(stderr, "Error: cannot open %s\n", path);
+            status = 1;
+            break;
+        }
+        if (format == FORMAT_FILE) {
+            size_t len = 0;
+            char* doc = file_docs ? read_file(f, &len) : NULL;
+            if (!doc || len > INT32_MAX) {
+                fprintf(stderr, "Error: cannot read %s as one document\n", path ? path : "stdin");
+                free(doc);
+                status = 1;
+            } else if (len == 0) {
+                free(doc);
+            } else {
+                file_docs[batch.n] = doc;
+                add_doc(&batch, doc, len);
+            }
+            if (status == 0 && (batch.n == batch.batch_size || k + 1 == n_inputs)) {
+                flush_batch(&batch);
+                status = batch.failed;
+            }
+            if (batch.n == 0) {
+                for (int32_t d = 0; d < batch_size; d++) {
+                    free(file_docs[d]);
+                    file_docs[d] = NULL;
+                }
+            }
+        } else {
+            if (pack_stream(&batch, f, format == FORMAT_NUL ? '\0' : '\n') != 0) {
+                fprintf(stderr, "Error: packing %s failed\n", path ? path : "stdin");
+                status = 1;
+            }
+        }
+        if (path) {
+            fclose(f);
+        }
+    }
+
+    if (packer) {
+        if (llama_tokenizer_packer_finish(packer) != 0) {
+            fprintf(stderr, "Error: writing the shards failed\n");
+            status = 1;
+        }
+
+        llama_tokenizer_packer_stats stats;
+        llama_tokenizer_packer_get_stats(packer, &stats);
+        printf("Documents: %llu (%llu failed)\n", (unsigned long long)stats.documents,
+               (unsigned long long)stats.failed);
+        printf("Tokens:    %llu (+%llu padding)\n", (unsigned long long)stats.tokens,
+               (unsigned long long)stats.padding);
+        printf("Sequences: %llu of %d tokens in %llu shard(s) at %s-*.bin\n",
+               (unsigned long long)stats.sequences, params.seq_len, (unsigned long long)stats.shards, prefix);
+    }
+
+    for (int32_t d = 0; file_docs && d < batch_size; d++) {
+        free(file_docs[d]);
+    }
+    free(file_docs);
+    free(batch.texts);
+    free(batch.lens);
+    llama_tokenizer_packer_destroy(packer);
+    llama_tokenizer_threadpool_destroy(pool);
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+    return status;
+}
@@ -9,6 +9,24 @@
 extern "C" {
 #endif
 
+/**
+ * Thread safety
+ *
+ * A tokenizer handle is immutable once llama_tokenizer_create() returns.
+ * Every function taking a const llama_tokenizer_t* (tokenize, detokenize,
+ * token_to_piece and all metadata queries) may be called on one handle
+ * from any number of threads at once, without external locking; these
+ * calls take no locks. Scratch memory is per thread. The only handle
+ * state they write is the statistics counters, which are atomic.
+ *
+ * Not covered: llama_tokenizer_destroy() must not overlap any other call
+ * on the same handle, and the process-wide functions
+ * (llama_tokenizer_init, llama_tokenizer_free_backend and the log
+ * setters) must not overlap any other call. The trace functions may be
+ * called at any time. Output buffers belong to the caller and must not
+ * be shared by concurrent calls.
+ */
+
 /**
  * Opaque handle to a tokenizer instance
  */
@@ -34,12 +52,59 @@ typedef enum {
 
 /**
  * Set the logging level for tokenizer operations
- * Must be called before llama_tokenizer_init()
  *
- * @param level Desired log level
+ * Messages below the level are dropped; continuation lines
+ * (LLAMA_TOKENIZER_LOG_CONT) follow the message they continue. NONE or an
+ * invalid level drops everything, LLAMA_TOKENIZER_LOG_CONT passes
+ * everything. Until this or another log setter is called, llama.cpp
+ * writes all messages to stderr itself.
+ *
+ * @param level Lowest level delivered
  */
 void llama_tokenizer_set_log_level(llama_tokenizer_log_level level);
 
+/**
+ * Log callback
+ *
+ * Calls are serialized. Without the async sink it runs on the thread that
+ * logged, inside the library call; with it, on the sink's thread.
+ */
+typedef void (*llama_tokenizer_log_fn)(llama_tokenizer_log_level level, const char* text, void* user_data);
+
+/**
+ * Send messages that pass the level filter to a callback instead of stderr
+ *
+ * @param fn Callback, or NULL to restore stderr output
+ * @param user_data Passed to every call of fn
+ */
+void llama_tokenizer_set_log_callback(llama_tokenizer_log_fn fn, void* user_data);
+
+/**
+ * Deliver log messages from a background thread
+ *
+ * Messages that pass the level filter are copied into a lock-free queue
+ * and the logging thread returns at once; a background thread hands them
+ * to the callback or stderr. When the queue is full messages are dropped
+ * rather than waited for. Messages longer than 511 bytes are truncated.
+ *
+ * @param capacity Messages queued; 0 for the default of 1024
+ * @return true if the sink is running, false on allocation or thread failure
+ */
+bool llama_tokenizer_log_async_start(size_t capacity);
+
+/**
+ * Deliver the queued messages, stop the background thread and go back to
+ * delivering on the logging thread
+ */
+void llama_tokenizer_log_async_stop(void);
+
+/**
+ * Get the number of messages dropped because the async queue was full
+ *
+ * @return Messages dropped since the process started
+ */
+uint64_t llama_tokenizer_log_dropped(void);
+
 /**
  * Initialize the tokenizer backend
  * Must be called before any other tokenizer functions
@@ -127,9 +192,32 @@ float llama_tokenizer_token_get_score(const llama_tokenizer_t* tokenizer, llama_
 bool llama_tokenizer_should_add_bos(const llama_tokenizer_t* tokenizer);
 bool llama_tokenizer_should_add_eos(const llama_tokenizer_t* tokenizer);
 
+/**
+ * Validate UTF-8 text
+ *
+ * Overlong encodings, surrogates and code points above U+10FFFF are invalid.
+ * Pure-ASCII runs are skipped in bulk, so this is cheap for mostly-ASCII text.
+ *
+ * @param text Text to validate
+ * @param text_len Length of text in bytes
+ * @param error_offset Output: byte offset of the first invalid sequence,
+ *                     or -1 if the text is valid (can be NULL)
+ * @return true if text is valid UTF-8, false otherwise
+ */
+bool llama_tokenizer_validate_utf8(const char* text, int32_t text_len, int32_t* error_offset);
+
 /**
  * Tokenize text into tokens
  *
+ * Invalid UTF-8 sequences are replaced with U+FFFD before tokenization.
+ * Use llama_tokenizer_validate_utf8() to reject malformed input instead.
+ *
+ * Temporaries come from per-thread scratch buffers that are kept between
+ * calls, so on a handle for which llama_tokenizer_uses_native_kernel()
+ * is true a thread's calls stop allocating once it has seen inputs of
+ * the size it keeps seeing. Other vocab types go through llama.cpp,
+ * which allocates per call.
+ *
  * @param tokenizer Tokenizer handle
  * @param text Text to tokenize
  * @param text_len Length of text in bytes
@@ -149,6 +237,75 @@ int32_t llama_tokenizer_tokenize(
     bool parse_special
 );
 
+/**
+ * Check whether llama_tokenizer_tokenize() runs on the wrapper's own
+ * kernel for every flag combination, rather than on llama.cpp
+ *
+ * True for SentencePiece, unigram and WordPiece vocabs whose kernel
+ * passed the create-time comparison against llama.cpp.
+ *
+ * @param tokenizer Tokenizer handle
+ * @return true if tokenization never calls into llama.cpp
+ */
+bool llama_tokenizer_uses_native_kernel(const llama_tokenizer_t* tokenizer);
+
+/**
+ * Tokenize text with llama.cpp alone
+ *
+ * Same arguments, UTF-8 handling and result as llama_tokenizer_tokenize(),
+ * but the whole text goes to llama_tokenize(): no native kernel, no
+ * special-token scanner and no probed BOS/EOS affixes. Slower; meant for
+ * checking the fast paths against llama.cpp.
+ *
+ * @param tokenizer Tokenizer handle
+ * @param text Text to tokenize
+ * @param text_len Length of text in bytes
+ * @param tokens Output buffer for tokens (can be NULL to get count)
+ * @param n_max_tokens Maximum number of tokens to write
+ * @param add_special Whether to add special tokens
+ * @param parse_special Whether to parse special tokens in text
+ * @return Number of tokens, or negative on error
+ */
+int32_t llama_tokenizer_tokenize_reference(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens,
+    bool add_special,
+    bool parse_special
+);
+
+/**
+ * Estimate the token count of text without tokenizing it
+ *
+ * One vectorized pass over the bytes counts letters, digits,
+ * punctuation, whitespace and multi-byte characters, and their runs; a
+ * per-vocab model fitted at create time turns those into a count. Meant
+ * for admission control on inputs too large to count exactly.
+ *
+ * The bounds are the error range seen on a built-in multilingual
+ * calibration corpus, widened by 15%: reliable for ordinary prose, code
+ * and data, not guaranteed for unusual text (long runs of one character,
+ * random bytes). Special tokens in the text are estimated as plain text.
+ *
+ * @param tokenizer Tokenizer handle
+ * @param text Text to estimate; invalid UTF-8 is estimated as-is
+ * @param text_len Length of text in bytes
+ * @param add_special Include the BOS/EOS tokens tokenize would add
+ * @param lower Output: lower bound (can be NULL)
+ * @param upper Output: upper bound (can be NULL)
+ * @return Estimated token count, or -1 on error
+ */
+int32_t llama_tokenizer_estimate_count(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    bool add_special,
+    int32_t* lower,
+    int32_t* upper
+);
+
 /**
  * Convert a single token to text
  *
@@ -198,6 +355,1332 @@ int32_t llama_tokenizer_detokenize(
     bool unparse_special
 );
 
+/**
+ * Token healing
+ *
+ * A prompt that ends inside what the model would write as one token (say
+ * "http:" before "//") makes it continue from an unlikely split. Healing
+ * backs off the last tokens of the prompt and constrains generation to
+ * tokens that render the removed text again. These lookups use an index
+ * of every token's piece, as llama_tokenizer_token_to_piece() renders it,
+ * built on first use; tokens whose piece is empty never match.
+ */
+
+/**
+ * Tokens whose piece starts with the given bytes
+ *
+ * @param tokenizer Tokenizer handle
+ * @param text Bytes the pieces must start with (every token for length 0)
+ * @param text_len Length of text in bytes
+ * @param tokens Output buffer for tokens, in piece order (can be NULL to get count)
+ * @param n_max_tokens Maximum number of tokens to write
+ * @return Number of tokens, negative of it if the buffer is too small, or
+ *         -1 on invalid arguments
+ */
+int32_t llama_tokenizer_tokens_with_prefix(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens
+);
+
+/**
+ * Tokens whose piece the given bytes start with
+ *
+ * @param tokenizer Tokenizer handle
+ * @param text Bytes that must start with the pieces
+ * @param text_len Length of text in bytes
+ * @param tokens Output buffer for tokens, shortest piece first (can be NULL to get count)
+ * @param n_max_tokens Maximum number of tokens to write
+ * @return Number of tokens, negative of it if the buffer is too small, or
+ *         -1 on invalid arguments
+ */
+int32_t llama_tokenizer_tokens_prefix_of(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens
+);
+
+/**
+ * Back off the end of a prompt for token healing
+ *
+ * Removes up to n_back tokens from the end of the prompt, stopping early
+ * at a token with an empty piece (a control token), and gives the tokens
+ * allowed to come first: those whose piece starts with the removed text,
+ * and those whose piece is a shorter prefix of it. After generating one
+ * of the latter, continue with llama_tokenizer_tokens_with_prefix() and
+ * llama_tokenizer_tokens_prefix_of() on the text still to cover.
+ *
+ * @param tokenizer Tokenizer handle
+ * @param prompt Prompt tokens
+ * @param n_prompt Number of prompt tokens
+ * @param n_back Number of tokens to back off
+ * @param n_kept Receives the number of prompt tokens to keep (can be NULL)
+ * @param tokens Output buffer for the allowed tokens: shorter prefixes
+ *        shortest first, then the rest in piece order (can be NULL to get count)
+ * @param n_max_tokens Maximum number of tokens to write
+ * @return Number of allowed tokens, negative of it if the buffer is too
+ *         small, or -1 on invalid arguments or an invalid prompt token
+ */
+int32_t llama_tokenizer_heal_tokens(
+    const llama_tokenizer_t* tokenizer,
+    const llama_token* prompt,
+    int32_t n_prompt,
+    int32_t n_back,
+    int32_t* n_kept,
+    llama_token* tokens,
+    int32_t n_max_tokens
+);
+
+/**
+ * Chat prompts
+ *
+ * llama_tokenizer_tokenize_chat() applies a chat template and tokenizes
+ * the result in one call. Special tokens are parsed in the template's own
+ * text only: a message that contains the text of a control token (say
+ * "<|im_end|>") gets that text tokenized, not the token. Message contents
+ * are never rendered through llama.cpp; they are spliced into the
+ * template's scaffolding directly.
+ *
+ * For a conversation that grows turn by turn, pass a chat cache: tokens
+ * of the part of the prompt unchanged since the previous call on the same
+ * cache are reused instead of tokenized again.
+ */
+typedef struct {
+    const char* role;           // "system", "user", "assistant", ...
+    const char* content;
+} llama_tokenizer_chat_message;
+
+typedef struct llama_tokenizer_chat_cache_t llama_tokenizer_chat_cache_t;
+
+typedef struct {
+    const char* chat_template;  // NULL for the model's own template (ChatML if it has none); else a
+                                // built-in template name such as "chatml" or "llama3", or template text
+    bool add_assistant;         // end with the opening of an assistant turn
+    bool add_special;           // add BOS/EOS as llama_tokenizer_tokenize() does
+    bool parse_special_content; // also parse special tokens inside message contents
+} llama_tokenizer_chat_params;
+
+/**
+ * Default chat parameters: the model's template, assistant turn opened,
+ * BOS/EOS added, special tokens in contents kept as text
+ */
+llama_tokenizer_chat_params llama_tokenizer_chat_default_params(void);
+
+/**
+ * Apply a chat template
+ *
+ * Returns the text llama_tokenizer_tokenize_chat() tokenizes, for logging
+ * and debugging. Contents that the template trims are trimmed; invalid
+ * UTF-8 is replaced with U+FFFD.
+ *
+ * @param tokenizer Tokenizer handle
+ * @param messages Messages in conversation order
+ * @param n_messages Number of messages
+ * @param params Chat parameters (NULL for defaults)
+ * @param buf Output buffer (can be NULL to get the length)
+ * @param length Size of buf; the text is NUL-terminated when it fits with the terminator
+ * @return Length of the text, negative of it if buf is too small, or -1
+ *         on invalid arguments or a template llama.cpp does not support
+ */
+int32_t llama_tokenizer_apply_chat_template(
+    const llama_tokenizer_t* tokenizer,
+    const llama_tokenizer_chat_message* messages,
+    int32_t n_messages,
+    const llama_tokenizer_chat_params* params,
+    char* buf,
+    int32_t length
+);
+
+/**
+ * Apply a chat template and tokenize the prompt
+ *
+ * Gives the tokens llama_tokenizer_tokenize() gives for the text of
+ * llama_tokenizer_apply_chat_template() with parse_special set, except
+ * that special tokens inside message contents stay text unless
+ * params->parse_special_content is set.
+ *
+ * @param tokenizer Tokenizer handle
+ * @param messages Messages in conversation order
+ * @param n_messages Number of messages
+ * @param params Chat parameters (NULL for defaults)
+ * @param cache Cache created for this tokenizer, or NULL
+ * @param tokens Output buffer for tokens (can be NULL to get count)
+ * @param n_max_tokens Maximum number of tokens to write
+ * @return Number of tokens, negative of it if the buffer is too small, or
+ *         -1 on invalid arguments, a template llama.cpp does not support,
+ *         or add_special on a vocab whose BOS/EOS placement could not be
+ *         determined
+ */
+int32_t llama_tokenizer_tokenize_chat(
+    const llama_tokenizer_t* tokenizer,
+    const llama_tokenizer_chat_message* messages,
+    int32_t n_messages,
+    const llama_tokenizer_chat_params* params,
+    llama_tokenizer_chat_cache_t* cache,
+    llama_token* tokens,
+    int32_t n_max_tokens
+);
+
+/**
+ * Create a chat cache
+ *
+ * A cache holds the last prompt tokenized with it and its tokens, and
+ * must be used with the tokenizer it was created for. Keep one per
+ * conversation; calls on one cache must not overlap.
+ *
+ * @param tokenizer Tokenizer handle (must outlive the cache)
+ * @return Cache handle, or NULL on failure
+ */
+llama_tokenizer_chat_cache_t* llama_tokenizer_chat_cache_create(const llama_tokenizer_t* tokenizer);
+
+/**
+ * Number of tokens the last llama_tokenizer_tokenize_chat() call on the
+ * cache took from it rather than tokenizing
+ *
+ * @param cache Cache handle
+ * @return Reused tokens, or -1 if cache is NULL
+ */
+int32_t llama_tokenizer_chat_cache_reused(const llama_tokenizer_chat_cache_t* cache);
+
+/**
+ * Free a chat cache
+ *
+ * @param cache Cache handle to free
+ */
+void llama_tokenizer_chat_cache_free(llama_tokenizer_chat_cache_t* cache);
+
+/**
+ * Fill-in-the-middle prompts
+ *
+ * llama_tokenizer_tokenize_fim() builds the FIM prompt for a completion
+ * at a cursor from the text before it (prefix) and after it (suffix),
+ * keeping the prefix tokens nearest the cursor and the suffix tokens
+ * nearest the cursor that fit a token budget. Only the text near the
+ * cursor is tokenized, so the cost follows the budget rather than the
+ * file size.
+ */
+typedef struct {
+    float suffix_share;         // part of the budget for the suffix when both sides overflow
+    bool suffix_first;          // suffix-prefix-middle (SPM) order instead of prefix-suffix-middle
+    bool add_special;           // start with BOS when the vocab adds it
+    bool parse_special;         // parse special tokens in the prefix and suffix
+} llama_tokenizer_fim_params;
+
+typedef struct {
+    int32_t n_prefix_tokens;    // prefix tokens kept
+    int32_t n_suffix_tokens;    // suffix tokens kept
+    bool prefix_truncated;      // prefix tokens were dropped on the left
+    bool suffix_truncated;      // suffix tokens were dropped on the right
+} llama_tokenizer_fim_info;
+
+/**
+ * Default FIM parameters: a quarter of the budget for the suffix, PSM
+ * order, BOS added, special tokens not parsed
+ */
+llama_tokenizer_fim_params llama_tokenizer_fim_default_params(void);
+
+/**
+ * Tokenize a fill-in-the-middle prompt within a token budget
+ *
+ * The result is [BOS] FIM_PRE prefix FIM_SUF suffix FIM_MID, or
+ * [BOS] FIM_SUF suffix FIM_PRE prefix FIM_MID with suffix_first. The
+ * prefix loses tokens from the left and the suffix from the right until
+ * the whole fits n_max_tokens; a side needing less than its share leaves
+ * the rest to the other. Kept tokens are those llama_tokenizer_tokenize()
+ * gives for the whole side without special tokens added, except at most
+ * a few where the text was cut inside one very long pre-token.
+ *
+ * @param tokenizer Tokenizer handle
+ * @param prefix Text before the cursor
+ * @param prefix_len Length of prefix in bytes
+ * @param suffix Text after the cursor
+ * @param suffix_len Length of suffix in bytes
+ * @param params FIM parameters (NULL for defaults)
+ * @param tokens Output buffer for tokens (can be NULL to get count)
+ * @param n_max_tokens Token budget, and size of tokens
+ * @param info Receives what was kept (can be NULL)
+ * @return Number of tokens, or -1 on invalid arguments, a vocab without
+ *         FIM tokens, a budget too small for the special tokens, or
+ *         add_special on a vocab whose BOS placement could not be
+ *         determined
+ */
+int32_t llama_tokenizer_tokenize_fim(
+    const llama_tokenizer_t* tokenizer,
+    const char* prefix,
+    int32_t prefix_len,
+    const char* suffix,
+    int32_t suffix_len,
+    const llama_tokenizer_fim_params* params,
+    llama_token* tokens,
+    int32_t n_max_tokens,
+    llama_tokenizer_fim_info* info
+);
+
+/**
+ * Thread pool shared by the parallel entry points
+ *
+ * One pool can serve any number of tokenizer handles and concurrent
+ * callers; a calling thread always takes part in its own work. Create it
+ * once and reuse it: no call spawns threads of its own.
+ */
+typedef struct llama_tokenizer_threadpool_t llama_tokenizer_threadpool_t;
+
+/**
+ * Unit of work handed to an external executor
+ */
+typedef void (*llama_tokenizer_task_fn)(void* arg);
+
+/**
+ * External executor: must eventually call task(arg) exactly once, on any
+ * thread (including the calling one). Tasks may block briefly on one
+ * another, so the executor must not run them all on a single thread that
+ * is also waiting for the call that submitted them.
+ */
+typedef void (*llama_tokenizer_executor_fn)(llama_tokenizer_task_fn task, void* arg, void* user_data);
+
+typedef struct {
+    int32_t n_threads;          // worker threads (or executor tasks per call); 0 = one per hardware thread
+    const int32_t* cpus;        // pin worker i to cpus[i % n_cpus]; NULL for no pinning
+    int32_t n_cpus;
+    int32_t numa_node;          // if cpus is NULL, keep workers on this node's CPUs; -1 for any
+    llama_tokenizer_executor_fn executor;  // if set, no threads are created and tasks go here
+    void* executor_user_data;
+} llama_tokenizer_threadpool_params;
+
+/**
+ * Default pool parameters: one worker per hardware thread, no pinning
+ */
+llama_tokenizer_threadpool_params llama_tokenizer_threadpool_default_params(void);
+
+/**
+ * Create a thread pool
+ *
+ * CPU and NUMA pinning are best effort and only supported on Linux.
+ *
+ * @param params Pool parameters (NULL for defaults)
+ * @return Pool handle, or NULL on failure
+ */
+llama_tokenizer_threadpool_t* llama_tokenizer_threadpool_create(const llama_tokenizer_threadpool_params* params);
+
+/**
+ * Stop the workers and free the pool
+ * No call using the pool may be in progress
+ *
+ * @param pool Pool handle to free
+ */
+void llama_tokenizer_threadpool_destroy(llama_tokenizer_threadpool_t* pool);
+
+/**
+ * Get the pool's degree of parallelism, not counting calling threads
+ *
+ * @param pool Pool handle
+ * @return Number of workers (or executor tasks per call), or -1 on error
+ */
+int32_t llama_tokenizer_threadpool_n_threads(const llama_tokenizer_threadpool_t* pool);
+
+/**
+ * Tokenize many texts in parallel
+ *
+ * Each text is tokenized exactly as llama_tokenizer_tokenize() would, into
+ * its own buffer, and its result (count, or negative required size) is
+ * stored in n_tokens[i].
+ *
+ * @param tokenizer Tokenizer handle
+ * @param pool Thread pool, or NULL to run on the calling thread
+ * @param texts Texts to tokenize
+ * @param text_lens Length of each text in bytes
+ * @param n_texts Number of texts
+ * @param tokens Output buffer per text (NULL, or NULL entries, to count only)
+ * @param n_max_tokens Capacity of each output buffer (NULL when tokens is NULL)
+ * @param n_tokens Output: per-text result
+ * @param add_special Whether to add special tokens
+ * @param parse_special Whether to parse special tokens in text
+ * @return 0 on success, -1 on invalid arguments
+ */
+int32_t llama_tokenizer_tokenize_batch(
+    const llama_tokenizer_t* tokenizer,
+    llama_tokenizer_threadpool_t* pool,
+    const char* const* texts,
+    const int32_t* text_lens,
+    int32_t n_texts,
+    llama_token* const* tokens,
+    const int32_t* n_max_tokens,
+    int32_t* n_tokens,
+    bool add_special,
+    bool parse_special
+);
+
+/**
+ * Count the tokens of one text under several tokenizers in parallel
+ *
+ * Each count is the one llama_tokenizer_tokenize() returns with a NULL
+ * buffer, but the UTF-8 pre-scan (and the replacement of invalid
+ * sequences) runs once for all handles, and each handle's count runs as
+ * its own task on the pool. Texts too short to repay handing work to
+ * the pool are counted on the calling thread.
+ *
+ * @param tokenizers Tokenizer handles, e.g. one per candidate model
+ * @param n_tokenizers Number of handles
+ * @param pool Thread pool, or NULL to run on the calling thread
+ * @param text Text to count
+ * @param text_len Length of text in bytes
+ * @param counts Output: per-handle token count, or negative on error
+ * @param add_special Whether to add special tokens
+ * @param parse_special Whether to parse special tokens in text
+ * @return 0 on success, -1 on invalid arguments
+ */
+int32_t llama_tokenizer_count_multi(
+    const llama_tokenizer_t* const* tokenizers,
+    int32_t n_tokenizers,
+    llama_tokenizer_threadpool_t* pool,
+    const char* text,
+    int32_t text_len,
+    int32_t* counts,
+    bool add_special,
+    bool parse_special
+);
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+// Arrow C Data Interface, as published by the Arrow project
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+/**
+ * Batch result in CSR layout
+ *
+ * The tokens of every text back to back in one buffer, plus n_texts + 1
+ * offsets: text i is tokens[offsets[i], offsets[i + 1]). A text that
+ * failed to tokenize is empty and marked null in the validity bitmap.
+ * The buffers are 64-byte aligned and laid out as an Arrow array, so
+ * they can be exported without copying.
+ */
+typedef struct llama_tokenizer_csr_t llama_tokenizer_csr_t;
+
+typedef struct {
+    const llama_token* tokens;  // n_tokens entries
+    const int64_t* offsets;     // n_texts + 1 entries, starting at 0
+    const uint8_t* validity;    // bit i (LSB first) set if text i tokenized; NULL if all did
+    int64_t n_texts;
+    int64_t n_tokens;
+    int64_t n_failed;           // texts marked null
+} llama_tokenizer_csr_view;
+
+/**
+ * Tokenize many texts in parallel into one CSR result
+ *
+ * Each text is tokenized exactly as llama_tokenizer_tokenize() would.
+ * Workers fill their own buffers, sized from the count estimate, and each
+ * is copied once into the final buffer; a batch run as one piece (no
+ * pool, or few texts) is not copied at all.
+ *
+ * @param tokenizer Tokenizer handle
+ * @param pool Thread pool, or NULL to run on the calling thread
+ * @param texts Texts to tokenize
+ * @param text_lens Length of each text in bytes
+ * @param n_texts Number of texts
+ * @param add_special Whether to add special tokens
+ * @param parse_special Whether to parse special tokens in text
+ * @return Result handle (free with llama_tokenizer_csr_free), or NULL on
+ *         invalid arguments or allocation failure
+ */
+llama_tokenizer_csr_t* llama_tokenizer_tokenize_batch_csr(
+    const llama_tokenizer_t* tokenizer,
+    llama_tokenizer_threadpool_t* pool,
+    const char* const* texts,
+    const int32_t* text_lens,
+    int32_t n_texts,
+    bool add_special,
+    bool parse_special
+);
+
+/**
+ * Get the buffers of a CSR result
+ * They stay valid until the handle is freed
+ *
+ * @param csr Result handle
+ * @param view Output: buffer pointers and sizes
+ * @return true on success, false on invalid arguments
+ */
+bool llama_tokenizer_csr_get(const llama_tokenizer_csr_t* csr, llama_tokenizer_csr_view* view);
+
+/**
+ * Export a CSR result as an Arrow LargeList<Int32> array
+ *
+ * Zero-copy: the array points at the result's buffers and keeps them
+ * alive until its release callback runs, so the handle may be freed
+ * first. The schema is format "+L" (list with int64 offsets) named
+ * "tokens", with a non-nullable "item" child of format "i". Both structs
+ * belong to the caller and must be released through their callbacks.
+ *
+ * @param csr Result handle
+ * @param array Output: Arrow array
+ * @param schema Output: Arrow schema (can be NULL)
+ * @return true on success, false on invalid arguments or allocation failure
+ */
+bool llama_tokenizer_csr_export_arrow(
+    const llama_tokenizer_csr_t* csr,
+    struct ArrowArray* array,
+    struct ArrowSchema* schema
+);
+
+/**
+ * Free a CSR result
+ * Exported Arrow arrays stay valid
+ *
+ * @param csr Result handle to free
+ */
+void llama_tokenizer_csr_free(llama_tokenizer_csr_t* csr);
+
+/**
+ * Layout of a padded token matrix
+ */
+typedef struct {
+    int32_t max_len;            // columns; longer rows are truncated, keeping a closing EOS/SEP
+    bool pad_left;              // pad before the tokens instead of after
+    bool pad_to_longest;        // row stride is the longest row instead of max_len
+    bool sort_by_length;        // rows longest first; row_order maps rows back to texts
+    llama_token pad_token;      // -1 for llama_tokenizer_token_pad(), else EOS, else 0
+    bool add_special;           // whether to add special tokens
+    bool parse_special;         // whether to parse special tokens in text
+} llama_tokenizer_pad_params;
+
+/**
+ * Default layout: 512 columns, right padding, the vocab's pad token,
+ * special tokens added but not parsed
+ */
+llama_tokenizer_pad_params llama_tokenizer_pad_default_params(void);
+
+/**
+ * Tokenize many texts in parallel into a padded token matrix
+ *
+ * Row r of the row-major matrix is a text tokenized as
+ * llama_tokenizer_tokenize() would, truncated to max_len and padded to
+ * the row stride. Rows go straight into the caller's buffer; only rows
+ * longer than max_len pass through scratch memory.
+ *
+ * With sort_by_length, row r holds text row_order[r]. Its rows are
+ * longest first, so rows [a, b) fit in lengths[a] columns: a caller can
+ * slice the matrix into buckets with little padding.
+ *
+ * @param tokenizer Tokenizer handle
+ * @param pool Thread pool, or NULL to run on the calling thread
+ * @param texts Texts to tokenize
+ * @param text_lens Length of each text in bytes
+ * @param n_texts Number of texts (rows)
+ * @param params Matrix layout (NULL for defaults)
+ * @param tokens Output: n_texts * max_len tokens; only n_texts * stride are written
+ * @param attention_mask Output: 1 for tokens, 0 for padding, same shape as tokens (can be NULL)
+ * @param lengths Output: tokens in each row (can be NULL)
+ * @param row_order Output: text held by each row (can be NULL unless sort_by_length)
+ * @return Row stride (max_len, or the longest row with pad_to_longest),
+ *         or -1 on invalid arguments or if a text fails to tokenize
+ */
+int32_t llama_tokenizer_tokenize_padded(
+    const llama_tokenizer_t* tokenizer,
+    llama_tokenizer_threadpool_t* pool,
+    const char* const* texts,
+    const int32_t* text_lens,
+    int32_t n_texts,
+    const llama_tokenizer_pad_params* params,
+    llama_token* tokens,
+    uint8_t* attention_mask,
+    int32_t* lengths,
+    int32_t* row_order
+);
+
+/**
+ * Sequence packer for training shards
+ *
+ * Streams documents into fixed-length sequences. Each batch of documents
+ * is tokenized in parallel without special tokens; every document then
+ * gets BOS in front if llama_tokenizer_should_add_bos() and EOS after it
+ * if llama_tokenizer_should_add_eos(), or else the separator, and the
+ * documents are concatenated and cut every seq_len tokens, so documents
+ * run across sequence boundaries. Writes happen on the packer's own
+ * thread and overlap tokenizing the next batch.
+ *
+ * Output is shards <prefix>-00000.bin, -00001.bin, ... of
+ * shard_sequences sequences each (the last may hold fewer): seq_len
+ * unsigned tokens of token_bytes per sequence, in native byte order
+ * (little-endian on every supported target). Beside each is
+ * <prefix>-NNNNN.idx with the document boundaries:
+ *
+ *   llama_tokenizer_pack_index_header
+ *   uint64_t sequence_segments[n_sequences + 1]
+ *   llama_tokenizer_pack_segment segments[n_segments]
+ *
+ * where the segments of sequence s are
+ * segments[sequence_segments[s], sequence_segments[s + 1]).
+ */
+typedef struct llama_tokenizer_packer_t llama_tokenizer_packer_t;
+
+#define LLAMA_TOKENIZER_PACK_MAGIC "LTPACK01"
+
+typedef struct {
+    char magic[8];              // LLAMA_TOKENIZER_PACK_MAGIC, not NUL-terminated
+    uint32_t version;           // 1
+    uint32_t token_bytes;       // 2 or 4
+    uint32_t seq_len;
+    uint32_t reserved;
+    uint64_t n_sequences;
+    uint64_t n_segments;
+} llama_tokenizer_pack_index_header;
+
+/**
+ * Part of one document inside one sequence
+ */
+typedef struct {
+    int64_t doc_id;             // document index, counting from 0 across all adds
+    int64_t doc_offset;         // position of the segment's first token in the document
+    int32_t start;              // position of that token in the sequence
+    int32_t length;             // tokens
+} llama_tokenizer_pack_segment;
+
+typedef struct {
+    int32_t seq_len;            // tokens per sequence
+    int64_t shard_sequences;    // sequences per shard
+    int32_t token_bytes;        // 2 or 4; 0 for 2 when every token id fits in 16 bits
+    bool add_separator;         // append separator after documents that get no EOS
+    llama_token separator;      // -1 for the EOS token
+    llama_token pad_token;      // pads the last sequence; -1 for llama_tokenizer_token_pad(), else EOS, else 0
+    bool drop_partial;          // drop the last sequence instead of padding it
+    bool parse_special;         // whether to parse special tokens in documents
+} llama_tokenizer_packer_params;
+
+typedef struct {
+    uint64_t documents;         // documents added, including failed ones
+    uint64_t failed;            // documents that failed to tokenize and were skipped
+    uint64_t tokens;            // tokens packed, including BOS, EOS and separators
+    uint64_t padding;           // pad tokens after the last document
+    uint64_t sequences;         // sequences packed
+    uint64_t shards;            // shards started
+} llama_tokenizer_packer_stats;
+
+/**
+ * Default packer parameters: 2048-token sequences, 32768 per shard,
+ * automatic token width, EOS as separator, last sequence padded
+ */
+llama_tokenizer_packer_params llama_tokenizer_packer_default_params(void);
+
+/**
+ * Create a sequence packer
+ *
+ * @param tokenizer Tokenizer handle (must outlive the packer)
+ * @param pool Thread pool to tokenize on (must outlive the packer), or NULL
+ * @param output_prefix Path prefix of the shard files
+ * @param params Packer parameters (NULL for defaults)
+ * @return Packer handle, or NULL on invalid arguments (including a
+ *         separator or pad id that does not fit 2-byte tokens) or failure
+ */
+llama_tokenizer_packer_t* llama_tokenizer_packer_create(
+    const llama_tokenizer_t* tokenizer,
+    llama_tokenizer_threadpool_t* pool,
+    const char* output_prefix,
+    const llama_tokenizer_packer_params* params
+);
+
+/**
+ * Tokenize and pack a batch of documents
+ *
+ * Larger batches keep the pool busier; a few thousand documents is
+ * plenty. Calls on one packer must not overlap.
+ *
+ * @param packer Packer handle
+ * @param texts Documents
+ * @param text_lens Length of each document in bytes
+ * @param n_texts Number of documents
+ * @return 0 on success, -1 on invalid arguments, a failed write, out of
+ *         memory or after llama_tokenizer_packer_finish(). After a failed
+ *         write or allocation every later add fails too
+ */
+int32_t llama_tokenizer_packer_add(
+    llama_tokenizer_packer_t* packer,
+    const char* const* texts,
+    const int32_t* text_lens,
+    int32_t n_texts
+);
+
+/**
+ * Pad or drop the last sequence, write the last index and wait for all
+ * writes to reach the files
+ *
+ * @param packer Packer handle
+ * @return 0 if every write and allocation succeeded, -1 otherwise
+ */
+int32_t llama_tokenizer_packer_finish(llama_tokenizer_packer_t* packer);
+
+/**
+ * Get packing totals so far
+ *
+ * @param packer Packer handle
+ * @param stats Output: totals
+ * @return true on success, false on invalid arguments
+ */
+bool llama_tokenizer_packer_get_stats(const llama_tokenizer_packer_t* packer, llama_tokenizer_packer_stats* stats);
+
+/**
+ * Free a packer, finishing it first if needed
+ *
+ * @param packer Packer handle to free
+ */
+void llama_tokenizer_packer_destroy(llama_tokenizer_packer_t* packer);
+
+/**
+ * Constrained decoding
+ *
+ * A grammar compiles a regular expression, or a JSON schema, against
+ * the vocab into an automaton over tokens. Every state carries the
+ * bitset of tokens allowed next, computed once at compile time, so a
+ * sampler masks logits with n_vocab / 64 word operations per step and
+ * follows the chosen token with llama_tokenizer_grammar_advance().
+ * Generation starts in state 0. End-of-generation tokens are allowed in
+ * accepting states only; every state still has a way to accept.
+ *
+ * Regex syntax: literals, '.', classes, \d \w \s and their negations,
+ * \xHH \uHHHH escapes, groups, '|', and * + ? {n,m}; the whole output
+ * must match. JSON schemas may use type, enum, const, anyOf/oneOf,
+ * properties/required, items/minItems/maxItems and
+ * minLength/maxLength/pattern; output is compact JSON with properties
+ * in schema order. Anything else is rejected with a message.
+ */
+typedef struct llama_tokenizer_grammar_t llama_tokenizer_grammar_t;
+
+typedef struct {
+    int32_t max_states;         // compiling fails above this many states; each costs n_vocab / 8 bytes
+} llama_tokenizer_grammar_params;
+
+/**
+ * Default grammar parameters: at most 1024 states
+ */
+llama_tokenizer_grammar_params llama_tokenizer_grammar_default_params(void);
+
+/**
+ * Compile a regular expression against the vocab
+ *
+ * @param tokenizer Tokenizer handle (must outlive the grammar)
+ * @param pattern Regular expression the whole output must match
+ * @param pattern_len Length of pattern in bytes
+ * @param params Grammar parameters (NULL for defaults)
+ * @param pool Thread pool for filling the masks, or NULL
+ * @param error Receives a message on failure (can be NULL)
+ * @param error_len Size of error in bytes
+ * @return Grammar handle, or NULL on invalid arguments, a pattern that
+ *         is malformed, unsupported, matches nothing or needs too many
+ *         states, or allocation failure
+ */
+llama_tokenizer_grammar_t* llama_tokenizer_grammar_from_regex(
+    const llama_tokenizer_t* tokenizer,
+    const char* pattern,
+    int32_t pattern_len,
+    const llama_tokenizer_grammar_params* params,
+    llama_tokenizer_threadpool_t* pool,
+    char* error,
+    int32_t error_len
+);
+
+/**
+ * Compile a JSON schema against the vocab
+ *
+ * @param tokenizer Tokenizer handle (must outlive the grammar)
+ * @param schema JSON schema text
+ * @param schema_len Length of schema in bytes
+ * @param params Grammar parameters (NULL for defaults)
+ * @param pool Thread pool for filling the masks, or NULL
+ * @param error Receives a message on failure (can be NULL)
+ * @param error_len Size of error in bytes
+ * @return Grammar handle, or NULL as for llama_tokenizer_grammar_from_regex()
+ *         or for malformed JSON or an unsupported schema
+ */
+llama_tokenizer_grammar_t* llama_tokenizer_grammar_from_json_schema(
+    const llama_tokenizer_t* tokenizer,
+    const char* schema,
+    int32_t schema_len,
+    const llama_tokenizer_grammar_params* params,
+    llama_tokenizer_threadpool_t* pool,
+    char* error,
+    int32_t error_len
+);
+
+/**
+ * Free a grammar
+ *
+ * @param grammar Grammar handle to free
+ */
+void llama_tokenizer_grammar_free(llama_tokenizer_grammar_t* grammar);
+
+/**
+ * Number of states; states are numbered from 0, the start state
+ *
+ * @param grammar Grammar handle
+ * @return Number of states, or -1 if grammar is NULL
+ */
+int32_t llama_tokenizer_grammar_n_states(const llama_tokenizer_grammar_t* grammar);
+
+/**
+ * Number of 64-bit words in a mask, (n_vocab + 63) / 64
+ *
+ * @param grammar Grammar handle
+ * @return Words per mask, or -1 if grammar is NULL
+ */
+int32_t llama_tokenizer_grammar_mask_words(const llama_tokenizer_grammar_t* grammar);
+
+/**
+ * Tokens allowed in a state
+ *
+ * @param grammar Grammar handle
+ * @param state State
+ * @return Mask with bit (t % 64) of word (t / 64) set when token t is
+ *         allowed, owned by the grammar; NULL for an invalid state
+ */
+const uint64_t* llama_tokenizer_grammar_mask(const llama_tokenizer_grammar_t* grammar, int32_t state);
+
+/**
+ * Follow a token
+ *
+ * @param grammar Grammar handle
+ * @param state Current state
+ * @param token Token generated
+ * @return Next state (the same one for an end-of-generation token in an
+ *         accepting state), or -1 if the token is not allowed or the
+ *         arguments are invalid
+ */
+int32_t llama_tokenizer_grammar_advance(const llama_tokenizer_grammar_t* grammar, int32_t state, llama_token token);
+
+/**
+ * Whether the output so far is complete, so generation may end here
+ *
+ * @param grammar Grammar handle
+ * @param state State
+ * @return true for an accepting state
+ */
+bool llama_tokenizer_grammar_is_accepting(const llama_tokenizer_grammar_t* grammar, int32_t state);
+
+/**
+ * Stop sequences
+ *
+ * A stop set compiles stop strings and stop tokens against the vocab
+ * once; any number of streams, one per generation, then consume tokens
+ * as they are sampled. Strings are matched over the concatenated pieces
+ * (as llama_tokenizer_token_to_piece() renders them) with one automaton,
+ * so a match may span tokens and the cost per token does not grow with
+ * the number of strings; stop tokens are a bit lookup. A stop set is
+ * immutable and may be shared across threads; a stream may not.
+ */
+typedef struct llama_tokenizer_stops_t llama_tokenizer_stops_t;
+typedef struct llama_tokenizer_stop_stream_t llama_tokenizer_stop_stream_t;
+
+typedef struct {
+    bool stop_on_eog;           // every end-of-generation token is also a stop token
+} llama_tokenizer_stops_params;
+
+typedef struct {
+    int32_t stop_index;         // index of the stop string, or -1 for a stop token
+    int64_t byte_offset;        // where the match starts in the stream's output bytes
+    int64_t token_index;        // stream token (from 0) holding the first byte of the match
+    int32_t token_offset;       // where the match starts in that token's piece
+} llama_tokenizer_stop_match;
+
+/**
+ * Default stop parameters: stop on end-of-generation tokens
+ */
+llama_tokenizer_stops_params llama_tokenizer_stops_default_params(void);
+
+/**
+ * Compile stop strings and stop tokens
+ *
+ * @param tokenizer Tokenizer handle (must outlive the stop set)
+ * @param stops Stop strings; empty ones never match
+ * @param stop_lens Length of each stop string in bytes
+ * @param n_stops Number of stop strings
+ * @param stop_tokens Tokens that stop generation by id (can be NULL if n_stop_tokens is 0)
+ * @param n_stop_tokens Number of stop tokens
+ * @param params Stop parameters (NULL for defaults)
+ * @return Stop set handle, or NULL on invalid arguments or allocation failure
+ */
+llama_tokenizer_stops_t* llama_tokenizer_stops_create(
+    const llama_tokenizer_t* tokenizer,
+    const char* const* stops,
+    const int32_t* stop_lens,
+    int32_t n_stops,
+    const llama_token* stop_tokens,
+    int32_t n_stop_tokens,
+    const llama_tokenizer_stops_params* params
+);
+
+/**
+ * Free a stop set; its streams must be freed first
+ *
+ * @param stops Stop set handle to free
+ */
+void llama_tokenizer_stops_free(llama_tokenizer_stops_t* stops);
+
+/**
+ * Start a stream over a stop set
+ *
+ * @param stops Stop set handle (must outlive the stream)
+ * @return Stream handle, or NULL on invalid arguments or allocation failure
+ */
+llama_tokenizer_stop_stream_t* llama_tokenizer_stop_stream_create(const llama_tokenizer_stops_t* stops);
+
+/**
+ * Consume generated tokens up to the first stop
+ *
+ * Among matches the one ending first wins, and of those ending in the
+ * same byte the longest. Tokens after the stopping one are not consumed;
+ * feeding them continues the scan. A stop token also drops any partial
+ * stop-string match.
+ *
+ * @param stream Stream handle
+ * @param tokens Generated tokens
+ * @param n_tokens Number of tokens
+ * @param match Output: the stop, set only when one is found (can be NULL)
+ * @return 0 if no stop was found, otherwise the number of tokens
+ *         consumed (the stopping one last); -1 on invalid arguments,
+ *         including an invalid token id, or allocation failure
+ */
+int32_t llama_tokenizer_stop_stream_feed(
+    llama_tokenizer_stop_stream_t* stream,
+    const llama_token* tokens,
+    int32_t n_tokens,
+    llama_tokenizer_stop_match* match
+);
+
+/**
+ * Bytes at the end of the output that begin a stop string; a server
+ * streaming text should hold them back until they are resolved
+ *
+ * @param stream Stream handle
+ * @return Number of bytes, or -1 if stream is NULL
+ */
+int32_t llama_tokenizer_stop_stream_pending(const llama_tokenizer_stop_stream_t* stream);
+
+/**
+ * Forget all output, as for a new generation
+ *
+ * @param stream Stream handle
+ */
+void llama_tokenizer_stop_stream_reset(llama_tokenizer_stop_stream_t* stream);
+
+/**
+ * Free a stream
+ *
+ * @param stream Stream handle to free
+ */
+void llama_tokenizer_stop_stream_free(llama_tokenizer_stop_stream_t* stream);
+
+/**
+ * Vocab translation
+ *
+ * A translator maps token sequences of one tokenizer to the tokens
+ * another gives the same text, e.g. between a draft model and a target
+ * model with different vocabs. Create it once per pair and keep it: it
+ * holds the target tokens of every source token that starts a word, so
+ * a word that is one source token costs a table lookup, and only words
+ * spread over several source tokens are tokenized again.
+ *
+ * The result is that of llama_tokenizer_detokenize() (not removing or
+ * rendering special tokens) followed by llama_tokenizer_tokenize() (not
+ * adding or parsing them), for vocabs whose pre-tokenizer starts a new
+ * pre-token at a space between two non-spaces, and whose detokenizer
+ * does not clean up spaces. Special tokens are dropped.
+ */
+typedef struct llama_tokenizer_translator_t llama_tokenizer_translator_t;
+
+/**
+ * Create a translator, tokenizing every word piece of the source vocab
+ * with the target
+ *
+ * @param from Source tokenizer (must outlive the translator)
+ * @param to Target tokenizer (must outlive the translator)
+ * @param pool Thread pool for building the table, or NULL
+ * @return Translator handle, or NULL on invalid arguments or if building fails
+ */
+llama_tokenizer_translator_t* llama_tokenizer_translator_create(
+    const llama_tokenizer_t* from,
+    const llama_tokenizer_t* to,
+    llama_tokenizer_threadpool_t* pool
+);
+
+/**
+ * Free a translator
+ *
+ * @param translator Translator handle to free
+ */
+void llama_tokenizer_translator_free(llama_tokenizer_translator_t* translator);
+
+/**
+ * Translate source tokens into target tokens
+ *
+ * Safe to call from any number of threads. For incremental use (a draft
+ * growing a token at a time), translate from the last source token
+ * whose text starts with a space (after one that ends in a non-space
+ * and is not a user-defined token) with continuation set; target
+ * tokens before that point do not change.
+ *
+ * @param translator Translator handle
+ * @param tokens Source tokens
+ * @param n_tokens Number of source tokens
+ * @param continuation Whether the tokens continue earlier text rather
+ *        than begin it (the source's leading space is then kept)
+ * @param out Output buffer for target tokens (can be NULL to get count)
+ * @param n_max_tokens Maximum number of tokens to write
+ * @return Number of target tokens, negative of it if the buffer is too
+ *         small, or -1 on invalid arguments (including an invalid token
+ *         id) or tokenization failure
+ */
+int32_t llama_tokenizer_translate(
+    const llama_tokenizer_translator_t* translator,
+    const llama_token* tokens,
+    int32_t n_tokens,
+    bool continuation,
+    llama_token* out,
+    int32_t n_max_tokens
+);
+
+/**
+ * Asynchronous request ring
+ *
+ * A submission queue (SQ) and completion queue (CQ) in the style of
+ * io_uring, served by a dispatcher thread, so one FFI crossing can carry
+ * many requests. Submit with llama_tokenizer_ring_submit() or by writing
+ * SQEs directly into the ring (see llama_tokenizer_ring_get_info()), then
+ * poll with llama_tokenizer_ring_reap(), block in llama_tokenizer_ring_wait(),
+ * or watch llama_tokenizer_ring_eventfd() from an event loop.
+ *
+ * The dispatcher takes whatever is queued as one batch and runs it on the
+ * ring's thread pool. Completions are posted in submission order. Input
+ * and output buffers referenced by an SQE must stay valid until its CQE
+ * has been reaped.
+ */
+typedef struct llama_tokenizer_ring_t llama_tokenizer_ring_t;
+
+typedef enum {
+    LLAMA_TOKENIZER_OP_TOKENIZE = 0,   // input: text; output: llama_token[output_cap]
+    LLAMA_TOKENIZER_OP_COUNT = 1,      // input: text; output unused
+    LLAMA_TOKENIZER_OP_DETOKENIZE = 2, // input: llama_token[input_len]; output: char[output_cap]
+} llama_tokenizer_ring_op;
+
+// SQE flags for TOKENIZE and COUNT
+#define LLAMA_TOKENIZER_RING_ADD_SPECIAL     (1u << 0)
+#define LLAMA_TOKENIZER_RING_PARSE_SPECIAL   (1u << 1)
+// SQE flags for DETOKENIZE
+#define LLAMA_TOKENIZER_RING_REMOVE_SPECIAL  (1u << 0)
+#define LLAMA_TOKENIZER_RING_UNPARSE_SPECIAL (1u << 1)
+
+/**
+ * Submission queue entry
+ */
+typedef struct {
+    uint64_t user_data;     // copied to the completion
+    int32_t op;             // llama_tokenizer_ring_op
+    uint32_t flags;         // LLAMA_TOKENIZER_RING_* flags for op
+    const void* input;      // text, or tokens for DETOKENIZE
+    int32_t input_len;      // bytes of text, or number of tokens
+    void* output;           // output buffer (NULL to get the size only)
+    int32_t output_cap;     // capacity of output, in tokens or bytes
+} llama_tokenizer_sqe;
+
+/**
+ * Completion queue entry
+ */
+typedef struct {
+    uint64_t user_data;     // from the submission
+    int32_t result;         // what the synchronous function would return
+    uint32_t flags;         // reserved, 0
+} llama_tokenizer_cqe;
+
+/**
+ * Shared ring memory, for submitting and reaping without a call per entry
+ *
+ * Heads and tails are free-running counters; entry i lives at index
+ * (i & mask). Access them atomically: to submit, fill sqes[tail & sq_mask],
+ * store *sq_tail = tail + 1 with release ordering and call
+ * llama_tokenizer_ring_enter(); the SQ is full when tail - *sq_head
+ * (acquire load) equals sq_mask + 1. To reap, read cqes[head & cq_mask]
+ * while head != *cq_tail (acquire load), store *cq_head with release
+ * ordering and call llama_tokenizer_ring_enter() so the dispatcher sees
+ * the freed space. Only one thread may produce and one consume this way,
+ * and not concurrently with llama_tokenizer_ring_submit() or
+ * llama_tokenizer_ring_reap().
+ */
+typedef struct {
+    llama_tokenizer_sqe* sqes;
+    uint32_t* sq_head;      // advanced by the dispatcher
+    uint32_t* sq_tail;      // advanced by the producer
+    uint32_t sq_mask;
+    llama_tokenizer_cqe* cqes;
+    uint32_t* cq_head;      // advanced by the consumer
+    uint32_t* cq_tail;      // advanced by the dispatcher
+    uint32_t cq_mask;
+} llama_tokenizer_ring_info;
+
+/**
+ * Create a request ring
+ *
+ * The SQ is rounded up to a power of two and the CQ is twice its size.
+ * The dispatcher only takes SQEs it has CQ space for, so an unreaped CQ
+ * applies backpressure rather than dropping completions.
+ *
+ * @param tokenizer Tokenizer handle (must outlive the ring)
+ * @param pool Thread pool to run batches on (must outlive the ring), or
+ *             NULL to run them on the dispatcher thread
+ * @param entries Submission queue size
+ * @return Ring handle, or NULL on failure
+ */
+llama_tokenizer_ring_t* llama_tokenizer_ring_create(
+    const llama_tokenizer_t* tokenizer,
+    llama_tokenizer_threadpool_t* pool,
+    uint32_t entries
+);
+
+/**
+ * Stop the dispatcher and free the ring
+ * A batch in progress finishes first; SQEs not yet taken are dropped.
+ * No other call using the ring may be in progress.
+ *
+ * @param ring Ring handle to free
+ */
+void llama_tokenizer_ring_destroy(llama_tokenizer_ring_t* ring);
+
+/**
+ * Copy SQEs into the submission queue and wake the dispatcher
+ * Safe to call from several threads at once.
+ *
+ * @param ring Ring handle
+ * @param sqes Entries to submit
+ * @param n_sqes Number of entries
+ * @return Number of entries queued (less than n_sqes if the SQ is full),
+ *         or -1 on error
+ */
+int32_t llama_tokenizer_ring_submit(llama_tokenizer_ring_t* ring, const llama_tokenizer_sqe* sqes, int32_t n_sqes);
+
+/**
+ * Copy available completions out of the completion queue, without blocking
+ * Safe to call from several threads at once.
+ *
+ * @param ring Ring handle
+ * @param cqes Output buffer for completions
+ * @param n_max Capacity of cqes
+ * @return Number of completions copied, or -1 on error
+ */
+int32_t llama_tokenizer_ring_reap(llama_tokenizer_ring_t* ring, llama_tokenizer_cqe* cqes, int32_t n_max);
+
+/**
+ * Wait until at least min_complete completions are ready to reap
+ *
+ * @param ring Ring handle
+ * @param min_complete Completions to wait for (capped at the CQ size)
+ * @param timeout_ms Maximum wait in milliseconds; negative waits forever
+ * @return Number of completions ready (less than min_complete on
+ *         timeout), or -1 on error
+ */
+int32_t llama_tokenizer_ring_wait(llama_tokenizer_ring_t* ring, int32_t min_complete, int32_t timeout_ms);
+
+/**
+ * Wake the dispatcher after writing SQEs or reaping CQEs through the
+ * shared ring memory
+ *
+ * @param ring Ring handle
+ */
+void llama_tokenizer_ring_enter(llama_tokenizer_ring_t* ring);
+
+/**
+ * Get a file descriptor that becomes readable when completions are posted
+ *
+ * Linux eventfd, non-blocking: reading it returns the number of
+ * completions posted since the last read. The ring owns it; do not close it.
+ *
+ * @param ring Ring handle
+ * @return File descriptor, or -1 if unsupported on this platform
+ */
+int32_t llama_tokenizer_ring_eventfd(const llama_tokenizer_ring_t* ring);
+
+/**
+ * Get the shared ring memory
+ *
+ * @param ring Ring handle
+ * @param info Output: ring layout, valid until the ring is destroyed
+ * @return true on success, false on error
+ */
+bool llama_tokenizer_ring_get_info(llama_tokenizer_ring_t* ring, llama_tokenizer_ring_info* info);
+
+/**
+ * Per-handle performance counters
+ *
+ * Every handle counts its calls in per-thread shards of relaxed atomic
+ * counters, so recording costs two clock reads and a few uncontended
+ * increments. Building with -DLLAMA_TOKENIZER_STATS=OFF compiles the
+ * recording out; llama_tokenizer_get_stats() then returns false.
+ */
+typedef enum {
+    LLAMA_TOKENIZER_STATS_TOKENIZE       = 0,  // llama_tokenizer_tokenize, including each text of a batch or ring
+    LLAMA_TOKENIZER_STATS_DETOKENIZE     = 1,  // llama_tokenizer_detokenize
+    LLAMA_TOKENIZER_STATS_TOKEN_TO_PIECE = 2,  // llama_tokenizer_token_to_piece
+    LLAMA_TOKENIZER_STATS_TOKENIZE_BATCH = 3,  // llama_tokenizer_tokenize_batch, once per batch
+    LLAMA_TOKENIZER_STATS_N_ENTRY_POINTS = 4,
+} llama_tokenizer_stats_entry;
+
+// Latency histogram bucket i counts calls taking [2^i, 2^(i+1)) ns;
+// bucket 0 also counts 0 ns and the last bucket everything slower
+#define LLAMA_TOKENIZER_STATS_HISTOGRAM_BUCKETS 32
+
+typedef struct {
+    uint64_t calls;             // calls that passed argument validation
+    uint64_t count_only_calls;  // output buffer NULL
+    uint64_t fill_calls;        // output buffer given
+    uint64_t buffer_too_small;  // fill calls that returned the negative required size
+    uint64_t input;             // tokenize: text bytes; detokenize, token_to_piece: tokens; batch: texts
+    uint64_t output;            // tokenize: tokens; detokenize, token_to_piece: bytes; batch: 0
+    uint64_t total_ns;          // wall time spent in the calls
+    uint64_t latency_histogram[LLAMA_TOKENIZER_STATS_HISTOGRAM_BUCKETS];
+} llama_tokenizer_entry_stats;
+
+typedef struct {
+    llama_tokenizer_entry_stats entries[LLAMA_TOKENIZER_STATS_N_ENTRY_POINTS];
+    uint64_t utf8_sanitized;       // tokenize inputs whose invalid UTF-8 was replaced first
+    uint64_t special_partitioned;  // tokenize inputs split around special tokens
+    uint64_t native_fallbacks;     // text fragments the native kernel handed back to llama.cpp
+} llama_tokenizer_stats;
+
+/**
+ * Get a snapshot of a handle's counters
+ *
+ * Safe to call while other threads use the handle; counters are read one
+ * by one, so a snapshot taken mid-call may count that call partially.
+ *
+ * @param tokenizer Tokenizer handle
+ * @param stats Output: counters summed over all shards
+ * @return true on success, false on error or if stats are compiled out
+ */
+bool llama_tokenizer_get_stats(const llama_tokenizer_t* tokenizer, llama_tokenizer_stats* stats);
+
+/**
+ * Reset a handle's counters to zero
+ *
+ * Calls in progress on other threads may be counted before or after the
+ * reset.
+ *
+ * @param tokenizer Tokenizer handle
+ */
+void llama_tokenizer_reset_stats(const llama_tokenizer_t* tokenizer);
+
+/**
+ * Tracing
+ *
+ * Internal phases can be timed as spans, delivered to a callback and/or
+ * kept in a process-wide ring buffer that can be dumped as Chrome trace
+ * event JSON (chrome://tracing, ui.perfetto.dev). While neither is
+ * installed each phase costs one predictable branch; building with
+ * -DLLAMA_TOKENIZER_TRACE=OFF compiles the hooks out and makes
+ * llama_tokenizer_trace_start() return false.
+ *
+ * The functions below are process-wide and safe to call from any thread
+ * while other calls are running, so a service can start and stop a
+ * trace without pausing. When one of them returns, a callback it
+ * replaced is no longer called and a recording it discarded is no
+ * longer written, so their user_data can be freed.
+ */
+typedef enum {
+    LLAMA_TOKENIZER_TRACE_CREATE            = 0,  // llama_tokenizer_create, whole call
+    LLAMA_TOKENIZER_TRACE_MODEL_LOAD        = 1,  // GGUF model and vocab load
+    LLAMA_TOKENIZER_TRACE_KERNEL_BUILD      = 2,  // special-token matcher, affix probe, native kernel
+    LLAMA_TOKENIZER_TRACE_TOKENIZE          = 3,  // llama_tokenizer_tokenize, whole call
+    LLAMA_TOKENIZER_TRACE_SPECIAL_PARTITION = 4,  // splitting text around special tokens
+    LLAMA_TOKENIZER_TRACE_PRE_TOKENIZE      = 5,  // SPM whitespace escaping, UGM normalization
+    LLAMA_TOKENIZER_TRACE_MODEL             = 6,  // SPM merge, UGM Viterbi, WPM word matching
+    LLAMA_TOKENIZER_TRACE_LLAMA_CPP         = 7,  // text tokenized by llama.cpp itself
+    LLAMA_TOKENIZER_TRACE_OUTPUT_COPY       = 8,  // copying tokens to the caller's buffer
+    LLAMA_TOKENIZER_TRACE_DETOKENIZE        = 9,  // llama_tokenizer_detokenize, whole call
+    LLAMA_TOKENIZER_TRACE_N_PHASES          = 10,
+} llama_tokenizer_trace_phase;
+
+typedef struct {
+    llama_tokenizer_trace_phase phase;
+    uint32_t thread_id;    // small per-process thread number, from 1
+    uint64_t start_ns;     // steady clock
+    uint64_t duration_ns;
+    uint64_t size;         // bytes for text phases, tokens for token phases, 0 for load phases
+} llama_tokenizer_trace_span;
+
+/**
+ * Trace callback, called on the thread that ran the span
+ *
+ * Called from inside library calls, possibly from many threads at once;
+ * it must be thread-safe, fast, and must not call back into the library.
+ */
+typedef void (*llama_tokenizer_trace_fn)(const llama_tokenizer_trace_span* span, void* user_data);
+
+/**
+ * Install or remove the trace callback
+ *
+ * Waits for calls already inside the previous callback to return.
+ *
+ * @param fn Callback, or NULL to remove it
+ * @param user_data Passed to every call of fn
+ */
+void llama_tokenizer_set_trace_callback(llama_tokenizer_trace_fn fn, void* user_data);
+
+/**
+ * Start recording spans into a ring buffer, discarding any previous recording
+ *
+ * Once full, the oldest spans are overwritten.
+ *
+ * @param capacity Spans kept; 0 for the default of 65536
+ * @return true on success, false on allocation failure or if tracing is compiled out
+ */
+bool llama_tokenizer_trace_start(size_t capacity);
+
+/**
+ * Stop recording; the recorded spans stay available to llama_tokenizer_trace_dump()
+ */
+void llama_tokenizer_trace_stop(void);
+
+/**
+ * Write the recorded spans as Chrome trace event JSON
+ *
+ * Safe to call while other threads are being traced; spans still being
+ * written are skipped.
+ *
+ * @param path Output file path
+ * @return Number of spans written, or -1 on error or if nothing was recorded
+ */
+int32_t llama_tokenizer_trace_dump(const char* path);
+
 #ifdef __cplusplus
 }
 #endif
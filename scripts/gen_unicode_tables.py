@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Generate src/unicode_tables.inc, the Unicode data of the WordPiece kernel.
+
+The derivation follows llama.cpp's scripts/gen-unicode-data.py, so the
+tables agree with llama.cpp's for the same Unicode version: the general
+category gives the control, punctuation and symbol flags, White_Space
+is the PropList set, lowercase is the simple (single code point) mapping
+and the NFD entry is the first code point of the canonical decomposition.
+Data comes from Python's unicodedata module; its Unicode version is
+recorded in the output, and a kernel whose tables disagree with the
+linked llama.cpp is caught by the create-time check and not used.
+
+Usage: python3 scripts/gen_unicode_tables.py > src/unicode_tables.inc
+"""
+
+import unicodedata
+
+MAX_CODEPOINTS = 0x110000
+
+FLAG_CONTROL = 1
+FLAG_PUNCTUATION = 2
+FLAG_SYMBOL = 4
+FLAG_WHITESPACE = 8
+
+# PropList.txt White_Space
+WHITESPACE = (list(range(0x0009, 0x000D + 1)) + list(range(0x2000, 0x200A + 1)) +
+              [0x0020, 0x0085, 0x00A0, 0x1680, 0x2028, 0x2029, 0x202F, 0x205F, 0x3000])
+
+
+def category_flags(cpt):
+    category = unicodedata.category(chr(cpt))
+    if category in ("Cc", "Cf", "Co", "Cs"):
+        return FLAG_CONTROL
+    if category[0] == "P":
+        return FLAG_PUNCTUATION
+    if category[0] == "S":
+        return FLAG_SYMBOL
+    return 0
+
+
+def main():
+    flags = [category_flags(cpt) for cpt in range(MAX_CODEPOINTS)]
+    for cpt in WHITESPACE:
+        flags[cpt] |= FLAG_WHITESPACE
+
+    flag_ranges = []  # (first, flags), each up to the next first
+    for cpt in range(MAX_CODEPOINTS):
+        if not flag_ranges or flag_ranges[-1][1] != flags[cpt]:
+            flag_ranges.append((cpt, flags[cpt]))
+
+    lowercase = []
+    nfd_ranges = []  # (first, last, nfd)
+    for cpt in range(MAX_CODEPOINTS):
+        if 0xD800 <= cpt <= 0xDFFF:
+            continue
+        char = chr(cpt)
+        lower = char.lower()
+        if cpt == 0x0130:
+            lower = "i"  # UnicodeData's simple mapping; SpecialCasing adds U+0307
+        if len(lower) == 1 and lower != char:
+            lowercase.append((cpt, ord(lower)))
+        nfd = ord(unicodedata.normalize("NFD", char)[0])
+        if nfd != cpt:
+            if nfd_ranges and nfd_ranges[-1][1] == cpt - 1 and nfd_ranges[-1][2] == nfd:
+                nfd_ranges[-1] = (nfd_ranges[-1][0], cpt, nfd)
+            else:
+                nfd_ranges.append((cpt, cpt, nfd))
+
+    out = []
+    out.append("// Generated by scripts/gen_unicode_tables.py; do not edit")
+    out.append("")
+    out.append('static const char generated_unicode_version[] = "%s";' % unicodedata.unidata_version)
+    out.append("")
+    out.append("static const unicode_flag_range generated_flag_ranges[] = {")
+    for i in range(0, len(flag_ranges), 6):
+        out.append("    " + " ".join("{ 0x%05X, %d }," % r for r in flag_ranges[i:i + 6]))
+    out.append("};")
+    out.append("")
+    out.append("static const unicode_mapping generated_lowercase[] = {")
+    for i in range(0, len(lowercase), 6):
+        out.append("    " + " ".join("{ 0x%05X, 0x%05X }," % m for m in lowercase[i:i + 6]))
+    out.append("};")
+    out.append("")
+    out.append("static const unicode_nfd_range generated_nfd_ranges[] = {")
+    for i in range(0, len(nfd_ranges), 4):
+        out.append("    " + " ".join("{ 0x%05X, 0x%05X, 0x%05X }," % r for r in nfd_ranges[i:i + 4]))
+    out.append("};")
+    print("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,93 @@
+#include "aho_corasick.h"
+
+#include <string.h>
+
+namespace ltok {
+
+void aho_corasick::build(const std::vector<std::string>& patterns) {
+    // Bytes that never occur in a pattern share class 0
+    bool used[256] = {};
+    int n_used = 0;
+    for (const std::string& p : patterns) {
+        for (unsigned char c : p) {
+            n_used += used[c] ? 0 : 1;
+            used[c] = true;
+        }
+    }
+    memset(byte_class, 0, sizeof(byte_class));
+    n_classes = (n_used == 256) ? 0 : 1;
+    for (int c = 0; c < 256; c++) {
+        if (used[c]) {
+            byte_class[c] = (uint8_t)n_classes++;
+        }
+    }
+
+    const uint32_t MISSING = UINT32_MAX;
+
+    delta.assign(n_classes, MISSING);
+    state_pattern.assign(1, NO_PATTERN);
+    lengths.assign(patterns.size(), 0);
+    depths.assign(1, 0);
+    n_states = 1;
+
+    // Trie
+    for (size_t i = 0; i < patterns.size(); i++) {
+        const std::string& p = patterns[i];
+        lengths[i] = (uint32_t)p.size();
+        if (p.empty()) {
+            continue;
+        }
+        uint32_t state = 0;
+        for (unsigned char c : p) {
+            uint32_t& next = delta[(size_t)state * n_classes + byte_class[c]];
+            if (next == MISSING) {
+                next = n_states++;
+                delta.resize((size_t)n_states * n_classes, MISSING);
+                state_pattern.push_back(NO_PATTERN);
+                depths.push_back(depths[state] + 1);
+                // delta may have been reallocated; re-read through the index
+                state = n_states - 1;
+                continue;
+            }
+            state = next;
+        }
+        if (state_pattern[state] == NO_PATTERN) {
+            state_pattern[state] = (uint32_t)i;
+        }
+    }
+
+    // Breadth-first fill of failure transitions, turning the trie into a DFA
+    std::vector<uint32_t> fail(n_states, 0);
+    dict_link.assign(n_states, 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(n_states);
+
+    for (uint32_t c = 0; c < n_classes; c++) {
+        uint32_t& next = delta[c];
+        if (next == MISSING) {
+            next = 0;
+        } else {
+            fail[next] = 0;
+            queue.push_back(next);
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        const uint32_t s = queue[head];
+        const uint32_t f = fail[s];
+        dict_link[s] = (state_pattern[f] != NO_PATTERN) ? f : dict_link[f];
+
+        for (uint32_t c = 0; c < n_classes; c++) {
+            uint32_t& next = delta[(size_t)s * n_classes + c];
+            const uint32_t via_fail = delta[(size_t)f * n_classes + c];
+            if (next == MISSING) {
+                next = via_fail;
+            } else {
+                fail[next] = via_fail;
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+} // namespace ltok
@@ -0,0 +1,88 @@
+#ifndef LLAMA_TOKENIZER_AHO_CORASICK_H
+#define LLAMA_TOKENIZER_AHO_CORASICK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ltok {
+
+/**
+ * Multi-pattern byte matcher (Aho-Corasick)
+ *
+ * Compiled into a dense DFA over byte equivalence classes, so a scan costs
+ * one table lookup per input byte regardless of the number of patterns.
+ * Immutable after build(); safe to share across threads.
+ */
+class aho_corasick {
+public:
+    static constexpr uint32_t NO_PATTERN = UINT32_MAX;
+
+    /**
+     * Build the automaton. Patterns are identified by their index;
+     * empty patterns are ignored, and for duplicates the lowest index wins.
+     */
+    void build(const std::vector<std::string>& patterns);
+
+    bool empty() const { return n_states <= 1; }
+    uint32_t start() const { return 0; }
+
+    uint32_t step(uint32_t state, unsigned char c) const {
+        return delta[(size_t)state * n_classes + byte_class[c]];
+    }
+
+    uint32_t pattern_length(uint32_t pattern) const { return lengths[pattern]; }
+
+    // Length of the pattern prefix a state stands for, i.e. of the
+    // longest input suffix that may still grow into a match
+    uint32_t depth(uint32_t state) const { return depths[state]; }
+
+    /**
+     * Visit every pattern ending in the given state (longest first)
+     */
+    template <typename F>
+    void for_each_output(uint32_t state, F&& fn) const {
+        if (state_pattern[state] == NO_PATTERN) {
+            state = dict_link[state];
+        }
+        while (state != 0) {
+            fn(state_pattern[state]);
+            state = dict_link[state];
+        }
+    }
+
+    bool has_output(uint32_t state) const {
+        return state_pattern[state] != NO_PATTERN || dict_link[state] != 0;
+    }
+
+    /**
+     * Report all (possibly overlapping) occurrences as fn(pattern, start)
+     */
+    template <typename F>
+    void scan(const char* text, size_t len, F&& fn) const {
+        uint32_t state = 0;
+        for (size_t i = 0; i < len; i++) {
+            state = step(state, (unsigned char)text[i]);
+            if (has_output(state)) {
+                for_each_output(state, [&](uint32_t p) {
+                    fn(p, i + 1 - lengths[p]);
+                });
+            }
+        }
+    }
+
+private:
+    uint8_t byte_class[256] = {};
+    uint32_t n_classes = 1;
+    uint32_t n_states = 0;
+    std::vector<uint32_t> delta;          // n_states * n_classes
+    std::vector<uint32_t> state_pattern;  // pattern accepted in this state
+    std::vector<uint32_t> dict_link;      // next state on the fail chain with output (0 = none)
+    std::vector<uint32_t> lengths;        // pattern lengths
+    std::vector<uint32_t> depths;         // trie depth of each state
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_AHO_CORASICK_H
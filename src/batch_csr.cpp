@@ -0,0 +1,280 @@
+#include "batch_csr.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+namespace ltok {
+
+namespace {
+
+// Arrow's recommended alignment and padding for buffers
+static constexpr size_t buffer_alignment = 64;
+
+// Never null, even for zero bytes: some consumers reject null data buffers
+void* alloc_buffer(size_t bytes) {
+    bytes = (bytes + buffer_alignment - 1) / buffer_alignment * buffer_alignment;
+    return ::operator new(std::max(bytes, buffer_alignment), std::align_val_t(buffer_alignment), std::nothrow);
+}
+
+void free_buffer(void* p) {
+    ::operator delete(p, std::align_val_t(buffer_alignment));
+}
+
+// Tokens of one chunk of texts, back to back
+struct chunk_buffer {
+    llama_token* data = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    chunk_buffer() = default;
+    ~chunk_buffer() { free_buffer(data); }
+
+    chunk_buffer(const chunk_buffer&) = delete;
+    chunk_buffer& operator=(const chunk_buffer&) = delete;
+
+    bool grow(size_t min_capacity) {
+        const size_t new_capacity = std::max<size_t>({min_capacity, capacity + capacity / 2, 16});
+        llama_token* p = static_cast<llama_token*>(alloc_buffer(new_capacity * sizeof(llama_token)));
+        if (!p) {
+            return false;
+        }
+        if (size > 0) {
+            memcpy(p, data, size * sizeof(llama_token));
+        }
+        free_buffer(data);
+        data = p;
+        capacity = new_capacity;
+        return true;
+    }
+};
+
+// Tokenize texts [first, last) into chunk, storing each count (negative
+// for a failed text) in counts[i]; false on allocation failure
+bool fill_chunk(csr_tokenize_fn tokenize, csr_reserve_fn reserve, const void* ctx,
+                size_t first, size_t last, chunk_buffer& chunk, int64_t* counts) {
+    size_t expected = 0;
+    for (size_t i = first; i < last; i++) {
+        expected += (size_t)std::max<int32_t>(reserve(ctx, i), 0);
+    }
+    if (!chunk.grow(expected)) {
+        return false;
+    }
+
+    for (size_t i = first; i < last; i++) {
+        size_t room = chunk.capacity - chunk.size;
+        int32_t n = tokenize(ctx, i, chunk.data + chunk.size, (int32_t)std::min<size_t>(room, INT32_MAX));
+        if (n < 0 && (size_t)-(int64_t)n > room) {
+            // Past the estimate: grow to the size reported and run it again
+            if (!chunk.grow(chunk.size + (size_t)-(int64_t)n)) {
+                return false;
+            }
+            room = chunk.capacity - chunk.size;
+            n = tokenize(ctx, i, chunk.data + chunk.size, (int32_t)std::min<size_t>(room, INT32_MAX));
+        }
+        counts[i] = n;
+        if (n > 0) {
+            chunk.size += (size_t)n;
+        }
+    }
+    return true;
+}
+
+// private_data of an exported array: one batch reference per array, so a
+// child moved out of its parent keeps the buffers alive on its own
+struct array_data {
+    csr_batch* batch = nullptr;
+    const void* buffers[2] = {};
+    ArrowArray* children[1] = {};
+    ArrowArray child = {};
+};
+
+void release_array(ArrowArray* array) {
+    array_data* data = static_cast<array_data*>(array->private_data);
+    for (int64_t i = 0; i < array->n_children; i++) {
+        ArrowArray* child = array->children[i];
+        if (child->release) {
+            child->release(child);
+        }
+    }
+    data->batch->release();
+    delete data;
+    array->release = nullptr;
+}
+
+struct schema_data {
+    ArrowSchema* children[1] = {};
+    ArrowSchema child = {};
+};
+
+void release_child_schema(ArrowSchema* schema) {
+    schema->release = nullptr;
+}
+
+void release_schema(ArrowSchema* schema) {
+    schema_data* data = static_cast<schema_data*>(schema->private_data);
+    ArrowSchema* child = schema->children[0];
+    if (child->release) {
+        child->release(child);
+    }
+    delete data;
+    schema->release = nullptr;
+}
+
+} // namespace
+
+csr_batch::~csr_batch() {
+    free_buffer(tokens);
+    free_buffer(offsets);
+    free_buffer(validity);
+}
+
+void csr_batch::release() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+csr_batch* csr_batch::build(csr_tokenize_fn tokenize, csr_reserve_fn reserve, const void* ctx,
+                            size_t n_texts, thread_pool* pool, size_t grain) {
+    csr_batch* batch = new (std::nothrow) csr_batch();
+    if (!batch) {
+        return nullptr;
+    }
+    batch->n_texts = (int64_t)n_texts;
+    batch->offsets = static_cast<int64_t*>(alloc_buffer((n_texts + 1) * sizeof(int64_t)));
+    if (!batch->offsets) {
+        batch->release();
+        return nullptr;
+    }
+
+    grain = std::max<size_t>(grain, 1);
+    const size_t n_chunks = (n_texts + grain - 1) / grain;
+    std::vector<chunk_buffer> chunks;
+    try {
+        chunks = std::vector<chunk_buffer>(n_chunks);
+    } catch (const std::bad_alloc&) {
+        batch->release();
+        return nullptr;
+    }
+
+    // Counts go where their offsets will be, then become offsets in place
+    int64_t* offsets = batch->offsets;
+    int64_t* counts = offsets + 1;
+    std::atomic<bool> failed{false};
+    auto fill_range = [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) {
+            const size_t first = c * grain;
+            const size_t last = std::min(n_texts, first + grain);
+            if (!fill_chunk(tokenize, reserve, ctx, first, last, chunks[c], counts)) {
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+    if (pool && n_chunks > 1) {
+        pool->parallel_for(n_chunks, 1, fill_range);
+    } else {
+        fill_range(0, n_chunks);
+    }
+    if (failed.load(std::memory_order_relaxed)) {
+        batch->release();
+        return nullptr;
+    }
+
+    offsets[0] = 0;
+    int64_t total = 0;
+    for (size_t i = 0; i < n_texts; i++) {
+        const int64_t n = counts[i];
+        if (n < 0) {
+            if (!batch->validity) {
+                batch->validity = static_cast<uint8_t*>(alloc_buffer((n_texts + 7) / 8));
+                if (!batch->validity) {
+                    batch->release();
+                    return nullptr;
+                }
+                memset(batch->validity, 0xFF, (n_texts + 7) / 8);
+            }
+            batch->validity[i / 8] &= (uint8_t)~(1u << (i % 8));
+            batch->n_failed++;
+        } else {
+            total += n;
+        }
+        offsets[i + 1] = total;
+    }
+    batch->n_tokens = total;
+
+    if (n_chunks == 1) {
+        batch->tokens = chunks[0].data;
+        chunks[0].data = nullptr;
+        return batch;
+    }
+    batch->tokens = static_cast<llama_token*>(alloc_buffer((size_t)total * sizeof(llama_token)));
+    if (!batch->tokens) {
+        batch->release();
+        return nullptr;
+    }
+    auto copy_range = [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) {
+            chunk_buffer& chunk = chunks[c];
+            if (chunk.size > 0) {
+                memcpy(batch->tokens + offsets[c * grain], chunk.data, chunk.size * sizeof(llama_token));
+            }
+            // Freed as it goes, so the peak stays near one copy plus a chunk per thread
+            free_buffer(chunk.data);
+            chunk.data = nullptr;
+        }
+    };
+    if (pool && n_chunks > 1) {
+        pool->parallel_for(n_chunks, 1, copy_range);
+    } else {
+        copy_range(0, n_chunks);
+    }
+    return batch;
+}
+
+void csr_batch::view(llama_tokenizer_csr_view& out) const {
+    out.tokens = tokens;
+    out.offsets = offsets;
+    out.validity = validity;
+    out.n_texts = n_texts;
+    out.n_tokens = n_tokens;
+    out.n_failed = n_failed;
+}
+
+bool csr_batch::export_arrow(ArrowArray* array, ArrowSchema* schema) {
+    array_data* list = new (std::nothrow) array_data();
+    array_data* items = new (std::nothrow) array_data();
+    schema_data* fields = schema ? new (std::nothrow) schema_data() : nullptr;
+    if (!list || !items || (schema && !fields)) {
+        delete list;
+        delete items;
+        delete fields;
+        return false;
+    }
+
+    retain();
+    items->batch = this;
+    items->buffers[0] = nullptr;  // no nulls among the tokens
+    items->buffers[1] = tokens;
+    list->child = ArrowArray{n_tokens, 0, 0, 2, 0, items->buffers, nullptr, nullptr, release_array, items};
+
+    retain();
+    list->batch = this;
+    list->buffers[0] = validity;
+    list->buffers[1] = offsets;
+    list->children[0] = &list->child;
+    *array = ArrowArray{n_texts, n_failed, 0, 2, 1, list->buffers, list->children, nullptr, release_array, list};
+
+    if (schema) {
+        fields->child = ArrowSchema{"i", "item", nullptr, 0, 0, nullptr, nullptr, release_child_schema, nullptr};
+        fields->children[0] = &fields->child;
+        *schema = ArrowSchema{"+L", "tokens", nullptr, ARROW_FLAG_NULLABLE, 1, fields->children, nullptr,
+                              release_schema, fields};
+    }
+    return true;
+}
+
+} // namespace ltok
@@ -0,0 +1,63 @@
+#ifndef LLAMA_TOKENIZER_BATCH_CSR_H
+#define LLAMA_TOKENIZER_BATCH_CSR_H
+
+#include "llama_tokenizer.h"
+#include "threadpool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+namespace ltok {
+
+// Tokens of text index into out[0, n_max): the count, the negative
+// required size when n_max is too small, or another negative on error
+typedef int32_t (*csr_tokenize_fn)(const void* ctx, size_t index, llama_token* out, int32_t n_max);
+
+// Token count text index is expected to stay under; only sizes buffers
+typedef int32_t (*csr_reserve_fn)(const void* ctx, size_t index);
+
+/**
+ * Buffers of one batch in CSR layout, shared by the result handle and
+ * every Arrow array exported from it
+ *
+ * The texts are split into chunks of grain; each chunk tokenizes into its
+ * own buffer and records its counts in offsets[i + 1]. A prefix sum then
+ * turns counts into offsets and the chunk buffers are copied into place,
+ * in parallel. With a single chunk its buffer becomes the token buffer.
+ * Reference counted: freed when the last owner releases it.
+ */
+class csr_batch {
+public:
+    // nullptr on allocation failure
+    static csr_batch* build(csr_tokenize_fn tokenize, csr_reserve_fn reserve, const void* ctx,
+                            size_t n_texts, thread_pool* pool, size_t grain);
+
+    void retain() { refs.fetch_add(1, std::memory_order_relaxed); }
+    void release();
+
+    void view(llama_tokenizer_csr_view& out) const;
+
+    // LargeList<Int32> sharing this batch's buffers; schema may be null
+    bool export_arrow(ArrowArray* array, ArrowSchema* schema);
+
+private:
+    csr_batch() = default;
+    ~csr_batch();
+
+    csr_batch(const csr_batch&) = delete;
+    csr_batch& operator=(const csr_batch&) = delete;
+
+    std::atomic<int> refs{1};
+    llama_token* tokens = nullptr;
+    int64_t* offsets = nullptr;
+    uint8_t* validity = nullptr;
+    int64_t n_texts = 0;
+    int64_t n_tokens = 0;
+    int64_t n_failed = 0;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_BATCH_CSR_H
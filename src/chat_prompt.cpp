@@ -0,0 +1,261 @@
+#include "chat_prompt.h"
+#include "llama.h"
+#include "scratch.h"
+#include "utf8_scan.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+
+namespace ltok {
+
+namespace {
+
+// Placeholder i is "  \x1f<i>\x1f  ": the control bytes never occur in a
+// template's own text, and the two spaces on each side reveal whether the
+// template trims the content there
+static constexpr char placeholder_mark = '\x1f';
+static constexpr size_t placeholder_pad = 2;
+
+struct placeholder {
+    char text[32];
+};
+
+// Same set as llama.cpp's trim()
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// One content's place in the rendered scaffolding
+struct content_slot {
+    size_t begin;           // first byte of the placeholder (including kept padding)
+    size_t end;             // one past its last byte
+    size_t message;
+    bool trim_leading;
+    bool trim_trailing;
+};
+
+void append_sanitized(std::string& out, const char* text, size_t len) {
+    if (utf8_scan(text, len).valid_len == len) {
+        out.append(text, len);
+    } else {
+        utf8_sanitize(text, len, out);
+    }
+}
+
+bool render(const char* tmpl, const std::vector<llama_chat_message>& chat, bool add_assistant, std::string& out) {
+    if (out.size() < 256) {
+        out.resize(256);
+    }
+    int32_t n = llama_chat_apply_template(tmpl, chat.data(), chat.size(), add_assistant,
+                                          &out[0], (int32_t)std::min<size_t>(out.size(), INT32_MAX));
+    if (n >= 0 && (size_t)n > out.size()) {
+        out.resize((size_t)n);
+        n = llama_chat_apply_template(tmpl, chat.data(), chat.size(), add_assistant, &out[0], n);
+    }
+    if (n < 0 || (size_t)n > out.size()) {
+        return false;
+    }
+    out.resize((size_t)n);
+    return true;
+}
+
+// Find the placeholders in the scaffolding, in text order
+bool find_slots(const std::string& scaffold, size_t n_messages, std::vector<content_slot>& slots) {
+    slots.clear();
+    size_t pos = 0;
+    while ((pos = scaffold.find(placeholder_mark, pos)) != std::string::npos) {
+        size_t end = pos + 1;
+        size_t index = 0;
+        while (end < scaffold.size() && scaffold[end] >= '0' && scaffold[end] <= '9' && index <= n_messages) {
+            index = index * 10 + (size_t)(scaffold[end] - '0');
+            end++;
+        }
+        if (end == pos + 1 || end >= scaffold.size() || scaffold[end] != placeholder_mark || index >= n_messages) {
+            pos++;  // a stray mark from a role; not ours
+            continue;
+        }
+        end++;
+
+        content_slot slot = {pos, end, index, true, true};
+        // Both pads left means the template kept the content's whitespace
+        size_t spaces = 0;
+        const size_t floor = slots.empty() ? 0 : slots.back().end;  // padding a previous slot kept
+        while (spaces < placeholder_pad && pos - spaces > floor && scaffold[pos - 1 - spaces] == ' ') {
+            spaces++;
+        }
+        if (spaces == placeholder_pad) {
+            slot.begin = pos - placeholder_pad;
+            slot.trim_leading = false;
+        }
+        spaces = 0;
+        while (spaces < placeholder_pad && end + spaces < scaffold.size() && scaffold[end + spaces] == ' ') {
+            spaces++;
+        }
+        if (spaces == placeholder_pad) {
+            slot.end = end + placeholder_pad;
+            slot.trim_trailing = false;
+        }
+        slots.push_back(slot);
+        pos = end;
+    }
+
+    // A content rendered twice cannot be told apart from template text
+    thread_local std::vector<uint8_t> seen;
+    seen.assign(n_messages, 0);
+    for (const content_slot& slot : slots) {
+        if (seen[slot.message]++) {
+            return false;
+        }
+    }
+    scratch_trim(seen);
+    return true;
+}
+
+} // namespace
+
+bool build_chat_prompt(const char* tmpl, const llama_tokenizer_chat_message* messages, size_t n_messages,
+                       bool add_assistant, std::string& text, std::vector<text_span>& content_spans) {
+    thread_local std::vector<placeholder> placeholders;
+    thread_local std::vector<llama_chat_message> chat;
+    thread_local std::string scaffold;
+    thread_local std::vector<content_slot> slots;
+
+    bool ok;
+    try {
+        placeholders.resize(n_messages);
+        chat.resize(n_messages);
+        for (size_t i = 0; i < n_messages; i++) {
+            chat[i].role = messages[i].role;
+            chat[i].content = "";
+            if (messages[i].content[0] != '\0') {
+                snprintf(placeholders[i].text, sizeof(placeholders[i].text), "  %c%zu%c  ",
+                         placeholder_mark, i, placeholder_mark);
+                chat[i].content = placeholders[i].text;
+            }
+        }
+        ok = render(tmpl, chat, add_assistant, scaffold) && find_slots(scaffold, n_messages, slots);
+
+        text.clear();
+        content_spans.clear();
+        size_t pos = 0;
+        for (size_t s = 0; ok && s < slots.size(); s++) {
+            const content_slot& slot = slots[s];
+            append_sanitized(text, scaffold.data() + pos, slot.begin - pos);
+
+            const char* content = messages[slot.message].content;
+            size_t len = strlen(content);
+            if (slot.trim_leading) {
+                while (len > 0 && is_space(*content)) {
+                    content++;
+                    len--;
+                }
+            }
+            if (slot.trim_trailing) {
+                while (len > 0 && is_space(content[len - 1])) {
+                    len--;
+                }
+            }
+            const size_t offset = text.size();
+            append_sanitized(text, content, len);
+            if (text.size() > offset) {
+                content_spans.push_back({offset, text.size() - offset});
+            }
+            pos = slot.end;
+        }
+        if (ok) {
+            append_sanitized(text, scaffold.data() + pos, scaffold.size() - pos);
+        }
+    } catch (const std::bad_alloc&) {
+        ok = false;
+    }
+    scratch_trim(scaffold);
+    scratch_trim(placeholders);
+    scratch_trim(chat);
+    return ok;
+}
+
+bool chat_token_cache::tokenize(std::string& new_text, std::vector<text_fragment>& new_fragments,
+                                chat_tokenize_fn tokenize_raw, const void* ctx) {
+    // Leading fragments that match and end inside the shared text
+    const size_t shared = (size_t)(std::mismatch(text.begin(), text.begin() + std::min(text.size(), new_text.size()),
+                                                 new_text.begin()).first - text.begin());
+    size_t keep = 0;
+    while (keep < fragments.size() && keep < new_fragments.size()) {
+        const text_fragment& a = fragments[keep];
+        const text_fragment& b = new_fragments[keep];
+        if (a.token != b.token || a.offset != b.offset || a.length != b.length || b.offset + b.length > shared) {
+            break;
+        }
+        keep++;
+    }
+    fragment_ends.resize(keep);
+    tokens.resize(keep > 0 ? fragment_ends[keep - 1] : 0);
+    n_reused = tokens.size();
+
+    try {
+        for (size_t i = keep; i < new_fragments.size(); i++) {
+            const text_fragment& fragment = new_fragments[i];
+            if (fragment.token != LLAMA_TOKEN_NULL) {
+                tokens.push_back(fragment.token);
+                fragment_ends.push_back(tokens.size());
+                continue;
+            }
+            const size_t base = tokens.size();
+            if (fragment.length > (size_t)INT32_MAX) {
+                clear();
+                return false;
+            }
+            // A byte rarely yields more than one token; grow and retry when it does
+            tokens.resize(base + fragment.length + 1);
+            size_t room = std::min<size_t>(tokens.size() - base, INT32_MAX);
+            int32_t n = tokenize_raw(ctx, new_text.data() + fragment.offset, (int32_t)fragment.length,
+                                     tokens.data() + base, (int32_t)room);
+            if (n < 0 && (size_t)-(int64_t)n > room) {
+                tokens.resize(base + (size_t)-(int64_t)n);
+                room = (size_t)-(int64_t)n;
+                n = tokenize_raw(ctx, new_text.data() + fragment.offset, (int32_t)fragment.length,
+                                 tokens.data() + base, (int32_t)room);
+            }
+            if (n < 0) {
+                clear();
+                return false;
+            }
+            tokens.resize(base + (size_t)n);
+            fragment_ends.push_back(tokens.size());
+        }
+    } catch (const std::bad_alloc&) {
+        clear();
+        return false;
+    }
+
+    text.swap(new_text);
+    fragments.swap(new_fragments);
+    return true;
+}
+
+void chat_token_cache::clear() {
+    text.clear();
+    fragments.clear();
+    fragment_ends.clear();
+    tokens.clear();
+    n_reused = 0;
+}
+
+void chat_token_cache::trim() {
+    if (text.capacity() > scratch_retain_limit ||
+        fragments.capacity() * sizeof(text_fragment) > scratch_retain_limit ||
+        fragment_ends.capacity() * sizeof(size_t) > scratch_retain_limit ||
+        tokens.capacity() * sizeof(llama_token) > scratch_retain_limit) {
+        clear();
+        scratch_trim(text);
+        scratch_trim(fragments);
+        scratch_trim(fragment_ends);
+        scratch_trim(tokens);
+    }
+}
+
+} // namespace ltok
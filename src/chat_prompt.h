@@ -0,0 +1,75 @@
+#ifndef LLAMA_TOKENIZER_CHAT_PROMPT_H
+#define LLAMA_TOKENIZER_CHAT_PROMPT_H
+
+#include "llama_tokenizer.h"
+#include "special_tokens.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace ltok {
+
+/**
+ * Assemble a chat prompt around the caller's message contents
+ *
+ * llama.cpp renders the template once over short placeholders rather
+ * than the contents, so only the template's own text is rendered and
+ * copied. The placeholders show where each content goes and whether
+ * the template trims it; the contents are then spliced into that
+ * scaffolding, with invalid UTF-8 replaced by U+FFFD. content_spans
+ * receives where they landed, in order.
+ *
+ * Returns false if the template is not supported or renders a
+ * placeholder more than once.
+ */
+bool build_chat_prompt(const char* tmpl, const llama_tokenizer_chat_message* messages, size_t n_messages,
+                       bool add_assistant, std::string& text, std::vector<text_span>& content_spans);
+
+// Tokenize raw text (no special tokens) of a chat prompt; returns the
+// count, or the negative required size when n_max_tokens is too small
+typedef int32_t (*chat_tokenize_fn)(const void* ctx, const char* text, int32_t text_len,
+                                    llama_token* tokens, int32_t n_max_tokens);
+
+/**
+ * Tokens of the last chat prompt, by fragment
+ *
+ * Every fragment of a partitioned prompt (a special token, or the raw text
+ * between two) tokenizes independently of the others, so a fragment that
+ * lies entirely within the text shared with the previous prompt and
+ * matches the previous prompt's fragment keeps its tokens. In a growing
+ * conversation that is every turn but the last.
+ *
+ * Not thread safe.
+ */
+class chat_token_cache {
+public:
+    // Tokenize text, split into fragments, reusing the tokens of leading
+    // fragments unchanged since the previous call. Takes over text and
+    // fragments, leaving the previous call's in their place. False on
+    // failure, which also empties the cache
+    bool tokenize(std::string& new_text, std::vector<text_fragment>& new_fragments,
+                  chat_tokenize_fn tokenize_raw, const void* ctx);
+
+    void clear();
+
+    // Free buffers grown past the scratch limit, forgetting the prompt
+    void trim();
+
+    const llama_token* data() const { return tokens.data(); }
+    size_t size() const { return tokens.size(); }
+    size_t reused() const { return n_reused; }
+
+private:
+    std::string text;
+    std::vector<text_fragment> fragments;
+    std::vector<size_t> fragment_ends;  // token count up to the end of each fragment
+    std::vector<llama_token> tokens;
+    size_t n_reused = 0;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_CHAT_PROMPT_H
@@ -0,0 +1,432 @@
+#include "count_estimator.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LTOK_ESTIMATE_SSE2 1
+// GCC and Clang can also build an AVX2 + POPCNT scan, chosen at run time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LTOK_ESTIMATE_AVX2 1
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LTOK_ESTIMATE_NEON 1
+#endif
+
+namespace ltok {
+
+namespace {
+
+// Bit i of each mask describes byte i of a 64-byte block
+struct block_masks {
+    uint64_t ascii;
+    uint64_t letter;
+    uint64_t digit;
+    uint64_t space;
+    uint64_t cont;
+    uint64_t lead2;
+    uint64_t lead3;
+    uint64_t lead4;
+};
+
+// The scan must be inlined into each target-specific caller to be built
+// for that instruction set
+#if defined(__GNUC__)
+#define LTOK_ESTIMATE_INLINE inline __attribute__((always_inline))
+#else
+#define LTOK_ESTIMATE_INLINE inline
+#endif
+
+#if defined(LTOK_ESTIMATE_SSE2)
+// Bytes b with lo <= b <= lo + span
+inline uint64_t in_range(__m128i chunk, uint8_t lo, uint8_t span) {
+    const __m128i x = _mm_sub_epi8(chunk, _mm_set1_epi8((char)lo));
+    const __m128i le = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8((char)span)), x);
+    return (uint64_t)(uint16_t)_mm_movemask_epi8(le);
+}
+
+// Bytes below 0x80 + t, for t < 0x80 (signed compare)
+inline uint64_t below(__m128i chunk, int8_t t) {
+    return (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmplt_epi8(chunk, _mm_set1_epi8(t)));
+}
+
+void classify_block(const unsigned char* p, block_masks& m) {
+    m = block_masks();
+    for (unsigned part = 0; part < 4; part++) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(p + 16 * part));
+        const __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+        const unsigned shift = 16 * part;
+        // Signed, bytes 0x80-0xFF sort below ASCII: split them at the
+        // lead-byte boundaries with three compares
+        const uint64_t high = (uint64_t)(uint16_t)_mm_movemask_epi8(chunk);
+        const uint64_t below_c0 = below(chunk, (int8_t)0xC0);
+        const uint64_t below_e0 = below(chunk, (int8_t)0xE0);
+        const uint64_t below_f0 = below(chunk, (int8_t)0xF0);
+        m.ascii |= (~high & 0xFFFF) << shift;
+        m.letter |= in_range(folded, 'a', 25) << shift;
+        m.digit |= in_range(chunk, '0', 9) << shift;
+        m.space |= (in_range(chunk, ' ', 0) | in_range(chunk, '\t', 4)) << shift;
+        m.cont |= below_c0 << shift;
+        m.lead2 |= (below_e0 & ~below_c0) << shift;
+        m.lead3 |= (below_f0 & ~below_e0) << shift;
+        m.lead4 |= (high & ~below_f0) << shift;
+    }
+}
+
+#if defined(LTOK_ESTIMATE_AVX2)
+// The same classification 32 bytes at a time
+__attribute__((target("avx2"))) inline uint64_t in_range_avx2(__m256i chunk, uint8_t lo, uint8_t span) {
+    const __m256i x = _mm256_sub_epi8(chunk, _mm256_set1_epi8((char)lo));
+    const __m256i le = _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8((char)span)), x);
+    return (uint64_t)(uint32_t)_mm256_movemask_epi8(le);
+}
+
+__attribute__((target("avx2"))) inline uint64_t below_avx2(__m256i chunk, int8_t t) {
+    return (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(t), chunk));
+}
+
+__attribute__((target("avx2"))) inline void classify_block_avx2(const unsigned char* p, block_masks& m) {
+    m = block_masks();
+    for (unsigned part = 0; part < 2; part++) {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i*)(p + 32 * part));
+        const __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+        const unsigned shift = 32 * part;
+        const uint64_t high = (uint64_t)(uint32_t)_mm256_movemask_epi8(chunk);
+        const uint64_t below_c0 = below_avx2(chunk, (int8_t)0xC0);
+        const uint64_t below_e0 = below_avx2(chunk, (int8_t)0xE0);
+        const uint64_t below_f0 = below_avx2(chunk, (int8_t)0xF0);
+        m.ascii |= (~high & 0xFFFFFFFF) << shift;
+        m.letter |= in_range_avx2(folded, 'a', 25) << shift;
+        m.digit |= in_range_avx2(chunk, '0', 9) << shift;
+        m.space |= (in_range_avx2(chunk, ' ', 0) | in_range_avx2(chunk, '\t', 4)) << shift;
+        m.cont |= below_c0 << shift;
+        m.lead2 |= (below_e0 & ~below_c0) << shift;
+        m.lead3 |= (below_f0 & ~below_e0) << shift;
+        m.lead4 |= (high & ~below_f0) << shift;
+    }
+}
+#endif
+#elif defined(LTOK_ESTIMATE_NEON)
+inline uint64_t movemask(uint8x16_t v) {
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t bits = vandq_u8(v, vld1q_u8(weights));
+    return (uint64_t)vaddv_u8(vget_low_u8(bits)) | ((uint64_t)vaddv_u8(vget_high_u8(bits)) << 8);
+}
+
+// Bytes b with lo <= b <= lo + span
+inline uint64_t in_range(uint8x16_t chunk, uint8_t lo, uint8_t span) {
+    return movemask(vcleq_u8(vsubq_u8(chunk, vdupq_n_u8(lo)), vdupq_n_u8(span)));
+}
+
+void classify_block(const unsigned char* p, block_masks& m) {
+    m = block_masks();
+    for (unsigned part = 0; part < 4; part++) {
+        const uint8x16_t chunk = vld1q_u8(p + 16 * part);
+        const uint8x16_t folded = vorrq_u8(chunk, vdupq_n_u8(0x20));
+        const unsigned shift = 16 * part;
+        m.ascii |= in_range(chunk, 0x00, 0x7F) << shift;
+        m.letter |= in_range(folded, 'a', 25) << shift;
+        m.digit |= in_range(chunk, '0', 9) << shift;
+        m.space |= (in_range(chunk, ' ', 0) | in_range(chunk, '\t', 4)) << shift;
+        m.cont |= in_range(chunk, 0x80, 0x3F) << shift;
+        m.lead2 |= in_range(chunk, 0xC0, 0x1F) << shift;
+        m.lead3 |= in_range(chunk, 0xE0, 0x0F) << shift;
+        m.lead4 |= in_range(chunk, 0xF0, 0x0F) << shift;
+    }
+}
+#else
+void classify_block(const unsigned char* p, block_masks& m) {
+    m = block_masks();
+    for (unsigned i = 0; i < 64; i++) {
+        const unsigned b = p[i];
+        const unsigned folded = b | 0x20;
+        const uint64_t bit = (uint64_t)1 << i;
+        m.ascii |= b < 0x80 ? bit : 0;
+        m.letter |= folded - 'a' <= 25 ? bit : 0;
+        m.digit |= b - '0' <= 9 ? bit : 0;
+        m.space |= b == ' ' || b - '\t' <= 4 ? bit : 0;
+        m.cont |= (b & 0xC0) == 0x80 ? bit : 0;
+        m.lead2 |= (b & 0xE0) == 0xC0 ? bit : 0;
+        m.lead3 |= (b & 0xF0) == 0xE0 ? bit : 0;
+        m.lead4 |= b >= 0xF0 ? bit : 0;
+    }
+}
+#endif
+
+inline uint64_t popcount(uint64_t x) {
+#if defined(__POPCNT__) || defined(__aarch64__)
+    return (uint64_t)__builtin_popcountll(x);
+#else
+    // Without the instruction the builtin is a library call
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (x * 0x0101010101010101ULL) >> 56;
+#endif
+}
+
+// Mask shifted toward higher bytes by k (1-3), taking bits from the
+// previous block
+inline uint64_t shifted(uint64_t cur, uint64_t prev, unsigned k) {
+    return (cur << k) | (prev >> (64 - k));
+}
+
+// Calibration corpus: a few hundred bytes each of the kinds of text a
+// gateway sees, so every feature has rows that exercise it
+const char* const calibration_corpus[] = {
+    "The committee met on Tuesday to review the proposal. After a long discussion, members agreed that "
+    "the budget should be revised before the next meeting, and that the schedule was too ambitious for "
+    "a team of this size. A final decision is expected early next month.",
+
+    "Photosynthesis converts light energy into chemical energy stored in glucose. Chlorophyll absorbs "
+    "mostly blue and red wavelengths, which is why leaves appear green. Internationalization, "
+    "interoperability and misunderstandings are long words that tokenizers usually split.",
+
+    "#include <stdio.h>\n\nint main(int argc, char** argv) {\n    for (int i = 0; i < argc; i++) {\n"
+    "        printf(\"%d: %s\\n\", i, argv[i]);\n    }\n    return 0;\n}\n",
+
+    "def load_config(path):\n    with open(path, encoding=\"utf-8\") as f:\n        data = json.load(f)\n"
+    "    if not isinstance(data, dict):\n        raise ValueError(f\"bad config: {path!r}\")\n"
+    "    return {k.lower(): v for k, v in data.items()}\n",
+
+    "{\"id\": 48213, \"user\": {\"name\": \"alice_w\", \"email\": \"alice@example.com\"}, \"tags\": "
+    "[\"beta\", \"eu-west-1\"], \"score\": 0.8731, \"active\": true, \"created_at\": \"2024-03-17T09:41:22Z\"}",
+
+    "2024-03-17 09:41:22.318 INFO  [worker-7] request_id=9f3c2a1b latency_ms=12.7 status=200 path=/v1/items\n"
+    "2024-03-17 09:41:22.402 WARN  [worker-2] retrying upstream 10.0.3.14:8443 attempt=2/5\n",
+
+    "3.14159 2.71828 1.41421 1729 65536 4294967296 0.000125 -42 +17 1e-9 6.022e23 299792458 "
+    "12,345,678.90 0x7FFFFFFF 0b101101 2048x1536 98.6% $1,299.99",
+
+    "## Installation\n\n1. Clone the repository.\n2. Run `make install`.\n\n> **Note:** the default prefix "
+    "is `/usr/local`.\n\n| Option | Default |\n|--------|---------|\n| `--jobs` | `4` |\n",
+
+    "Die Verhandlungen zwischen den Vertragsparteien wurden gestern überraschend abgebrochen. Según el "
+    "informe, la economía creció un 2,3 % en el último trimestre. L'été dernier, nous sommes allés à la "
+    "plage près de Marseille.",
+
+    "Вчера вечером в городе прошёл сильный дождь, и многие улицы были затоплены. Правительство "
+    "объявило о новых мерах поддержки малого бизнеса.",
+
+    "Η ανάπτυξη της τεχνολογίας αλλάζει τον τρόπο που εργαζόμαστε. שלום, מה שלומך היום? "
+    "أعلنت الحكومة عن خطة جديدة لتطوير التعليم في المدارس الحكومية.",
+
+    "人工智能正在改变我们的生活方式和工作方式。研究人员表示，这项技术在医疗领域具有巨大潜力。"
+    "今日は天気が良いので、公園へ散歩に行きました。",
+
+    "자연어 처리는 컴퓨터가 인간의 언어를 이해하도록 돕는 기술입니다. नमस्ते, आज मौसम बहुत अच्छा है "
+    "और हम बाहर घूमने जा रहे हैं। ภาษาไทยไม่มีการเว้นวรรคระหว่างคำ",
+
+    "Great job 🎉🎉 see you tomorrow 👋 😂😂😂 ❤️ 🚀 launch day! 🇺🇸 🇯🇵 👨‍👩‍👧 ok 👍",
+
+    "        if (x) {\n                y = 1;\n        }\n\n\n\t\tz = 2;\t// tabs\n    \n    \n",
+
+    "SELECT u.id, u.name, COUNT(o.id) AS orders FROM users u LEFT JOIN orders o ON o.user_id = u.id "
+    "WHERE u.created_at >= '2024-01-01' GROUP BY u.id, u.name HAVING COUNT(o.id) > 3 ORDER BY orders DESC;",
+
+    "https://example.com/search?q=token+count&lang=en&page=2#results "
+    "C:\\Users\\admin\\AppData\\Local\\Temp\\build_7f3a.log ~/.config/app/settings.yaml",
+
+    "ok. yes! no? maybe... (see above) [1] {a,b} <tag> --flag -x a/b c:d e;f g|h i&j k*l m+n o=p",
+};
+
+// Fraction the observed error range is widened by, for text unlike the corpus
+constexpr double bound_margin = 0.15;
+
+// Rows with fewer exact tokens are too noisy to set the bounds
+constexpr int32_t min_bound_tokens = 8;
+
+// First character boundary at or after the middle
+size_t split_point(const char* text, size_t len) {
+    size_t mid = len / 2;
+    while (mid < len && ((unsigned char)text[mid] & 0xC0) == 0x80) {
+        mid++;
+    }
+    return mid;
+}
+
+template <void (*Classify)(const unsigned char*, block_masks&), uint64_t (*Popcount)(uint64_t)>
+LTOK_ESTIMATE_INLINE void scan(const char* text, size_t len, double* out) {
+    uint64_t n_letter = 0, r_letter = 0, n_digit = 0, r_digit = 0, n_punct = 0, n_space = 0, r_space = 0;
+    uint64_t n_lead2 = 0, r_lead2 = 0, n_lead3 = 0, r_lead3 = 0, n_lead4 = 0;
+
+    // A run starts where the previous character is of another class; for
+    // multi-byte characters the previous character is the lead byte just
+    // before this one's continuation bytes
+    const unsigned char* p = (const unsigned char*)text;
+    block_masks prev = block_masks();
+    for (size_t pos = 0; pos < len; pos += 64) {
+        block_masks m;
+        if (len - pos >= 64) {
+            Classify(p + pos, m);
+        } else {
+            unsigned char tail[64] = {};
+            memcpy(tail, p + pos, len - pos);
+            Classify(tail, m);
+            const uint64_t valid = ((uint64_t)1 << (len - pos)) - 1;
+            m.ascii &= valid;
+            m.letter &= valid;
+            m.digit &= valid;
+            m.space &= valid;
+        }
+
+        const uint64_t cont1 = shifted(m.cont, prev.cont, 1);
+        const uint64_t cont2 = shifted(m.cont, prev.cont, 2);
+        n_letter += Popcount(m.letter);
+        r_letter += Popcount(m.letter & ~shifted(m.letter, prev.letter, 1));
+        n_digit += Popcount(m.digit);
+        r_digit += Popcount(m.digit & ~shifted(m.digit, prev.digit, 1));
+        n_punct += Popcount(m.ascii & ~(m.letter | m.digit | m.space));
+        n_space += Popcount(m.space);
+        r_space += Popcount(m.space & ~shifted(m.space, prev.space, 1));
+        n_lead2 += Popcount(m.lead2);
+        r_lead2 += Popcount(m.lead2 & ~(cont1 & shifted(m.lead2, prev.lead2, 2)));
+        n_lead3 += Popcount(m.lead3);
+        r_lead3 += Popcount(m.lead3 & ~(cont1 & cont2 & shifted(m.lead3, prev.lead3, 3)));
+        n_lead4 += Popcount(m.lead4);
+        prev = m;
+    }
+
+    out[0] = (double)n_letter;
+    out[1] = (double)r_letter;
+    out[2] = (double)n_digit;
+    out[3] = (double)r_digit;
+    out[4] = (double)n_punct;
+    out[5] = (double)n_space;
+    out[6] = (double)r_space;
+    out[7] = (double)n_lead2;
+    out[8] = (double)r_lead2;
+    out[9] = (double)n_lead3;
+    out[10] = (double)r_lead3;
+    out[11] = (double)n_lead4;
+}
+
+#if defined(LTOK_ESTIMATE_AVX2)
+// Only called when the CPU has both AVX2 and POPCNT
+__attribute__((target("popcnt"))) inline uint64_t popcount_hw(uint64_t x) {
+    return (uint64_t)__builtin_popcountll(x);
+}
+
+__attribute__((target("avx2,popcnt"))) void scan_avx2(const char* text, size_t len, double* out) {
+    scan<classify_block_avx2, popcount_hw>(text, len, out);
+}
+#endif
+
+} // namespace
+
+void count_estimator::features(const char* text, size_t len, double* out) {
+#if defined(LTOK_ESTIMATE_AVX2)
+    static const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    if (avx2) {
+        scan_avx2(text, len, out);
+        return;
+    }
+#endif
+    scan<classify_block, popcount>(text, len, out);
+}
+
+void count_estimator::calibrate(exact_count_fn count, const void* ctx, int32_t n_affix, size_t max_piece_len) {
+    affix = n_affix > 0 ? n_affix : 0;
+    max_piece = max_piece_len;
+
+    // Rows: each corpus text whole and in halves, scaled by 1 / exact count
+    // so the fit minimizes relative error
+    struct row {
+        double x[n_features];
+        int32_t exact;
+    };
+    std::vector<row> rows;
+    for (const char* text : calibration_corpus) {
+        const size_t len = strlen(text);
+        const size_t mid = split_point(text, len);
+        const size_t starts[3] = { 0, 0, mid };
+        const size_t ends[3] = { len, mid, len };
+        for (int part = 0; part < 3; part++) {
+            row r;
+            r.exact = count(ctx, text + starts[part], (int32_t)(ends[part] - starts[part]));
+            if (r.exact <= 0) {
+                continue;
+            }
+            features(text + starts[part], ends[part] - starts[part], r.x);
+            rows.push_back(r);
+        }
+    }
+
+    // Non-negative least squares by cyclic coordinate descent on the
+    // normal equations; n_features is small, so this converges quickly
+    double gram[n_features][n_features] = {};
+    double rhs[n_features] = {};
+    for (const row& r : rows) {
+        const double scale = 1.0 / (double)r.exact;
+        for (size_t j = 0; j < n_features; j++) {
+            rhs[j] += r.x[j] * scale;
+            for (size_t k = 0; k < n_features; k++) {
+                gram[j][k] += r.x[j] * r.x[k] * scale * scale;
+            }
+        }
+    }
+    std::fill(weights, weights + n_features, 0.0);
+    for (int sweep = 0; sweep < 1000; sweep++) {
+        for (size_t j = 0; j < n_features; j++) {
+            if (gram[j][j] <= 0.0) {
+                continue;
+            }
+            double residual = rhs[j];
+            for (size_t k = 0; k < n_features; k++) {
+                if (k != j) {
+                    residual -= gram[j][k] * weights[k];
+                }
+            }
+            weights[j] = std::max(0.0, residual / gram[j][j]);
+        }
+    }
+
+    low_ratio = 1.0;
+    high_ratio = 1.0;
+    for (const row& r : rows) {
+        double est = 0.0;
+        for (size_t j = 0; j < n_features; j++) {
+            est += weights[j] * r.x[j];
+        }
+        if (r.exact >= min_bound_tokens && est > 0.0) {
+            const double ratio = (double)r.exact / est;
+            low_ratio = std::min(low_ratio, ratio);
+            high_ratio = std::max(high_ratio, ratio);
+        }
+    }
+    low_ratio *= 1.0 - bound_margin;
+    high_ratio *= 1.0 + bound_margin;
+}
+
+int32_t count_estimator::estimate(const char* text, size_t len, bool add_special, int32_t* lower, int32_t* upper) const {
+    double x[n_features];
+    features(text, len, x);
+    double est = 0.0;
+    for (size_t j = 0; j < n_features; j++) {
+        est += weights[j] * x[j];
+    }
+
+    // No token covers more than max_piece bytes, when that bound is known
+    const double floor_tokens = max_piece > 0 ? (double)((len + max_piece - 1) / max_piece) : 0.0;
+    const double limit = (double)(INT32_MAX - affix);
+    const double lo = std::min(limit, std::max(floor_tokens, floor(est * low_ratio)));
+    const double hi = std::min(limit, std::max(lo, ceil(est * high_ratio)));
+    const double mid = std::min(hi, std::max(lo, round(est)));
+
+    const int32_t extra = add_special ? affix : 0;
+    if (lower) {
+        *lower = (int32_t)lo + extra;
+    }
+    if (upper) {
+        *upper = (int32_t)hi + extra;
+    }
+    return (int32_t)mid + extra;
+}
+
+} // namespace ltok
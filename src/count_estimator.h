@@ -0,0 +1,48 @@
+#ifndef LLAMA_TOKENIZER_COUNT_ESTIMATOR_H
+#define LLAMA_TOKENIZER_COUNT_ESTIMATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ltok {
+
+// Exact token count of text without BOS/EOS, or negative on error
+typedef int32_t (*exact_count_fn)(const void* ctx, const char* text, int32_t text_len);
+
+/**
+ * Token count estimate from byte-class statistics
+ *
+ * One pass over the text counts bytes and runs (words, numbers, ...) per
+ * byte class: ASCII letters, digits, punctuation and whitespace, and
+ * 2-, 3- and 4-byte UTF-8 characters. The estimate is a non-negative
+ * linear model of those counts, fitted at create time against exact
+ * counts of a small built-in multilingual corpus. The error bounds are
+ * the spread seen on that corpus plus a margin, so they are empirical.
+ * For vocabs that never shrink text the lower bound is also at least
+ * text_len / longest piece; normalizing vocabs can fold long runs into a
+ * single token, so they get no such floor.
+ */
+class count_estimator {
+public:
+    // n_affix: tokens add_special places around the text
+    // max_piece_len: upper bound on the bytes one token can cover, or 0
+    // when normalization makes it unbounded
+    void calibrate(exact_count_fn count, const void* ctx, int32_t n_affix, size_t max_piece_len);
+
+    int32_t estimate(const char* text, size_t len, bool add_special, int32_t* lower, int32_t* upper) const;
+
+    static constexpr size_t n_features = 12;
+
+private:
+    static void features(const char* text, size_t len, double* out);
+
+    double weights[n_features] = {};
+    double low_ratio = 0.0;   // exact / estimate, lowest seen
+    double high_ratio = 0.0;  // exact / estimate, highest seen
+    int32_t affix = 0;
+    size_t max_piece = 0;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_COUNT_ESTIMATOR_H
@@ -0,0 +1,131 @@
+#include "double_array_trie.h"
+
+#include <algorithm>
+
+namespace ltok {
+
+void double_array_trie::build(std::vector<std::pair<std::string, int32_t>> entries) {
+    // std::string compares bytes as unsigned char, matching child order
+    std::stable_sort(entries.begin(), entries.end(),
+        [](const std::pair<std::string, int32_t>& a, const std::pair<std::string, int32_t>& b) {
+            return a.first < b.first;
+        });
+
+    // Keep the last of each run of equal keys
+    size_t n_unique = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].first.empty()) {
+            continue;
+        }
+        if (n_unique > 0 && entries[n_unique - 1].first == entries[i].first) {
+            entries[n_unique - 1].second = entries[i].second;
+        } else {
+            if (n_unique != i) {
+                entries[n_unique] = std::move(entries[i]);
+            }
+            n_unique++;
+        }
+    }
+    entries.resize(n_unique);
+
+    const unit free_unit = { 0, -1, NO_VALUE };
+    units.assign(512, free_unit);
+    units[ROOT].check = -2;  // never a valid child
+
+    auto ensure = [&](size_t size) {
+        if (units.size() < size) {
+            units.resize(std::max(size, units.size() * 2), free_unit);
+        }
+    };
+
+    struct pending {
+        int32_t node;
+        size_t lo;
+        size_t hi;
+        size_t depth;
+    };
+    std::vector<pending> stack;
+    if (!entries.empty()) {
+        stack.push_back({ ROOT, 0, entries.size(), 0 });
+    }
+
+    std::vector<std::pair<unsigned char, size_t>> children;  // (label, first entry)
+    size_t next_check_pos = 1;
+
+    while (!stack.empty()) {
+        pending p = stack.back();
+        stack.pop_back();
+
+        if (entries[p.lo].first.size() == p.depth) {
+            units[p.node].value = entries[p.lo].second;
+            p.lo++;
+        }
+        if (p.lo == p.hi) {
+            continue;
+        }
+
+        children.clear();
+        for (size_t i = p.lo; i < p.hi; i++) {
+            const unsigned char c = (unsigned char)entries[i].first[p.depth];
+            if (children.empty() || children.back().first != c) {
+                children.push_back({ c, i });
+            }
+        }
+
+        // Find the lowest base where every child slot is free
+        const size_t first = children.front().first;
+        const size_t last = children.back().first;
+        size_t pos = std::max(next_check_pos, first);
+        size_t n_occupied = 0;
+        bool seen_free = false;
+        size_t base = 0;
+        for (;; pos++) {
+            ensure(pos + 1);
+            if (units[pos].check != -1) {
+                n_occupied++;
+                continue;
+            }
+            if (!seen_free) {
+                next_check_pos = pos;
+                seen_free = true;
+            }
+            base = pos - first;
+            ensure(base + last + 1);
+            bool fits = true;
+            for (const auto& child : children) {
+                if (units[base + child.first].check != -1) {
+                    fits = false;
+                    break;
+                }
+            }
+            if (fits) {
+                break;
+            }
+        }
+        // Stop rescanning a region once it is nearly full
+        if ((double)n_occupied / (double)(pos - next_check_pos + 1) >= 0.95) {
+            next_check_pos = pos;
+        }
+
+        units[p.node].base = (int32_t)base;
+        for (const auto& child : children) {
+            units[base + child.first].check = p.node;
+        }
+
+        for (size_t k = 0; k < children.size(); k++) {
+            const size_t lo = children[k].second;
+            const size_t hi = (k + 1 < children.size()) ? children[k + 1].second : p.hi;
+            stack.push_back({ (int32_t)(base + children[k].first), lo, hi, p.depth + 1 });
+        }
+    }
+
+    // Trim trailing free slots; child() bounds-checks against size()
+    size_t size = units.size();
+    while (size > 1 && units[size - 1].check == -1) {
+        size--;
+    }
+    units.resize(size);
+    units.shrink_to_fit();
+}
+
+} // namespace ltok
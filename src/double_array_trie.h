@@ -0,0 +1,86 @@
+#ifndef LLAMA_TOKENIZER_DOUBLE_ARRAY_TRIE_H
+#define LLAMA_TOKENIZER_DOUBLE_ARRAY_TRIE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ltok {
+
+/**
+ * Static double-array trie mapping byte strings to non-negative values
+ *
+ * All nodes live in one contiguous array: the child of node s on byte c is
+ * node base(s) + c, valid when its check field equals s. A walk is one
+ * array access per byte with no hashing and no pointer chasing.
+ * Immutable after build(); safe to share across threads.
+ */
+class double_array_trie {
+public:
+    static constexpr int32_t NO_VALUE = -1;
+    static constexpr int32_t ROOT = 0;
+
+    /**
+     * Build from (key, value) pairs; keys must be non-empty. For duplicate
+     * keys the pair that comes last wins.
+     */
+    void build(std::vector<std::pair<std::string, int32_t>> entries);
+
+    bool empty() const { return units.size() <= 1; }
+
+    /**
+     * Follow byte c from node; returns the child node or -1
+     */
+    int32_t child(int32_t node, unsigned char c) const {
+        const uint32_t next = (uint32_t)units[node].base + c;
+        if (next < units.size() && units[next].check == node) {
+            return (int32_t)next;
+        }
+        return -1;
+    }
+
+    int32_t value(int32_t node) const { return units[node].value; }
+
+    /**
+     * Value stored for the exact key, or NO_VALUE
+     */
+    int32_t find(const char* key, size_t len) const {
+        int32_t node = ROOT;
+        for (size_t i = 0; i < len && node >= 0; i++) {
+            node = child(node, (unsigned char)key[i]);
+        }
+        return node >= 0 ? units[node].value : NO_VALUE;
+    }
+
+    /**
+     * Visit every key that is a prefix of text as fn(value, key_length),
+     * shortest first
+     */
+    template <typename F>
+    void prefixes(const char* text, size_t len, F&& fn) const {
+        int32_t node = ROOT;
+        for (size_t i = 0; i < len; i++) {
+            node = child(node, (unsigned char)text[i]);
+            if (node < 0) {
+                return;
+            }
+            if (units[node].value != NO_VALUE) {
+                fn(units[node].value, i + 1);
+            }
+        }
+    }
+
+private:
+    struct unit {
+        int32_t base;
+        int32_t check;  // parent node, -1 when the slot is free
+        int32_t value;
+    };
+    std::vector<unit> units;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_DOUBLE_ARRAY_TRIE_H
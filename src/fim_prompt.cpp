@@ -0,0 +1,133 @@
+#include "fim_prompt.h"
+
+#include <algorithm>
+#include <new>
+
+namespace ltok {
+
+namespace {
+
+// First window guess; source code runs about three bytes per token
+static constexpr size_t bytes_per_token_guess = 4;
+
+inline bool is_continuation(char c) {
+    return ((unsigned char)c & 0xC0) == 0x80;
+}
+
+// Start of a tail window of about want bytes: just after a newline (or a
+// space) in its first half, else the next character boundary
+size_t tail_window_start(const char* text, size_t len, size_t want) {
+    const size_t start = len - want;
+    const size_t limit = start + want / 2;
+    for (char boundary : {'\n', ' '}) {
+        for (size_t i = start; i < limit; i++) {
+            if (text[i] == boundary) {
+                return i + 1;
+            }
+        }
+    }
+    size_t i = start;
+    while (i < len && is_continuation(text[i])) {
+        i++;
+    }
+    return i;
+}
+
+// End of a head window of about want bytes: just after a newline (or
+// before a space) in its second half, else a character boundary
+size_t head_window_end(const char* text, size_t want) {
+    const size_t limit = want / 2;
+    for (size_t i = want; i > limit; i--) {
+        if (text[i - 1] == '\n') {
+            return i;
+        }
+    }
+    for (size_t i = want; i > limit; i--) {
+        if (text[i - 1] == ' ') {
+            return i - 1;
+        }
+    }
+    size_t i = want;
+    while (i > 0 && is_continuation(text[i])) {
+        i--;
+    }
+    return i;
+}
+
+bool tokenize_all(edge_tokenize_fn tokenize, const void* ctx, const char* text, size_t len,
+                  std::vector<llama_token>& out) {
+    if (len > (size_t)INT32_MAX) {
+        return false;
+    }
+    try {
+        out.resize(len + 1);
+        int32_t n = tokenize(ctx, text, (int32_t)len, out.data(), (int32_t)std::min<size_t>(out.size(), INT32_MAX));
+        if (n < 0 && (size_t)-(int64_t)n > out.size()) {
+            out.resize((size_t)-(int64_t)n);
+            n = tokenize(ctx, text, (int32_t)len, out.data(), (int32_t)out.size());
+        }
+        if (n < 0) {
+            return false;
+        }
+        out.resize((size_t)n);
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    return true;
+}
+
+// Tokenize growing windows at one end until one is large enough
+template <bool Tail>
+bool tokenize_edge(edge_tokenize_fn tokenize, const void* ctx, const char* text, size_t len, size_t max_tokens,
+                   std::vector<llama_token>& out, bool& truncated) {
+    truncated = false;
+    out.clear();
+    if (max_tokens == 0 || len == 0) {
+        truncated = len > 0;
+        return true;
+    }
+
+    size_t want = (max_tokens + edge_slack) * bytes_per_token_guess;
+    for (;;) {
+        if (want >= len) {
+            if (!tokenize_all(tokenize, ctx, text, len, out)) {
+                return false;
+            }
+            break;
+        }
+        const size_t begin = Tail ? tail_window_start(text, len, want) : 0;
+        const size_t end = Tail ? len : head_window_end(text, want);
+        if (!tokenize_all(tokenize, ctx, text + begin, end - begin, out)) {
+            return false;
+        }
+        if (out.size() >= max_tokens + edge_slack) {
+            truncated = true;
+            break;
+        }
+        want *= 2;
+    }
+
+    if (out.size() > max_tokens) {
+        truncated = true;
+        if (Tail) {
+            out.erase(out.begin(), out.end() - (ptrdiff_t)max_tokens);
+        } else {
+            out.resize(max_tokens);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool tokenize_head(edge_tokenize_fn tokenize, const void* ctx, const char* text, size_t len, size_t max_tokens,
+                   std::vector<llama_token>& out, bool& truncated) {
+    return tokenize_edge<false>(tokenize, ctx, text, len, max_tokens, out, truncated);
+}
+
+bool tokenize_tail(edge_tokenize_fn tokenize, const void* ctx, const char* text, size_t len, size_t max_tokens,
+                   std::vector<llama_token>& out, bool& truncated) {
+    return tokenize_edge<true>(tokenize, ctx, text, len, max_tokens, out, truncated);
+}
+
+} // namespace ltok
@@ -0,0 +1,41 @@
+#ifndef LLAMA_TOKENIZER_FIM_PROMPT_H
+#define LLAMA_TOKENIZER_FIM_PROMPT_H
+
+#include "llama_tokenizer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace ltok {
+
+// Tokenize text; returns the count, or the negative required size when
+// n_max_tokens is too small
+typedef int32_t (*edge_tokenize_fn)(const void* ctx, const char* text, int32_t text_len,
+                                    llama_token* tokens, int32_t n_max_tokens);
+
+/**
+ * The first or last max_tokens tokens of text, tokenizing only a window
+ * at that end
+ *
+ * The window grows from an estimate until it yields edge_slack tokens
+ * more than needed or covers the whole text. It is cut after a newline
+ * where there is one (else after a space, else at a character boundary),
+ * and the slack tokens next to the cut, which the cut may have split
+ * differently, are dropped; the tokens kept are those of the whole text
+ * except where a pre-token spans more than edge_slack tokens.
+ *
+ * truncated is set when text yields more tokens than were kept. False on
+ * failure.
+ */
+bool tokenize_head(edge_tokenize_fn tokenize, const void* ctx, const char* text, size_t len, size_t max_tokens,
+                   std::vector<llama_token>& out, bool& truncated);
+bool tokenize_tail(edge_tokenize_fn tokenize, const void* ctx, const char* text, size_t len, size_t max_tokens,
+                   std::vector<llama_token>& out, bool& truncated);
+
+static constexpr size_t edge_slack = 8;
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_FIM_PROMPT_H
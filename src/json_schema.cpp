@@ -0,0 +1,844 @@
+#include "json_schema.h"
+#include "regex_dfa.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ltok {
+
+namespace {
+
+static constexpr int max_depth = 64;
+
+struct json_value {
+    enum value_kind { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT } kind = NUL;
+    bool boolean = false;
+    std::string text;  // decoded string, or the number as written
+    std::vector<json_value> items;
+    std::vector<std::pair<std::string, json_value>> members;
+
+    const json_value* get(const char* name) const {
+        for (const auto& member : members) {
+            if (member.first == name) {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class json_reader {
+public:
+    json_reader(const char* text, size_t len, std::string& error) : p(text), len(len), error(error) {}
+
+    bool read(json_value& out) {
+        if (!value(out, 0)) {
+            return false;
+        }
+        skip_space();
+        return pos == len || fail("trailing characters");
+    }
+
+private:
+    bool fail(const char* message) {
+        error = std::string("schema JSON: ") + message + " at offset " + std::to_string(pos);
+        return false;
+    }
+
+    void skip_space() {
+        while (pos < len && (p[pos] == ' ' || p[pos] == '\t' || p[pos] == '\n' || p[pos] == '\r')) {
+            pos++;
+        }
+    }
+
+    bool literal(const char* word) {
+        const size_t n = strlen(word);
+        if (len - pos < n || memcmp(p + pos, word, n) != 0) {
+            return fail("unexpected character");
+        }
+        pos += n;
+        return true;
+    }
+
+    bool value(json_value& out, int depth) {
+        if (depth > max_depth) {
+            return fail("nested too deeply");
+        }
+        skip_space();
+        if (pos >= len) {
+            return fail("unexpected end");
+        }
+        switch (p[pos]) {
+        case 'n':
+            out.kind = json_value::NUL;
+            return literal("null");
+        case 't':
+            out.kind = json_value::BOOLEAN;
+            out.boolean = true;
+            return literal("true");
+        case 'f':
+            out.kind = json_value::BOOLEAN;
+            return literal("false");
+        case '"':
+            out.kind = json_value::STRING;
+            return string(out.text);
+        case '[':
+            out.kind = json_value::ARRAY;
+            pos++;
+            skip_space();
+            if (pos < len && p[pos] == ']') {
+                pos++;
+                return true;
+            }
+            for (;;) {
+                out.items.emplace_back();
+                if (!value(out.items.back(), depth + 1)) {
+                    return false;
+                }
+                skip_space();
+                if (pos < len && p[pos] == ',') {
+                    pos++;
+                } else if (pos < len && p[pos] == ']') {
+                    pos++;
+                    return true;
+                } else {
+                    return fail("expected ',' or ']'");
+                }
+            }
+        case '{':
+            out.kind = json_value::OBJECT;
+            pos++;
+            skip_space();
+            if (pos < len && p[pos] == '}') {
+                pos++;
+                return true;
+            }
+            for (;;) {
+                skip_space();
+                std::string name;
+                if (pos >= len || p[pos] != '"' || !string(name)) {
+                    return error.empty() ? fail("expected a member name") : false;
+                }
+                skip_space();
+                if (pos >= len || p[pos] != ':') {
+                    return fail("expected ':'");
+                }
+                pos++;
+                out.members.emplace_back(std::move(name), json_value());
+                if (!value(out.members.back().second, depth + 1)) {
+                    return false;
+                }
+                skip_space();
+                if (pos < len && p[pos] == ',') {
+                    pos++;
+                } else if (pos < len && p[pos] == '}') {
+                    pos++;
+                    return true;
+                } else {
+                    return fail("expected ',' or '}'");
+                }
+            }
+        default:
+            out.kind = json_value::NUMBER;
+            return number(out.text);
+        }
+    }
+
+    bool digits() {
+        const size_t start = pos;
+        while (pos < len && p[pos] >= '0' && p[pos] <= '9') {
+            pos++;
+        }
+        return pos > start;
+    }
+
+    bool number(std::string& out) {
+        const size_t start = pos;
+        if (pos < len && p[pos] == '-') {
+            pos++;
+        }
+        if (pos < len && p[pos] == '0') {
+            pos++;
+        } else if (!digits()) {
+            return fail("unexpected character");
+        }
+        if (pos < len && p[pos] == '.') {
+            pos++;
+            if (!digits()) {
+                return fail("bad number");
+            }
+        }
+        if (pos < len && (p[pos] == 'e' || p[pos] == 'E')) {
+            pos++;
+            if (pos < len && (p[pos] == '+' || p[pos] == '-')) {
+                pos++;
+            }
+            if (!digits()) {
+                return fail("bad number");
+            }
+        }
+        out.assign(p + start, pos - start);
+        return true;
+    }
+
+    bool hex4(uint32_t& out) {
+        out = 0;
+        for (int i = 0; i < 4; i++, pos++) {
+            const char c = pos < len ? p[pos] : 0;
+            const int v = c >= '0' && c <= '9' ? c - '0'
+                        : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                        : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (v < 0) {
+                return fail("bad \\u escape");
+            }
+            out = out * 16 + (uint32_t)v;
+        }
+        return true;
+    }
+
+    static void append_utf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += (char)cp;
+        } else if (cp < 0x800) {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool string(std::string& out) {
+        pos++;
+        for (;;) {
+            if (pos >= len) {
+                return fail("unterminated string");
+            }
+            const char c = p[pos++];
+            if (c == '"') {
+                return true;
+            }
+            if ((unsigned char)c < 0x20) {
+                return fail("control character in string");
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= len) {
+                return fail("unterminated string");
+            }
+            const char e = p[pos++];
+            switch (e) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!hex4(cp)) {
+                    return false;
+                }
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low;
+                    if (pos + 2 > len || p[pos] != '\\' || p[pos + 1] != 'u') {
+                        return fail("unpaired surrogate");
+                    }
+                    pos += 2;
+                    if (!hex4(low)) {
+                        return false;
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        return fail("unpaired surrogate");
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return fail("unpaired surrogate");
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                return fail("bad escape");
+            }
+        }
+    }
+
+    const char* p;
+    const size_t len;
+    size_t pos = 0;
+    std::string& error;
+};
+
+// Regex pieces for compact JSON
+static const char* const string_char = "(?:[^\"\\\\\\x00-\\x1F]|\\\\(?:[\"\\\\/bfnrt]|u[0-9a-fA-F]{4}))";
+// One code point of string content, for length bounds: a surrogate pair
+// escape is one code point, and a lone surrogate is refused
+static const char* const string_code_point =
+    "(?:[^\"\\\\\\x00-\\x1F]|\\\\(?:[\"\\\\/bfnrt]|u(?:[0-9a-cA-CeEfF][0-9a-fA-F]{3}|[dD][0-7][0-9a-fA-F]{2}"
+    "|[dD][89abAB][0-9a-fA-F]{2}\\\\u[dD][c-fC-F][0-9a-fA-F]{2})))";
+static const char* const integer_regex = "-?(?:0|[1-9][0-9]*)";
+static const char* const number_regex = "-?(?:0|[1-9][0-9]*)(?:\\.[0-9]+)?(?:[eE][-+]?[0-9]+)?";
+static const char* const colon = ": ?";
+static const char* const comma = ", ?";
+
+void append_escaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        if (strchr("\\.^$|?*+()[]{}", c) && c != 0) {
+            out += '\\';
+        }
+        out += c;
+    }
+}
+
+// JSON text of a string, as written in compact output
+std::string json_string(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                static const char hex[] = "0123456789abcdef";
+                out += "\\u00";
+                out += hex[(unsigned char)c >> 4];
+                out += hex[c & 0xF];
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+// Regex for exactly this value
+void literal_regex(const json_value& value, std::string& out) {
+    switch (value.kind) {
+    case json_value::NUL: out += "null"; break;
+    case json_value::BOOLEAN: out += value.boolean ? "true" : "false"; break;
+    case json_value::NUMBER: append_escaped(out, value.text); break;
+    case json_value::STRING: append_escaped(out, json_string(value.text)); break;
+    case json_value::ARRAY:
+        out += "\\[";
+        for (size_t i = 0; i < value.items.size(); i++) {
+            out += i ? comma : "";
+            literal_regex(value.items[i], out);
+        }
+        out += "\\]";
+        break;
+    case json_value::OBJECT:
+        out += "\\{";
+        for (size_t i = 0; i < value.members.size(); i++) {
+            out += i ? comma : "";
+            append_escaped(out, json_string(value.members[i].first));
+            out += colon;
+            literal_regex(value.members[i].second, out);
+        }
+        out += "\\}";
+        break;
+    }
+}
+
+// Whether two literal values may be the same JSON value. Numbers are
+// equal by value (1 and 1.0), so only plain integers compare by text
+bool may_equal(const json_value& a, const json_value& b) {
+    if (a.kind != b.kind) {
+        return false;
+    }
+    switch (a.kind) {
+    case json_value::NUL:
+        return true;
+    case json_value::BOOLEAN:
+        return a.boolean == b.boolean;
+    case json_value::NUMBER: {
+        const auto plain = [](const std::string& text) {
+            return text.find_first_of(".eE") == std::string::npos && text != "-0";
+        };
+        return a.text == b.text || !plain(a.text) || !plain(b.text);
+    }
+    case json_value::STRING:
+        return a.text == b.text;
+    case json_value::ARRAY:
+        if (a.items.size() != b.items.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.items.size(); i++) {
+            if (!may_equal(a.items[i], b.items[i])) {
+                return false;
+            }
+        }
+        return true;
+    case json_value::OBJECT: {
+        // Member order does not matter; every member needs a counterpart
+        const auto covered = [](const json_value& x, const json_value& y) {
+            for (const auto& member : x.members) {
+                bool found = false;
+                for (const auto& other : y.members) {
+                    found = found || (member.first == other.first && may_equal(member.second, other.second));
+                }
+                if (!found) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        return covered(a, b) && covered(b, a);
+    }
+    }
+    return true;
+}
+
+// The JSON types a schema's values may have and, when it is made only of
+// "const"/"enum" (possibly under "anyOf"/"oneOf"), the values themselves
+struct value_set {
+    unsigned types = 0;
+    bool literal = true;
+    std::vector<const json_value*> values;
+};
+
+static constexpr unsigned any_type = (1u << (json_value::OBJECT + 1)) - 1;
+
+void values_of(const json_value& schema, value_set& out) {
+    const json_value* value = schema.kind == json_value::OBJECT ? schema.get("const") : nullptr;
+    const json_value* values = schema.kind == json_value::OBJECT ? schema.get("enum") : nullptr;
+    const json_value* branches = nullptr;
+    if (schema.kind == json_value::OBJECT) {
+        branches = schema.get("anyOf") ? schema.get("anyOf") : schema.get("oneOf");
+    }
+    if (value) {
+        out.types |= 1u << value->kind;
+        out.values.push_back(value);
+        return;
+    }
+    if (values && values->kind == json_value::ARRAY) {
+        for (const json_value& item : values->items) {
+            out.types |= 1u << item.kind;
+            out.values.push_back(&item);
+        }
+        return;
+    }
+    if (branches && branches->kind == json_value::ARRAY) {
+        for (const json_value& item : branches->items) {
+            values_of(item, out);
+        }
+        return;
+    }
+
+    out.literal = false;
+    const json_value* type = schema.kind == json_value::OBJECT ? schema.get("type") : nullptr;
+    std::vector<const json_value*> names;
+    if (type && type->kind == json_value::STRING) {
+        names.push_back(type);
+    } else if (type && type->kind == json_value::ARRAY) {
+        for (const json_value& item : type->items) {
+            names.push_back(&item);
+        }
+    } else if (!type && schema.kind == json_value::OBJECT && schema.get("properties")) {
+        out.types |= 1u << json_value::OBJECT;
+        return;
+    } else if (!type && schema.kind == json_value::OBJECT && schema.get("items")) {
+        out.types |= 1u << json_value::ARRAY;
+        return;
+    } else {
+        out.types = any_type;
+        return;
+    }
+    for (const json_value* name : names) {
+        const std::string& t = name->text;
+        out.types |= name->kind != json_value::STRING ? any_type
+                   : t == "integer" || t == "number"  ? 1u << json_value::NUMBER
+                   : t == "string"                    ? 1u << json_value::STRING
+                   : t == "boolean"                   ? 1u << json_value::BOOLEAN
+                   : t == "null"                      ? 1u << json_value::NUL
+                   : t == "object"                    ? 1u << json_value::OBJECT
+                   : t == "array"                     ? 1u << json_value::ARRAY
+                                                      : any_type;
+    }
+}
+
+// Whether no value can match two of the branches, by type or, for
+// literal branches, by value. Alternation then matches what "oneOf" does
+bool disjoint_branches(const json_value& branches) {
+    std::vector<value_set> sets(branches.items.size());
+    for (size_t i = 0; i < sets.size(); i++) {
+        values_of(branches.items[i], sets[i]);
+    }
+    for (size_t i = 0; i < sets.size(); i++) {
+        for (size_t j = i + 1; j < sets.size(); j++) {
+            if (!(sets[i].types & sets[j].types)) {
+                continue;
+            }
+            if (!sets[i].literal || !sets[j].literal) {
+                return false;
+            }
+            for (const json_value* a : sets[i].values) {
+                for (const json_value* b : sets[j].values) {
+                    if (may_equal(*a, *b)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+class schema_compiler {
+public:
+    explicit schema_compiler(std::string& error) : error(error) {}
+
+    bool compile(const json_value& schema, std::string& out, int depth) {
+        if (depth > max_depth) {
+            return fail("schema nested too deeply");
+        }
+        if (schema.kind != json_value::OBJECT) {
+            return fail("a schema must be an object");
+        }
+        for (const auto& member : schema.members) {
+            if (!known_keyword(member.first)) {
+                error = "unsupported schema keyword \"" + member.first + "\"";
+                return false;
+            }
+        }
+
+        if (const json_value* value = schema.get("additionalProperties")) {
+            if (value->kind != json_value::BOOLEAN || value->boolean) {
+                return fail("only \"additionalProperties\": false is supported");
+            }
+        }
+
+        // Keywords that fix the whole value; anything next to them would
+        // narrow it further, so it is rejected rather than ignored
+        if (const json_value* value = schema.get("const")) {
+            if (!alone(schema, "const")) {
+                return fail("keywords next to \"const\" are not supported");
+            }
+            literal_regex(*value, out);
+            return true;
+        }
+        if (const json_value* values = schema.get("enum")) {
+            if (values->kind != json_value::ARRAY || values->items.empty()) {
+                return fail("\"enum\" must be a non-empty array");
+            }
+            if (!alone(schema, "enum")) {
+                return fail("keywords next to \"enum\" are not supported");
+            }
+            out += "(?:";
+            for (size_t i = 0; i < values->items.size(); i++) {
+                out += i ? "|" : "";
+                literal_regex(values->items[i], out);
+            }
+            out += ")";
+            return true;
+        }
+        const char* const any_of_keyword = schema.get("anyOf") ? "anyOf" : "oneOf";
+        if (const json_value* any_of = schema.get(any_of_keyword)) {
+            if (any_of->kind != json_value::ARRAY || any_of->items.empty()) {
+                error = std::string("\"") + any_of_keyword + "\" must be a non-empty array";
+                return false;
+            }
+            if (!alone(schema, any_of_keyword)) {
+                error = std::string("keywords next to \"") + any_of_keyword + "\" are not supported";
+                return false;
+            }
+            // Alternation accepts a value that matches several branches,
+            // which "oneOf" refuses
+            if (!schema.get("anyOf") && !disjoint_branches(*any_of)) {
+                return fail("\"oneOf\" with branches that may overlap is not supported");
+            }
+            out += "(?:";
+            for (size_t i = 0; i < any_of->items.size(); i++) {
+                out += i ? "|" : "";
+                if (!compile(any_of->items[i], out, depth + 1)) {
+                    return false;
+                }
+            }
+            out += ")";
+            return true;
+        }
+
+        std::vector<std::string> types;
+        const json_value* type = schema.get("type");
+        if (type && type->kind == json_value::STRING) {
+            types.push_back(type->text);
+        } else if (type && type->kind == json_value::ARRAY) {
+            for (const json_value& item : type->items) {
+                if (item.kind != json_value::STRING) {
+                    return fail("\"type\" must be a string or an array of strings");
+                }
+                types.push_back(item.text);
+            }
+        } else if (type) {
+            return fail("\"type\" must be a string or an array of strings");
+        } else if (schema.get("properties")) {
+            types.push_back("object");
+        } else if (schema.get("items")) {
+            types.push_back("array");
+        } else {
+            return fail("a schema without \"type\" (any value) is not supported");
+        }
+
+        out += types.size() > 1 ? "(?:" : "";
+        for (size_t i = 0; i < types.size(); i++) {
+            out += i ? "|" : "";
+            if (!compile_type(schema, types[i], out, depth)) {
+                return false;
+            }
+        }
+        out += types.size() > 1 ? ")" : "";
+        return true;
+    }
+
+private:
+    bool fail(const char* message) {
+        error = message;
+        return false;
+    }
+
+    static bool known_keyword(const std::string& name) {
+        static const char* const keywords[] = {
+            "type", "enum", "const", "anyOf", "oneOf", "properties", "required", "additionalProperties",
+            "items", "minItems", "maxItems", "minLength", "maxLength", "pattern",
+        };
+        for (const char* keyword : keywords) {
+            if (name == keyword) {
+                return true;
+            }
+        }
+        return annotation(name);
+    }
+
+    // Whether keyword is the only member of schema besides annotations
+    static bool alone(const json_value& schema, const char* keyword) {
+        for (const auto& member : schema.members) {
+            if (!annotation(member.first) && member.first != keyword) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool annotation(const std::string& name) {
+        return name == "title" || name == "description" || name == "default" || name == "examples" ||
+               name == "$schema" || name == "$id" || name == "$comment";
+    }
+
+    // A non-negative integer keyword; -1 when absent
+    bool count(const json_value& schema, const char* name, long& out) {
+        out = -1;
+        const json_value* value = schema.get(name);
+        if (!value) {
+            return true;
+        }
+        if (value->kind != json_value::NUMBER || value->text.find_first_of(".eE-") != std::string::npos ||
+            value->text.size() > 6) {
+            error = std::string("\"") + name + "\" must be a small non-negative integer";
+            return false;
+        }
+        out = std::stol(value->text);
+        return true;
+    }
+
+    bool compile_type(const json_value& schema, const std::string& type, std::string& out, int depth) {
+        if (type == "string") {
+            return compile_string(schema, out);
+        }
+        if (type == "integer") {
+            out += integer_regex;
+        } else if (type == "number") {
+            out += number_regex;
+        } else if (type == "boolean") {
+            out += "(?:true|false)";
+        } else if (type == "null") {
+            out += "null";
+        } else if (type == "object") {
+            return compile_object(schema, out, depth);
+        } else if (type == "array") {
+            return compile_array(schema, out, depth);
+        } else {
+            error = "unknown type \"" + type + "\"";
+            return false;
+        }
+        return true;
+    }
+
+    bool compile_string(const json_value& schema, std::string& out) {
+        long min_length;
+        long max_length;
+        if (!count(schema, "minLength", min_length) || !count(schema, "maxLength", max_length)) {
+            return false;
+        }
+        const json_value* pattern = schema.get("pattern");
+        out += '"';
+        if (pattern) {
+            if (pattern->kind != json_value::STRING) {
+                return fail("\"pattern\" must be a string");
+            }
+            if (min_length >= 0 || max_length >= 0) {
+                return fail("\"pattern\" with a length bound is not supported");
+            }
+            // Unanchored ends may be surrounded by any string content
+            std::string body = pattern->text;
+            const bool anchored_start = !body.empty() && body[0] == '^';
+            const bool anchored_end = body.size() > (anchored_start ? 1 : 0) && body.back() == '$' &&
+                                      (body.size() < 2 || body[body.size() - 2] != '\\');
+            if (anchored_end) {
+                body.pop_back();
+            }
+            if (anchored_start) {
+                body.erase(0, 1);
+            }
+            // The pattern matches decoded content; '"', '\\' and control
+            // characters in it may only appear escaped
+            std::string encoded;
+            std::string message;
+            if (!json_string_regex(body.data(), body.size(), encoded, message)) {
+                error = "\"pattern\": " + message;
+                return false;
+            }
+            out += anchored_start ? "" : std::string(string_char) + "*";
+            out += encoded;
+            out += anchored_end ? "" : std::string(string_char) + "*";
+        } else if (min_length < 0 && max_length < 0) {
+            out += string_char;
+            out += '*';
+        } else {
+            // Bounds count code points, not escapes
+            out += string_code_point;
+            out += "{" + std::to_string(std::max(min_length, 0L)) + "," +
+                   (max_length >= 0 ? std::to_string(max_length) : std::string()) + "}";
+        }
+        out += '"';
+        return true;
+    }
+
+    bool compile_object(const json_value& schema, std::string& out, int depth) {
+        const json_value* properties = schema.get("properties");
+        const json_value* required = schema.get("required");
+        if (properties && properties->kind != json_value::OBJECT) {
+            return fail("\"properties\" must be an object");
+        }
+        if (required && required->kind != json_value::ARRAY) {
+            return fail("\"required\" must be an array");
+        }
+
+        // One "name": value regex per property, and whether it is required
+        std::vector<std::pair<std::string, bool>> members;
+        if (properties) {
+            for (const auto& property : properties->members) {
+                std::string member;
+                append_escaped(member, json_string(property.first));
+                member += colon;
+                if (!compile(property.second, member, depth + 1)) {
+                    return false;
+                }
+                members.emplace_back(std::move(member), false);
+            }
+        }
+        for (size_t i = 0; required && i < required->items.size(); i++) {
+            const json_value& name = required->items[i];
+            bool found = false;
+            for (size_t k = 0; properties && k < properties->members.size(); k++) {
+                if (name.kind == json_value::STRING && properties->members[k].first == name.text) {
+                    members[k].second = found = true;
+                }
+            }
+            if (!found) {
+                return fail("a required property is missing from \"properties\"");
+            }
+        }
+
+        // rest[i]: members i.. after at least one member was written
+        std::vector<std::string> rest(members.size() + 1);
+        for (size_t i = members.size(); i-- > 0;) {
+            const std::string member = std::string(comma) + members[i].first;
+            rest[i] = (members[i].second ? member : "(?:" + member + ")?") + rest[i + 1];
+        }
+        // first(i): members i.. before any was written
+        std::string first;
+        for (size_t i = members.size(); i-- > 0;) {
+            first = members[i].second ? members[i].first + rest[i + 1]
+                                      : "(?:" + members[i].first + rest[i + 1] + "|" + first + ")";
+        }
+        out += "\\{" + first + "\\}";
+        return true;
+    }
+
+    bool compile_array(const json_value& schema, std::string& out, int depth) {
+        const json_value* items = schema.get("items");
+        if (!items) {
+            return fail("an array without \"items\" is not supported");
+        }
+        long min_items;
+        long max_items;
+        if (!count(schema, "minItems", min_items) || !count(schema, "maxItems", max_items)) {
+            return false;
+        }
+        min_items = std::max(min_items, 0L);
+        if (max_items >= 0 && max_items < min_items) {
+            return fail("\"maxItems\" is below \"minItems\"");
+        }
+        if (max_items == 0) {
+            out += "\\[\\]";
+            return true;
+        }
+        std::string item;
+        if (!compile(*items, item, depth + 1)) {
+            return false;
+        }
+        std::string more = "(?:" + std::string(comma) + item + "){" + std::to_string(std::max(min_items - 1, 0L)) +
+                           "," + (max_items >= 0 ? std::to_string(max_items - 1) : std::string()) + "}";
+        out += "\\[";
+        out += min_items == 0 ? "(?:" + item + more + ")?" : item + more;
+        out += "\\]";
+        return true;
+    }
+
+    std::string& error;
+};
+
+} // namespace
+
+bool json_schema_to_regex(const char* schema, size_t len, std::string& regex, std::string& error) {
+    regex.clear();
+    error.clear();
+    try {
+        json_value root;
+        json_reader reader(schema, len, error);
+        if (!reader.read(root)) {
+            return false;
+        }
+        schema_compiler compiler(error);
+        if (!compiler.compile(root, regex, 0)) {
+            regex.clear();
+            return false;
+        }
+    } catch (const std::bad_alloc&) {
+        regex.clear();
+        error = "out of memory";
+        return false;
+    }
+    return true;
+}
+
+} // namespace ltok
@@ -0,0 +1,35 @@
+#ifndef LLAMA_TOKENIZER_JSON_SCHEMA_H
+#define LLAMA_TOKENIZER_JSON_SCHEMA_H
+
+#include <stddef.h>
+
+#include <string>
+
+namespace ltok {
+
+/**
+ * Regex (in byte_dfa syntax) for the compact JSON documents a schema
+ * allows
+ *
+ * Supported: "type" (one or a list of string, integer, number, boolean,
+ * null, object, array), "enum", "const", "anyOf"/"oneOf", string
+ * "minLength"/"maxLength"/"pattern", object "properties"/"required"/
+ * "additionalProperties": false, array "items"/"minItems"/"maxItems".
+ * "const", "enum" and "anyOf"/"oneOf" take no sibling keywords.
+ * "oneOf" needs branches no value can match twice: of different types,
+ * or "const"/"enum" branches with different values.
+ * Properties are written in schema order and no others are allowed; at
+ * most one space follows ':' and ','. String length bounds count code
+ * points, so a surrogate pair escape is one. A "pattern" matches the
+ * decoded string, so the quotes, backslashes and control characters it
+ * allows are written escaped. Anything else a schema uses ($ref, recursion,
+ * numeric bounds...) is rejected rather than ignored, so the constraint
+ * is never looser than the schema.
+ *
+ * False with error set for malformed JSON or an unsupported schema.
+ */
+bool json_schema_to_regex(const char* schema, size_t len, std::string& regex, std::string& error);
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_JSON_SCHEMA_H
@@ -1,32 +1,44 @@
 #include "llama_tokenizer.h"
+#include "llama_tokenizer_internal.h"
 #include "llama.h"
+#include "fim_prompt.h"
+#include "json_schema.h"
+#include "log_sink.h"
+#include "scratch.h"
+#include "spm_tokenizer.h"
+#include "trace.h"
+#include "ugm_tokenizer.h"
+#include "unicode_tables.h"
+#include "utf8_scan.h"
+#include "wpm_tokenizer.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
 
-struct llama_tokenizer_t {
-    llama_model* model;
-    const llama_vocab* vocab;
-};
+void llama_tokenizer_set_log_level(llama_tokenizer_log_level level) {
+    ltok::log_set_level(level);
+}
 
-// No-op callback to disable all logging
-static void log_callback_none(enum ggml_log_level level, const char * text, void * user_data) {
-    (void)level;
-    (void)text;
-    (void)user_data;
-    // Do nothing - this suppresses all log output
+void llama_tokenizer_set_log_callback(llama_tokenizer_log_fn fn, void* user_data) {
+    ltok::log_set_callback(fn, user_data);
 }
 
-void llama_tokenizer_set_log_level(llama_tokenizer_log_level level) {
-    // For NONE or invalid levels, set a no-op callback to suppress all logs
-    // Note: llama_log_set(NULL, NULL) would output everything to stderr
-    if (level == LLAMA_TOKENIZER_LOG_NONE || level < 0 || level > LLAMA_TOKENIZER_LOG_CONT) {
-        llama_log_set(log_callback_none, NULL);
-    } else {
-        // For other levels, set NULL to use default stderr output
-        // Note: llama.cpp doesn't provide runtime log level filtering
-        llama_log_set(NULL, NULL);
-    }
+bool llama_tokenizer_log_async_start(size_t capacity) {
+    return ltok::log_async_start(capacity);
+}
+
+void llama_tokenizer_log_async_stop(void) {
+    ltok::log_async_stop();
+}
+
+uint64_t llama_tokenizer_log_dropped(void) {
+    return ltok::log_dropped();
 }
 
 void llama_tokenizer_init(void) {
@@ -37,27 +49,151 @@ void llama_tokenizer_free_backend(void) {
     llama_backend_free();
 }
 
+// Work out which tokens llama.cpp adds around the text for add_special by
+// comparing a probe tokenized with and without it
+static bool probe_special_affixes(llama_tokenizer_t* tokenizer) {
+    llama_token empty[8];
+    llama_token plain[8];
+    llama_token full[16];
+    int32_t n_empty = llama_tokenize(tokenizer->vocab, "", 0, empty, 8, true, false);
+    int32_t n_plain = llama_tokenize(tokenizer->vocab, "a", 1, plain, 8, false, false);
+    int32_t n_full = llama_tokenize(tokenizer->vocab, "a", 1, full, 16, true, false);
+    if (n_empty < 0 || n_plain <= 0 || n_full != n_empty + n_plain) {
+        return false;
+    }
+
+    for (int32_t k = 0; k <= n_empty; k++) {
+        if (memcmp(full, empty, k * sizeof(llama_token)) == 0 &&
+            memcmp(full + k, plain, n_plain * sizeof(llama_token)) == 0 &&
+            memcmp(full + k + n_plain, empty + k, (n_empty - k) * sizeof(llama_token)) == 0) {
+            tokenizer->special_prefix.assign(empty, empty + k);
+            tokenizer->special_suffix.assign(empty + k, empty + n_empty);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Probe corpus for checking native kernels against llama.cpp: whitespace
+// runs, digits, code, controls, accents (precomposed, combining and
+// uppercase), fullwidth forms, CJK, emoji and characters rare enough to
+// need byte fallback
+static const char* const native_probes[] = {
+    "Hello world",
+    "Hello, world! How are you doing today?",
+    " leading space",
+    "trailing space ",
+    "multiple   spaces\tand\ttabs\n\nand newlines\r\n",
+    "   ",
+    "\n",
+    "1234567890 3.14159 -42 1e-9 0x7fffffff",
+    "for (int i = 0; i < n; ++i) { sum += a[i] * b[i]; }",
+    "def f(x):\n    return {'key': [x, None, True]}\n",
+    "UPPER lower MiXeD CamelCaseIdentifier snake_case_name",
+    "!?.,;:'\"()[]{}<>@#$%^&*-_=+/\\|~`",
+    "caf\xC3\xA9 na\xC3\xAFve r\xC3\xA9sum\xC3\xA9 cafe\xCC\x81",
+    "\xC3\x80\xC3\x89\xC3\x8E \xC3\x9Cn\xC3\xAF" "c\xC3\xB6" "d\xC3\xA9 \xC3\x9F \xC3\x98 \xC5\x81\xC3\xB3" "d\xC5\xBA",
+    "control\x01" "chars\x7f and\x0bvertical\x0ctabs",
+    "\xEF\xBC\xA1\xEF\xBC\xA2\xEF\xBC\xA3 \xEF\xBC\x91\xEF\xBC\x92\xEF\xBC\x93",
+    "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87\xE7\xAB\xA0 \xED\x95\x9C\xEA\xB5\xAD\xEC\x96\xB4",
+    "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 \xCE\x93\xCE\xB5\xCE\xB9\xCE\xAC \xD9\x85\xD8\xB1\xD8\xAD\xD8\xA8\xD8\xA7",
+    "\xF0\x9F\x98\x80\xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD \xF0\x9F\xA6\x80 \xE2\x80\x8B\xE2\x80\x94\xE2\x80\xA6",
+    "\xF0\x90\x8C\xB0\xF0\x90\x8C\xB1 \xE1\x9A\xA0\xE1\x9A\xA2 \xEA\x99\xAE",
+    "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs.",
+};
+
+// Whether the native kernel tokenizes probe as llama.cpp does; probes the
+// kernel hands back to llama.cpp, or that contain user-defined tokens,
+// prove nothing and pass
+static bool native_matches_llama(const llama_tokenizer_t* tokenizer, const char* probe, int32_t len) {
+    std::vector<ltok::text_fragment> fragments;
+    if (tokenizer->specials.partition(probe, (size_t)len, false, fragments)) {
+        return true;
+    }
+
+    llama_token dummy;
+    int32_t n = llama_tokenize(tokenizer->vocab, probe, len, &dummy, 0, false, false);
+    n = (n < 0) ? -n : n;
+    std::vector<llama_token> expected(n);
+    if (n > 0 && llama_tokenize(tokenizer->vocab, probe, len, expected.data(), n, false, false) != n) {
+        return false;
+    }
+
+    std::vector<llama_token> actual;
+    if (!tokenizer->native->tokenize(probe, (size_t)len, actual)) {
+        return true;  // falls back to llama.cpp for such input anyway
+    }
+    return actual == expected;
+}
+
+// Native kernels must agree with llama.cpp token for token; a handle whose
+// kernel disagrees on any probe keeps using llama.cpp
+static bool verify_native_tokenizer(const llama_tokenizer_t* tokenizer) {
+    for (const char* probe : native_probes) {
+        if (!native_matches_llama(tokenizer, probe, (int32_t)strlen(probe))) {
+            return false;
+        }
+    }
+
+    // The WordPiece kernel normalizes with vendored Unicode tables: every
+    // BMP character on its own must come out as llama.cpp's tables make
+    // it, or the llama.cpp in use was built from another Unicode version
+    if (llama_vocab_type(tokenizer->vocab) == LLAMA_VOCAB_TYPE_WPM) {
+        std::string probe;
+        for (uint32_t first = 0x80; first < 0x10000; first += 0x1000) {
+            probe.clear();
+            for (uint32_t cpt = first; cpt < first + 0x1000; cpt++) {
+                if (cpt >= 0xD800 && cpt <= 0xDFFF) {
+                    continue;
+                }
+                char utf8[4];
+                probe.append(utf8, ltok::unicode_to_utf8(cpt, utf8));
+                probe.push_back(' ');
+            }
+            if (!native_matches_llama(tokenizer, probe.data(), (int32_t)probe.size())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void select_tokenize_fns(llama_tokenizer_t* tokenizer);
+static void calibrate_estimator(llama_tokenizer_t* tokenizer);
+
 llama_tokenizer_t* llama_tokenizer_create(const char* model_path) {
     if (!model_path) {
         return NULL;
     }
-    llama_tokenizer_t* tokenizer = (llama_tokenizer_t*)malloc(sizeof(llama_tokenizer_t));
+    ltok::trace_span create_span(LLAMA_TOKENIZER_TRACE_CREATE, 0);
+    llama_tokenizer_t* tokenizer = new (std::nothrow) llama_tokenizer_t();
     if (!tokenizer) {
         return NULL;
     }
     llama_model_params params = llama_model_default_params();
     params.vocab_only = true;
+    ltok::trace_span load_span(LLAMA_TOKENIZER_TRACE_MODEL_LOAD, 0);
     tokenizer->model = llama_model_load_from_file(model_path, params);
+    load_span.end();
     if (!tokenizer->model) {
-        free(tokenizer);
+        delete tokenizer;
         return NULL;
     }
     tokenizer->vocab = llama_model_get_vocab(tokenizer->model);
     if (!tokenizer->vocab) {
         llama_model_free(tokenizer->model);
-        free(tokenizer);
+        delete tokenizer;
         return NULL;
     }
+    ltok::trace_span build_span(LLAMA_TOKENIZER_TRACE_KERNEL_BUILD, 0);
+    tokenizer->specials.build(tokenizer->vocab);
+    tokenizer->special_affixes_ok = probe_special_affixes(tokenizer);
+    tokenizer->native = ltok::create_native_tokenizer(tokenizer->vocab, model_path);
+    if (tokenizer->native && !verify_native_tokenizer(tokenizer)) {
+        tokenizer->native.reset();
+    }
+    select_tokenize_fns(tokenizer);
+    calibrate_estimator(tokenizer);
     return tokenizer;
 }
 
@@ -66,7 +202,7 @@ void llama_tokenizer_destroy(llama_tokenizer_t* tokenizer) {
         if (tokenizer->model) {
             llama_model_free(tokenizer->model);
         }
-        free(tokenizer);
+        delete tokenizer;
     }
 }
 
@@ -182,18 +318,36 @@ bool llama_tokenizer_should_add_eos(const llama_tokenizer_t* tokenizer) {
     return llama_vocab_get_add_eos(tokenizer->vocab);
 }
 
-int32_t llama_tokenizer_tokenize(
+bool llama_tokenizer_validate_utf8(const char* text, int32_t text_len, int32_t* error_offset) {
+    if (!text || text_len < 0) {
+        if (error_offset) {
+            *error_offset = 0;
+        }
+        return false;
+    }
+    ltok::utf8_scan_result scan = ltok::utf8_scan(text, (size_t)text_len);
+    if (error_offset) {
+        *error_offset = (scan.valid_len == (size_t)text_len) ? -1 : (int32_t)scan.valid_len;
+    }
+    return scan.valid_len == (size_t)text_len;
+}
+
+// Raw-text kernel that defers to llama.cpp; used when the vocab type has
+// no native kernel or its kernel failed the create-time check
+namespace {
+struct llama_kernel {};
+}
+
+// Tokenize the whole text with llama.cpp, flags passed through
+template <bool AddSpecial, bool ParseSpecial>
+static int32_t tokenize_llama(
     const llama_tokenizer_t* tokenizer,
     const char* text,
     int32_t text_len,
     llama_token* tokens,
-    int32_t n_max_tokens,
-    bool add_special,
-    bool parse_special
+    int32_t n_max_tokens
 ) {
-    if (!tokenizer || !tokenizer->vocab || !text) {
-        return -1;
-    }
+    ltok::trace_span span(LLAMA_TOKENIZER_TRACE_LLAMA_CPP, (uint64_t)text_len);
 
     // If tokens is NULL, caller wants to know the token count
     // Use n_max_tokens=0 to trigger count-only path without writing to buffer
@@ -210,8 +364,8 @@ int32_t llama_tokenizer_tokenize(
             text_len,
             &dummy,
             0,  // Size 0 ensures no writes, always returns count for non-empty text
-            add_special,
-            parse_special
+            AddSpecial,
+            ParseSpecial
         );
 
         // llama_tokenize returns negative of required size when buffer is too small
@@ -226,11 +380,332 @@ int32_t llama_tokenizer_tokenize(
         text_len,
         tokens,
         n_max_tokens,
-        add_special,
-        parse_special
+        AddSpecial,
+        ParseSpecial
     );
 }
 
+// Tokenize one raw-text fragment (no special tokens, no BOS/EOS) with the
+// native kernel when there is one. The tokens are appended to out when
+// there are at most room of them, otherwise only counted. Returns the
+// count, or INT32_MIN on failure.
+template <typename Kernel>
+static int32_t tokenize_raw(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    std::vector<llama_token>& out,
+    int64_t room
+) {
+    const size_t base = out.size();
+    if constexpr (!std::is_same<Kernel, llama_kernel>::value) {
+        // Kernels are final, so this call is direct and can be inlined
+        const Kernel& kernel = static_cast<const Kernel&>(*tokenizer->native);
+        if (kernel.tokenize(text, (size_t)text_len, out)) {
+            const size_t n = out.size() - base;
+            if (n > (size_t)INT32_MAX) {
+                out.resize(base);
+                return INT32_MIN;
+            }
+            if ((int64_t)n > room) {
+                out.resize(base);
+            }
+            return (int32_t)n;
+        }
+        tokenizer->stats.record_native_fallback();
+    }
+
+    ltok::trace_span span(LLAMA_TOKENIZER_TRACE_LLAMA_CPP, (uint64_t)text_len);
+    // Raw text seldom has more tokens than bytes; past that llama.cpp
+    // reports the size and is asked again
+    const int32_t guess = (int32_t)std::max<int64_t>(0, std::min<int64_t>(room, (int64_t)text_len + 1));
+    llama_token dummy;
+    out.resize(base + (size_t)guess);
+    int32_t n = llama_tokenize(tokenizer->vocab, text, text_len, guess > 0 ? out.data() + base : &dummy, guess,
+                               false, false);
+    if (n < 0 && n != INT32_MIN && -(int64_t)n <= room) {
+        out.resize(base + (size_t)-n);
+        n = llama_tokenize(tokenizer->vocab, text, text_len, out.data() + base, -n, false, false);
+    }
+    if (n < 0) {
+        out.resize(base);
+        return (n == INT32_MIN) ? INT32_MIN : -n;
+    }
+    out.resize(base + (size_t)n);
+    return n;
+}
+
+// Tokenize partitioned text: special tokens are emitted as-is, raw fragments
+// are tokenized one by one. Keeps counting once the buffer is full so
+// the required size can be reported. Output is staged and copied once
+// it is known to fit, so a buffer that is too small is left untouched,
+// as llama_tokenize() leaves it.
+template <typename Kernel, bool AddSpecial>
+static int32_t tokenize_fragments(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    const std::vector<ltok::text_fragment>& fragments,
+    llama_token* tokens,
+    int32_t n_max_tokens
+) {
+    thread_local std::vector<llama_token> staged;
+    staged.clear();
+    const int64_t capacity = tokens ? n_max_tokens : 0;
+    int64_t n = 0;
+
+    auto emit = [&](llama_token token) {
+        if (n < capacity) {
+            staged.push_back(token);
+        }
+        n++;
+    };
+
+    if (AddSpecial) {
+        for (llama_token token : tokenizer->special_prefix) {
+            emit(token);
+        }
+    }
+
+    for (const ltok::text_fragment& fragment : fragments) {
+        if (fragment.token != LLAMA_TOKEN_NULL) {
+            emit(fragment.token);
+            continue;
+        }
+        const int32_t result = tokenize_raw<Kernel>(
+            tokenizer,
+            text + fragment.offset,
+            (int32_t)fragment.length,
+            staged,
+            capacity - n
+        );
+        if (result == INT32_MIN) {
+            ltok::scratch_trim(staged);
+            return INT32_MIN;
+        }
+        n += result;
+    }
+
+    if (AddSpecial) {
+        for (llama_token token : tokenizer->special_suffix) {
+            emit(token);
+        }
+    }
+
+    int32_t result;
+    if (n > INT32_MAX) {
+        result = INT32_MIN;
+    } else if (tokens == NULL) {
+        result = (int32_t)n;
+    } else if (n > n_max_tokens) {
+        result = -(int32_t)n;
+    } else {
+        if (n > 0) {
+            ltok::trace_span span(LLAMA_TOKENIZER_TRACE_OUTPUT_COPY, (uint64_t)n);
+            memcpy(tokens, staged.data(), (size_t)n * sizeof(llama_token));
+        }
+        result = (int32_t)n;
+    }
+    ltok::scratch_trim(staged);
+    return result;
+}
+
+// Special tokens are located with one automaton pass; llama.cpp (or the
+// native kernel) then only sees the raw text between them and never runs
+// its per-token search. BOS/EOS come from the create-time probe.
+template <typename Kernel, bool AddSpecial, bool ParseSpecial>
+static int32_t tokenize_partitioned(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens
+) {
+    thread_local std::vector<ltok::text_fragment> fragments;
+    ltok::trace_span partition_span(LLAMA_TOKENIZER_TRACE_SPECIAL_PARTITION, (uint64_t)text_len);
+    const bool has_specials = tokenizer->specials.partition(text, (size_t)text_len, ParseSpecial, fragments);
+    partition_span.end();
+    if (has_specials) {
+        tokenizer->stats.record_partitioned();
+        const int32_t result = tokenize_fragments<Kernel, AddSpecial>(tokenizer, text, fragments, tokens, n_max_tokens);
+        ltok::scratch_trim(fragments);
+        return result;
+    }
+
+    // No special tokens in the text
+    if constexpr (std::is_same<Kernel, llama_kernel>::value) {
+        return tokenize_llama<AddSpecial, false>(tokenizer, text, text_len, tokens, n_max_tokens);
+    } else {
+        if (text_len > 0) {
+            fragments.push_back({ LLAMA_TOKEN_NULL, 0, (size_t)text_len });
+        }
+        return tokenize_fragments<Kernel, AddSpecial>(tokenizer, text, fragments, tokens, n_max_tokens);
+    }
+}
+
+template <typename Kernel>
+static void install_tokenize_fns(llama_tokenizer_t* tokenizer) {
+    tokenizer->tokenize[0][0] = tokenize_partitioned<Kernel, false, false>;
+    tokenizer->tokenize[0][1] = tokenize_partitioned<Kernel, false, true>;
+    // Without known BOS/EOS affixes llama.cpp has to add them itself
+    if (tokenizer->special_affixes_ok) {
+        tokenizer->tokenize[1][0] = tokenize_partitioned<Kernel, true, false>;
+        tokenizer->tokenize[1][1] = tokenize_partitioned<Kernel, true, true>;
+    } else {
+        tokenizer->tokenize[1][0] = tokenize_llama<true, false>;
+        tokenizer->tokenize[1][1] = tokenize_llama<true, true>;
+    }
+}
+
+// Pick the specialized entry points for the handle's vocab type, once,
+// so the per-call path carries no branches on vocab type or flags
+static void select_tokenize_fns(llama_tokenizer_t* tokenizer) {
+    const enum llama_vocab_type type = tokenizer->native
+        ? llama_vocab_type(tokenizer->vocab)
+        : LLAMA_VOCAB_TYPE_NONE;
+    switch (type) {
+        case LLAMA_VOCAB_TYPE_SPM:
+            install_tokenize_fns<ltok::spm_tokenizer>(tokenizer);
+            break;
+        case LLAMA_VOCAB_TYPE_UGM:
+            install_tokenize_fns<ltok::ugm_tokenizer>(tokenizer);
+            break;
+        case LLAMA_VOCAB_TYPE_WPM:
+            install_tokenize_fns<ltok::wpm_tokenizer>(tokenizer);
+            break;
+        default:
+            install_tokenize_fns<llama_kernel>(tokenizer);
+            break;
+    }
+}
+
+// Arguments already validated
+static int32_t tokenize_with(
+    const llama_tokenizer_t* tokenizer,
+    ltok::tokenize_fn tokenize,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens
+) {
+    ltok::trace_span span(LLAMA_TOKENIZER_TRACE_TOKENIZE, (uint64_t)text_len);
+
+    // Pre-scan: pure-ASCII and valid UTF-8 input is passed through untouched,
+    // invalid sequences are replaced with U+FFFD so every vocab type sees
+    // the same well-formed input
+    ltok::utf8_scan_result scan = ltok::utf8_scan(text, (size_t)text_len);
+    if (scan.valid_len != (size_t)text_len) {
+        tokenizer->stats.record_sanitized();
+        thread_local std::string sanitized;
+        sanitized.clear();
+        ltok::utf8_sanitize(text, (size_t)text_len, sanitized);
+        if (sanitized.size() > (size_t)INT32_MAX) {
+            return -1;
+        }
+        const int32_t result = tokenize(tokenizer, sanitized.data(), (int32_t)sanitized.size(), tokens, n_max_tokens);
+        ltok::scratch_trim(sanitized);
+        return result;
+    }
+    return tokenize(tokenizer, text, text_len, tokens, n_max_tokens);
+}
+
+static int32_t tokenize_text(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens,
+    bool add_special,
+    bool parse_special
+) {
+    return tokenize_with(tokenizer, tokenizer->tokenize[add_special][parse_special], text, text_len, tokens,
+                         n_max_tokens);
+}
+
+int32_t llama_tokenizer_tokenize(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens,
+    bool add_special,
+    bool parse_special
+) {
+    if (!tokenizer || !tokenizer->vocab || !text || text_len < 0) {
+        return -1;
+    }
+
+    return ltok::record_call(tokenizer->stats, LLAMA_TOKENIZER_STATS_TOKENIZE, tokens == NULL, (uint64_t)text_len, [&] {
+        return tokenize_text(tokenizer, text, text_len, tokens, n_max_tokens, add_special, parse_special);
+    });
+}
+
+int32_t llama_tokenizer_tokenize_reference(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens,
+    bool add_special,
+    bool parse_special
+) {
+    if (!tokenizer || !tokenizer->vocab || !text || text_len < 0) {
+        return -1;
+    }
+
+    static const ltok::tokenize_fn reference[2][2] = {
+        { tokenize_llama<false, false>, tokenize_llama<false, true> },
+        { tokenize_llama<true, false>, tokenize_llama<true, true> },
+    };
+    return tokenize_with(tokenizer, reference[add_special][parse_special], text, text_len, tokens, n_max_tokens);
+}
+
+// Fit the count estimator to exact counts; runs once at create time
+static void calibrate_estimator(llama_tokenizer_t* tokenizer) {
+    // Raw piece text is never shorter than the input it covers, unless
+    // the vocab normalizes: UGM and WordPiece can drop or fold whole runs
+    size_t max_piece_len = 0;
+    const enum llama_vocab_type type = llama_vocab_type(tokenizer->vocab);
+    if (type == LLAMA_VOCAB_TYPE_SPM || type == LLAMA_VOCAB_TYPE_BPE || type == LLAMA_VOCAB_TYPE_RWKV) {
+        max_piece_len = 1;
+        const int32_t n_vocab = llama_vocab_n_tokens(tokenizer->vocab);
+        for (llama_token id = 0; id < n_vocab; id++) {
+            const char* text = llama_vocab_get_text(tokenizer->vocab, id);
+            if (text) {
+                max_piece_len = std::max(max_piece_len, strlen(text));
+            }
+        }
+    }
+    const int32_t n_affix = tokenize_text(tokenizer, "", 0, NULL, 0, true, false);
+    tokenizer->estimator.calibrate(
+        [](const void* ctx, const char* text, int32_t text_len) {
+            const llama_tokenizer_t* t = static_cast<const llama_tokenizer_t*>(ctx);
+            return tokenize_text(t, text, text_len, NULL, 0, false, false);
+        },
+        tokenizer, n_affix, max_piece_len);
+}
+
+int32_t llama_tokenizer_estimate_count(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    bool add_special,
+    int32_t* lower,
+    int32_t* upper
+) {
+    if (!tokenizer || !tokenizer->vocab || !text || text_len < 0) {
+        return -1;
+    }
+    return tokenizer->estimator.estimate(text, (size_t)text_len, add_special, lower, upper);
+}
+
+bool llama_tokenizer_uses_native_kernel(const llama_tokenizer_t* tokenizer) {
+    if (!tokenizer || !tokenizer->vocab) {
+        return false;
+    }
+    // Without known BOS/EOS affixes add_special goes through llama.cpp
+    return tokenizer->native != nullptr && tokenizer->special_affixes_ok;
+}
+
 int32_t llama_tokenizer_token_to_piece(
     const llama_tokenizer_t* tokenizer,
     llama_token token,
@@ -241,17 +716,20 @@ int32_t llama_tokenizer_token_to_piece(
         return -1;
     }
 
-    return llama_token_to_piece(
-        tokenizer->vocab,
-        token,
-        buf,
-        length,
-        0,
-        false
-    );
+    return ltok::record_call(tokenizer->stats, LLAMA_TOKENIZER_STATS_TOKEN_TO_PIECE, buf == NULL, 1, [&] {
+        return llama_token_to_piece(
+            tokenizer->vocab,
+            token,
+            buf,
+            length,
+            0,
+            false
+        );
+    });
 }
 
-int32_t llama_tokenizer_detokenize(
+// Arguments already validated
+static int32_t detokenize_tokens(
     const llama_tokenizer_t* tokenizer,
     const llama_token* tokens,
     int32_t n_tokens,
@@ -260,9 +738,7 @@ int32_t llama_tokenizer_detokenize(
     bool remove_special,
     bool unparse_special
 ) {
-    if (!tokenizer || !tokenizer->vocab || !tokens) {
-        return -1;
-    }
+    ltok::trace_span span(LLAMA_TOKENIZER_TRACE_DETOKENIZE, (uint64_t)n_tokens);
 
     // If text is NULL, caller wants to know the required text buffer size
     // Use zero-size buffer to get the required size without writes
@@ -296,3 +772,1299 @@ int32_t llama_tokenizer_detokenize(
         unparse_special
     );
 }
+
+int32_t llama_tokenizer_detokenize(
+    const llama_tokenizer_t* tokenizer,
+    const llama_token* tokens,
+    int32_t n_tokens,
+    char* text,
+    int32_t text_len_max,
+    bool remove_special,
+    bool unparse_special
+) {
+    if (!tokenizer || !tokenizer->vocab || !tokens) {
+        return -1;
+    }
+
+    const uint64_t n_input = n_tokens > 0 ? (uint64_t)n_tokens : 0;
+    return ltok::record_call(tokenizer->stats, LLAMA_TOKENIZER_STATS_DETOKENIZE, text == NULL, n_input, [&] {
+        return detokenize_tokens(tokenizer, tokens, n_tokens, text, text_len_max, remove_special, unparse_special);
+    });
+}
+
+// Built by the first caller; later callers wait for it once, then never.
+// A build that fails (out of memory) leaves it unpublished, and the next
+// call tries again instead of failing for the life of the handle
+static const ltok::piece_index* piece_index_of(const llama_tokenizer_t* tokenizer) {
+    const ltok::piece_index* index = tokenizer->pieces_ready.load(std::memory_order_acquire);
+    if (index) {
+        return index;
+    }
+    std::lock_guard<std::mutex> lock(tokenizer->pieces_mutex);
+    index = tokenizer->pieces_ready.load(std::memory_order_relaxed);
+    if (!index && tokenizer->pieces.build(tokenizer->vocab)) {
+        index = &tokenizer->pieces;
+        tokenizer->pieces_ready.store(index, std::memory_order_release);
+    }
+    return index;
+}
+
+// Copy ranges of the index's piece order out as one token list
+static int32_t write_piece_ranges(const ltok::piece_index& index, const std::vector<std::pair<size_t, size_t>>& ranges,
+                                  llama_token* tokens, int32_t n_max_tokens) {
+    size_t n = 0;
+    for (const auto& range : ranges) {
+        n += range.second - range.first;
+    }
+    if (n > (size_t)INT32_MAX) {
+        return -1;
+    }
+    if (!tokens) {
+        return (int32_t)n;
+    }
+    if (n > (size_t)std::max<int32_t>(n_max_tokens, 0)) {
+        return -(int32_t)n;
+    }
+    llama_token* out = tokens;
+    for (const auto& range : ranges) {
+        out = std::copy(index.sorted() + range.first, index.sorted() + range.second, out);
+    }
+    return (int32_t)n;
+}
+
+int32_t llama_tokenizer_tokens_with_prefix(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens
+) {
+    if (!tokenizer || !tokenizer->vocab || text_len < 0 || (text_len > 0 && !text)) {
+        return -1;
+    }
+    const ltok::piece_index* index = piece_index_of(tokenizer);
+    if (!index) {
+        return -1;
+    }
+    try {
+        std::vector<std::pair<size_t, size_t>> ranges(1);
+        index->with_prefix(text ? text : "", (size_t)text_len, ranges[0].first, ranges[0].second);
+        return write_piece_ranges(*index, ranges, tokens, n_max_tokens);
+    } catch (const std::bad_alloc&) {
+        return -1;
+    }
+}
+
+int32_t llama_tokenizer_tokens_prefix_of(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens
+) {
+    if (!tokenizer || !tokenizer->vocab || text_len < 0 || (text_len > 0 && !text)) {
+        return -1;
+    }
+    const ltok::piece_index* index = piece_index_of(tokenizer);
+    if (!index) {
+        return -1;
+    }
+    try {
+        std::vector<std::pair<size_t, size_t>> ranges;
+        index->prefixes_of(text, (size_t)text_len, [&](size_t begin, size_t end, size_t) {
+            ranges.emplace_back(begin, end);
+        });
+        return write_piece_ranges(*index, ranges, tokens, n_max_tokens);
+    } catch (const std::bad_alloc&) {
+        return -1;
+    }
+}
+
+int32_t llama_tokenizer_heal_tokens(
+    const llama_tokenizer_t* tokenizer,
+    const llama_token* prompt,
+    int32_t n_prompt,
+    int32_t n_back,
+    int32_t* n_kept,
+    llama_token* tokens,
+    int32_t n_max_tokens
+) {
+    if (!tokenizer || !tokenizer->vocab || n_prompt < 0 || (n_prompt > 0 && !prompt) || n_back < 0) {
+        return -1;
+    }
+    const ltok::piece_index* index = piece_index_of(tokenizer);
+    if (!index) {
+        return -1;
+    }
+
+    const int32_t n_vocab = llama_vocab_n_tokens(tokenizer->vocab);
+    int32_t kept = n_prompt;
+    while (kept > 0 && n_prompt - kept < n_back) {
+        const llama_token id = prompt[kept - 1];
+        size_t length;
+        if (id < 0 || id >= n_vocab) {
+            return -1;
+        }
+        index->piece(id, length);
+        if (length == 0) {
+            break;
+        }
+        kept--;
+    }
+
+    thread_local std::string removed;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    try {
+        removed.clear();
+        for (int32_t i = kept; i < n_prompt; i++) {
+            size_t length;
+            const char* piece = index->piece(prompt[i], length);
+            removed.append(piece, length);
+        }
+
+        // A piece equal to the removed text is in both sets; list it once
+        index->prefixes_of(removed.data(), removed.size(), [&](size_t begin, size_t end, size_t length) {
+            if (length < removed.size()) {
+                ranges.emplace_back(begin, end);
+            }
+        });
+        ranges.emplace_back();
+        index->with_prefix(removed.data(), removed.size(), ranges.back().first, ranges.back().second);
+    } catch (const std::bad_alloc&) {
+        ltok::scratch_trim(removed);
+        return -1;
+    }
+    ltok::scratch_trim(removed);
+
+    if (n_kept) {
+        *n_kept = kept;
+    }
+    return write_piece_ranges(*index, ranges, tokens, n_max_tokens);
+}
+
+llama_tokenizer_chat_params llama_tokenizer_chat_default_params(void) {
+    llama_tokenizer_chat_params params;
+    params.chat_template = NULL;
+    params.add_assistant = true;
+    params.add_special = true;
+    params.parse_special_content = false;
+    return params;
+}
+
+// Every message needs a role and content; content_bytes gets their total
+static bool check_chat_messages(const llama_tokenizer_chat_message* messages, int32_t n_messages,
+                                uint64_t* content_bytes) {
+    if (n_messages < 0 || (n_messages > 0 && !messages)) {
+        return false;
+    }
+    *content_bytes = 0;
+    for (int32_t i = 0; i < n_messages; i++) {
+        if (!messages[i].role || !messages[i].content) {
+            return false;
+        }
+        *content_bytes += strlen(messages[i].content);
+    }
+    return true;
+}
+
+// llama.cpp falls back to ChatML itself when the model has no template
+static const char* chat_template_of(const llama_tokenizer_t* tokenizer, const llama_tokenizer_chat_params& params) {
+    return params.chat_template ? params.chat_template : llama_model_chat_template(tokenizer->model, NULL);
+}
+
+int32_t llama_tokenizer_apply_chat_template(
+    const llama_tokenizer_t* tokenizer,
+    const llama_tokenizer_chat_message* messages,
+    int32_t n_messages,
+    const llama_tokenizer_chat_params* params,
+    char* buf,
+    int32_t length
+) {
+    uint64_t content_bytes;
+    if (!tokenizer || !tokenizer->vocab || !check_chat_messages(messages, n_messages, &content_bytes) ||
+        (buf && length < 0)) {
+        return -1;
+    }
+    const llama_tokenizer_chat_params p = params ? *params : llama_tokenizer_chat_default_params();
+
+    thread_local std::string text;
+    thread_local std::vector<ltok::text_span> content_spans;
+    int32_t result = -1;
+    if (ltok::build_chat_prompt(chat_template_of(tokenizer, p), messages, (size_t)n_messages, p.add_assistant,
+                                text, content_spans) && text.size() <= (size_t)INT32_MAX) {
+        const int32_t n = (int32_t)text.size();
+        if (!buf) {
+            result = n;
+        } else if (n > length) {
+            result = -n;
+        } else {
+            memcpy(buf, text.data(), (size_t)n);
+            if (n < length) {
+                buf[n] = '\0';
+            }
+            result = n;
+        }
+    }
+    ltok::scratch_trim(text);
+    ltok::scratch_trim(content_spans);
+    return result;
+}
+
+// Raw text between the special tokens of a chat prompt
+static int32_t tokenize_chat_fragment(const void* ctx, const char* text, int32_t text_len,
+                                      llama_token* tokens, int32_t n_max_tokens) {
+    const llama_tokenizer_t* tokenizer = static_cast<const llama_tokenizer_t*>(ctx);
+    return tokenizer->tokenize[0][0](tokenizer, text, text_len, tokens, n_max_tokens);
+}
+
+// The prompt is partitioned once with the contents protected from special
+// token matching; its fragments are then tokenized one by one, as
+// tokenize_fragments() does, except for those the cache still holds
+static int32_t tokenize_chat(
+    const llama_tokenizer_t* tokenizer,
+    const llama_tokenizer_chat_message* messages,
+    size_t n_messages,
+    const llama_tokenizer_chat_params& params,
+    ltok::chat_token_cache* cache,
+    llama_token* tokens,
+    int32_t n_max_tokens
+) {
+    thread_local std::string text;
+    thread_local std::vector<ltok::text_span> content_spans;
+    thread_local std::vector<ltok::text_fragment> fragments;
+    thread_local ltok::chat_token_cache uncached;
+
+    int32_t result = -1;
+    if (ltok::build_chat_prompt(chat_template_of(tokenizer, params), messages, n_messages, params.add_assistant,
+                                text, content_spans) && text.size() <= (size_t)INT32_MAX) {
+        ltok::trace_span partition_span(LLAMA_TOKENIZER_TRACE_SPECIAL_PARTITION, (uint64_t)text.size());
+        if (!tokenizer->specials.partition(text.data(), text.size(), true, fragments,
+                                           params.parse_special_content ? nullptr : &content_spans)) {
+            if (!text.empty()) {
+                fragments.push_back({ LLAMA_TOKEN_NULL, 0, text.size() });
+            }
+        }
+        partition_span.end();
+
+        ltok::chat_token_cache& state = cache ? *cache : uncached;
+        if (!cache) {
+            uncached.clear();
+        }
+        if (state.tokenize(text, fragments, tokenize_chat_fragment, tokenizer)) {
+            const std::vector<llama_token> none;
+            const std::vector<llama_token>& prefix = params.add_special ? tokenizer->special_prefix : none;
+            const std::vector<llama_token>& suffix = params.add_special ? tokenizer->special_suffix : none;
+            const size_t n = prefix.size() + state.size() + suffix.size();
+            if (n > (size_t)INT32_MAX) {
+                result = -1;
+            } else if (!tokens) {
+                result = (int32_t)n;
+            } else if (n > (size_t)n_max_tokens) {
+                result = -(int32_t)n;
+            } else {
+                ltok::trace_span span(LLAMA_TOKENIZER_TRACE_OUTPUT_COPY, (uint64_t)n);
+                std::copy(prefix.begin(), prefix.end(), tokens);
+                std::copy(state.data(), state.data() + state.size(), tokens + prefix.size());
+                std::copy(suffix.begin(), suffix.end(), tokens + prefix.size() + state.size());
+                result = (int32_t)n;
+            }
+        }
+    }
+    uncached.trim();
+    ltok::scratch_trim(text);
+    ltok::scratch_trim(content_spans);
+    ltok::scratch_trim(fragments);
+    return result;
+}
+
+int32_t llama_tokenizer_tokenize_chat(
+    const llama_tokenizer_t* tokenizer,
+    const llama_tokenizer_chat_message* messages,
+    int32_t n_messages,
+    const llama_tokenizer_chat_params* params,
+    llama_tokenizer_chat_cache_t* cache,
+    llama_token* tokens,
+    int32_t n_max_tokens
+) {
+    uint64_t content_bytes;
+    if (!tokenizer || !tokenizer->vocab || !check_chat_messages(messages, n_messages, &content_bytes) ||
+        (cache && cache->tokenizer != tokenizer)) {
+        return -1;
+    }
+    const llama_tokenizer_chat_params p = params ? *params : llama_tokenizer_chat_default_params();
+    // Without known BOS/EOS affixes they cannot be placed around the fragments
+    if (p.add_special && !tokenizer->special_affixes_ok) {
+        return -1;
+    }
+
+    return ltok::record_call(tokenizer->stats, LLAMA_TOKENIZER_STATS_TOKENIZE, tokens == NULL, content_bytes, [&] {
+        return tokenize_chat(tokenizer, messages, (size_t)n_messages, p, cache ? &cache->cache : nullptr,
+                             tokens, n_max_tokens);
+    });
+}
+
+llama_tokenizer_chat_cache_t* llama_tokenizer_chat_cache_create(const llama_tokenizer_t* tokenizer) {
+    if (!tokenizer || !tokenizer->vocab) {
+        return NULL;
+    }
+    return new (std::nothrow) llama_tokenizer_chat_cache_t(tokenizer);
+}
+
+int32_t llama_tokenizer_chat_cache_reused(const llama_tokenizer_chat_cache_t* cache) {
+    if (!cache) {
+        return -1;
+    }
+    return (int32_t)std::min<size_t>(cache->cache.reused(), INT32_MAX);
+}
+
+void llama_tokenizer_chat_cache_free(llama_tokenizer_chat_cache_t* cache) {
+    delete cache;
+}
+
+llama_tokenizer_fim_params llama_tokenizer_fim_default_params(void) {
+    llama_tokenizer_fim_params params;
+    params.suffix_share = 0.25f;
+    params.suffix_first = false;
+    params.add_special = true;
+    params.parse_special = false;
+    return params;
+}
+
+struct fim_side_context {
+    const llama_tokenizer_t* tokenizer;
+    bool parse_special;
+};
+
+static int32_t tokenize_fim_side(const void* ctx, const char* text, int32_t text_len,
+                                 llama_token* tokens, int32_t n_max_tokens) {
+    const fim_side_context* side = static_cast<const fim_side_context*>(ctx);
+    return tokenize_text(side->tokenizer, text, text_len, tokens, n_max_tokens, false, side->parse_special);
+}
+
+// The suffix gets its share first; the prefix gets what the suffix left,
+// and a suffix cut short takes back what a short prefix did not use
+static int32_t tokenize_fim(
+    const llama_tokenizer_t* tokenizer,
+    const char* prefix,
+    size_t prefix_len,
+    const char* suffix,
+    size_t suffix_len,
+    const llama_tokenizer_fim_params& params,
+    const llama_token fim[3],
+    llama_token* tokens,
+    int32_t n_max_tokens,
+    llama_tokenizer_fim_info* info
+) {
+    const std::vector<llama_token> none;
+    const std::vector<llama_token>& bos = params.add_special ? tokenizer->special_prefix : none;
+    const size_t n_fixed = bos.size() + 3;
+    if ((size_t)n_max_tokens < n_fixed) {
+        return -1;
+    }
+    const size_t available = (size_t)n_max_tokens - n_fixed;
+
+    thread_local std::vector<llama_token> prefix_tokens;
+    thread_local std::vector<llama_token> suffix_tokens;
+    const fim_side_context ctx = { tokenizer, params.parse_special };
+    bool prefix_truncated = false;
+    bool suffix_truncated = false;
+
+    const size_t suffix_cap = std::min(available, (size_t)((double)available * params.suffix_share));
+    if (!ltok::tokenize_head(tokenize_fim_side, &ctx, suffix, suffix_len, suffix_cap,
+                             suffix_tokens, suffix_truncated) ||
+        !ltok::tokenize_tail(tokenize_fim_side, &ctx, prefix, prefix_len, available - suffix_tokens.size(),
+                             prefix_tokens, prefix_truncated)) {
+        return -1;
+    }
+    if (suffix_truncated && prefix_tokens.size() + suffix_tokens.size() < available &&
+        !ltok::tokenize_head(tokenize_fim_side, &ctx, suffix, suffix_len, available - prefix_tokens.size(),
+                             suffix_tokens, suffix_truncated)) {
+        return -1;
+    }
+
+    const size_t n = n_fixed + prefix_tokens.size() + suffix_tokens.size();
+    if (tokens) {
+        ltok::trace_span span(LLAMA_TOKENIZER_TRACE_OUTPUT_COPY, (uint64_t)n);
+        const std::vector<llama_token>& first = params.suffix_first ? suffix_tokens : prefix_tokens;
+        const std::vector<llama_token>& second = params.suffix_first ? prefix_tokens : suffix_tokens;
+        llama_token* out = std::copy(bos.begin(), bos.end(), tokens);
+        *out++ = params.suffix_first ? fim[1] : fim[0];
+        out = std::copy(first.begin(), first.end(), out);
+        *out++ = params.suffix_first ? fim[0] : fim[1];
+        out = std::copy(second.begin(), second.end(), out);
+        *out = fim[2];
+    }
+    if (info) {
+        info->n_prefix_tokens = (int32_t)prefix_tokens.size();
+        info->n_suffix_tokens = (int32_t)suffix_tokens.size();
+        info->prefix_truncated = prefix_truncated;
+        info->suffix_truncated = suffix_truncated;
+    }
+    ltok::scratch_trim(prefix_tokens);
+    ltok::scratch_trim(suffix_tokens);
+    return (int32_t)n;
+}
+
+int32_t llama_tokenizer_tokenize_fim(
+    const llama_tokenizer_t* tokenizer,
+    const char* prefix,
+    int32_t prefix_len,
+    const char* suffix,
+    int32_t suffix_len,
+    const llama_tokenizer_fim_params* params,
+    llama_token* tokens,
+    int32_t n_max_tokens,
+    llama_tokenizer_fim_info* info
+) {
+    if (!tokenizer || !tokenizer->vocab || prefix_len < 0 || suffix_len < 0 ||
+        (prefix_len > 0 && !prefix) || (suffix_len > 0 && !suffix) || n_max_tokens < 0) {
+        return -1;
+    }
+    const llama_tokenizer_fim_params p = params ? *params : llama_tokenizer_fim_default_params();
+    if (!(p.suffix_share >= 0.0f && p.suffix_share <= 1.0f) ||
+        (p.add_special && !tokenizer->special_affixes_ok)) {
+        return -1;
+    }
+    const llama_token fim[3] = {
+        llama_vocab_fim_pre(tokenizer->vocab),
+        llama_vocab_fim_suf(tokenizer->vocab),
+        llama_vocab_fim_mid(tokenizer->vocab),
+    };
+    if (fim[0] == LLAMA_TOKEN_NULL || fim[1] == LLAMA_TOKEN_NULL || fim[2] == LLAMA_TOKEN_NULL) {
+        return -1;
+    }
+
+    const uint64_t input = (uint64_t)prefix_len + (uint64_t)suffix_len;
+    return ltok::record_call(tokenizer->stats, LLAMA_TOKENIZER_STATS_TOKENIZE, tokens == NULL, input, [&] {
+        return tokenize_fim(tokenizer, prefix, (size_t)prefix_len, suffix, (size_t)suffix_len, p, fim,
+                            tokens, n_max_tokens, info);
+    });
+}
+
+llama_tokenizer_threadpool_params llama_tokenizer_threadpool_default_params(void) {
+    llama_tokenizer_threadpool_params params;
+    params.n_threads = 0;
+    params.cpus = NULL;
+    params.n_cpus = 0;
+    params.numa_node = -1;
+    params.executor = NULL;
+    params.executor_user_data = NULL;
+    return params;
+}
+
+llama_tokenizer_threadpool_t* llama_tokenizer_threadpool_create(const llama_tokenizer_threadpool_params* params) {
+    llama_tokenizer_threadpool_params p = params ? *params : llama_tokenizer_threadpool_default_params();
+    if (p.n_threads < 0 || p.n_cpus < 0 || (p.n_cpus > 0 && !p.cpus)) {
+        return NULL;
+    }
+
+    ltok::thread_pool_options options;
+    options.n_threads = (size_t)p.n_threads;
+    if (p.cpus) {
+        options.cpus.assign(p.cpus, p.cpus + p.n_cpus);
+    }
+    options.numa_node = p.numa_node;
+    options.executor = p.executor;
+    options.executor_user_data = p.executor_user_data;
+
+    return new (std::nothrow) llama_tokenizer_threadpool_t(options);
+}
+
+void llama_tokenizer_threadpool_destroy(llama_tokenizer_threadpool_t* pool) {
+    delete pool;
+}
+
+int32_t llama_tokenizer_threadpool_n_threads(const llama_tokenizer_threadpool_t* pool) {
+    if (!pool) {
+        return -1;
+    }
+    return (int32_t)pool->pool.size();
+}
+
+// Texts per task: enough to amortize scheduling, small enough that
+// uneven text lengths still balance across workers
+static size_t batch_grain(size_t n_texts, size_t n_workers) {
+    return std::max<size_t>(1, std::min<size_t>(64, n_texts / (8 * (n_workers + 1))));
+}
+
+int32_t llama_tokenizer_tokenize_batch(
+    const llama_tokenizer_t* tokenizer,
+    llama_tokenizer_threadpool_t* pool,
+    const char* const* texts,
+    const int32_t* text_lens,
+    int32_t n_texts,
+    llama_token* const* tokens,
+    const int32_t* n_max_tokens,
+    int32_t* n_tokens,
+    bool add_special,
+    bool parse_special
+) {
+    if (!tokenizer || n_texts < 0 || (n_texts > 0 && (!texts || !text_lens || !n_tokens))) {
+        return -1;
+    }
+    if (tokens && !n_max_tokens) {
+        return -1;
+    }
+
+    auto tokenize_range = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            llama_token* out = tokens ? tokens[i] : NULL;
+            n_tokens[i] = llama_tokenizer_tokenize(
+                tokenizer,
+                texts[i],
+                text_lens[i],
+                out,
+                out ? n_max_tokens[i] : 0,
+                add_special,
+                parse_special
+            );
+        }
+    };
+
+    // Each text is also recorded as a tokenize call
+    return ltok::record_call(tokenizer->stats, LLAMA_TOKENIZER_STATS_TOKENIZE_BATCH, tokens == NULL, (uint64_t)n_texts, [&] {
+        if (!pool) {
+            tokenize_range(0, (size_t)n_texts);
+        } else {
+            pool->pool.parallel_for((size_t)n_texts, batch_grain((size_t)n_texts, pool->pool.size()), tokenize_range);
+        }
+        return 0;
+    });
+}
+
+// Below this many bytes a count takes about as long as waking a worker,
+// so fanning out would only add latency
+static constexpr int32_t count_multi_min_parallel_bytes = 4096;
+
+int32_t llama_tokenizer_count_multi(
+    const llama_tokenizer_t* const* tokenizers,
+    int32_t n_tokenizers,
+    llama_tokenizer_threadpool_t* pool,
+    const char* text,
+    int32_t text_len,
+    int32_t* counts,
+    bool add_special,
+    bool parse_special
+) {
+    if (n_tokenizers < 0 || (n_tokenizers > 0 && (!tokenizers || !counts)) || !text || text_len < 0) {
+        return -1;
+    }
+    for (int32_t i = 0; i < n_tokenizers; i++) {
+        if (!tokenizers[i] || !tokenizers[i]->vocab) {
+            return -1;
+        }
+    }
+
+    // One pre-scan for every handle, as tokenize_text() does per call
+    const char* clean = text;
+    int32_t clean_len = text_len;
+    thread_local std::string sanitized;
+    const bool was_sanitized = ltok::utf8_scan(text, (size_t)text_len).valid_len != (size_t)text_len;
+    if (was_sanitized) {
+        sanitized.clear();
+        ltok::utf8_sanitize(text, (size_t)text_len, sanitized);
+        if (sanitized.size() > (size_t)INT32_MAX) {
+            std::fill(counts, counts + n_tokenizers, -1);
+            return 0;
+        }
+        clean = sanitized.data();
+        clean_len = (int32_t)sanitized.size();
+    }
+
+    auto count_range = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const llama_tokenizer_t* tokenizer = tokenizers[i];
+            counts[i] = ltok::record_call(tokenizer->stats, LLAMA_TOKENIZER_STATS_TOKENIZE, true, (uint64_t)text_len, [&] {
+                ltok::trace_span span(LLAMA_TOKENIZER_TRACE_TOKENIZE, (uint64_t)text_len);
+                if (was_sanitized) {
+                    tokenizer->stats.record_sanitized();
+                }
+                return tokenizer->tokenize[add_special][parse_special](tokenizer, clean, clean_len, NULL, 0);
+            });
+        }
+    };
+
+    if (pool && n_tokenizers > 1 && text_len >= count_multi_min_parallel_bytes) {
+        pool->pool.parallel_for((size_t)n_tokenizers, 1, count_range);
+    } else {
+        count_range(0, (size_t)n_tokenizers);
+    }
+    ltok::scratch_trim(sanitized);
+    return 0;
+}
+
+namespace {
+
+// Batch inputs handed to the CSR and padded builders
+struct batch_source {
+    const llama_tokenizer_t* tokenizer;
+    const char* const* texts;
+    const int32_t* text_lens;
+    bool add_special;
+    bool parse_special;
+};
+
+} // namespace
+
+llama_tokenizer_csr_t* llama_tokenizer_tokenize_batch_csr(
+    const llama_tokenizer_t* tokenizer,
+    llama_tokenizer_threadpool_t* pool,
+    const char* const* texts,
+    const int32_t* text_lens,
+    int32_t n_texts,
+    bool add_special,
+    bool parse_special
+) {
+    if (!tokenizer || n_texts < 0 || (n_texts > 0 && (!texts || !text_lens))) {
+        return NULL;
+    }
+
+    const batch_source source = {tokenizer, texts, text_lens, add_special, parse_special};
+    ltok::csr_batch* batch = nullptr;
+    ltok::record_call(tokenizer->stats, LLAMA_TOKENIZER_STATS_TOKENIZE_BATCH, false, (uint64_t)n_texts, [&] {
+        batch = ltok::csr_batch::build(
+            [](const void* ctx, size_t i, llama_token* out, int32_t n_max) {
+                const batch_source* s = static_cast<const batch_source*>(ctx);
+                return llama_tokenizer_tokenize(s->tokenizer, s->texts[i], s->text_lens[i], out, n_max,
+                                                s->add_special, s->parse_special);
+            },
+            [](const void* ctx, size_t i) {
+                const batch_source* s = static_cast<const batch_source*>(ctx);
+                if (!s->texts[i] || s->text_lens[i] < 0) {
+                    return 0;
+                }
+                int32_t upper = 0;
+                s->tokenizer->estimator.estimate(s->texts[i], (size_t)s->text_lens[i], s->add_special, NULL, &upper);
+                return upper;
+            },
+            &source,
+            (size_t)n_texts,
+            pool ? &pool->pool : NULL,
+            pool ? batch_grain((size_t)n_texts, pool->pool.size()) : (size_t)n_texts
+        );
+        return batch ? 0 : -1;
+    });
+    if (!batch) {
+        return NULL;
+    }
+
+    llama_tokenizer_csr_t* csr = new (std::nothrow) llama_tokenizer_csr_t(batch);
+    if (!csr) {
+        batch->release();
+    }
+    return csr;
+}
+
+bool llama_tokenizer_csr_get(const llama_tokenizer_csr_t* csr, llama_tokenizer_csr_view* view) {
+    if (!csr || !view) {
+        return false;
+    }
+    csr->batch->view(*view);
+    return true;
+}
+
+bool llama_tokenizer_csr_export_arrow(
+    const llama_tokenizer_csr_t* csr,
+    struct ArrowArray* array,
+    struct ArrowSchema* schema
+) {
+    if (!csr || !array) {
+        return false;
+    }
+    return csr->batch->export_arrow(array, schema);
+}
+
+void llama_tokenizer_csr_free(llama_tokenizer_csr_t* csr) {
+    delete csr;
+}
+
+llama_tokenizer_pad_params llama_tokenizer_pad_default_params(void) {
+    llama_tokenizer_pad_params params;
+    params.max_len = 512;
+    params.pad_left = false;
+    params.pad_to_longest = false;
+    params.sort_by_length = false;
+    params.pad_token = -1;
+    params.add_special = true;
+    params.parse_special = false;
+    return params;
+}
+
+int32_t llama_tokenizer_tokenize_padded(
+    const llama_tokenizer_t* tokenizer,
+    llama_tokenizer_threadpool_t* pool,
+    const char* const* texts,
+    const int32_t* text_lens,
+    int32_t n_texts,
+    const llama_tokenizer_pad_params* params,
+    llama_token* tokens,
+    uint8_t* attention_mask,
+    int32_t* lengths,
+    int32_t* row_order
+) {
+    const llama_tokenizer_pad_params p = params ? *params : llama_tokenizer_pad_default_params();
+    if (!tokenizer || n_texts < 0 || p.max_len <= 0) {
+        return -1;
+    }
+    if (n_texts > 0 && (!texts || !text_lens || !tokens || (p.sort_by_length && !row_order))) {
+        return -1;
+    }
+    for (int32_t i = 0; i < n_texts; i++) {
+        if (!texts[i] || text_lens[i] < 0) {
+            return -1;
+        }
+    }
+
+    ltok::padded_layout layout;
+    layout.max_len = (size_t)p.max_len;
+    layout.pad_left = p.pad_left;
+    layout.pad_to_longest = p.pad_to_longest;
+    layout.sort_by_length = p.sort_by_length;
+    layout.pad_token = p.pad_token;
+    if (layout.pad_token < 0) {
+        layout.pad_token = llama_tokenizer_token_pad(tokenizer);
+    }
+    if (layout.pad_token < 0) {
+        layout.pad_token = llama_tokenizer_token_eos(tokenizer);
+    }
+    if (layout.pad_token < 0) {
+        layout.pad_token = 0;
+    }
+    if (p.add_special && tokenizer->special_affixes_ok) {
+        layout.suffix = tokenizer->special_suffix.data();
+        layout.n_suffix = tokenizer->special_suffix.size();
+    }
+
+    const batch_source source = {tokenizer, texts, text_lens, p.add_special, p.parse_special};
+    return ltok::record_call(tokenizer->stats, LLAMA_TOKENIZER_STATS_TOKENIZE_BATCH, false, (uint64_t)n_texts, [&] {
+        return ltok::fill_padded(
+            [](const void* ctx, size_t i, llama_token* out, int32_t n_max) {
+                const batch_source* s = static_cast<const batch_source*>(ctx);
+                return llama_tokenizer_tokenize(s->tokenizer, s->texts[i], s->text_lens[i], out, n_max,
+                                                s->add_special, s->parse_special);
+            },
+            [](const void* ctx, size_t i) {
+                const batch_source* s = static_cast<const batch_source*>(ctx);
+                int32_t lower = 0;
+                s->tokenizer->estimator.estimate(s->texts[i], (size_t)s->text_lens[i], s->add_special, &lower, NULL);
+                return lower;
+            },
+            &source,
+            (size_t)n_texts,
+            layout,
+            pool ? &pool->pool : NULL,
+            pool ? batch_grain((size_t)n_texts, pool->pool.size()) : (size_t)n_texts,
+            tokens,
+            attention_mask,
+            lengths,
+            row_order
+        );
+    });
+}
+
+llama_tokenizer_packer_params llama_tokenizer_packer_default_params(void) {
+    llama_tokenizer_packer_params params;
+    params.seq_len = 2048;
+    params.shard_sequences = 32768;
+    params.token_bytes = 0;
+    params.add_separator = true;
+    params.separator = -1;
+    params.pad_token = -1;
+    params.drop_partial = false;
+    params.parse_special = false;
+    return params;
+}
+
+llama_tokenizer_packer_t* llama_tokenizer_packer_create(
+    const llama_tokenizer_t* tokenizer,
+    llama_tokenizer_threadpool_t* pool,
+    const char* output_prefix,
+    const llama_tokenizer_packer_params* params
+) {
+    const llama_tokenizer_packer_params p = params ? *params : llama_tokenizer_packer_default_params();
+    if (!tokenizer || !output_prefix || p.seq_len <= 0 || p.shard_sequences <= 0) {
+        return NULL;
+    }
+    if (p.token_bytes != 0 && p.token_bytes != 2 && p.token_bytes != 4) {
+        return NULL;
+    }
+
+    const llama_token eos = llama_tokenizer_token_eos(tokenizer);
+    ltok::packer_options options;
+    options.seq_len = (size_t)p.seq_len;
+    options.shard_sequences = (size_t)p.shard_sequences;
+    options.token_bytes = p.token_bytes != 0 ? (size_t)p.token_bytes
+                        : llama_tokenizer_vocab_size(tokenizer) <= 65536 ? 2 : 4;
+    if (options.token_bytes == 2 && llama_tokenizer_vocab_size(tokenizer) > 65536) {
+        return NULL;
+    }
+    options.bos = llama_tokenizer_should_add_bos(tokenizer) ? llama_tokenizer_token_bos(tokenizer) : -1;
+    if (llama_tokenizer_should_add_eos(tokenizer)) {
+        options.separator = eos;
+    } else if (p.add_separator) {
+        options.separator = p.separator >= 0 ? p.separator : eos;
+    }
+    options.pad = p.pad_token;
+    if (options.pad < 0) {
+        options.pad = llama_tokenizer_token_pad(tokenizer);
+    }
+    if (options.pad < 0) {
+        options.pad = eos;
+    }
+    if (options.pad < 0) {
+        options.pad = 0;
+    }
+    // Ids written as-is would be truncated
+    if (options.token_bytes == 2 && (options.separator > 0xFFFF || options.pad > 0xFFFF)) {
+        return NULL;
+    }
+    options.drop_partial = p.drop_partial;
+
+    llama_tokenizer_packer_t* packer = NULL;
+    try {
+        options.prefix = output_prefix;
+        packer = new llama_tokenizer_packer_t(tokenizer, pool, p.parse_special, options);
+    } catch (const std::bad_alloc&) {
+        return NULL;
+    }
+    if (!packer->packer.ok()) {
+        delete packer;
+        return NULL;
+    }
+    return packer;
+}
+
+int32_t llama_tokenizer_packer_add(
+    llama_tokenizer_packer_t* packer,
+    const char* const* texts,
+    const int32_t* text_lens,
+    int32_t n_texts
+) {
+    if (!packer || n_texts < 0 || (n_texts > 0 && (!texts || !text_lens))) {
+        return -1;
+    }
+    llama_tokenizer_csr_t* batch = llama_tokenizer_tokenize_batch_csr(
+        packer->tokenizer, packer->pool, texts, text_lens, n_texts, false, packer->parse_special);
+    if (!batch) {
+        return -1;
+    }
+    llama_tokenizer_csr_view view;
+    batch->batch->view(view);
+    bool ok;
+    try {
+        ok = packer->packer.append(view);
+    } catch (const std::bad_alloc&) {
+        ok = false;
+    }
+    llama_tokenizer_csr_free(batch);
+    return ok ? 0 : -1;
+}
+
+int32_t llama_tokenizer_packer_finish(llama_tokenizer_packer_t* packer) {
+    if (!packer) {
+        return -1;
+    }
+    bool ok;
+    try {
+        ok = packer->packer.finish();
+    } catch (const std::bad_alloc&) {
+        ok = false;
+    }
+    return ok ? 0 : -1;
+}
+
+bool llama_tokenizer_packer_get_stats(const llama_tokenizer_packer_t* packer, llama_tokenizer_packer_stats* stats) {
+    if (!packer || !stats) {
+        return false;
+    }
+    packer->packer.get_stats(*stats);
+    return true;
+}
+
+void llama_tokenizer_packer_destroy(llama_tokenizer_packer_t* packer) {
+    delete packer;
+}
+
+llama_tokenizer_grammar_params llama_tokenizer_grammar_default_params(void) {
+    llama_tokenizer_grammar_params params;
+    params.max_states = 1024;
+    return params;
+}
+
+static void set_error(char* error, int32_t error_len, const std::string& message) {
+    if (error && error_len > 0) {
+        snprintf(error, (size_t)error_len, "%s", message.c_str());
+    }
+}
+
+// Compile the regex and fill the token masks
+static llama_tokenizer_grammar_t* create_grammar(
+    const llama_tokenizer_t* tokenizer,
+    const char* pattern,
+    size_t pattern_len,
+    const llama_tokenizer_grammar_params& params,
+    llama_tokenizer_threadpool_t* pool,
+    char* error,
+    int32_t error_len
+) {
+    std::string message;
+    ltok::byte_dfa dfa;
+    if (!dfa.compile(pattern, pattern_len, (size_t)params.max_states, message)) {
+        set_error(error, error_len, message);
+        return NULL;
+    }
+    const ltok::piece_index* pieces = piece_index_of(tokenizer);
+    llama_tokenizer_grammar_t* grammar = new (std::nothrow) llama_tokenizer_grammar_t(tokenizer);
+    if (!pieces || !grammar) {
+        delete grammar;
+        set_error(error, error_len, "out of memory");
+        return NULL;
+    }
+    if (!grammar->grammar.build(std::move(dfa), *pieces, tokenizer->vocab, pool ? &pool->pool : nullptr, message)) {
+        delete grammar;
+        set_error(error, error_len, message);
+        return NULL;
+    }
+    return grammar;
+}
+
+llama_tokenizer_grammar_t* llama_tokenizer_grammar_from_regex(
+    const llama_tokenizer_t* tokenizer,
+    const char* pattern,
+    int32_t pattern_len,
+    const llama_tokenizer_grammar_params* params,
+    llama_tokenizer_threadpool_t* pool,
+    char* error,
+    int32_t error_len
+) {
+    const llama_tokenizer_grammar_params p = params ? *params : llama_tokenizer_grammar_default_params();
+    if (!tokenizer || !tokenizer->vocab || pattern_len < 0 || (pattern_len > 0 && !pattern) || p.max_states <= 0) {
+        set_error(error, error_len, "invalid arguments");
+        return NULL;
+    }
+    return create_grammar(tokenizer, pattern ? pattern : "", (size_t)pattern_len, p, pool, error, error_len);
+}
+
+llama_tokenizer_grammar_t* llama_tokenizer_grammar_from_json_schema(
+    const llama_tokenizer_t* tokenizer,
+    const char* schema,
+    int32_t schema_len,
+    const llama_tokenizer_grammar_params* params,
+    llama_tokenizer_threadpool_t* pool,
+    char* error,
+    int32_t error_len
+) {
+    const llama_tokenizer_grammar_params p = params ? *params : llama_tokenizer_grammar_default_params();
+    if (!tokenizer || !tokenizer->vocab || schema_len < 0 || (schema_len > 0 && !schema) || p.max_states <= 0) {
+        set_error(error, error_len, "invalid arguments");
+        return NULL;
+    }
+    std::string regex;
+    std::string message;
+    if (!ltok::json_schema_to_regex(schema ? schema : "", (size_t)schema_len, regex, message)) {
+        set_error(error, error_len, message);
+        return NULL;
+    }
+    return create_grammar(tokenizer, regex.data(), regex.size(), p, pool, error, error_len);
+}
+
+void llama_tokenizer_grammar_free(llama_tokenizer_grammar_t* grammar) {
+    delete grammar;
+}
+
+int32_t llama_tokenizer_grammar_n_states(const llama_tokenizer_grammar_t* grammar) {
+    return grammar ? (int32_t)grammar->grammar.n_states() : -1;
+}
+
+int32_t llama_tokenizer_grammar_mask_words(const llama_tokenizer_grammar_t* grammar) {
+    return grammar ? (int32_t)grammar->grammar.n_words() : -1;
+}
+
+static bool valid_grammar_state(const llama_tokenizer_grammar_t* grammar, int32_t state) {
+    return grammar && state >= 0 && (size_t)state < grammar->grammar.n_states();
+}
+
+const uint64_t* llama_tokenizer_grammar_mask(const llama_tokenizer_grammar_t* grammar, int32_t state) {
+    return valid_grammar_state(grammar, state) ? grammar->grammar.mask(state) : NULL;
+}
+
+int32_t llama_tokenizer_grammar_advance(const llama_tokenizer_grammar_t* grammar, int32_t state, llama_token token) {
+    return valid_grammar_state(grammar, state) ? grammar->grammar.advance(state, token) : -1;
+}
+
+bool llama_tokenizer_grammar_is_accepting(const llama_tokenizer_grammar_t* grammar, int32_t state) {
+    return valid_grammar_state(grammar, state) && grammar->grammar.accepting(state);
+}
+
+llama_tokenizer_stops_params llama_tokenizer_stops_default_params(void) {
+    llama_tokenizer_stops_params params;
+    params.stop_on_eog = true;
+    return params;
+}
+
+llama_tokenizer_stops_t* llama_tokenizer_stops_create(
+    const llama_tokenizer_t* tokenizer,
+    const char* const* stops,
+    const int32_t* stop_lens,
+    int32_t n_stops,
+    const llama_token* stop_tokens,
+    int32_t n_stop_tokens,
+    const llama_tokenizer_stops_params* params
+) {
+    if (!tokenizer || n_stops < 0 || (n_stops > 0 && (!stops || !stop_lens)) || n_stop_tokens < 0 ||
+        (n_stop_tokens > 0 && !stop_tokens)) {
+        return NULL;
+    }
+    const llama_tokenizer_stops_params p = params ? *params : llama_tokenizer_stops_default_params();
+    const int32_t n_vocab = llama_vocab_n_tokens(tokenizer->vocab);
+    for (int32_t i = 0; i < n_stops; i++) {
+        if (stop_lens[i] < 0 || (stop_lens[i] > 0 && !stops[i])) {
+            return NULL;
+        }
+    }
+    for (int32_t i = 0; i < n_stop_tokens; i++) {
+        if (stop_tokens[i] < 0 || stop_tokens[i] >= n_vocab) {
+            return NULL;
+        }
+    }
+
+    const ltok::piece_index* pieces = piece_index_of(tokenizer);
+    llama_tokenizer_stops_t* set = new (std::nothrow) llama_tokenizer_stops_t(tokenizer);
+    if (!pieces || !set) {
+        delete set;
+        return NULL;
+    }
+    try {
+        std::vector<std::string> strings;
+        strings.reserve((size_t)n_stops);
+        for (int32_t i = 0; i < n_stops; i++) {
+            strings.emplace_back(stop_lens[i] > 0 ? stops[i] : "", (size_t)stop_lens[i]);
+        }
+        const std::vector<llama_token> ids(stop_tokens, stop_tokens + n_stop_tokens);
+        if (set->set.build(*pieces, tokenizer->vocab, strings, ids, p.stop_on_eog)) {
+            return set;
+        }
+    } catch (const std::bad_alloc&) {
+    }
+    delete set;
+    return NULL;
+}
+
+void llama_tokenizer_stops_free(llama_tokenizer_stops_t* stops) {
+    delete stops;
+}
+
+llama_tokenizer_stop_stream_t* llama_tokenizer_stop_stream_create(const llama_tokenizer_stops_t* stops) {
+    if (!stops) {
+        return NULL;
+    }
+    return new (std::nothrow) llama_tokenizer_stop_stream_t(stops);
+}
+
+int32_t llama_tokenizer_stop_stream_feed(
+    llama_tokenizer_stop_stream_t* stream,
+    const llama_token* tokens,
+    int32_t n_tokens,
+    llama_tokenizer_stop_match* match
+) {
+    if (!stream || n_tokens < 0 || (n_tokens > 0 && !tokens)) {
+        return -1;
+    }
+    const size_t n_vocab = stream->stream.vocab_size();
+    for (int32_t i = 0; i < n_tokens; i++) {
+        if (tokens[i] < 0 || (size_t)tokens[i] >= n_vocab) {
+            return -1;
+        }
+    }
+
+    bool stopped;
+    ltok::stop_hit hit;
+    size_t consumed;
+    try {
+        consumed = stream->stream.feed(tokens, (size_t)n_tokens, stopped, hit);
+    } catch (const std::bad_alloc&) {
+        return -1;
+    }
+    if (!stopped) {
+        return 0;
+    }
+    if (match) {
+        match->stop_index = hit.stop;
+        match->byte_offset = hit.byte_offset;
+        match->token_index = hit.token;
+        match->token_offset = hit.token_offset;
+    }
+    return (int32_t)consumed;
+}
+
+int32_t llama_tokenizer_stop_stream_pending(const llama_tokenizer_stop_stream_t* stream) {
+    return stream ? (int32_t)stream->stream.pending() : -1;
+}
+
+void llama_tokenizer_stop_stream_reset(llama_tokenizer_stop_stream_t* stream) {
+    if (stream) {
+        stream->stream.reset();
+    }
+}
+
+void llama_tokenizer_stop_stream_free(llama_tokenizer_stop_stream_t* stream) {
+    delete stream;
+}
+
+llama_tokenizer_translator_t* llama_tokenizer_translator_create(
+    const llama_tokenizer_t* from,
+    const llama_tokenizer_t* to,
+    llama_tokenizer_threadpool_t* pool
+) {
+    if (!from || !to) {
+        return NULL;
+    }
+    const ltok::piece_index* pieces = piece_index_of(from);
+    llama_tokenizer_translator_t* translator = new (std::nothrow) llama_tokenizer_translator_t();
+    if (!pieces || !translator) {
+        delete translator;
+        return NULL;
+    }
+    if (!translator->translator.build(from, *pieces, to, to->vocab, pool ? &pool->pool : NULL)) {
+        delete translator;
+        return NULL;
+    }
+    return translator;
+}
+
+void llama_tokenizer_translator_free(llama_tokenizer_translator_t* translator) {
+    delete translator;
+}
+
+int32_t llama_tokenizer_translate(
+    const llama_tokenizer_translator_t* translator,
+    const llama_token* tokens,
+    int32_t n_tokens,
+    bool continuation,
+    llama_token* out,
+    int32_t n_max_tokens
+) {
+    if (!translator || n_tokens < 0 || (n_tokens > 0 && !tokens)) {
+        return -1;
+    }
+    const size_t n_vocab = translator->translator.from_vocab_size();
+    for (int32_t i = 0; i < n_tokens; i++) {
+        if (tokens[i] < 0 || (size_t)tokens[i] >= n_vocab) {
+            return -1;
+        }
+    }
+
+    thread_local std::vector<llama_token> translated;
+    translated.clear();
+    bool ok;
+    try {
+        ok = translator->translator.translate(tokens, (size_t)n_tokens, continuation, translated);
+    } catch (const std::bad_alloc&) {
+        ok = false;
+    }
+    int32_t result;
+    if (!ok || translated.size() > (size_t)INT32_MAX) {
+        result = -1;
+    } else if (!out) {
+        result = (int32_t)translated.size();
+    } else if (translated.size() > (size_t)std::max<int32_t>(n_max_tokens, 0)) {
+        result = -(int32_t)translated.size();
+    } else {
+        std::copy(translated.begin(), translated.end(), out);
+        result = (int32_t)translated.size();
+    }
+    ltok::scratch_trim(translated);
+    return result;
+}
+
+llama_tokenizer_ring_t* llama_tokenizer_ring_create(
+    const llama_tokenizer_t* tokenizer,
+    llama_tokenizer_threadpool_t* pool,
+    uint32_t entries
+) {
+    if (!tokenizer || entries == 0 || entries > (1u << 30)) {
+        return NULL;
+    }
+    llama_tokenizer_ring_t* ring = new (std::nothrow) llama_tokenizer_ring_t(tokenizer, pool ? &pool->pool : NULL, entries);
+    if (ring && !ring->ring.ok()) {
+        delete ring;
+        return NULL;
+    }
+    return ring;
+}
+
+void llama_tokenizer_ring_destroy(llama_tokenizer_ring_t* ring) {
+    delete ring;
+}
+
+int32_t llama_tokenizer_ring_submit(llama_tokenizer_ring_t* ring, const llama_tokenizer_sqe* sqes, int32_t n_sqes) {
+    if (!ring || n_sqes < 0 || (n_sqes > 0 && !sqes)) {
+        return -1;
+    }
+    return (int32_t)ring->ring.submit(sqes, (size_t)n_sqes);
+}
+
+int32_t llama_tokenizer_ring_reap(llama_tokenizer_ring_t* ring, llama_tokenizer_cqe* cqes, int32_t n_max) {
+    if (!ring || n_max < 0 || (n_max > 0 && !cqes)) {
+        return -1;
+    }
+    return (int32_t)ring->ring.reap(cqes, (size_t)n_max);
+}
+
+int32_t llama_tokenizer_ring_wait(llama_tokenizer_ring_t* ring, int32_t min_complete, int32_t timeout_ms) {
+    if (!ring || min_complete < 0) {
+        return -1;
+    }
+    return (int32_t)ring->ring.wait((size_t)min_complete, timeout_ms);
+}
+
+void llama_tokenizer_ring_enter(llama_tokenizer_ring_t* ring) {
+    if (ring) {
+        ring->ring.notify();
+    }
+}
+
+int32_t llama_tokenizer_ring_eventfd(const llama_tokenizer_ring_t* ring) {
+    if (!ring) {
+        return -1;
+    }
+    return ring->ring.eventfd();
+}
+
+bool llama_tokenizer_ring_get_info(llama_tokenizer_ring_t* ring, llama_tokenizer_ring_info* info) {
+    if (!ring || !info) {
+        return false;
+    }
+    ring->ring.get_info(*info);
+    return true;
+}
+
+bool llama_tokenizer_get_stats(const llama_tokenizer_t* tokenizer, llama_tokenizer_stats* stats) {
+    if (!tokenizer || !stats || !LLAMA_TOKENIZER_STATS) {
+        return false;
+    }
+    tokenizer->stats.snapshot(*stats);
+    return true;
+}
+
+void llama_tokenizer_reset_stats(const llama_tokenizer_t* tokenizer) {
+    if (tokenizer) {
+        tokenizer->stats.reset();
+    }
+}
+
+void llama_tokenizer_set_trace_callback(llama_tokenizer_trace_fn fn, void* user_data) {
+    ltok::trace_set_callback(fn, user_data);
+}
+
+bool llama_tokenizer_trace_start(size_t capacity) {
+    return ltok::trace_start(capacity);
+}
+
+void llama_tokenizer_trace_stop(void) {
+    ltok::trace_stop();
+}
+
+int32_t llama_tokenizer_trace_dump(const char* path) {
+    return ltok::trace_dump(path);
+}
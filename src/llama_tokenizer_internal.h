@@ -0,0 +1,144 @@
+#ifndef LLAMA_TOKENIZER_INTERNAL_H
+#define LLAMA_TOKENIZER_INTERNAL_H
+
+#include "llama_tokenizer.h"
+#include "llama.h"
+#include "batch_csr.h"
+#include "chat_prompt.h"
+#include "count_estimator.h"
+#include "native_tokenizer.h"
+#include "padded_batch.h"
+#include "piece_index.h"
+#include "request_ring.h"
+#include "sequence_packer.h"
+#include "special_tokens.h"
+#include "stats.h"
+#include "stop_matcher.h"
+#include "threadpool.h"
+#include "token_grammar.h"
+#include "vocab_translator.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ltok {
+
+// Tokenize entry point specialized for one kernel and flag combination;
+// arguments are already validated and the text is well-formed UTF-8
+typedef int32_t (*tokenize_fn)(
+    const llama_tokenizer_t* tokenizer,
+    const char* text,
+    int32_t text_len,
+    llama_token* tokens,
+    int32_t n_max_tokens
+);
+
+} // namespace ltok
+
+// Read-only after llama_tokenizer_create(), so any number of threads can
+// share a handle. State built lazily later must be published with
+// std::call_once or atomics, never under a lock taken on the hot path;
+// the stats counters are the only state calls write.
+struct llama_tokenizer_t {
+    llama_model* model = nullptr;
+    const llama_vocab* vocab = nullptr;
+
+    // Special-token automaton built at create time
+    ltok::special_token_scanner specials;
+
+    // Tokens llama.cpp places around the text when add_special is set
+    // (BOS/CLS before, EOS/SEP after); valid when special_affixes_ok
+    std::vector<llama_token> special_prefix;
+    std::vector<llama_token> special_suffix;
+    bool special_affixes_ok = false;
+
+    // Wrapper-side kernel for raw text (SPM/UGM); NULL when llama.cpp is used
+    std::unique_ptr<ltok::native_tokenizer> native;
+
+    // Entry points chosen once at create time, indexed
+    // [add_special][parse_special]
+    ltok::tokenize_fn tokenize[2][2] = {};
+
+    // Byte-class token count model, calibrated at create time
+    ltok::count_estimator estimator;
+
+    // Rendered-piece index for token healing, built on first use and
+    // published through pieces_ready; the mutex is only taken until a
+    // build succeeds, so a failed build is retried by the next caller
+    mutable std::mutex pieces_mutex;
+    mutable std::atomic<const ltok::piece_index*> pieces_ready{nullptr};
+    mutable ltok::piece_index pieces;
+
+    // Per-thread-sharded call counters
+    mutable ltok::tokenizer_stats stats;
+};
+
+struct llama_tokenizer_threadpool_t {
+    explicit llama_tokenizer_threadpool_t(const ltok::thread_pool_options& options) : pool(options) {}
+
+    ltok::thread_pool pool;
+};
+
+struct llama_tokenizer_ring_t {
+    llama_tokenizer_ring_t(const llama_tokenizer_t* tokenizer, ltok::thread_pool* pool, uint32_t entries)
+        : ring(tokenizer, pool, entries) {}
+
+    ltok::request_ring ring;
+};
+
+// Owns one reference on the batch; exported Arrow arrays hold their own
+struct llama_tokenizer_csr_t {
+    explicit llama_tokenizer_csr_t(ltok::csr_batch* batch) : batch(batch) {}
+    ~llama_tokenizer_csr_t() { batch->release(); }
+
+    llama_tokenizer_csr_t(const llama_tokenizer_csr_t&) = delete;
+    llama_tokenizer_csr_t& operator=(const llama_tokenizer_csr_t&) = delete;
+
+    ltok::csr_batch* batch;
+};
+
+struct llama_tokenizer_chat_cache_t {
+    explicit llama_tokenizer_chat_cache_t(const llama_tokenizer_t* tokenizer) : tokenizer(tokenizer) {}
+
+    const llama_tokenizer_t* tokenizer;
+    ltok::chat_token_cache cache;
+};
+
+struct llama_tokenizer_grammar_t {
+    explicit llama_tokenizer_grammar_t(const llama_tokenizer_t* tokenizer) : tokenizer(tokenizer) {}
+
+    const llama_tokenizer_t* tokenizer;
+    ltok::token_grammar grammar;
+};
+
+struct llama_tokenizer_stops_t {
+    explicit llama_tokenizer_stops_t(const llama_tokenizer_t* tokenizer) : tokenizer(tokenizer) {}
+
+    const llama_tokenizer_t* tokenizer;
+    ltok::stop_set set;
+};
+
+struct llama_tokenizer_stop_stream_t {
+    explicit llama_tokenizer_stop_stream_t(const llama_tokenizer_stops_t* stops) : stream(stops->set) {}
+
+    ltok::stop_stream stream;
+};
+
+struct llama_tokenizer_translator_t {
+    ltok::vocab_translator translator;
+};
+
+struct llama_tokenizer_packer_t {
+    llama_tokenizer_packer_t(const llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool,
+                             bool parse_special, const ltok::packer_options& options)
+        : tokenizer(tokenizer), pool(pool), parse_special(parse_special), packer(options) {}
+
+    const llama_tokenizer_t* tokenizer;
+    llama_tokenizer_threadpool_t* pool;
+    bool parse_special;
+    ltok::sequence_packer packer;
+};
+
+#endif // LLAMA_TOKENIZER_INTERNAL_H
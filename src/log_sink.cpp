@@ -0,0 +1,257 @@
+#include "log_sink.h"
+#include "llama.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+
+namespace ltok {
+
+namespace {
+
+// Longer messages are truncated, keeping their final newline
+static constexpr size_t log_text_max = 512;
+static constexpr size_t default_log_capacity = 1024;
+
+// Threshold that no message level reaches
+static constexpr int log_level_off = LLAMA_TOKENIZER_LOG_CONT + 1;
+
+struct log_slot {
+    std::atomic<size_t> seq;
+    llama_tokenizer_log_level level;
+    char text[log_text_max];
+};
+
+/**
+ * Bounded multi-producer, single-consumer message queue drained by its
+ * own thread
+ *
+ * Producers claim a slot with a CAS on the tail and never wait: when the
+ * queue is full the message is counted as dropped. They only touch the
+ * sleep mutex when the drain thread is asleep, to wake it. Each slot's
+ * seq says whose turn it is: pos for the producer filling it, pos + 1 for
+ * the consumer, pos + capacity for the next lap's producer.
+ */
+class log_queue {
+public:
+    explicit log_queue(size_t capacity) : slots(new log_slot[capacity]), mask(capacity - 1) {
+        for (size_t i = 0; i < capacity; i++) {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~log_queue() { stop(); }
+
+    log_queue(const log_queue&) = delete;
+    log_queue& operator=(const log_queue&) = delete;
+
+    void start() { drainer = std::thread(&log_queue::drain_main, this); }
+
+    // Deliver everything queued so far, then join the drain thread
+    void stop() {
+        if (!drainer.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        sleep_cv.notify_one();
+        drainer.join();
+    }
+
+    bool push(llama_tokenizer_log_level level, const char* text) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        log_slot* slot;
+        for (;;) {
+            slot = &slots[pos & mask];
+            const size_t seq = slot->seq.load(std::memory_order_acquire);
+            if (seq == pos) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (seq < pos) {
+                return false;  // the consumer has not freed this slot yet: full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->level = level;
+        size_t len = strlen(text);
+        if (len >= log_text_max) {
+            const bool newline = text[len - 1] == '\n';
+            len = log_text_max - 1;
+            memcpy(slot->text, text, len);
+            if (newline) {
+                slot->text[len - 1] = '\n';
+            }
+        } else {
+            memcpy(slot->text, text, len);
+        }
+        slot->text[len] = '\0';
+        slot->seq.store(pos + 1, std::memory_order_release);
+
+        // Pairs with the sleepers increment in drain_main()
+        pending.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0) {
+            { std::lock_guard<std::mutex> lock(sleep_mutex); }
+            sleep_cv.notify_one();
+        }
+        return true;
+    }
+
+private:
+    void drain_main();
+
+    std::unique_ptr<log_slot[]> slots;
+    const size_t mask;
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) size_t head = 0;  // drain thread only
+
+    std::atomic<size_t> pending{0};
+    std::atomic<int> sleepers{0};
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    bool stopping = false;
+    std::thread drainer;
+};
+
+// Written only by the setters, which must not overlap other calls
+std::atomic<int> min_level{LLAMA_TOKENIZER_LOG_DEBUG};
+llama_tokenizer_log_fn user_fn = nullptr;
+void* user_data_ptr = nullptr;
+std::unique_ptr<log_queue> queue;
+std::atomic<uint64_t> dropped{0};
+
+// Serializes deliveries, so a callback never runs on two threads at once
+std::mutex deliver_mutex;
+
+void deliver(llama_tokenizer_log_level level, const char* text) {
+    std::lock_guard<std::mutex> lock(deliver_mutex);
+    if (user_fn) {
+        user_fn(level, text, user_data_ptr);
+    } else {
+        fputs(text, stderr);
+    }
+}
+
+void log_queue::drain_main() {
+    for (;;) {
+        while (pending.load(std::memory_order_seq_cst) > 0) {
+            log_slot& slot = slots[head & mask];
+            // A producer that claimed the slot may still be copying into it
+            while (slot.seq.load(std::memory_order_acquire) != head + 1) {
+                std::this_thread::yield();
+            }
+            deliver(slot.level, slot.text);
+            slot.seq.store(head + mask + 1, std::memory_order_release);
+            head++;
+            pending.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        sleep_cv.wait(lock, [&] { return stopping || pending.load(std::memory_order_seq_cst) > 0; });
+        sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        if (stopping && pending.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+    }
+}
+
+void log_dispatch(enum ggml_log_level level, const char* text, void* user_data) {
+    (void)user_data;
+    // llama.cpp continues a line on the thread that started it
+    thread_local bool last_passed = false;
+    const bool pass = level == GGML_LOG_LEVEL_CONT
+        ? last_passed
+        : (int)level >= min_level.load(std::memory_order_relaxed);
+    last_passed = pass;
+    if (!pass || !text) {
+        return;
+    }
+
+    const llama_tokenizer_log_level our_level = (llama_tokenizer_log_level)level;
+    if (queue) {
+        if (!queue->push(our_level, text)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    deliver(our_level, text);
+}
+
+// Destroyed before the state above: stops a running drain thread at exit
+// while the mutex and callback it delivers through still exist
+struct log_queue_guard {
+    ~log_queue_guard() { queue.reset(); }
+} queue_guard;
+
+} // namespace
+
+void log_set_level(llama_tokenizer_log_level level) {
+    int threshold;
+    if (level < LLAMA_TOKENIZER_LOG_DEBUG || level > LLAMA_TOKENIZER_LOG_CONT) {
+        threshold = log_level_off;  // NONE or invalid
+    } else if (level == LLAMA_TOKENIZER_LOG_CONT) {
+        threshold = LLAMA_TOKENIZER_LOG_DEBUG;  // not a severity; keeps passing everything
+    } else {
+        threshold = level;
+    }
+    min_level.store(threshold, std::memory_order_relaxed);
+    llama_log_set(log_dispatch, nullptr);
+}
+
+void log_set_callback(llama_tokenizer_log_fn fn, void* user_data) {
+    {
+        std::lock_guard<std::mutex> lock(deliver_mutex);
+        user_fn = fn;
+        user_data_ptr = user_data;
+    }
+    llama_log_set(log_dispatch, nullptr);
+}
+
+bool log_async_start(size_t capacity) {
+    if (queue) {
+        return true;
+    }
+    if (capacity == 0) {
+        capacity = default_log_capacity;
+    }
+    // Round up to a power of two so slots are indexed with a mask; one
+    // slot would make its full and empty seq values equal
+    size_t rounded = 2;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    try {
+        std::unique_ptr<log_queue> q(new log_queue(rounded));
+        q->start();
+        queue = std::move(q);
+    } catch (const std::bad_alloc&) {
+        return false;
+    } catch (const std::system_error&) {
+        return false;
+    }
+    llama_log_set(log_dispatch, nullptr);
+    return true;
+}
+
+void log_async_stop() {
+    // Stopping drains the queue; later messages are delivered directly
+    queue.reset();
+}
+
+uint64_t log_dropped() {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace ltok
@@ -0,0 +1,27 @@
+#ifndef LLAMA_TOKENIZER_LOG_SINK_H
+#define LLAMA_TOKENIZER_LOG_SINK_H
+
+#include "llama_tokenizer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ltok {
+
+/**
+ * Process-wide log routing for llama.cpp messages
+ *
+ * Each setter installs one dispatcher with llama_log_set(). It drops
+ * messages below the configured level (continuation lines follow the
+ * message they continue) and hands the rest to the user callback, or to
+ * stderr without one: directly, or through the async queue when started.
+ */
+void log_set_level(llama_tokenizer_log_level level);
+void log_set_callback(llama_tokenizer_log_fn fn, void* user_data);
+bool log_async_start(size_t capacity);
+void log_async_stop();
+uint64_t log_dropped();
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_LOG_SINK_H
@@ -0,0 +1,32 @@
+#include "native_tokenizer.h"
+#include "spm_tokenizer.h"
+#include "ugm_tokenizer.h"
+#include "vocab_metadata.h"
+#include "wpm_tokenizer.h"
+
+namespace ltok {
+
+std::unique_ptr<native_tokenizer> create_native_tokenizer(const llama_vocab* vocab, const char* model_path) {
+    const enum llama_vocab_type type = llama_vocab_type(vocab);
+    if (type != LLAMA_VOCAB_TYPE_SPM && type != LLAMA_VOCAB_TYPE_UGM && type != LLAMA_VOCAB_TYPE_WPM) {
+        return nullptr;
+    }
+
+    vocab_metadata meta;
+    if (!read_vocab_metadata(model_path, type, meta)) {
+        return nullptr;
+    }
+
+    switch (type) {
+        case LLAMA_VOCAB_TYPE_SPM:
+            return std::unique_ptr<native_tokenizer>(new spm_tokenizer(vocab, meta));
+        case LLAMA_VOCAB_TYPE_UGM:
+            return std::unique_ptr<native_tokenizer>(new ugm_tokenizer(vocab, meta));
+        case LLAMA_VOCAB_TYPE_WPM:
+            return std::unique_ptr<native_tokenizer>(new wpm_tokenizer(vocab, meta));
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace ltok
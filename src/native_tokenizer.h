@@ -0,0 +1,42 @@
+#ifndef LLAMA_TOKENIZER_NATIVE_TOKENIZER_H
+#define LLAMA_TOKENIZER_NATIVE_TOKENIZER_H
+
+#include "llama.h"
+
+#include <stddef.h>
+#include <memory>
+#include <vector>
+
+namespace ltok {
+
+/**
+ * Wrapper-side tokenizer kernel for one vocab type
+ *
+ * Replaces llama_tokenize() for raw text that contains no special tokens,
+ * with add_special off; special tokens and BOS/EOS are handled by the
+ * caller. Kernels are immutable after construction and safe to share.
+ *
+ * Concrete kernels are final: the tokenize path is instantiated per
+ * kernel type and calls them directly, so the virtual interface is only
+ * used at create time.
+ */
+class native_tokenizer {
+public:
+    virtual ~native_tokenizer() = default;
+
+    /**
+     * Append the tokens for one raw-text fragment to out. Returns false if
+     * the kernel cannot handle the input; out is then left unchanged and
+     * the caller falls back to llama.cpp.
+     */
+    virtual bool tokenize(const char* text, size_t len, std::vector<llama_token>& out) const = 0;
+};
+
+/**
+ * Build the kernel for the vocab's type, or NULL if there is none
+ */
+std::unique_ptr<native_tokenizer> create_native_tokenizer(const llama_vocab* vocab, const char* model_path);
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_NATIVE_TOKENIZER_H
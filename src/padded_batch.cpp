@@ -0,0 +1,184 @@
+#include "padded_batch.h"
+#include "scratch.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <vector>
+
+namespace ltok {
+
+namespace {
+
+// Full token sequences of rows too long for the matrix
+thread_local std::vector<llama_token> row_scratch;
+
+template <typename F>
+void for_rows(thread_pool* pool, size_t n, size_t grain, const F& fn) {
+    if (pool && n > grain) {
+        pool->parallel_for(n, grain, fn);
+    } else {
+        fn(0, n);
+    }
+}
+
+// Tokenize text i into row, truncated to max_len; -1 on failure
+int32_t tokenize_row(row_tokenize_fn tokenize, row_estimate_fn estimate, const void* ctx, size_t i,
+                     const padded_layout& layout, llama_token* row) {
+    const int32_t max_len = (int32_t)layout.max_len;
+    if (estimate(ctx, i) <= max_len) {
+        const int32_t n = tokenize(ctx, i, row, max_len);
+        if (n >= 0) {
+            return n;
+        }
+        if (-(int64_t)n <= max_len) {
+            return -1;  // an error, not a size
+        }
+    }
+
+    std::vector<llama_token>& full = row_scratch;
+    int32_t n;
+    try {
+        if (full.size() < layout.max_len * 2) {
+            full.resize(layout.max_len * 2);
+        }
+        n = tokenize(ctx, i, full.data(), (int32_t)std::min<size_t>(full.size(), INT32_MAX));
+        if (n < 0 && (size_t)-(int64_t)n > full.size()) {
+            full.resize((size_t)-(int64_t)n);
+            n = tokenize(ctx, i, full.data(), (int32_t)full.size());
+        }
+    } catch (const std::bad_alloc&) {
+        return -1;
+    }
+    if (n < 0) {
+        return -1;
+    }
+
+    size_t keep = std::min((size_t)n, layout.max_len);
+    memcpy(row, full.data(), keep * sizeof(llama_token));
+    // Keep the closing special tokens (EOS, SEP) of a truncated row
+    const size_t n_suffix = layout.n_suffix;
+    if ((size_t)n > layout.max_len && n_suffix > 0 && n_suffix < layout.max_len &&
+        memcmp(full.data() + n - n_suffix, layout.suffix, n_suffix * sizeof(llama_token)) == 0) {
+        memcpy(row + keep - n_suffix, layout.suffix, n_suffix * sizeof(llama_token));
+    }
+    return (int32_t)keep;
+}
+
+} // namespace
+
+int32_t fill_padded(row_tokenize_fn tokenize, row_estimate_fn estimate, const void* ctx, size_t n_texts,
+                    const padded_layout& layout, thread_pool* pool, size_t grain,
+                    llama_token* tokens, uint8_t* attention_mask, int32_t* lengths, int32_t* row_order) {
+    const size_t max_len = layout.max_len;
+    std::vector<int32_t> own_lengths;
+    try {
+        if (!lengths) {
+            own_lengths.resize(n_texts);
+            lengths = own_lengths.data();
+        }
+    } catch (const std::bad_alloc&) {
+        return -1;
+    }
+
+    std::atomic<bool> failed{false};
+    for_rows(pool, n_texts, grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            lengths[i] = tokenize_row(tokenize, estimate, ctx, i, layout, tokens + i * max_len);
+            if (lengths[i] < 0) {
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+        scratch_trim(row_scratch);
+    });
+    if (failed.load(std::memory_order_relaxed)) {
+        return -1;
+    }
+
+    size_t width = max_len;
+    if (layout.pad_to_longest) {
+        width = 0;
+        for (size_t i = 0; i < n_texts; i++) {
+            width = std::max(width, (size_t)lengths[i]);
+        }
+    }
+
+    if (layout.sort_by_length) {
+        // Longest first; ties keep their input order
+        for (size_t i = 0; i < n_texts; i++) {
+            row_order[i] = (int32_t)i;
+        }
+        std::stable_sort(row_order, row_order + n_texts,
+                         [&](int32_t a, int32_t b) { return lengths[a] > lengths[b]; });
+
+        std::vector<size_t> offsets;
+        std::vector<llama_token> compact;
+        std::vector<int32_t> text_lengths;
+        try {
+            offsets.resize(n_texts + 1);
+            offsets[0] = 0;
+            for (size_t i = 0; i < n_texts; i++) {
+                offsets[i + 1] = offsets[i] + (size_t)lengths[i];
+            }
+            compact.resize(offsets[n_texts]);
+            text_lengths.assign(lengths, lengths + n_texts);
+        } catch (const std::bad_alloc&) {
+            return -1;
+        }
+        for_rows(pool, n_texts, grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                memcpy(compact.data() + offsets[i], tokens + i * max_len, (size_t)lengths[i] * sizeof(llama_token));
+            }
+        });
+        // Row lengths follow the rows, not the texts
+        for_rows(pool, n_texts, grain, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++) {
+                const size_t i = (size_t)row_order[r];
+                lengths[r] = text_lengths[i];
+                memcpy(tokens + r * width, compact.data() + offsets[i], (size_t)lengths[r] * sizeof(llama_token));
+            }
+        });
+    } else {
+        if (row_order) {
+            for (size_t i = 0; i < n_texts; i++) {
+                row_order[i] = (int32_t)i;
+            }
+        }
+        // Each row moves down to a lower address, never over a row not yet moved
+        if (width < max_len) {
+            for (size_t i = 1; i < n_texts; i++) {
+                memmove(tokens + i * width, tokens + i * max_len, (size_t)lengths[i] * sizeof(llama_token));
+            }
+        }
+    }
+
+    for_rows(pool, n_texts, grain, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; r++) {
+            llama_token* row = tokens + r * width;
+            const size_t len = (size_t)lengths[r];
+            const size_t pad = width - len;
+            llama_token* pad_begin = row + len;
+            if (layout.pad_left) {
+                memmove(row + pad, row, len * sizeof(llama_token));
+                pad_begin = row;
+            }
+            std::fill(pad_begin, pad_begin + pad, layout.pad_token);
+            if (attention_mask) {
+                uint8_t* mask = attention_mask + r * width;
+                if (layout.pad_left) {
+                    memset(mask, 0, pad);
+                    memset(mask + pad, 1, len);
+                } else {
+                    memset(mask, 1, len);
+                    memset(mask + len, 0, pad);
+                }
+            }
+        }
+    });
+    return (int32_t)width;
+}
+
+} // namespace ltok
@@ -0,0 +1,48 @@
+#ifndef LLAMA_TOKENIZER_PADDED_BATCH_H
+#define LLAMA_TOKENIZER_PADDED_BATCH_H
+
+#include "llama_tokenizer.h"
+#include "threadpool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ltok {
+
+// Tokens of text index into out[0, n_max): the count, the negative
+// required size when n_max is too small, or another negative on error
+typedef int32_t (*row_tokenize_fn)(const void* ctx, size_t index, llama_token* out, int32_t n_max);
+
+// Lowest plausible token count of text index; texts expected to overflow
+// a row go straight to scratch instead of being tokenized twice
+typedef int32_t (*row_estimate_fn)(const void* ctx, size_t index);
+
+struct padded_layout {
+    size_t max_len = 0;
+    bool pad_left = false;
+    bool pad_to_longest = false;
+    bool sort_by_length = false;
+    llama_token pad_token = 0;
+    // Kept at the end of a truncated row if the full row ended with it
+    const llama_token* suffix = nullptr;
+    size_t n_suffix = 0;
+};
+
+/**
+ * Tokenize texts into a row-major [n_texts, width] matrix
+ *
+ * Rows are first tokenized in place at a stride of max_len, truncating
+ * through a per-thread scratch buffer. Sorting then reorders them via a
+ * compact copy, and pad_to_longest narrows the stride to the longest row
+ * in one forward pass; padding and the mask are filled last, in parallel.
+ *
+ * @return Row stride (width), or -1 if a text failed to tokenize or
+ *         memory ran out
+ */
+int32_t fill_padded(row_tokenize_fn tokenize, row_estimate_fn estimate, const void* ctx, size_t n_texts,
+                    const padded_layout& layout, thread_pool* pool, size_t grain,
+                    llama_token* tokens, uint8_t* attention_mask, int32_t* lengths, int32_t* row_order);
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_PADDED_BATCH_H
@@ -0,0 +1,85 @@
+#include "piece_index.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+
+namespace ltok {
+
+bool piece_index::build(const llama_vocab* vocab) {
+    const int32_t n_vocab = llama_vocab_n_tokens(vocab);
+    if (n_vocab <= 0) {
+        return false;
+    }
+
+    try {
+        text.clear();
+        offsets.assign(1, 0);
+        offsets.reserve((size_t)n_vocab + 1);
+        std::vector<char> buf(256);
+        for (llama_token id = 0; id < n_vocab; id++) {
+            int32_t n = llama_token_to_piece(vocab, id, buf.data(), (int32_t)buf.size(), 0, false);
+            if (n < 0) {
+                buf.resize((size_t)-(int64_t)n);
+                n = llama_token_to_piece(vocab, id, buf.data(), (int32_t)buf.size(), 0, false);
+            }
+            if (n > 0) {
+                text.append(buf.data(), (size_t)n);
+            }
+            if (text.size() > UINT32_MAX) {
+                return false;
+            }
+            offsets.push_back((uint32_t)text.size());
+        }
+
+        order.clear();
+        for (llama_token id = 0; id < n_vocab; id++) {
+            if (offsets[id + 1] > offsets[id]) {
+                order.push_back(id);
+            }
+        }
+        const auto view = [this](llama_token id) {
+            return std::string(text, offsets[id], offsets[id + 1] - offsets[id]);
+        };
+        std::sort(order.begin(), order.end(), [&](llama_token a, llama_token b) {
+            const size_t la = offsets[a + 1] - offsets[a];
+            const size_t lb = offsets[b + 1] - offsets[b];
+            const int c = memcmp(text.data() + offsets[a], text.data() + offsets[b], std::min(la, lb));
+            return c != 0 ? c < 0 : (la != lb ? la < lb : a < b);
+        });
+
+        group_begin.clear();
+        std::vector<std::pair<std::string, int32_t>> keys;
+        for (size_t i = 0; i < order.size(); i++) {
+            std::string piece = view(order[i]);
+            if (keys.empty() || piece != keys.back().first) {
+                keys.emplace_back(std::move(piece), (int32_t)group_begin.size());
+                group_begin.push_back((uint32_t)i);
+            }
+        }
+        group_begin.push_back((uint32_t)order.size());
+        pieces.build(std::move(keys));
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    built = true;
+    return true;
+}
+
+void piece_index::with_prefix(const char* prefix, size_t len, size_t& begin, size_t& end) const {
+    // Pieces that start with prefix sort together, right where prefix would
+    const auto first = std::partition_point(order.begin(), order.end(), [&](llama_token id) {
+        const size_t n = offsets[id + 1] - offsets[id];
+        const int c = memcmp(text.data() + offsets[id], prefix, std::min(n, len));
+        return c != 0 ? c < 0 : n < len;
+    });
+    const auto last = std::partition_point(first, order.end(), [&](llama_token id) {
+        const size_t n = offsets[id + 1] - offsets[id];
+        return n >= len && memcmp(text.data() + offsets[id], prefix, len) == 0;
+    });
+    begin = (size_t)(first - order.begin());
+    end = (size_t)(last - order.begin());
+}
+
+} // namespace ltok
@@ -0,0 +1,77 @@
+#ifndef LLAMA_TOKENIZER_PIECE_INDEX_H
+#define LLAMA_TOKENIZER_PIECE_INDEX_H
+
+#include "llama.h"
+#include "double_array_trie.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace ltok {
+
+/**
+ * Index over every token's rendered piece, as llama_token_to_piece()
+ * gives it without special tokens
+ *
+ * Ids are kept sorted by piece, so the tokens whose piece starts with a
+ * byte string are one range of that order. Each distinct piece is a key
+ * of a trie whose value is its range, so the tokens whose piece a byte
+ * string starts with are found in one walk. Tokens with an empty piece
+ * (control tokens) are left out. Immutable after build().
+ */
+class piece_index {
+public:
+    // False if the vocab could not be read or memory ran out
+    bool build(const llama_vocab* vocab);
+
+    bool ok() const { return built; }
+
+    // Ids in piece order; a range below indexes into it
+    const llama_token* sorted() const { return order.data(); }
+    size_t size() const { return order.size(); }
+
+    /**
+     * Range of sorted() whose pieces start with prefix; all of it for
+     * an empty prefix
+     */
+    void with_prefix(const char* prefix, size_t len, size_t& begin, size_t& end) const;
+
+    /**
+     * Visit the ranges of sorted() whose pieces are prefixes of text as
+     * fn(begin, end, piece_length), shortest piece first
+     */
+    template <typename F>
+    void prefixes_of(const char* text, size_t len, F&& fn) const {
+        pieces.prefixes(text, len, [&](int32_t group, size_t piece_length) {
+            fn((size_t)group_begin[group], (size_t)group_begin[group + 1], piece_length);
+        });
+    }
+
+    /**
+     * Rendered piece of a token; length 0 for a token left out or out of
+     * range
+     */
+    const char* piece(llama_token id, size_t& length) const {
+        if (id < 0 || (size_t)id + 1 >= offsets.size()) {
+            length = 0;
+            return nullptr;
+        }
+        length = offsets[id + 1] - offsets[id];
+        return text.data() + offsets[id];
+    }
+
+private:
+    std::string text;                   // every piece, in id order
+    std::vector<uint32_t> offsets;      // piece of id i is [offsets[i], offsets[i + 1])
+    std::vector<llama_token> order;     // ids with a piece, sorted by piece
+    std::vector<uint32_t> group_begin;  // start in order of each distinct piece, then order.size()
+    double_array_trie pieces;           // distinct piece -> group
+    bool built = false;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_PIECE_INDEX_H
@@ -0,0 +1,943 @@
+#include "regex_dfa.h"
+
+#include <algorithm>
+#include <map>
+#include <new>
+
+namespace ltok {
+
+namespace {
+
+static constexpr uint32_t max_codepoint = 0x10FFFF;
+static constexpr int max_repeat = 1000;
+static constexpr int max_depth = 256;
+static constexpr size_t max_nfa_states = (size_t)1 << 20;
+
+// Sorted, disjoint, inclusive codepoint ranges
+typedef std::vector<std::pair<uint32_t, uint32_t>> codepoint_set;
+
+struct regex_node {
+    enum node_kind { CHARS, CONCAT, ALT, REPEAT } kind = CONCAT;  // CONCAT of nothing is the empty string
+    codepoint_set chars;
+    std::vector<regex_node> children;
+    int min = 0;
+    int max = 0;  // -1 for no limit
+};
+
+void normalize(codepoint_set& set) {
+    std::sort(set.begin(), set.end());
+    size_t out = 0;
+    for (size_t i = 0; i < set.size(); i++) {
+        if (out > 0 && set[i].first <= set[out - 1].second + 1) {
+            set[out - 1].second = std::max(set[out - 1].second, set[i].second);
+        } else {
+            set[out++] = set[i];
+        }
+    }
+    set.resize(out);
+}
+
+codepoint_set complement(const codepoint_set& set) {
+    codepoint_set out;
+    uint32_t next = 0;
+    for (const auto& range : set) {
+        if (range.first > next) {
+            out.emplace_back(next, range.first - 1);
+        }
+        next = range.second + 1;
+    }
+    if (next <= max_codepoint) {
+        out.emplace_back(next, max_codepoint);
+    }
+    return out;
+}
+
+codepoint_set class_digit() { return { { '0', '9' } }; }
+codepoint_set class_word() { return { { '0', '9' }, { 'A', 'Z' }, { '_', '_' }, { 'a', 'z' } }; }
+codepoint_set class_space() { return { { '\t', '\r' }, { ' ', ' ' } }; }
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+class regex_parser {
+public:
+    regex_parser(const char* pattern, size_t len, std::string& error) : p(pattern), len(len), error(error) {}
+
+    bool parse(regex_node& out) {
+        if (pos < len && p[pos] == '^') {
+            pos++;
+        }
+        if (!parse_alt(out, 0)) {
+            return false;
+        }
+        return pos == len || fail("unmatched ')'");
+    }
+
+private:
+    bool fail(const char* message) {
+        error = std::string(message) + " at offset " + std::to_string(pos);
+        return false;
+    }
+
+    bool parse_alt(regex_node& out, int depth) {
+        if (depth > max_depth) {
+            return fail("pattern nested too deeply");
+        }
+        regex_node first;
+        if (!parse_concat(first, depth)) {
+            return false;
+        }
+        if (pos >= len || p[pos] != '|') {
+            out = std::move(first);
+            return true;
+        }
+        out.kind = regex_node::ALT;
+        out.children.push_back(std::move(first));
+        while (pos < len && p[pos] == '|') {
+            pos++;
+            regex_node branch;
+            if (!parse_concat(branch, depth)) {
+                return false;
+            }
+            out.children.push_back(std::move(branch));
+        }
+        return true;
+    }
+
+    bool parse_concat(regex_node& out, int depth) {
+        out.kind = regex_node::CONCAT;
+        while (pos < len && p[pos] != '|' && p[pos] != ')') {
+            if (p[pos] == '$' && pos + 1 == len) {
+                pos++;
+                break;
+            }
+            regex_node item;
+            if (!parse_repeat(item, depth)) {
+                return false;
+            }
+            out.children.push_back(std::move(item));
+        }
+        if (out.children.size() == 1) {
+            regex_node only = std::move(out.children[0]);
+            out = std::move(only);
+        }
+        return true;
+    }
+
+    bool parse_repeat(regex_node& out, int depth) {
+        if (!parse_atom(out, depth)) {
+            return false;
+        }
+        int lo;
+        int hi;
+        bool quantified;
+        if (!parse_quantifier(lo, hi, quantified)) {
+            return false;
+        }
+        if (!quantified) {
+            return true;
+        }
+        if (pos < len && p[pos] == '?') {
+            pos++;  // lazy: same language
+        }
+
+        // a** or a?{2} would nest repeats without bound, as JS and PCRE
+        // refuse them
+        int next_lo;
+        int next_hi;
+        bool again;
+        if (!parse_quantifier(next_lo, next_hi, again)) {
+            return false;
+        }
+        if (again) {
+            return fail("multiple repeat");
+        }
+
+        regex_node repeat;
+        repeat.kind = regex_node::REPEAT;
+        repeat.min = lo;
+        repeat.max = hi;
+        repeat.children.push_back(std::move(out));
+        out = std::move(repeat);
+        return true;
+    }
+
+    // *, +, ? or a count; quantified false (and pos unchanged) for anything else
+    bool parse_quantifier(int& lo, int& hi, bool& quantified) {
+        quantified = true;
+        const char c = pos < len ? p[pos] : 0;
+        if (c == '*') {
+            lo = 0, hi = -1, pos++;
+        } else if (c == '+') {
+            lo = 1, hi = -1, pos++;
+        } else if (c == '?') {
+            lo = 0, hi = 1, pos++;
+        } else if (c == '{') {
+            return parse_count(lo, hi, quantified);  // not a count: a literal '{'
+        } else {
+            quantified = false;
+        }
+        return true;
+    }
+
+    // {n}, {n,} or {n,m}; is_count false (and pos unchanged) for anything else
+    bool parse_count(int& lo, int& hi, bool& is_count) {
+        size_t i = pos + 1;
+        long values[2] = { -1, -1 };
+        bool comma = false;
+        for (int k = 0; k < 2; k++) {
+            long v = -1;
+            while (i < len && p[i] >= '0' && p[i] <= '9') {
+                v = (v < 0 ? 0 : v) * 10 + (p[i] - '0');
+                v = std::min(v, (long)max_repeat + 1);
+                i++;
+            }
+            values[k] = v;
+            if (k == 0 && i < len && p[i] == ',') {
+                comma = true;
+                i++;
+            } else {
+                break;
+            }
+        }
+        is_count = i < len && p[i] == '}' && values[0] >= 0;
+        if (!is_count) {
+            return true;
+        }
+        pos = i + 1;
+        lo = (int)values[0];
+        hi = comma ? (int)values[1] : lo;
+        if (lo > max_repeat || hi > max_repeat) {
+            return fail("repetition count too large");
+        }
+        if (hi >= 0 && hi < lo) {
+            return fail("repetition range out of order");
+        }
+        return true;
+    }
+
+    bool parse_atom(regex_node& out, int depth) {
+        const char c = p[pos];
+        out.kind = regex_node::CHARS;
+        switch (c) {
+        case '(':
+            pos++;
+            if (pos + 1 < len && p[pos] == '?' && p[pos + 1] == ':') {
+                pos += 2;
+            } else if (pos < len && p[pos] == '?') {
+                return fail("unsupported group");
+            }
+            if (!parse_alt(out, depth + 1)) {
+                return false;
+            }
+            if (pos >= len || p[pos] != ')') {
+                return fail("missing ')'");
+            }
+            pos++;
+            return true;
+        case '[':
+            return parse_class(out.chars);
+        case '.':
+            pos++;
+            // Any character but a line terminator, as in ECMA-262
+            out.chars = { { 0, '\n' - 1 }, { '\n' + 1, '\r' - 1 }, { '\r' + 1, 0x2027 }, { 0x202A, max_codepoint } };
+            return true;
+        case '\\':
+            pos++;
+            return parse_escape(out.chars, false);
+        case '*':
+        case '+':
+        case '?':
+            return fail("nothing to repeat");
+        case '^':
+            return fail("'^' is only supported at the start");
+        case '$':
+            return fail("'$' is only supported at the end");
+        default: {
+            uint32_t cp;
+            if (!decode(cp)) {
+                return false;
+            }
+            out.chars = { { cp, cp } };
+            return true;
+        }
+        }
+    }
+
+    // After the backslash
+    bool parse_escape(codepoint_set& out, bool in_class) {
+        if (pos >= len) {
+            return fail("trailing backslash");
+        }
+        const char c = p[pos++];
+        uint32_t cp;
+        switch (c) {
+        case 'd': out = class_digit(); return true;
+        case 'D': out = complement(class_digit()); return true;
+        case 'w': out = class_word(); return true;
+        case 'W': out = complement(class_word()); return true;
+        case 's': out = class_space(); return true;
+        case 'S': out = complement(class_space()); return true;
+        case 'n': cp = '\n'; break;
+        case 'r': cp = '\r'; break;
+        case 't': cp = '\t'; break;
+        case 'f': cp = '\f'; break;
+        case 'v': cp = '\v'; break;
+        case '0': cp = 0; break;
+        case 'x':
+            if (pos + 2 > len || hex_value(p[pos]) < 0 || hex_value(p[pos + 1]) < 0) {
+                return fail("bad \\x escape");
+            }
+            cp = (uint32_t)(hex_value(p[pos]) * 16 + hex_value(p[pos + 1]));
+            pos += 2;
+            break;
+        case 'u':
+            if (!parse_unicode_escape(cp)) {
+                return false;
+            }
+            break;
+        case 'b':
+            if (!in_class) {
+                return fail("word boundaries are not supported");
+            }
+            cp = '\b';
+            break;
+        default:
+            if ((unsigned char)c >= 0x80) {
+                pos--;
+                if (!decode(cp)) {
+                    return false;
+                }
+            } else if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+                pos--;
+                return fail("unsupported escape");
+            } else {
+                cp = (uint32_t)c;
+            }
+        }
+        out = { { cp, cp } };
+        return true;
+    }
+
+    // \uHHHH or \u{H...}, after the 'u'
+    bool parse_unicode_escape(uint32_t& cp) {
+        cp = 0;
+        if (pos < len && p[pos] == '{') {
+            size_t i = pos + 1;
+            while (i < len && hex_value(p[i]) >= 0 && cp <= max_codepoint) {
+                cp = cp * 16 + (uint32_t)hex_value(p[i++]);
+            }
+            if (i == pos + 1 || i >= len || p[i] != '}' || cp > max_codepoint) {
+                return fail("bad \\u escape");
+            }
+            pos = i + 1;
+            return true;
+        }
+        for (int k = 0; k < 4; k++) {
+            if (pos >= len || hex_value(p[pos]) < 0) {
+                return fail("bad \\u escape");
+            }
+            cp = cp * 16 + (uint32_t)hex_value(p[pos++]);
+        }
+        return true;
+    }
+
+    bool parse_class(codepoint_set& out) {
+        pos++;
+        const bool negate = pos < len && p[pos] == '^';
+        if (negate) {
+            pos++;
+        }
+        codepoint_set set;
+        for (bool first = true;; first = false) {
+            if (pos >= len) {
+                return fail("missing ']'");
+            }
+            if (p[pos] == ']' && !first) {
+                pos++;
+                break;
+            }
+            uint32_t lo;
+            bool single;
+            if (!parse_class_char(set, lo, single)) {
+                return false;
+            }
+            if (!single) {
+                continue;
+            }
+            uint32_t hi = lo;
+            if (pos + 1 < len && p[pos] == '-' && p[pos + 1] != ']') {
+                pos++;
+                if (!parse_class_char(set, hi, single)) {
+                    return false;
+                }
+                if (!single || hi < lo) {
+                    return fail("bad class range");
+                }
+            }
+            set.emplace_back(lo, hi);
+        }
+        normalize(set);
+        out = negate ? complement(set) : set;
+        return true;
+    }
+
+    // One class member: a character (single) or a class escape added to set
+    bool parse_class_char(codepoint_set& set, uint32_t& cp, bool& single) {
+        single = true;
+        if (p[pos] != '\\') {
+            return decode(cp);
+        }
+        pos++;
+        codepoint_set escaped;
+        if (!parse_escape(escaped, true)) {
+            return false;
+        }
+        if (escaped.size() == 1 && escaped[0].first == escaped[0].second) {
+            cp = escaped[0].first;
+        } else {
+            set.insert(set.end(), escaped.begin(), escaped.end());
+            single = false;
+        }
+        return true;
+    }
+
+    // One UTF-8 character of the pattern
+    bool decode(uint32_t& cp) {
+        const unsigned char c = (unsigned char)p[pos];
+        size_t n = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+        if (n == 0 || pos + n > len) {
+            return fail("invalid UTF-8 in pattern");
+        }
+        cp = n == 1 ? c : c & (0x7F >> n);
+        for (size_t i = 1; i < n; i++) {
+            const unsigned char b = (unsigned char)p[pos + i];
+            if ((b & 0xC0) != 0x80) {
+                return fail("invalid UTF-8 in pattern");
+            }
+            cp = (cp << 6) | (b & 0x3F);
+        }
+        static const uint32_t min_for_length[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+        if (cp < min_for_length[n] || cp > max_codepoint || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            return fail("invalid UTF-8 in pattern");
+        }
+        pos += n;
+        return true;
+    }
+
+    const char* p;
+    const size_t len;
+    size_t pos = 0;
+    std::string& error;
+};
+
+typedef std::vector<std::pair<uint8_t, uint8_t>> byte_sequence;
+
+size_t utf8_encode(uint32_t cp, uint8_t out[4]) {
+    if (cp < 0x80) {
+        out[0] = (uint8_t)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (uint8_t)(0xC0 | (cp >> 6));
+        out[1] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (uint8_t)(0xE0 | (cp >> 12));
+        out[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (uint8_t)(0xF0 | (cp >> 18));
+    out[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (uint8_t)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Split a codepoint range into byte-range sequences, one per run of
+// UTF-8 encodings that differ only within each byte's own range
+void utf8_sequences(uint32_t lo, uint32_t hi, std::vector<byte_sequence>& out) {
+    if (lo > hi) {
+        return;
+    }
+    if (lo <= 0xDFFF && hi >= 0xD800) {
+        if (lo < 0xD800) {
+            utf8_sequences(lo, 0xD7FF, out);
+        }
+        if (hi > 0xDFFF) {
+            utf8_sequences(0xE000, hi, out);
+        }
+        return;
+    }
+    for (uint32_t limit : { 0x7Fu, 0x7FFu, 0xFFFFu }) {
+        if (lo <= limit && hi > limit) {
+            utf8_sequences(lo, limit, out);
+            utf8_sequences(limit + 1, hi, out);
+            return;
+        }
+    }
+    if (hi > 0x7F) {
+        for (int i = 1; i < 4; i++) {
+            const uint32_t m = (1u << (6 * i)) - 1;
+            if ((lo & ~m) != (hi & ~m)) {
+                if ((lo & m) != 0) {
+                    utf8_sequences(lo, lo | m, out);
+                    utf8_sequences((lo | m) + 1, hi, out);
+                    return;
+                }
+                if ((hi & m) != m) {
+                    utf8_sequences(lo, (hi & ~m) - 1, out);
+                    utf8_sequences(hi & ~m, hi, out);
+                    return;
+                }
+            }
+        }
+    }
+    uint8_t a[4];
+    uint8_t b[4];
+    const size_t n = utf8_encode(lo, a);
+    utf8_encode(hi, b);
+    byte_sequence sequence;
+    for (size_t i = 0; i < n; i++) {
+        sequence.emplace_back(a[i], b[i]);
+    }
+    out.push_back(std::move(sequence));
+}
+
+// Thompson NFA over bytes
+class nfa_builder {
+public:
+    struct edge {
+        uint8_t lo;
+        uint8_t hi;
+        int32_t target;
+    };
+
+    std::vector<std::vector<edge>> edges;
+    std::vector<std::vector<int32_t>> epsilon;
+    bool too_large = false;
+
+    int32_t add() {
+        if (edges.size() >= max_nfa_states) {
+            too_large = true;
+            return 0;
+        }
+        edges.emplace_back();
+        epsilon.emplace_back();
+        return (int32_t)edges.size() - 1;
+    }
+
+    // Add node's language after state from; returns the state it ends in
+    int32_t compile(const regex_node& node, int32_t from) {
+        if (too_large) {
+            return from;
+        }
+        switch (node.kind) {
+        case regex_node::CHARS: {
+            const int32_t end = add();
+            std::vector<byte_sequence> sequences;
+            for (const auto& range : node.chars) {
+                utf8_sequences(range.first, range.second, sequences);
+            }
+            for (const byte_sequence& sequence : sequences) {
+                int32_t state = from;
+                for (size_t i = 0; i + 1 < sequence.size(); i++) {
+                    const int32_t next = add();
+                    edges[(size_t)state].push_back({ sequence[i].first, sequence[i].second, next });
+                    state = next;
+                }
+                edges[(size_t)state].push_back({ sequence.back().first, sequence.back().second, end });
+            }
+            return end;
+        }
+        case regex_node::CONCAT: {
+            int32_t state = from;
+            for (const regex_node& child : node.children) {
+                state = compile(child, state);
+            }
+            return state;
+        }
+        case regex_node::ALT: {
+            const int32_t end = add();
+            for (const regex_node& child : node.children) {
+                const int32_t start = add();
+                epsilon[(size_t)from].push_back(start);
+                epsilon[(size_t)compile(child, start)].push_back(end);
+            }
+            return end;
+        }
+        case regex_node::REPEAT: {
+            int32_t state = from;
+            for (int i = 0; i < node.min; i++) {
+                state = compile(node.children[0], state);
+            }
+            if (node.max < 0) {
+                const int32_t loop = add();
+                const int32_t end = add();
+                epsilon[(size_t)state].push_back(loop);
+                epsilon[(size_t)loop].push_back(end);
+                epsilon[(size_t)compile(node.children[0], loop)].push_back(loop);
+                return end;
+            }
+            const int32_t end = add();
+            for (int i = node.min; i < node.max; i++) {
+                epsilon[(size_t)state].push_back(end);
+                state = compile(node.children[0], state);
+            }
+            epsilon[(size_t)state].push_back(end);
+            return end;
+        }
+        }
+        return from;
+    }
+};
+
+// Prints a parsed pattern back as regex text, with '"', '\' and control
+// characters moved from character sets to the JSON escapes for them
+class json_string_printer {
+public:
+    explicit json_string_printer(std::string& out) : out(out) {}
+
+    void print(const regex_node& node) {
+        switch (node.kind) {
+        case regex_node::CHARS:
+            print_chars(node.chars);
+            break;
+        case regex_node::CONCAT:
+        case regex_node::ALT:
+            out += "(?:";
+            for (size_t i = 0; i < node.children.size(); i++) {
+                out += i > 0 && node.kind == regex_node::ALT ? "|" : "";
+                print(node.children[i]);
+            }
+            out += ")";
+            break;
+        case regex_node::REPEAT:
+            out += "(?:";
+            print(node.children[0]);
+            out += "){" + std::to_string(node.min) + "," + (node.max >= 0 ? std::to_string(node.max) : "") + "}";
+            break;
+        }
+    }
+
+private:
+    void print_chars(const codepoint_set& set) {
+        // raw: set without the characters JSON requires escaped
+        codepoint_set outside = complement(set);
+        outside.insert(outside.end(), { { 0, 0x1F }, { '"', '"' }, { '\\', '\\' } });
+        normalize(outside);
+        const codepoint_set raw = complement(outside);
+
+        std::string escapes;
+        for (const auto& range : set) {
+            for (uint32_t cp = range.first; cp <= std::min<uint32_t>(range.second, '\\'); cp++) {
+                if (cp < 0x20 || cp == '"' || cp == '\\') {
+                    add_escapes(cp, escapes);
+                }
+            }
+        }
+        if (escapes.empty() && !raw.empty()) {
+            print_class(raw);
+            return;
+        }
+        out += "(?:";
+        if (!raw.empty()) {
+            print_class(raw);
+            out += "|";
+        }
+        out += escapes.empty() ? "[^\\u{0}-\\u{10FFFF}]" : escapes.substr(1);
+        out += ")";
+    }
+
+    void print_class(const codepoint_set& set) {
+        out += "[";
+        for (const auto& range : set) {
+            out += "\\u{" + hex(range.first) + "}";
+            if (range.second != range.first) {
+                out += "-\\u{" + hex(range.second) + "}";
+            }
+        }
+        out += "]";
+    }
+
+    // "|"-prefixed regexes for each JSON escape that decodes to cp
+    static void add_escapes(uint32_t cp, std::string& escapes) {
+        static const struct {
+            char decoded;
+            const char* regex;
+        } short_forms[] = {
+            { '"', "\\\\\"" }, { '\\', "\\\\\\\\" }, { '\b', "\\\\b" }, { '\f', "\\\\f" },
+            { '\n', "\\\\n" }, { '\r', "\\\\r" }, { '\t', "\\\\t" },
+        };
+        for (const auto& form : short_forms) {
+            if ((uint32_t)(unsigned char)form.decoded == cp) {
+                escapes += std::string("|") + form.regex;
+            }
+        }
+        // \u00XX, either case
+        static const char digits[] = "0123456789abcdef";
+        escapes += "|\\\\u00";
+        for (uint32_t nibble : { cp >> 4, cp & 0xF }) {
+            if (nibble < 10) {
+                escapes += digits[nibble];
+            } else {
+                escapes += std::string("[") + digits[nibble] + (char)(digits[nibble] - 'a' + 'A') + "]";
+            }
+        }
+    }
+
+    static std::string hex(uint32_t cp) {
+        static const char digits[] = "0123456789ABCDEF";
+        std::string text;
+        do {
+            text.insert(text.begin(), digits[cp & 0xF]);
+            cp >>= 4;
+        } while (cp != 0);
+        return text;
+    }
+
+    std::string& out;
+};
+
+} // namespace
+
+bool byte_dfa::compile(const char* pattern, size_t len, size_t max_states, std::string& error) {
+    transitions.clear();
+    accepting_.clear();
+    error.clear();
+
+    try {
+        regex_node root;
+        regex_parser parser(pattern, len, error);
+        if (!parser.parse(root)) {
+            return false;
+        }
+
+        nfa_builder nfa;
+        const int32_t start = nfa.add();
+        const int32_t final_state = nfa.compile(root, start);
+        if (nfa.too_large) {
+            error = "pattern too large";
+            return false;
+        }
+
+        // Bytes no edge tells apart share one column
+        std::vector<uint8_t> boundary(257, 0);
+        for (const auto& state_edges : nfa.edges) {
+            for (const auto& e : state_edges) {
+                boundary[e.lo] = 1;
+                boundary[(size_t)e.hi + 1] = 1;
+            }
+        }
+        std::vector<uint8_t> class_of(256);
+        std::vector<uint8_t> representative;
+        for (size_t b = 0; b < 256; b++) {
+            if (b == 0 || boundary[b]) {
+                representative.push_back((uint8_t)b);
+            }
+            class_of[b] = (uint8_t)(representative.size() - 1);
+        }
+        const size_t n_classes = representative.size();
+
+        // Subset construction
+        std::vector<uint32_t> mark(nfa.edges.size(), 0);
+        uint32_t generation = 0;
+        std::vector<int32_t> stack;
+        auto closure = [&](std::vector<int32_t>& set) {
+            generation++;
+            stack.assign(set.begin(), set.end());
+            set.clear();
+            while (!stack.empty()) {
+                const int32_t s = stack.back();
+                stack.pop_back();
+                if (mark[(size_t)s] == generation) {
+                    continue;
+                }
+                mark[(size_t)s] = generation;
+                set.push_back(s);
+                for (int32_t t : nfa.epsilon[(size_t)s]) {
+                    stack.push_back(t);
+                }
+            }
+            std::sort(set.begin(), set.end());
+        };
+
+        const size_t construction_cap = std::max<size_t>(max_states * 8, 4096);
+        std::vector<std::vector<int32_t>> sets;
+        std::map<std::vector<int32_t>, int32_t> ids;
+        std::vector<int32_t> table;  // [state * n_classes + class]
+        std::vector<uint8_t> accepts;
+
+        std::vector<int32_t> set = { start };
+        closure(set);
+        ids.emplace(set, 0);
+        sets.push_back(std::move(set));
+        for (size_t i = 0; i < sets.size(); i++) {
+            accepts.push_back(std::binary_search(sets[i].begin(), sets[i].end(), final_state));
+            for (size_t k = 0; k < n_classes; k++) {
+                const uint8_t b = representative[k];
+                std::vector<int32_t> target;
+                for (int32_t s : sets[i]) {
+                    for (const auto& e : nfa.edges[(size_t)s]) {
+                        if (e.lo <= b && b <= e.hi) {
+                            target.push_back(e.target);
+                        }
+                    }
+                }
+                if (target.empty()) {
+                    table.push_back(DEAD);
+                    continue;
+                }
+                closure(target);
+                auto it = ids.find(target);
+                if (it == ids.end()) {
+                    if (sets.size() >= construction_cap) {
+                        error = "pattern needs too many states";
+                        return false;
+                    }
+                    it = ids.emplace(target, (int32_t)sets.size()).first;
+                    sets.push_back(target);
+                }
+                table.push_back(it->second);
+            }
+        }
+        const size_t n = sets.size();
+        sets.clear();
+        ids.clear();
+
+        // Keep the states that can still reach an accepting one
+        std::vector<std::vector<int32_t>> reverse(n);
+        for (size_t s = 0; s < n; s++) {
+            for (size_t k = 0; k < n_classes; k++) {
+                const int32_t t = table[s * n_classes + k];
+                if (t != DEAD) {
+                    reverse[(size_t)t].push_back((int32_t)s);
+                }
+            }
+        }
+        std::vector<uint8_t> live(n, 0);
+        for (size_t s = 0; s < n; s++) {
+            if (accepts[s]) {
+                live[s] = 1;
+                stack.push_back((int32_t)s);
+            }
+        }
+        while (!stack.empty()) {
+            const int32_t s = stack.back();
+            stack.pop_back();
+            for (int32_t r : reverse[(size_t)s]) {
+                if (!live[(size_t)r]) {
+                    live[(size_t)r] = 1;
+                    stack.push_back(r);
+                }
+            }
+        }
+        reverse.clear();
+        if (!live[0]) {
+            error = "pattern matches nothing";
+            return false;
+        }
+        for (int32_t& t : table) {
+            if (t != DEAD && !live[(size_t)t]) {
+                t = DEAD;
+            }
+        }
+
+        // Moore minimization: split blocks by where their columns lead
+        std::vector<int32_t> block(n, DEAD);
+        for (size_t s = 0; s < n; s++) {
+            if (live[s]) {
+                block[s] = accepts[s] ? 1 : 0;
+            }
+        }
+        size_t n_blocks = 0;
+        for (;;) {
+            std::map<std::vector<int32_t>, int32_t> signatures;
+            std::vector<int32_t> next_block(n, DEAD);
+            std::vector<int32_t> signature(n_classes + 1);
+            for (size_t s = 0; s < n; s++) {
+                if (!live[s]) {
+                    continue;
+                }
+                signature[0] = block[s];
+                for (size_t k = 0; k < n_classes; k++) {
+                    const int32_t t = table[s * n_classes + k];
+                    signature[k + 1] = t == DEAD ? DEAD : block[(size_t)t];
+                }
+                next_block[s] = signatures.emplace(signature, (int32_t)signatures.size()).first->second;
+            }
+            block.swap(next_block);
+            if (signatures.size() == n_blocks) {
+                break;
+            }
+            n_blocks = signatures.size();
+        }
+
+        // Number the blocks breadth-first from the start state's
+        std::vector<int32_t> member(n_blocks, DEAD);
+        for (size_t s = 0; s < n; s++) {
+            if (live[s] && member[(size_t)block[s]] == DEAD) {
+                member[(size_t)block[s]] = (int32_t)s;
+            }
+        }
+        std::vector<int32_t> number(n_blocks, DEAD);
+        std::vector<int32_t> order = { block[0] };
+        number[(size_t)block[0]] = 0;
+        for (size_t i = 0; i < order.size(); i++) {
+            const size_t s = (size_t)member[(size_t)order[i]];
+            for (size_t k = 0; k < n_classes; k++) {
+                const int32_t t = table[s * n_classes + k];
+                if (t != DEAD && number[(size_t)block[(size_t)t]] == DEAD) {
+                    number[(size_t)block[(size_t)t]] = (int32_t)order.size();
+                    order.push_back(block[(size_t)t]);
+                }
+            }
+        }
+        if (order.size() > max_states) {
+            error = "pattern needs too many states";
+            return false;
+        }
+
+        transitions.assign(order.size() * 256, DEAD);
+        accepting_.assign(order.size(), 0);
+        for (size_t i = 0; i < order.size(); i++) {
+            const size_t s = (size_t)member[(size_t)order[i]];
+            accepting_[i] = accepts[s];
+            for (size_t b = 0; b < 256; b++) {
+                const int32_t t = table[s * n_classes + class_of[b]];
+                transitions[i * 256 + b] = t == DEAD ? DEAD : number[(size_t)block[(size_t)t]];
+            }
+        }
+    } catch (const std::bad_alloc&) {
+        transitions.clear();
+        accepting_.clear();
+        error = "out of memory";
+        return false;
+    }
+    return true;
+}
+
+bool json_string_regex(const char* pattern, size_t len, std::string& out, std::string& error) {
+    out.clear();
+    error.clear();
+    try {
+        regex_node root;
+        regex_parser parser(pattern, len, error);
+        if (!parser.parse(root)) {
+            return false;
+        }
+        json_string_printer(out).print(root);
+    } catch (const std::bad_alloc&) {
+        error = "out of memory";
+        return false;
+    }
+    return true;
+}
+
+} // namespace ltok
@@ -0,0 +1,74 @@
+#ifndef LLAMA_TOKENIZER_REGEX_DFA_H
+#define LLAMA_TOKENIZER_REGEX_DFA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace ltok {
+
+/**
+ * Minimal DFA over bytes for a regular expression, matched against the
+ * whole input
+ *
+ * Syntax: literals (UTF-8), '.', classes with ranges and negation,
+ * escapes \d \D \w \W \s \S \n \r \t \f \v \0 \xHH \uHHHH \u{H...} and
+ * escaped punctuation, groups (...) and (?:...), alternation, and the
+ * quantifiers * + ? {n} {n,} {n,m} (a lazy '?' after one is accepted;
+ * the language is the same). '^' at the start and '$' at the end are
+ * accepted and ignored. Classes and '.' match whole UTF-8 characters;
+ * '.' matches any but the line terminators \n \r U+2028 U+2029, as in
+ * ECMA-262.
+ *
+ * States from which no accepting state can be reached are dropped, so a
+ * walk that returns DEAD can never match, and any state still alive can.
+ * State 0 is the start state. Immutable after compile().
+ */
+class byte_dfa {
+public:
+    static constexpr int32_t DEAD = -1;
+
+    /**
+     * Compile pattern; false with error set if it is malformed, uses
+     * something unsupported, matches nothing or needs more than
+     * max_states states
+     */
+    bool compile(const char* pattern, size_t len, size_t max_states, std::string& error);
+
+    size_t n_states() const { return accepting_.size(); }
+
+    int32_t next(int32_t state, unsigned char c) const {
+        return transitions[(size_t)state * 256 + c];
+    }
+
+    bool accepting(int32_t state) const { return accepting_[(size_t)state] != 0; }
+
+    // State after walking bytes from state, or DEAD
+    int32_t walk(int32_t state, const char* bytes, size_t len) const {
+        for (size_t i = 0; i < len && state != DEAD; i++) {
+            state = next(state, (unsigned char)bytes[i]);
+        }
+        return state;
+    }
+
+private:
+    std::vector<int32_t> transitions;  // [state * 256 + byte]
+    std::vector<uint8_t> accepting_;
+};
+
+/**
+ * Rewrite pattern, which matches decoded JSON string content, to match
+ * that content as it appears between the quotes of a JSON string
+ *
+ * '"', '\' and U+0000-U+001F are removed from every literal, class and
+ * '.', and match only through their JSON escapes (\" \\ \n \u001f ...).
+ * Other characters match only as themselves. False with error set if
+ * pattern is malformed.
+ */
+bool json_string_regex(const char* pattern, size_t len, std::string& out, std::string& error);
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_REGEX_DFA_H
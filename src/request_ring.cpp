@@ -0,0 +1,233 @@
+#include "request_ring.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "ring indices are exposed to callers as plain uint32_t");
+
+namespace ltok {
+
+// Round up to a power of two so ring positions can be masked
+static uint32_t ring_size(uint32_t entries) {
+    uint32_t size = 1;
+    while (size < entries && size < (1u << 30)) {
+        size <<= 1;
+    }
+    return size;
+}
+
+request_ring::request_ring(const llama_tokenizer_t* tokenizer, thread_pool* pool, uint32_t entries)
+    : tokenizer(tokenizer),
+      pool(pool),
+      sq_entries(ring_size(entries)),
+      cq_entries(2 * ring_size(entries)) {
+    sqes.resize(sq_entries);
+    cqes.resize(cq_entries);
+
+#ifdef __linux__
+    event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+
+    try {
+        dispatcher = std::thread(&request_ring::dispatcher_main, this);
+    } catch (const std::system_error&) {
+        // ok() reports the failure
+    }
+}
+
+request_ring::~request_ring() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    if (dispatcher.joinable()) {
+        dispatcher.join();
+    }
+    if (event_fd >= 0) {
+        close(event_fd);
+    }
+}
+
+void request_ring::get_info(llama_tokenizer_ring_info& info) {
+    info.sqes = sqes.data();
+    info.sq_head = reinterpret_cast<uint32_t*>(&sq_head);
+    info.sq_tail = reinterpret_cast<uint32_t*>(&sq_tail);
+    info.sq_mask = sq_entries - 1;
+    info.cqes = cqes.data();
+    info.cq_head = reinterpret_cast<uint32_t*>(&cq_head);
+    info.cq_tail = reinterpret_cast<uint32_t*>(&cq_tail);
+    info.cq_mask = cq_entries - 1;
+}
+
+void request_ring::notify() {
+    { std::lock_guard<std::mutex> lock(mutex); }
+    work_cv.notify_one();
+}
+
+size_t request_ring::submit(const llama_tokenizer_sqe* entries, size_t n) {
+    size_t queued;
+    {
+        std::lock_guard<std::mutex> lock(submit_mutex);
+        const uint32_t tail = sq_tail.load(std::memory_order_relaxed);
+        const uint32_t head = sq_head.load(std::memory_order_acquire);
+        queued = std::min<size_t>(n, sq_entries - (tail - head));
+        for (size_t i = 0; i < queued; i++) {
+            sqes[(tail + i) & (sq_entries - 1)] = entries[i];
+        }
+        sq_tail.store(tail + (uint32_t)queued, std::memory_order_release);
+    }
+    if (queued > 0) {
+        notify();
+    }
+    return queued;
+}
+
+size_t request_ring::reap(llama_tokenizer_cqe* out, size_t max) {
+    size_t n;
+    {
+        std::lock_guard<std::mutex> lock(reap_mutex);
+        const uint32_t head = cq_head.load(std::memory_order_relaxed);
+        const uint32_t tail = cq_tail.load(std::memory_order_acquire);
+        n = std::min<size_t>(max, tail - head);
+        for (size_t i = 0; i < n; i++) {
+            out[i] = cqes[(head + i) & (cq_entries - 1)];
+        }
+        cq_head.store(head + (uint32_t)n, std::memory_order_release);
+    }
+    // Freed completion slots may unblock the dispatcher
+    if (n > 0) {
+        notify();
+    }
+    return n;
+}
+
+size_t request_ring::wait(size_t min_complete, int32_t timeout_ms) {
+    auto ready = [&] {
+        return (size_t)(cq_tail.load(std::memory_order_acquire) - cq_head.load(std::memory_order_acquire));
+    };
+    min_complete = std::min<size_t>(min_complete, cq_entries);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (timeout_ms < 0) {
+        complete_cv.wait(lock, [&] { return ready() >= min_complete; });
+    } else {
+        complete_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                             [&] { return ready() >= min_complete; });
+    }
+    return ready();
+}
+
+bool request_ring::has_work() const {
+    const uint32_t sq_pending = sq_tail.load(std::memory_order_acquire) - sq_head.load(std::memory_order_relaxed);
+    const uint32_t cq_used = cq_tail.load(std::memory_order_relaxed) - cq_head.load(std::memory_order_acquire);
+    return sq_pending > 0 && cq_used < cq_entries;
+}
+
+int32_t request_ring::process(const llama_tokenizer_sqe& sqe) const {
+    switch (sqe.op) {
+        case LLAMA_TOKENIZER_OP_TOKENIZE:
+            return llama_tokenizer_tokenize(
+                tokenizer,
+                (const char*)sqe.input,
+                sqe.input_len,
+                (llama_token*)sqe.output,
+                sqe.output ? sqe.output_cap : 0,
+                (sqe.flags & LLAMA_TOKENIZER_RING_ADD_SPECIAL) != 0,
+                (sqe.flags & LLAMA_TOKENIZER_RING_PARSE_SPECIAL) != 0
+            );
+        case LLAMA_TOKENIZER_OP_COUNT:
+            return llama_tokenizer_tokenize(
+                tokenizer,
+                (const char*)sqe.input,
+                sqe.input_len,
+                NULL,
+                0,
+                (sqe.flags & LLAMA_TOKENIZER_RING_ADD_SPECIAL) != 0,
+                (sqe.flags & LLAMA_TOKENIZER_RING_PARSE_SPECIAL) != 0
+            );
+        case LLAMA_TOKENIZER_OP_DETOKENIZE:
+            return llama_tokenizer_detokenize(
+                tokenizer,
+                (const llama_token*)sqe.input,
+                sqe.input_len,
+                (char*)sqe.output,
+                sqe.output ? sqe.output_cap : 0,
+                (sqe.flags & LLAMA_TOKENIZER_RING_REMOVE_SPECIAL) != 0,
+                (sqe.flags & LLAMA_TOKENIZER_RING_UNPARSE_SPECIAL) != 0
+            );
+        default:
+            return -1;
+    }
+}
+
+void request_ring::dispatcher_main() {
+    std::vector<llama_tokenizer_sqe> batch;
+    std::vector<int32_t> results;
+    batch.reserve(sq_entries);
+    results.reserve(sq_entries);
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_cv.wait(lock, [&] { return stopping || has_work(); });
+            if (stopping) {
+                return;
+            }
+        }
+
+        // Copy the batch out so its submission slots can be reused at once
+        const uint32_t head = sq_head.load(std::memory_order_relaxed);
+        const uint32_t tail = sq_tail.load(std::memory_order_acquire);
+        const uint32_t cq_free = cq_entries - (cq_tail.load(std::memory_order_relaxed) -
+                                               cq_head.load(std::memory_order_acquire));
+        const uint32_t n = std::min(tail - head, cq_free);
+        batch.clear();
+        for (uint32_t i = 0; i < n; i++) {
+            batch.push_back(sqes[(head + i) & (sq_entries - 1)]);
+        }
+        sq_head.store(head + n, std::memory_order_release);
+
+        results.assign(n, 0);
+        auto process_range = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                results[i] = process(batch[i]);
+            }
+        };
+        if (pool && n > 1) {
+            pool->parallel_for(n, std::max<size_t>(1, n / (8 * (pool->size() + 1))), process_range);
+        } else {
+            process_range(0, n);
+        }
+
+        // Post in submission order
+        const uint32_t cq_pos = cq_tail.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < n; i++) {
+            llama_tokenizer_cqe& cqe = cqes[(cq_pos + i) & (cq_entries - 1)];
+            cqe.user_data = batch[i].user_data;
+            cqe.result = results[i];
+            cqe.flags = 0;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cq_tail.store(cq_pos + n, std::memory_order_release);
+        }
+        complete_cv.notify_all();
+
+        if (event_fd >= 0) {
+            const uint64_t count = n;
+            ssize_t written = write(event_fd, &count, sizeof(count));
+            (void)written;  // only fails if the counter would overflow, and it is still readable then
+        }
+    }
+}
+
+} // namespace ltok
@@ -0,0 +1,79 @@
+#ifndef LLAMA_TOKENIZER_REQUEST_RING_H
+#define LLAMA_TOKENIZER_REQUEST_RING_H
+
+#include "llama_tokenizer.h"
+#include "threadpool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ltok {
+
+/**
+ * Submission/completion queue pair served by a dispatcher thread
+ *
+ * Same protocol as io_uring: the producer fills sqes[tail & mask] and
+ * then publishes sq_tail with release ordering; the dispatcher consumes
+ * from sq_head. Completions go to cqes[cq_tail & mask] and are consumed
+ * from cq_head. Heads and tails are free-running 32-bit counters.
+ *
+ * The dispatcher takes SQEs in batches (only as many as the completion
+ * ring has room for), runs each batch on the thread pool and posts the
+ * completions in submission order, signalling the eventfd once per batch.
+ */
+class request_ring {
+public:
+    request_ring(const llama_tokenizer_t* tokenizer, thread_pool* pool, uint32_t entries);
+    ~request_ring();
+
+    request_ring(const request_ring&) = delete;
+    request_ring& operator=(const request_ring&) = delete;
+
+    bool ok() const { return dispatcher.joinable(); }
+
+    size_t submit(const llama_tokenizer_sqe* entries, size_t n);
+    size_t reap(llama_tokenizer_cqe* out, size_t max);
+    size_t wait(size_t min_complete, int32_t timeout_ms);
+    void notify();
+
+    int eventfd() const { return event_fd; }
+    void get_info(llama_tokenizer_ring_info& info);
+
+private:
+    void dispatcher_main();
+    bool has_work() const;
+    int32_t process(const llama_tokenizer_sqe& sqe) const;
+
+    const llama_tokenizer_t* tokenizer;
+    thread_pool* pool;
+
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    std::vector<llama_tokenizer_sqe> sqes;
+    std::vector<llama_tokenizer_cqe> cqes;
+    std::atomic<uint32_t> sq_head{0};
+    std::atomic<uint32_t> sq_tail{0};
+    std::atomic<uint32_t> cq_head{0};
+    std::atomic<uint32_t> cq_tail{0};
+
+    std::mutex submit_mutex;  // serializes submit() callers
+    std::mutex reap_mutex;    // serializes reap() callers
+
+    std::mutex mutex;
+    std::condition_variable work_cv;      // dispatcher waits for SQEs or CQ room
+    std::condition_variable complete_cv;  // wait() waits for CQEs
+    bool stopping = false;
+
+    int event_fd = -1;
+    std::thread dispatcher;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_REQUEST_RING_H
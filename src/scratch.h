@@ -0,0 +1,29 @@
+#ifndef LLAMA_TOKENIZER_SCRATCH_H
+#define LLAMA_TOKENIZER_SCRATCH_H
+
+#include <stddef.h>
+
+namespace ltok {
+
+// Bytes a per-thread scratch buffer may keep between calls
+static constexpr size_t scratch_retain_limit = (size_t)1 << 20;
+
+/**
+ * Free a per-thread scratch buffer that an unusually large input grew
+ * past scratch_retain_limit
+ *
+ * The tokenize path keeps its temporaries in thread_local containers that
+ * are cleared, not freed, between calls, so once a thread is warm its
+ * calls do not touch the heap. Trimming after use keeps one outlier from
+ * pinning its memory on every thread that saw it.
+ */
+template <typename Container>
+inline void scratch_trim(Container& buffer) {
+    if (buffer.capacity() * sizeof(typename Container::value_type) > scratch_retain_limit) {
+        Container().swap(buffer);
+    }
+}
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_SCRATCH_H
@@ -0,0 +1,271 @@
+#include "sequence_packer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+#include <system_error>
+#include <utility>
+
+namespace ltok {
+
+namespace {
+
+// Bytes per write; the queue holds at most max_queued_writes of them
+static constexpr size_t chunk_bytes = (size_t)8 << 20;
+static constexpr size_t max_queued_writes = 4;
+
+void store_tokens(uint8_t* out, const llama_token* tokens, size_t n, size_t token_bytes) {
+    if (token_bytes == 4) {
+        memcpy(out, tokens, n * sizeof(llama_token));
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        const uint16_t narrow = (uint16_t)tokens[i];
+        memcpy(out + i * 2, &narrow, 2);
+    }
+}
+
+} // namespace
+
+sequence_packer::sequence_packer(const packer_options& options)
+    : options(options),
+      chunk_sequences(std::max<size_t>(1, std::min(options.shard_sequences,
+                                                   chunk_bytes / (options.seq_len * options.token_bytes)))),
+      chunk_size(chunk_sequences * options.seq_len * options.token_bytes) {
+    chunk.resize(chunk_size);
+    free_buffers.reserve(max_queued_writes);    // the writer never allocates
+    try {
+        writer = std::thread(&sequence_packer::writer_main, this);
+    } catch (const std::system_error&) {
+    }
+}
+
+sequence_packer::~sequence_packer() {
+    if (writer.joinable()) {
+        finish();
+    }
+}
+
+bool sequence_packer::append(const llama_tokenizer_csr_view& batch) {
+    if (finished || failed.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    // Out of memory part way through a document leaves the shard without
+    // it, so the packer stops as it does after a failed write
+    try {
+        for (int64_t i = 0; i < batch.n_texts; i++, doc_id++) {
+            stats.documents++;
+            if (batch.validity && !((batch.validity[i / 8] >> (i % 8)) & 1)) {
+                stats.failed++;
+                continue;
+            }
+            doc_offset = 0;
+            segment_open = false;
+            if (options.bos >= 0) {
+                emit(&options.bos, 1);
+            }
+            emit(batch.tokens + batch.offsets[i], (size_t)(batch.offsets[i + 1] - batch.offsets[i]));
+            if (options.separator >= 0) {
+                emit(&options.separator, 1);
+            }
+        }
+    } catch (const std::bad_alloc&) {
+        failed.store(true, std::memory_order_relaxed);
+    }
+    return !failed.load(std::memory_order_relaxed);
+}
+
+void sequence_packer::emit(const llama_token* tokens, size_t n) {
+    while (n > 0) {
+        if (!segment_open) {
+            const llama_tokenizer_pack_segment segment = {doc_id, doc_offset, (int32_t)seq_fill, 0};
+            segments.push_back(segment);
+            segment_open = true;
+        }
+        const size_t k = std::min(n, options.seq_len - seq_fill);
+        store_tokens(chunk.data() + (chunk_filled * options.seq_len + seq_fill) * options.token_bytes,
+                     tokens, k, options.token_bytes);
+        seq_fill += k;
+        segments.back().length += (int32_t)k;
+        doc_offset += (int64_t)k;
+        stats.tokens += k;
+        tokens += k;
+        n -= k;
+        if (seq_fill == options.seq_len) {
+            end_sequence();
+        }
+    }
+}
+
+void sequence_packer::end_sequence() {
+    sequence_segments.push_back(segments.size());
+    segment_open = false;
+    seq_fill = 0;
+    chunk_filled++;
+    shard_filled++;
+    stats.sequences++;
+    if (shard_filled == options.shard_sequences) {
+        end_shard();
+    } else if (chunk_filled == chunk_sequences) {
+        flush_chunk();
+    }
+}
+
+void sequence_packer::flush_chunk() {
+    if (chunk_filled == 0) {
+        return;
+    }
+    // Take a buffer the writer is done with, or a new one, before handing
+    // the chunk over, so running out of memory leaves the chunk in place
+    std::vector<uint8_t> next;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (!free_buffers.empty()) {
+            next.swap(free_buffers.back());
+            free_buffers.pop_back();
+        }
+    }
+    next.resize(chunk_size);
+    write_job job;
+    job.path = shard_path("bin");
+    job.append = shard_started;
+
+    job.bytes.swap(chunk);
+    job.bytes.resize(chunk_filled * options.seq_len * options.token_bytes);
+    chunk.swap(next);
+    chunk_filled = 0;
+    if (!shard_started) {
+        shard_started = true;
+        stats.shards++;
+    }
+    enqueue(std::move(job));
+}
+
+void sequence_packer::end_shard() {
+    flush_chunk();
+
+    llama_tokenizer_pack_index_header header;
+    memcpy(header.magic, LLAMA_TOKENIZER_PACK_MAGIC, sizeof(header.magic));
+    header.version = 1;
+    header.token_bytes = (uint32_t)options.token_bytes;
+    header.seq_len = (uint32_t)options.seq_len;
+    header.reserved = 0;
+    header.n_sequences = shard_filled;
+    header.n_segments = segments.size();
+
+    const size_t offsets_size = sequence_segments.size() * sizeof(uint64_t);
+    const size_t segments_size = segments.size() * sizeof(llama_tokenizer_pack_segment);
+    write_job job;
+    job.path = shard_path("idx");
+    job.append = false;
+    job.bytes.resize(sizeof(header) + offsets_size + segments_size);
+    memcpy(job.bytes.data(), &header, sizeof(header));
+    memcpy(job.bytes.data() + sizeof(header), sequence_segments.data(), offsets_size);
+    memcpy(job.bytes.data() + sizeof(header) + offsets_size, segments.data(), segments_size);
+    enqueue(std::move(job));
+
+    shard_index++;
+    shard_filled = 0;
+    shard_started = false;
+    sequence_segments.assign(1, 0);
+    segments.clear();
+}
+
+bool sequence_packer::finish() {
+    if (finished) {
+        return !failed.load(std::memory_order_relaxed);
+    }
+    finished = true;
+
+    // After a failure the writer is still stopped, so the destructor never
+    // leaves a thread running
+    if (!failed.load(std::memory_order_relaxed)) {
+        try {
+            if (seq_fill > 0) {
+                if (options.drop_partial) {
+                    segments.resize(sequence_segments.back());
+                    stats.tokens -= seq_fill;
+                    seq_fill = 0;
+                } else {
+                    const size_t pad = options.seq_len - seq_fill;
+                    uint8_t* out = chunk.data() + (chunk_filled * options.seq_len + seq_fill) * options.token_bytes;
+                    for (size_t i = 0; i < pad; i++) {
+                        store_tokens(out + i * options.token_bytes, &options.pad, 1, options.token_bytes);
+                    }
+                    stats.padding += pad;
+                    end_sequence();
+                }
+            }
+            if (shard_filled > 0) {
+                end_shard();
+            }
+        } catch (const std::bad_alloc&) {
+            failed.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_cv.notify_all();
+    writer.join();
+    return !failed.load(std::memory_order_relaxed);
+}
+
+void sequence_packer::get_stats(llama_tokenizer_packer_stats& out) const {
+    out = stats;
+}
+
+void sequence_packer::enqueue(write_job job) {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    queue_cv.wait(lock, [&] { return queue.size() < max_queued_writes; });
+    queue.push_back(std::move(job));
+    lock.unlock();
+    queue_cv.notify_all();
+}
+
+void sequence_packer::writer_main() {
+    for (;;) {
+        write_job job;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [&] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        queue_cv.notify_all();
+
+        // After a failure later writes are skipped: the shards are unusable
+        if (!failed.load(std::memory_order_relaxed)) {
+            FILE* f = fopen(job.path.c_str(), job.append ? "ab" : "wb");
+            bool ok = f && fwrite(job.bytes.data(), 1, job.bytes.size(), f) == job.bytes.size();
+            if (f && fclose(f) != 0) {
+                ok = false;
+            }
+            if (!ok) {
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        if (job.bytes.capacity() >= chunk_size) {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (free_buffers.size() < max_queued_writes) {
+                free_buffers.push_back(std::move(job.bytes));
+            }
+        }
+    }
+}
+
+std::string sequence_packer::shard_path(const char* extension) const {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "-%05zu.%s", shard_index, extension);
+    return options.prefix + suffix;
+}
+
+} // namespace ltok
@@ -0,0 +1,112 @@
+#ifndef LLAMA_TOKENIZER_SEQUENCE_PACKER_H
+#define LLAMA_TOKENIZER_SEQUENCE_PACKER_H
+
+#include "llama_tokenizer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ltok {
+
+struct packer_options {
+    size_t seq_len = 0;
+    size_t shard_sequences = 0;
+    size_t token_bytes = 4;          // 2 or 4
+    llama_token bos = -1;            // before each document; -1 for none
+    llama_token separator = -1;      // after each document; -1 for none
+    llama_token pad = 0;             // fills the last sequence
+    bool drop_partial = false;       // drop the last sequence instead of padding it
+    std::string prefix;
+};
+
+/**
+ * Packs tokenized documents back to back into fixed-length sequences
+ * and writes them as shards
+ *
+ * Documents run across sequence boundaries; every piece of a document in
+ * a sequence is recorded as a segment. Tokens are narrowed to token_bytes
+ * while packing into a chunk of whole sequences; full chunks go to a
+ * writer thread through a short queue, so disk writes overlap the
+ * caller's next tokenize batch. The queue blocks the producer when the
+ * disk falls behind. A shard's index is written when the shard is full.
+ *
+ * Not thread safe: one producer per packer.
+ */
+class sequence_packer {
+public:
+    explicit sequence_packer(const packer_options& options);
+    ~sequence_packer();
+
+    sequence_packer(const sequence_packer&) = delete;
+    sequence_packer& operator=(const sequence_packer&) = delete;
+
+    bool ok() const { return writer.joinable(); }
+
+    // Pack one batch; documents the view marks null are counted as failed
+    // and skipped. False once a write or an allocation has failed, or
+    // after finish()
+    bool append(const llama_tokenizer_csr_view& batch);
+
+    // Pad or drop the last sequence, write the last index and wait for
+    // every write; false if any write or allocation failed
+    bool finish();
+
+    void get_stats(llama_tokenizer_packer_stats& out) const;
+
+private:
+    struct write_job {
+        std::string path;
+        std::vector<uint8_t> bytes;
+        bool append;
+    };
+
+    void emit(const llama_token* tokens, size_t n);
+    void end_sequence();
+    void flush_chunk();
+    void end_shard();
+    void enqueue(write_job job);
+    void writer_main();
+    std::string shard_path(const char* extension) const;
+
+    const packer_options options;
+    const size_t chunk_sequences;    // sequences per write
+    const size_t chunk_size;         // bytes per write
+
+    // Current shard
+    size_t shard_index = 0;
+    std::vector<uint8_t> chunk;      // whole sequences, token_bytes each
+    size_t chunk_filled = 0;         // sequences in chunk
+    size_t shard_filled = 0;         // sequences in the shard, including chunk
+    bool shard_started = false;      // bin file created
+    std::vector<uint64_t> sequence_segments{0};
+    std::vector<llama_tokenizer_pack_segment> segments;
+
+    // Current sequence and document
+    size_t seq_fill = 0;
+    int64_t doc_id = 0;
+    int64_t doc_offset = 0;
+    bool segment_open = false;
+    bool finished = false;
+
+    llama_tokenizer_packer_stats stats = {};
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<write_job> queue;
+    std::vector<std::vector<uint8_t>> free_buffers;  // written chunks, for reuse
+    bool stopping = false;
+    std::atomic<bool> failed{false};    // a write or an allocation failed; sticky
+    std::thread writer;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_SEQUENCE_PACKER_H
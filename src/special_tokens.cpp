@@ -0,0 +1,187 @@
+#include "special_tokens.h"
+#include "scratch.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+namespace ltok {
+
+// Same set as llama.cpp's isspace() in the C locale
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+void special_token_scanner::build(const llama_vocab* vocab) {
+    const int32_t n_tokens = llama_vocab_n_tokens(vocab);
+    const uint32_t special_mask = LLAMA_TOKEN_ATTR_CONTROL |
+                                  LLAMA_TOKEN_ATTR_USER_DEFINED |
+                                  LLAMA_TOKEN_ATTR_UNKNOWN;
+
+    struct candidate {
+        llama_token id;
+        size_t length;
+    };
+    std::vector<candidate> candidates;
+    for (llama_token id = 0; id < n_tokens; id++) {
+        if (llama_vocab_get_attr(vocab, id) & special_mask) {
+            const char* text = llama_vocab_get_text(vocab, id);
+            candidates.push_back({ id, text ? strlen(text) : 0 });
+        }
+    }
+
+    // Longest first, as llama.cpp applies special tokens. Its cache holds
+    // the same ids in the same order and is ordered with std::sort, not a
+    // stable sort, so doing the same breaks ties between equal-length
+    // tokens the way it does
+    std::sort(candidates.begin(), candidates.end(),
+        [](const candidate& a, const candidate& b) { return a.length > b.length; });
+
+    std::vector<std::string> patterns;
+    patterns.reserve(candidates.size());
+    ids.clear();
+    attrs.clear();
+    for (const candidate& c : candidates) {
+        if (c.length == 0) {
+            continue;
+        }
+        patterns.emplace_back(llama_vocab_get_text(vocab, c.id), c.length);
+        ids.push_back(c.id);
+        attrs.push_back((uint32_t)llama_vocab_get_attr(vocab, c.id));
+    }
+
+    // The automaton reports only the first of several tokens sharing a text;
+    // chain the rest so a filtered-out token can defer to the next one
+    duplicate_next.assign(patterns.size(), UINT32_MAX);
+    std::unordered_map<std::string, uint32_t> last_with_text;
+    for (uint32_t i = 0; i < (uint32_t)patterns.size(); i++) {
+        auto it = last_with_text.find(patterns[i]);
+        if (it != last_with_text.end()) {
+            duplicate_next[it->second] = i;
+            it->second = i;
+        } else {
+            last_with_text.emplace(patterns[i], i);
+        }
+    }
+
+    automaton.build(patterns);
+}
+
+// Whether [start, end) overlaps one of the sorted, disjoint spans
+static bool overlaps(const std::vector<text_span>& spans, size_t start, size_t end) {
+    auto it = std::upper_bound(spans.begin(), spans.end(), start,
+        [](size_t pos, const text_span& span) { return pos < span.offset + span.length; });
+    return it != spans.end() && it->offset < end;
+}
+
+bool special_token_scanner::partition(const char* text, size_t len, bool parse_special,
+                                      std::vector<text_fragment>& out,
+                                      const std::vector<text_span>* plain_spans) const {
+    out.clear();
+    if (automaton.empty() || len == 0) {
+        return false;
+    }
+
+    // Without parse_special only user-defined tokens are matched
+    const uint32_t skip_mask = parse_special ? 0 : (LLAMA_TOKEN_ATTR_CONTROL | LLAMA_TOKEN_ATTR_UNKNOWN);
+
+    // Per-thread scratch, reused across calls
+    thread_local std::vector<uint64_t> matches;
+    thread_local std::vector<uint8_t> claimed;
+    thread_local std::vector<uint64_t> accepted;
+
+    // (pattern, start) packed so sorting yields priority order, then position
+    matches.clear();
+    const uint32_t plain_skip_mask = LLAMA_TOKEN_ATTR_CONTROL | LLAMA_TOKEN_ATTR_UNKNOWN;
+    const bool has_plain = parse_special && plain_spans && !plain_spans->empty();
+    automaton.scan(text, len, [&](uint32_t pattern, size_t start) {
+        const uint32_t mask = has_plain && overlaps(*plain_spans, start, start + automaton.pattern_length(pattern))
+                            ? plain_skip_mask : skip_mask;
+        while (pattern != UINT32_MAX && (attrs[pattern] & mask)) {
+            pattern = duplicate_next[pattern];
+        }
+        if (pattern != UINT32_MAX) {
+            matches.push_back(((uint64_t)pattern << 32) | (uint64_t)start);
+        }
+    });
+    if (matches.empty()) {
+        return false;
+    }
+    std::sort(matches.begin(), matches.end());
+
+    // An occurrence is accepted only if none of its bytes were claimed by a
+    // higher-priority token (or the whitespace it stripped). Unclaimed bytes
+    // between two accepted tokens form exactly one raw fragment.
+    claimed.assign(len, 0);
+    accepted.clear();  // (start, pattern)
+
+    for (uint64_t m : matches) {
+        const uint32_t pattern = (uint32_t)(m >> 32);
+        const size_t start = (size_t)(m & 0xFFFFFFFFu);
+        const size_t end = start + automaton.pattern_length(pattern);
+
+        bool free = true;
+        for (size_t i = start; i < end; i++) {
+            if (claimed[i]) {
+                free = false;
+                break;
+            }
+        }
+        if (!free) {
+            continue;
+        }
+        for (size_t i = start; i < end; i++) {
+            claimed[i] = 1;
+        }
+        if (attrs[pattern] & LLAMA_TOKEN_ATTR_LSTRIP) {
+            for (size_t i = start; i > 0 && !claimed[i - 1] && is_space(text[i - 1]); i--) {
+                claimed[i - 1] = 2;
+            }
+        }
+        if (attrs[pattern] & LLAMA_TOKEN_ATTR_RSTRIP) {
+            for (size_t i = end; i < len && !claimed[i] && is_space(text[i]); i++) {
+                claimed[i] = 2;
+            }
+        }
+        accepted.push_back(((uint64_t)start << 32) | pattern);
+    }
+
+    std::sort(accepted.begin(), accepted.end());
+
+    size_t pos = 0;
+    for (uint64_t a : accepted) {
+        const size_t start = (size_t)(a >> 32);
+        const uint32_t pattern = (uint32_t)(a & 0xFFFFFFFFu);
+
+        size_t raw_begin = pos;
+        while (raw_begin < start && claimed[raw_begin]) {
+            raw_begin++;
+        }
+        size_t raw_end = start;
+        while (raw_end > raw_begin && claimed[raw_end - 1]) {
+            raw_end--;
+        }
+        if (raw_end > raw_begin) {
+            out.push_back({ LLAMA_TOKEN_NULL, raw_begin, raw_end - raw_begin });
+        }
+        out.push_back({ ids[pattern], start, automaton.pattern_length(pattern) });
+        pos = start + automaton.pattern_length(pattern);
+    }
+
+    size_t raw_begin = pos;
+    while (raw_begin < len && claimed[raw_begin]) {
+        raw_begin++;
+    }
+    if (raw_begin < len) {
+        out.push_back({ LLAMA_TOKEN_NULL, raw_begin, len - raw_begin });
+    }
+
+    scratch_trim(matches);
+    scratch_trim(claimed);
+    scratch_trim(accepted);
+    return true;
+}
+
+} // namespace ltok
@@ -0,0 +1,66 @@
+#ifndef LLAMA_TOKENIZER_SPECIAL_TOKENS_H
+#define LLAMA_TOKENIZER_SPECIAL_TOKENS_H
+
+#include "aho_corasick.h"
+#include "llama.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace ltok {
+
+/**
+ * A piece of partitioned input: either raw text or a special token
+ */
+struct text_fragment {
+    llama_token token;  // LLAMA_TOKEN_NULL for raw text
+    size_t offset;
+    size_t length;
+};
+
+/**
+ * A byte range of text
+ */
+struct text_span {
+    size_t offset;
+    size_t length;
+};
+
+/**
+ * Finds special-token occurrences in a single pass over the text
+ *
+ * Reproduces the partitioning llama.cpp performs with one substring
+ * search per special token: tokens are applied longest first, an
+ * occurrence is taken only if it lies entirely inside text not already
+ * claimed, and LSTRIP/RSTRIP tokens swallow adjacent whitespace.
+ */
+class special_token_scanner {
+public:
+    void build(const llama_vocab* vocab);
+
+    bool empty() const { return automaton.empty(); }
+    size_t size() const { return ids.size(); }
+
+    /**
+     * Split text into fragments. Returns false (and leaves out empty)
+     * when the text contains no special tokens.
+     *
+     * With parse_special, control tokens overlapping one of plain_spans
+     * (sorted, disjoint) are not matched, as if those bytes were
+     * tokenized without parse_special; user-defined tokens still are.
+     */
+    bool partition(const char* text, size_t len, bool parse_special,
+                   std::vector<text_fragment>& out,
+                   const std::vector<text_span>* plain_spans = nullptr) const;
+
+private:
+    aho_corasick automaton;
+    std::vector<llama_token> ids;   // pattern index -> token, longest first
+    std::vector<uint32_t> attrs;    // pattern index -> llama_token_attr
+    std::vector<uint32_t> duplicate_next;  // next pattern with the same text
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_SPECIAL_TOKENS_H
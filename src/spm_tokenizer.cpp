@@ -0,0 +1,193 @@
+#include "spm_tokenizer.h"
+#include "scratch.h"
+#include "trace.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+namespace ltok {
+
+// U+2581 (Lower One Eighth Block), SentencePiece's escaped space
+static const char escaped_space[] = "\xE2\x96\x81";
+
+static inline size_t utf8_len(char c) {
+    static const size_t lookup[] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 4 };
+    return lookup[(uint8_t)c >> 4];
+}
+
+spm_tokenizer::spm_tokenizer(const llama_vocab* vocab, const vocab_metadata& meta)
+    : add_space_prefix(meta.add_space_prefix) {
+    const int32_t n_tokens = llama_vocab_n_tokens(vocab);
+
+    std::vector<std::pair<std::string, int32_t>> entries;
+    entries.reserve(n_tokens);
+    scores.resize(n_tokens);
+    for (llama_token id = 0; id < n_tokens; id++) {
+        const char* text = llama_vocab_get_text(vocab, id);
+        if (text && text[0]) {
+            entries.emplace_back(text, id);
+        }
+        scores[id] = llama_vocab_get_score(vocab, id);
+    }
+    pieces.build(std::move(entries));
+
+    // Byte fallback: <0xXX> pieces, else the raw byte itself
+    static const char* hex = "0123456789ABCDEF";
+    for (int ch = 0; ch < 256; ch++) {
+        const char buf[7] = { '<', '0', 'x', hex[ch >> 4], hex[ch & 15], '>', 0 };
+        llama_token id = pieces.find(buf, 6);
+        if (id == double_array_trie::NO_VALUE) {
+            const char raw = (char)ch;
+            id = pieces.find(&raw, 1);
+        }
+        byte_tokens[ch] = id;
+    }
+}
+
+namespace {
+
+struct spm_symbol {
+    int prev;
+    int next;
+    const char* text;
+    size_t n;
+};
+
+struct spm_bigram {
+    struct comparator {
+        bool operator()(const spm_bigram& l, const spm_bigram& r) const {
+            return (l.score < r.score) || (l.score == r.score && l.left > r.left);
+        }
+    };
+    int left;
+    int right;
+    float score;
+    size_t size;
+};
+
+} // namespace
+
+bool spm_tokenizer::tokenize(const char* text, size_t len, std::vector<llama_token>& out) const {
+    // Per-thread scratch, reused across calls
+    thread_local std::string escaped;
+    thread_local std::vector<spm_symbol> symbols;
+    thread_local std::vector<spm_bigram> work_queue;  // max-heap by comparator
+
+    // Escape whitespace the way llama.cpp does before running the model
+    trace_span pre_span(LLAMA_TOKENIZER_TRACE_PRE_TOKENIZE, len);
+    escaped.clear();
+    escaped.reserve(len + len / 2 + 3);
+    if (add_space_prefix) {
+        escaped.append(escaped_space, 3);
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == ' ') {
+            escaped.append(escaped_space, 3);
+        } else {
+            escaped.push_back(text[i]);
+        }
+    }
+    pre_span.end();
+    if (escaped.empty()) {
+        return true;
+    }
+    trace_span model_span(LLAMA_TOKENIZER_TRACE_MODEL, escaped.size());
+
+    // Split into UTF-8 characters
+    symbols.clear();
+    symbols.reserve(escaped.size());
+    size_t offs = 0;
+    int index = 0;
+    while (offs < escaped.size()) {
+        spm_symbol sym;
+        sym.text = escaped.data() + offs;
+        sym.n = std::min(utf8_len(escaped[offs]), escaped.size() - offs);
+        offs += sym.n;
+        sym.prev = index - 1;
+        sym.next = offs == escaped.size() ? -1 : index + 1;
+        index++;
+        symbols.push_back(sym);
+    }
+
+    // Same heap operations as std::priority_queue, on a reusable vector
+    const spm_bigram::comparator less{};
+    work_queue.clear();
+
+    // Symbols are adjacent in the buffer, so a bigram's text is a single
+    // contiguous range that can be walked in the trie without copying
+    auto try_add_bigram = [&](int left, int right) {
+        if (left == -1 || right == -1) {
+            return;
+        }
+        const size_t size = symbols[left].n + symbols[right].n;
+        const int32_t token = pieces.find(symbols[left].text, size);
+        if (token == double_array_trie::NO_VALUE) {
+            return;
+        }
+        work_queue.push_back({ left, right, scores[token], size });
+        std::push_heap(work_queue.begin(), work_queue.end(), less);
+    };
+
+    for (int i = 1; i < (int)symbols.size(); i++) {
+        try_add_bigram(i - 1, i);
+    }
+
+    // Keep substituting the highest scoring pairs for as long as we can
+    while (!work_queue.empty()) {
+        std::pop_heap(work_queue.begin(), work_queue.end(), less);
+        const spm_bigram bigram = work_queue.back();
+        work_queue.pop_back();
+
+        spm_symbol& left_sym = symbols[bigram.left];
+        spm_symbol& right_sym = symbols[bigram.right];
+
+        // Skip if one of the symbols already got merged
+        if (left_sym.n == 0 || right_sym.n == 0 || left_sym.n + right_sym.n != bigram.size) {
+            continue;
+        }
+
+        left_sym.n += right_sym.n;
+        right_sym.n = 0;
+
+        left_sym.next = right_sym.next;
+        if (right_sym.next >= 0) {
+            symbols[right_sym.next].prev = bigram.left;
+        }
+
+        try_add_bigram(left_sym.prev, bigram.left);
+        try_add_bigram(bigram.left, left_sym.next);
+    }
+
+    // Merged symbols are always pieces; a symbol that is not must be a
+    // single character missing from the vocab and falls back to bytes.
+    // (llama.cpp's rev_merge lookup cannot hit for well-formed UTF-8,
+    // which is all this wrapper ever passes in.)
+    const size_t out_size = out.size();
+    bool ok = true;
+    for (int i = 0; i != -1 && ok; i = symbols[i].next) {
+        const spm_symbol& sym = symbols[i];
+        const int32_t token = pieces.find(sym.text, sym.n);
+        if (token != double_array_trie::NO_VALUE) {
+            out.push_back(token);
+            continue;
+        }
+        for (size_t j = 0; j < sym.n; j++) {
+            const llama_token byte_token = byte_tokens[(uint8_t)sym.text[j]];
+            if (byte_token == double_array_trie::NO_VALUE) {
+                out.resize(out_size);
+                ok = false;
+                break;
+            }
+            out.push_back(byte_token);
+        }
+    }
+
+    scratch_trim(escaped);
+    scratch_trim(symbols);
+    scratch_trim(work_queue);
+    return ok;
+}
+
+} // namespace ltok
@@ -0,0 +1,32 @@
+#ifndef LLAMA_TOKENIZER_SPM_TOKENIZER_H
+#define LLAMA_TOKENIZER_SPM_TOKENIZER_H
+
+#include "double_array_trie.h"
+#include "native_tokenizer.h"
+#include "vocab_metadata.h"
+
+namespace ltok {
+
+/**
+ * SentencePiece BPE (LLAMA_VOCAB_TYPE_SPM)
+ *
+ * Port of llama.cpp's llm_tokenizer_spm: bigram merges by score with byte
+ * fallback. Candidate pieces are looked up by walking a double-array trie
+ * over the input bytes instead of hashing a freshly built string.
+ */
+class spm_tokenizer final : public native_tokenizer {
+public:
+    spm_tokenizer(const llama_vocab* vocab, const vocab_metadata& meta);
+
+    bool tokenize(const char* text, size_t len, std::vector<llama_token>& out) const override;
+
+private:
+    double_array_trie pieces;  // every token text -> id
+    std::vector<float> scores;
+    llama_token byte_tokens[256];
+    bool add_space_prefix;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_SPM_TOKENIZER_H
@@ -0,0 +1,50 @@
+#include "stats.h"
+
+#include <string.h>
+
+namespace ltok {
+
+void tokenizer_stats::snapshot(llama_tokenizer_stats& out) const {
+    memset(&out, 0, sizeof(out));
+    for (const shard_counters& shard : shards) {
+        for (size_t e = 0; e < LLAMA_TOKENIZER_STATS_N_ENTRY_POINTS; e++) {
+            const entry_counters& c = shard.entries[e];
+            llama_tokenizer_entry_stats& o = out.entries[e];
+            o.calls += c.calls.load(std::memory_order_relaxed);
+            o.count_only_calls += c.count_only_calls.load(std::memory_order_relaxed);
+            o.fill_calls += c.fill_calls.load(std::memory_order_relaxed);
+            o.buffer_too_small += c.buffer_too_small.load(std::memory_order_relaxed);
+            o.input += c.input.load(std::memory_order_relaxed);
+            o.output += c.output.load(std::memory_order_relaxed);
+            o.total_ns += c.total_ns.load(std::memory_order_relaxed);
+            for (size_t b = 0; b < stats_buckets; b++) {
+                o.latency_histogram[b] += c.histogram[b].load(std::memory_order_relaxed);
+            }
+        }
+        out.utf8_sanitized += shard.utf8_sanitized.load(std::memory_order_relaxed);
+        out.special_partitioned += shard.special_partitioned.load(std::memory_order_relaxed);
+        out.native_fallbacks += shard.native_fallbacks.load(std::memory_order_relaxed);
+    }
+}
+
+void tokenizer_stats::reset() {
+    for (shard_counters& shard : shards) {
+        for (entry_counters& c : shard.entries) {
+            c.calls.store(0, std::memory_order_relaxed);
+            c.count_only_calls.store(0, std::memory_order_relaxed);
+            c.fill_calls.store(0, std::memory_order_relaxed);
+            c.buffer_too_small.store(0, std::memory_order_relaxed);
+            c.input.store(0, std::memory_order_relaxed);
+            c.output.store(0, std::memory_order_relaxed);
+            c.total_ns.store(0, std::memory_order_relaxed);
+            for (std::atomic<uint64_t>& bucket : c.histogram) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+        shard.utf8_sanitized.store(0, std::memory_order_relaxed);
+        shard.special_partitioned.store(0, std::memory_order_relaxed);
+        shard.native_fallbacks.store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace ltok
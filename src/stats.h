@@ -0,0 +1,137 @@
+#ifndef LLAMA_TOKENIZER_STATS_H
+#define LLAMA_TOKENIZER_STATS_H
+
+#include "llama_tokenizer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+
+// Set to 0 by -DLLAMA_TOKENIZER_STATS=OFF
+#ifndef LLAMA_TOKENIZER_STATS
+#define LLAMA_TOKENIZER_STATS 1
+#endif
+
+namespace ltok {
+
+static constexpr size_t stats_shards = 16;
+static constexpr size_t stats_buckets = LLAMA_TOKENIZER_STATS_HISTOGRAM_BUCKETS;
+
+/**
+ * Per-handle call counters, sharded by thread
+ *
+ * Each thread is assigned one shard (round-robin on first use), so
+ * threads on one handle increment different cache lines. Counters are
+ * relaxed atomics: they are only ever summed, never used to order other
+ * memory. Recording is inline so the cost at each entry point is two
+ * clock reads and a handful of fetch_adds on a line the thread owns.
+ */
+class tokenizer_stats {
+public:
+    tokenizer_stats() { reset(); }
+
+    tokenizer_stats(const tokenizer_stats&) = delete;
+    tokenizer_stats& operator=(const tokenizer_stats&) = delete;
+
+    static uint64_t now_ns() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // One finished call; result follows the entry point's return convention
+    void record(llama_tokenizer_stats_entry entry, bool count_only, int32_t result,
+                uint64_t input, uint64_t output, uint64_t start_ns) {
+#if LLAMA_TOKENIZER_STATS
+        const uint64_t ns = now_ns() - start_ns;
+        entry_counters& c = shard().entries[entry];
+        add(c.calls, 1);
+        add(count_only ? c.count_only_calls : c.fill_calls, 1);
+        if (!count_only && result < 0 && result != INT32_MIN) {
+            add(c.buffer_too_small, 1);
+        }
+        add(c.input, input);
+        add(c.output, output);
+        add(c.total_ns, ns);
+        add(c.histogram[bucket(ns)], 1);
+#else
+        (void)entry, (void)count_only, (void)result, (void)input, (void)output, (void)start_ns;
+#endif
+    }
+
+    void record_sanitized() { record_event(&shard_counters::utf8_sanitized); }
+    void record_partitioned() { record_event(&shard_counters::special_partitioned); }
+    void record_native_fallback() { record_event(&shard_counters::native_fallbacks); }
+
+    void snapshot(llama_tokenizer_stats& out) const;
+    void reset();
+
+private:
+    struct entry_counters {
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> count_only_calls;
+        std::atomic<uint64_t> fill_calls;
+        std::atomic<uint64_t> buffer_too_small;
+        std::atomic<uint64_t> input;
+        std::atomic<uint64_t> output;
+        std::atomic<uint64_t> total_ns;
+        std::atomic<uint64_t> histogram[stats_buckets];
+    };
+
+    struct alignas(64) shard_counters {
+        entry_counters entries[LLAMA_TOKENIZER_STATS_N_ENTRY_POINTS];
+        std::atomic<uint64_t> utf8_sanitized;
+        std::atomic<uint64_t> special_partitioned;
+        std::atomic<uint64_t> native_fallbacks;
+    };
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t value) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    static size_t bucket(uint64_t ns) {
+        const size_t b = ns == 0 ? 0 : (size_t)(63 - __builtin_clzll(ns));
+        return b < stats_buckets ? b : stats_buckets - 1;
+    }
+
+    static size_t thread_shard() {
+        static std::atomic<size_t> next_shard{0};
+        thread_local const size_t index = next_shard.fetch_add(1, std::memory_order_relaxed) % stats_shards;
+        return index;
+    }
+
+    shard_counters& shard() { return shards[thread_shard()]; }
+
+    void record_event(std::atomic<uint64_t> shard_counters::*counter) {
+#if LLAMA_TOKENIZER_STATS
+        add(shard().*counter, 1);
+#else
+        (void)counter;
+#endif
+    }
+
+    shard_counters shards[stats_shards];
+};
+
+/**
+ * Run one entry point call and record it, with the call's positive
+ * result as its output size
+ */
+template <typename Fn>
+inline int32_t record_call(tokenizer_stats& stats, llama_tokenizer_stats_entry entry, bool count_only,
+                           uint64_t input, Fn&& fn) {
+#if LLAMA_TOKENIZER_STATS
+    const uint64_t start = tokenizer_stats::now_ns();
+    const int32_t result = fn();
+    stats.record(entry, count_only, result, input, result > 0 ? (uint64_t)result : 0, start);
+    return result;
+#else
+    (void)stats, (void)entry, (void)count_only, (void)input;
+    return fn();
+#endif
+}
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_STATS_H
@@ -0,0 +1,129 @@
+#include "stop_matcher.h"
+
+#include <algorithm>
+#include <new>
+
+namespace ltok {
+
+bool stop_set::build(const piece_index& index, const llama_vocab* vocab, const std::vector<std::string>& stops,
+                     const std::vector<llama_token>& stop_tokens, bool stop_on_eog) {
+    pieces = &index;
+    const size_t n = (size_t)std::max<int32_t>(llama_vocab_n_tokens(vocab), 0);
+    try {
+        strings.build(stops);
+        longest = 0;
+        for (const std::string& stop : stops) {
+            longest = std::max(longest, stop.size());
+        }
+
+        stop_bits.assign((n + 63) / 64, 0);
+        for (llama_token id : stop_tokens) {
+            stop_bits[(size_t)id / 64] |= 1ull << (id % 64);
+        }
+        if (stop_on_eog) {
+            for (size_t id = 0; id < n; id++) {
+                if (llama_vocab_is_eog(vocab, (llama_token)id)) {
+                    stop_bits[id / 64] |= 1ull << (id % 64);
+                }
+            }
+        }
+
+        from_start.resize(n);
+        for (size_t id = 0; id < n; id++) {
+            size_t len;
+            const char* piece = index.piece((llama_token)id, len);
+            uint32_t state = 0;
+            for (size_t i = 0; i < len && state != WALK; i++) {
+                state = strings.step(state, (unsigned char)piece[i]);
+                state = strings.has_output(state) ? WALK : state;
+            }
+            from_start[id] = state;
+        }
+    } catch (const std::bad_alloc&) {
+        from_start.clear();
+        stop_bits.clear();
+        return false;
+    }
+    return true;
+}
+
+size_t stop_stream::feed(const llama_token* tokens, size_t count, bool& stopped, stop_hit& hit) {
+    const aho_corasick& automaton = set.automaton();
+    stopped = false;
+    for (size_t i = 0; i < count; i++) {
+        const llama_token id = tokens[i];
+        const int64_t begin = n_bytes;
+        size_t len;
+        const char* piece = set.piece(id, len);
+        starts.push_back(begin);
+        n_tokens++;
+        n_bytes += (int64_t)len;
+
+        if (set.is_stop_token(id)) {
+            state = 0;
+            hit = { -1, begin, n_tokens - 1, 0 };
+            stopped = true;
+            trim();
+            return i + 1;
+        }
+
+        const uint32_t next = state == 0 ? set.start_transition(id) : stop_set::WALK;
+        if (next != stop_set::WALK) {
+            state = next;
+            trim();
+            continue;
+        }
+
+        for (size_t j = 0; j < len; j++) {
+            state = automaton.step(state, (unsigned char)piece[j]);
+            if (!stopped && automaton.has_output(state)) {
+                // Outputs come longest first, so the match starting earliest
+                uint32_t stop = aho_corasick::NO_PATTERN;
+                automaton.for_each_output(state, [&](uint32_t pattern) {
+                    stop = stop == aho_corasick::NO_PATTERN ? pattern : stop;
+                });
+                hit.stop = (int32_t)stop;
+                locate(begin + (int64_t)(j + 1) - (int64_t)automaton.pattern_length(stop), hit);
+                stopped = true;
+            }
+        }
+        trim();
+        if (stopped) {
+            return i + 1;
+        }
+    }
+    return count;
+}
+
+void stop_stream::locate(int64_t start, stop_hit& hit) const {
+    // Last token starting at or before the match; tokens with an empty
+    // piece share their start with the next one, which is the one chosen
+    const auto it = std::upper_bound(starts.begin() + (ptrdiff_t)head, starts.end(), start) - 1;
+    hit.byte_offset = start;
+    hit.token = first_token + (it - starts.begin());
+    hit.token_offset = (int32_t)(start - *it);
+}
+
+void stop_stream::trim() {
+    // A match ending by now starts at or after keep_from
+    const int64_t keep_from = n_bytes - (int64_t)set.max_length();
+    while (head + 1 < starts.size() && starts[head + 1] <= keep_from) {
+        head++;
+    }
+    if (head >= 64 && head * 2 >= starts.size()) {
+        starts.erase(starts.begin(), starts.begin() + (ptrdiff_t)head);
+        first_token += (int64_t)head;
+        head = 0;
+    }
+}
+
+void stop_stream::reset() {
+    state = 0;
+    n_bytes = 0;
+    n_tokens = 0;
+    starts.clear();
+    first_token = 0;
+    head = 0;
+}
+
+} // namespace ltok
@@ -0,0 +1,100 @@
+#ifndef LLAMA_TOKENIZER_STOP_MATCHER_H
+#define LLAMA_TOKENIZER_STOP_MATCHER_H
+
+#include "llama.h"
+#include "aho_corasick.h"
+#include "piece_index.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace ltok {
+
+struct stop_hit {
+    int32_t stop;          // stop string, or -1 for a stop token
+    int64_t byte_offset;   // start of the match in the stream's output
+    int64_t token;         // stream token holding the first byte of the match
+    int32_t token_offset;  // start of the match in that token's piece
+};
+
+/**
+ * Stop strings and stop tokens compiled against a vocab
+ *
+ * The strings form one Aho-Corasick automaton over the rendered pieces.
+ * For every token the state reached by walking its piece from the start
+ * state is precomputed, so while no stop string is partly matched (the
+ * common case) a token costs one lookup instead of a walk. Immutable
+ * after build(); the piece index must outlive it.
+ */
+class stop_set {
+public:
+    // False when memory runs out
+    bool build(const piece_index& pieces, const llama_vocab* vocab, const std::vector<std::string>& stops,
+               const std::vector<llama_token>& stop_tokens, bool stop_on_eog);
+
+    size_t n_vocab() const { return from_start.size(); }
+
+    bool is_stop_token(llama_token id) const { return (stop_bits[(size_t)id / 64] >> (id % 64)) & 1; }
+
+    const char* piece(llama_token id, size_t& len) const { return pieces->piece(id, len); }
+
+    // State after id's piece from the start state, or WALK when the piece
+    // itself contains a stop string
+    static constexpr uint32_t WALK = UINT32_MAX;
+    uint32_t start_transition(llama_token id) const { return from_start[(size_t)id]; }
+
+    const aho_corasick& automaton() const { return strings; }
+    size_t max_length() const { return longest; }
+
+private:
+    const piece_index* pieces = nullptr;
+    aho_corasick strings;
+    size_t longest = 0;
+    std::vector<uint32_t> from_start;  // per token
+    std::vector<uint64_t> stop_bits;   // per token
+};
+
+/**
+ * Matching state of one generation stream over a shared stop_set
+ *
+ * Matches may span any number of tokens. Only the start offsets of the
+ * tokens that can still hold the first byte of a match are kept.
+ */
+class stop_stream {
+public:
+    explicit stop_stream(const stop_set& set) : set(set) {}
+
+    /**
+     * Consume tokens up to the first one completing a match (earliest
+     * end; the longest string among those ending there). Returns the
+     * number consumed, with hit set when the last of them stopped; ids
+     * must be valid for the vocab.
+     */
+    size_t feed(const llama_token* tokens, size_t n_tokens, bool& stopped, stop_hit& hit);
+
+    size_t vocab_size() const { return set.n_vocab(); }
+
+    // Trailing output bytes that may still grow into a stop string
+    size_t pending() const { return set.automaton().depth(state); }
+
+    void reset();
+
+private:
+    void locate(int64_t start, stop_hit& hit) const;
+    void trim();
+
+    const stop_set& set;
+    uint32_t state = 0;
+    int64_t n_bytes = 0;
+    int64_t n_tokens = 0;
+    std::vector<int64_t> starts;  // output offset of token first_token + i
+    int64_t first_token = 0;
+    size_t head = 0;              // starts before this can no longer hold a match
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_STOP_MATCHER_H
@@ -0,0 +1,317 @@
+#include "threadpool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <system_error>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ltok {
+
+// Identifies pool workers so nested parallel_for() calls use their own deque
+static thread_local const thread_pool* current_pool = nullptr;
+static thread_local size_t current_queue = 0;
+
+// Rounds a worker spins on the pending count before it goes to sleep
+static const int spin_rounds = 64;
+
+// Best effort: a CPU the process may not use is silently ignored
+static void pin_current_thread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    if (cpus.empty()) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpus;
+#endif
+}
+
+// Parses the kernel's cpulist format, e.g. "0-15,32-47"
+std::vector<int> numa_node_cpus(int node) {
+    std::vector<int> cpus;
+#ifdef __linux__
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return cpus;
+    }
+    char line[4096];
+    if (fgets(line, sizeof(line), f)) {
+        char* p = line;
+        while (*p >= '0' && *p <= '9') {
+            long first = strtol(p, &p, 10);
+            long last = first;
+            if (*p == '-') {
+                last = strtol(p + 1, &p, 10);
+            }
+            for (long cpu = first; cpu <= last; cpu++) {
+                cpus.push_back((int)cpu);
+            }
+            if (*p != ',') {
+                break;
+            }
+            p++;
+        }
+    }
+    fclose(f);
+#else
+    (void)node;
+#endif
+    return cpus;
+}
+
+thread_pool::thread_pool(const thread_pool_options& options)
+    : executor(options.executor),
+      executor_user_data(options.executor_user_data) {
+    concurrency = options.n_threads;
+    if (concurrency == 0) {
+        concurrency = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (executor) {
+        return;
+    }
+
+    std::vector<int> node_cpus;
+    if (options.cpus.empty() && options.numa_node >= 0) {
+        node_cpus = numa_node_cpus(options.numa_node);
+    }
+
+    queues.reserve(concurrency);
+    for (size_t i = 0; i < concurrency; i++) {
+        queues.emplace_back(new worker_queue());
+    }
+
+    workers.reserve(concurrency);
+    for (size_t i = 0; i < concurrency; i++) {
+        std::vector<int> cpus = options.cpus.empty()
+            ? node_cpus
+            : std::vector<int>(1, options.cpus[i % options.cpus.size()]);
+        try {
+            workers.emplace_back(&thread_pool::worker_main, this, i, std::move(cpus));
+        } catch (const std::system_error&) {
+            break;  // run with the workers we have; queues without one get stolen from
+        }
+    }
+    concurrency = workers.size();
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    sleep_cv.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void thread_pool::push(size_t queue, const range_task& task) {
+    {
+        std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+        queues[queue]->tasks.push_back(task);
+    }
+    // Pairs with the sleepers increment in worker_main(): either the worker
+    // sees the new task or this sees the sleeper and wakes it
+    pending.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_seq_cst) > 0) {
+        { std::lock_guard<std::mutex> lock(sleep_mutex); }
+        sleep_cv.notify_one();
+    }
+}
+
+bool thread_pool::pop(size_t queue, range_task& out) {
+    worker_queue& q = *queues[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) {
+        return false;
+    }
+    out = q.tasks.back();
+    q.tasks.pop_back();
+    pending.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool thread_pool::steal(size_t thief, range_task& out) {
+    const size_t n = queues.size();
+    for (size_t i = 1; i <= n; i++) {
+        worker_queue& q = *queues[(thief + i) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty()) {
+            out = q.tasks.front();
+            q.tasks.pop_front();
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Split down to the grain, leaving the upper halves for thieves, then run
+// what is left and retire it
+void thread_pool::execute(range_task task, size_t queue) {
+    job* j = task.owner;
+    while (task.end - task.begin > j->grain) {
+        const size_t mid = task.begin + (task.end - task.begin) / 2;
+        push(queue, { j, mid, task.end });
+        task.end = mid;
+    }
+
+    j->fn(j->ctx, task.begin, task.end);
+
+    const size_t count = task.end - task.begin;
+    if (j->remaining.fetch_sub(count, std::memory_order_acq_rel) == count) {
+        // The owner may return (and free the job) as soon as this unlocks
+        std::lock_guard<std::mutex> lock(j->mutex);
+        j->done = true;
+        j->cv.notify_all();
+    }
+}
+
+void thread_pool::worker_main(size_t index, std::vector<int> cpus) {
+    pin_current_thread(cpus);
+    current_pool = this;
+    current_queue = index;
+
+    range_task task;
+    for (;;) {
+        if (pop(index, task) || steal(index, task)) {
+            execute(task, index);
+            continue;
+        }
+        for (int i = 0; i < spin_rounds && pending.load(std::memory_order_relaxed) == 0; i++) {
+            std::this_thread::yield();
+        }
+        if (pending.load(std::memory_order_relaxed) > 0) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        sleep_cv.wait(lock, [&] { return stopping || pending.load(std::memory_order_seq_cst) > 0; });
+        sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        if (stopping && pending.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+    }
+}
+
+void thread_pool::run(size_t n, size_t grain, range_fn fn, const void* ctx) {
+    if (n == 0) {
+        return;
+    }
+    if (executor) {
+        run_on_executor(n, grain, fn, ctx);
+        return;
+    }
+    if (workers.empty() || n <= grain) {
+        fn(ctx, 0, n);
+        return;
+    }
+
+    job j;
+    j.fn = fn;
+    j.ctx = ctx;
+    j.grain = grain;
+    j.remaining.store(n, std::memory_order_relaxed);
+
+    // Outside callers seed a worker's deque round-robin and help from there
+    const size_t queue = (current_pool == this)
+        ? current_queue
+        : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    execute({ &j, 0, n }, queue);
+
+    range_task task;
+    while (j.remaining.load(std::memory_order_acquire) > 0) {
+        if (!pop(queue, task) && !steal(queue, task)) {
+            break;
+        }
+        execute(task, queue);
+    }
+
+    std::unique_lock<std::mutex> lock(j.mutex);
+    j.cv.wait(lock, [&] { return j.done; });
+}
+
+// Shared by the caller and the tasks it submitted; the last one to let
+// go frees it, since the executor may run a task after the caller returned
+struct thread_pool::executor_job {
+    range_fn fn;
+    const void* ctx;
+    size_t n;
+    size_t grain;
+    size_t n_chunks;
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> remaining_chunks{0};
+    std::atomic<size_t> refs{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+
+    void work() {
+        for (;;) {
+            const size_t chunk = next_chunk.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= n_chunks) {
+                return;
+            }
+            const size_t begin = chunk * grain;
+            fn(ctx, begin, std::min(n, begin + grain));
+            if (remaining_chunks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done = true;
+                cv.notify_all();
+            }
+        }
+    }
+
+    void release() {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+};
+
+void thread_pool::executor_task(void* arg) {
+    executor_job* j = static_cast<executor_job*>(arg);
+    j->work();
+    j->release();
+}
+
+void thread_pool::run_on_executor(size_t n, size_t grain, range_fn fn, const void* ctx) {
+    executor_job* j = new executor_job();
+    j->fn = fn;
+    j->ctx = ctx;
+    j->n = n;
+    j->grain = grain;
+    j->n_chunks = (n + grain - 1) / grain;
+    j->remaining_chunks.store(j->n_chunks, std::memory_order_relaxed);
+
+    const size_t n_tasks = std::min(concurrency, j->n_chunks - 1);
+    j->refs.store(n_tasks + 1, std::memory_order_relaxed);
+    for (size_t i = 0; i < n_tasks; i++) {
+        executor(executor_task, j, executor_user_data);
+    }
+
+    j->work();
+    {
+        std::unique_lock<std::mutex> lock(j->mutex);
+        j->cv.wait(lock, [&] { return j->done; });
+    }
+    j->release();
+}
+
+} // namespace ltok
@@ -0,0 +1,123 @@
+#ifndef LLAMA_TOKENIZER_THREADPOOL_H
+#define LLAMA_TOKENIZER_THREADPOOL_H
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ltok {
+
+// Runs task(arg) exactly once, on any thread
+typedef void (*task_fn)(void* arg);
+typedef void (*executor_fn)(task_fn task, void* arg, void* user_data);
+
+struct thread_pool_options {
+    size_t n_threads = 0;        // worker threads; 0 for one per hardware thread
+    std::vector<int> cpus;       // pin worker i to cpus[i % cpus.size()]
+    int numa_node = -1;          // otherwise restrict workers to this node's CPUs
+    executor_fn executor = nullptr;  // hand tasks to the caller's scheduler instead
+    void* executor_user_data = nullptr;
+};
+
+/**
+ * Fork-join pool with one work-stealing deque per worker
+ *
+ * parallel_for() pushes one task for the whole range; whoever runs a task
+ * splits it in half, keeps the first half and pushes the second onto its
+ * own deque, so idle workers steal large pieces from the top while the
+ * owner works through small pieces at the bottom. The calling thread
+ * takes part until the range is done, which also makes nested
+ * parallel_for() calls from inside a task safe.
+ *
+ * With an executor no threads are created: each parallel_for() submits
+ * up to size() - 1 tasks to it that claim chunks from a shared counter,
+ * alongside the caller.
+ */
+class thread_pool {
+public:
+    explicit thread_pool(const thread_pool_options& options);
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // Degree of parallelism, not counting the calling thread
+    size_t size() const { return concurrency; }
+
+    /**
+     * Call fn(begin, end) over [0, n) in chunks of at most grain items and
+     * return once every chunk has run
+     */
+    template <typename F>
+    void parallel_for(size_t n, size_t grain, const F& fn) {
+        run(n, grain ? grain : 1,
+            [](const void* ctx, size_t begin, size_t end) { (*static_cast<const F*>(ctx))(begin, end); },
+            &fn);
+    }
+
+private:
+    typedef void (*range_fn)(const void* ctx, size_t begin, size_t end);
+
+    struct job {
+        range_fn fn;
+        const void* ctx;
+        size_t grain;
+        std::atomic<size_t> remaining;  // items not yet processed
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+    };
+
+    struct range_task {
+        job* owner;
+        size_t begin;
+        size_t end;
+    };
+
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<range_task> tasks;  // owner uses the back, thieves the front
+    };
+
+    struct executor_job;
+
+    void run(size_t n, size_t grain, range_fn fn, const void* ctx);
+    void run_on_executor(size_t n, size_t grain, range_fn fn, const void* ctx);
+    static void executor_task(void* arg);
+
+    void worker_main(size_t index, std::vector<int> cpus);
+    void push(size_t queue, const range_task& task);
+    bool pop(size_t queue, range_task& out);
+    bool steal(size_t thief, range_task& out);
+    void execute(range_task task, size_t queue);
+
+    size_t concurrency = 0;
+    executor_fn executor = nullptr;
+    void* executor_user_data = nullptr;
+
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next_queue{0};  // round-robin target for outside callers
+
+    // Sleeping workers wait for pending > 0
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> sleepers{0};
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    bool stopping = false;
+};
+
+/**
+ * CPUs of a NUMA node from /sys; empty if unknown
+ */
+std::vector<int> numa_node_cpus(int node);
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_THREADPOOL_H
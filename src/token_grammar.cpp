@@ -0,0 +1,93 @@
+#include "token_grammar.h"
+
+#include <algorithm>
+#include <new>
+
+namespace ltok {
+
+bool token_grammar::build(byte_dfa compiled, const piece_index& index, const llama_vocab* vocab, thread_pool* pool,
+                          std::string& error) {
+    dfa = std::move(compiled);
+    pieces = &index;
+    n_vocab = (size_t)std::max<int32_t>(llama_vocab_n_tokens(vocab), 0);
+    words = (n_vocab + 63) / 64;
+
+    std::vector<uint16_t> shared;  // bytes each piece shares with the one before it, capped
+    size_t max_piece = 0;
+    try {
+        masks.assign(dfa.n_states() * words, 0);
+        eog.assign(n_vocab, 0);
+        for (size_t id = 0; id < n_vocab; id++) {
+            eog[id] = llama_vocab_is_eog(vocab, (llama_token)id);
+        }
+
+        shared.resize(index.size());
+        const char* prev = nullptr;
+        size_t prev_len = 0;
+        for (size_t i = 0; i < index.size(); i++) {
+            size_t len;
+            const char* piece = index.piece(index.sorted()[i], len);
+            size_t common = 0;
+            while (common < len && common < prev_len && common < UINT16_MAX && piece[common] == prev[common]) {
+                common++;
+            }
+            shared[i] = (uint16_t)common;
+            max_piece = std::max(max_piece, len);
+            prev = piece;
+            prev_len = len;
+        }
+    } catch (const std::bad_alloc&) {
+        masks.clear();
+        error = "out of memory";
+        return false;
+    }
+
+    // states[d] is the state after the first d bytes of the current piece;
+    // the prefix shared with the previous piece is already walked
+    auto fill = [&](size_t begin, size_t end) {
+        std::vector<int32_t> states(max_piece + 1);
+        for (size_t s = begin; s < end; s++) {
+            uint64_t* bits = masks.data() + s * words;
+            states[0] = (int32_t)s;
+            for (size_t i = 0; i < index.size(); i++) {
+                const llama_token id = index.sorted()[i];
+                size_t len;
+                const char* piece = index.piece(id, len);
+                for (size_t d = shared[i]; d < len; d++) {
+                    states[d + 1] = states[d] == byte_dfa::DEAD ? byte_dfa::DEAD
+                                                                : dfa.next(states[d], (unsigned char)piece[d]);
+                }
+                if (states[len] != byte_dfa::DEAD && !eog[(size_t)id]) {
+                    bits[(size_t)id / 64] |= (uint64_t)1 << ((size_t)id % 64);
+                }
+            }
+            if (dfa.accepting((int32_t)s)) {
+                for (size_t id = 0; id < n_vocab; id++) {
+                    if (eog[id]) {
+                        bits[id / 64] |= (uint64_t)1 << (id % 64);
+                    }
+                }
+            }
+        }
+    };
+    if (pool && dfa.n_states() > 1) {
+        pool->parallel_for(dfa.n_states(), 1, fill);
+    } else {
+        fill(0, dfa.n_states());
+    }
+    return true;
+}
+
+int32_t token_grammar::advance(int32_t state, llama_token token) const {
+    if (token < 0 || (size_t)token >= n_vocab) {
+        return byte_dfa::DEAD;
+    }
+    if (eog[(size_t)token]) {
+        return dfa.accepting(state) ? state : byte_dfa::DEAD;
+    }
+    size_t len;
+    const char* piece = pieces->piece(token, len);
+    return len > 0 ? dfa.walk(state, piece, len) : byte_dfa::DEAD;
+}
+
+} // namespace ltok
@@ -0,0 +1,55 @@
+#ifndef LLAMA_TOKENIZER_TOKEN_GRAMMAR_H
+#define LLAMA_TOKENIZER_TOKEN_GRAMMAR_H
+
+#include "llama.h"
+#include "piece_index.h"
+#include "regex_dfa.h"
+#include "threadpool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace ltok {
+
+/**
+ * A byte DFA lifted to tokens: for every state, the bitset of tokens
+ * whose piece can be walked from it without dying
+ *
+ * Masks are filled by walking the vocab in piece order, so each state
+ * only walks the bytes a piece does not share with the one before it.
+ * End-of-generation tokens are allowed exactly in accepting states;
+ * other tokens with an empty piece never are. Immutable after build();
+ * the piece index must outlive it.
+ */
+class token_grammar {
+public:
+    // pool may be null; false with error set when memory runs out
+    bool build(byte_dfa dfa, const piece_index& pieces, const llama_vocab* vocab, thread_pool* pool,
+               std::string& error);
+
+    size_t n_states() const { return dfa.n_states(); }
+    size_t n_words() const { return words; }
+
+    // Bit t % 64 of word t / 64 is set when token t is allowed
+    const uint64_t* mask(int32_t state) const { return masks.data() + (size_t)state * words; }
+
+    bool accepting(int32_t state) const { return dfa.accepting(state); }
+
+    // State after token, or byte_dfa::DEAD when it is not allowed
+    int32_t advance(int32_t state, llama_token token) const;
+
+private:
+    byte_dfa dfa;
+    const piece_index* pieces = nullptr;
+    size_t n_vocab = 0;
+    size_t words = 0;
+    std::vector<uint64_t> masks;  // [state * words + token / 64]
+    std::vector<uint8_t> eog;     // per token
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_TOKEN_GRAMMAR_H
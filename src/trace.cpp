@@ -0,0 +1,241 @@
+#include "trace.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace ltok {
+
+std::atomic<bool> trace_active{false};
+
+namespace {
+
+static constexpr size_t default_trace_capacity = 65536;
+
+/**
+ * One recorded span, guarded by a per-slot sequence number
+ *
+ * A writer makes seq odd, stores the fields and makes it even again; a
+ * reader keeps the fields only if it saw the same even seq before and
+ * after reading them. Fields are relaxed atomics so a torn read is a
+ * discarded span, not a data race.
+ */
+struct trace_slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> duration_ns{0};
+    std::atomic<uint64_t> size{0};
+    std::atomic<uint32_t> phase{0};
+    std::atomic<uint32_t> thread_id{0};
+};
+
+struct trace_recorder {
+    explicit trace_recorder(size_t capacity) : slots(new trace_slot[capacity]), capacity(capacity) {}
+
+    std::unique_ptr<trace_slot[]> slots;
+    size_t capacity;
+    std::atomic<uint64_t> next{0};
+};
+
+// Read by every traced thread; written by the setters, one at a time.
+// The setters change what trace_emit() sees and then wait for the
+// emitters that may still see the old values (see retire())
+std::mutex setter_mutex;
+std::atomic<llama_tokenizer_trace_fn> trace_callback{nullptr};
+std::atomic<void*> trace_user_data{nullptr};
+std::atomic<trace_recorder*> recording{nullptr};  // recorder being written, null when stopped
+std::unique_ptr<trace_recorder> recorder;          // kept after stop so it can be dumped
+
+// Emitters in flight, counted under the epoch they started in
+std::atomic<uint32_t> epoch{0};
+std::atomic<uint32_t> emitting[2];
+
+const char* const phase_names[LLAMA_TOKENIZER_TRACE_N_PHASES] = {
+    "create",
+    "model_load",
+    "kernel_build",
+    "tokenize",
+    "special_partition",
+    "pre_tokenize",
+    "model",
+    "llama_cpp",
+    "output_copy",
+    "detokenize",
+};
+
+void update_active() {
+    trace_active.store(trace_callback.load() != nullptr || recording.load() != nullptr, std::memory_order_relaxed);
+}
+
+// Wait until no emitter can still use a callback or recorder the caller
+// has already unpublished. An emitter may have read the epoch just before
+// a flip, so both counters are drained in turn; emitters starting after a
+// flip count under the other one, so the wait is bounded.
+void retire() {
+    for (int i = 0; i < 2; i++) {
+        const uint32_t old = epoch.fetch_add(1) & 1;
+        while (emitting[old].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+uint32_t trace_thread_id() {
+    static std::atomic<uint32_t> next_id{1};
+    thread_local const uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void record(trace_recorder& r, const llama_tokenizer_trace_span& span) {
+    const uint64_t n = r.next.fetch_add(1, std::memory_order_relaxed);
+    trace_slot& slot = r.slots[n % r.capacity];
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.start_ns.store(span.start_ns, std::memory_order_relaxed);
+    slot.duration_ns.store(span.duration_ns, std::memory_order_relaxed);
+    slot.size.store(span.size, std::memory_order_relaxed);
+    slot.phase.store((uint32_t)span.phase, std::memory_order_relaxed);
+    slot.thread_id.store(span.thread_id, std::memory_order_relaxed);
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+}
+
+bool read_slot(const trace_slot& slot, llama_tokenizer_trace_span& span) {
+    const uint64_t before = slot.seq.load(std::memory_order_acquire);
+    if (before == 0 || (before & 1) != 0) {
+        return false;
+    }
+    span.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+    span.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+    span.size = slot.size.load(std::memory_order_relaxed);
+    span.phase = (llama_tokenizer_trace_phase)slot.phase.load(std::memory_order_relaxed);
+    span.thread_id = slot.thread_id.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.seq.load(std::memory_order_relaxed) == before && span.phase < LLAMA_TOKENIZER_TRACE_N_PHASES;
+}
+
+} // namespace
+
+uint64_t trace_now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void trace_emit(llama_tokenizer_trace_phase phase, uint64_t start_ns, uint64_t size) {
+    llama_tokenizer_trace_span span;
+    span.phase = phase;
+    span.thread_id = trace_thread_id();
+    span.start_ns = start_ns;
+    span.duration_ns = trace_now_ns() - start_ns;
+    span.size = size;
+
+    // Sequentially consistent throughout: the setters' unpublish and
+    // counter reads must order against the increment and loads here
+    const uint32_t e = epoch.load() & 1;
+    emitting[e].fetch_add(1);
+    if (trace_recorder* r = recording.load()) {
+        record(*r, span);
+    }
+    // user_data is stored before fn is published, so they always match
+    if (llama_tokenizer_trace_fn fn = trace_callback.load()) {
+        fn(&span, trace_user_data.load());
+    }
+    emitting[e].fetch_sub(1);
+}
+
+void trace_set_callback(llama_tokenizer_trace_fn fn, void* user_data) {
+    std::lock_guard<std::mutex> lock(setter_mutex);
+    if (trace_callback.load() != nullptr) {
+        trace_callback.store(nullptr);
+        retire();
+    }
+    trace_user_data.store(user_data);
+    trace_callback.store(fn);
+    update_active();
+}
+
+bool trace_start(size_t capacity) {
+#if LLAMA_TOKENIZER_TRACE
+    if (capacity == 0) {
+        capacity = default_trace_capacity;
+    }
+    std::lock_guard<std::mutex> lock(setter_mutex);
+    recording.store(nullptr);
+    retire();
+    recorder.reset();
+    try {
+        recorder.reset(new trace_recorder(capacity));
+    } catch (const std::bad_alloc&) {
+        update_active();
+        return false;
+    }
+    recording.store(recorder.get());
+    update_active();
+    return true;
+#else
+    (void)capacity;
+    return false;
+#endif
+}
+
+void trace_stop() {
+    std::lock_guard<std::mutex> lock(setter_mutex);
+    recording.store(nullptr);
+    update_active();
+}
+
+int32_t trace_dump(const char* path) {
+    if (!path) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(setter_mutex);
+    if (!recorder) {
+        return -1;
+    }
+
+    // Only the last `capacity` claimed slots can still hold their span
+    const trace_recorder& r = *recorder;
+    const uint64_t end = r.next.load(std::memory_order_acquire);
+    const uint64_t begin = end > r.capacity ? end - r.capacity : 0;
+
+    std::vector<llama_tokenizer_trace_span> spans;
+    spans.reserve((size_t)(end - begin));
+    for (uint64_t n = begin; n < end; n++) {
+        llama_tokenizer_trace_span span;
+        if (read_slot(r.slots[n % r.capacity], span)) {
+            spans.push_back(span);
+        }
+    }
+    std::sort(spans.begin(), spans.end(),
+              [](const llama_tokenizer_trace_span& a, const llama_tokenizer_trace_span& b) {
+                  return a.start_ns < b.start_ns;
+              });
+
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        return -1;
+    }
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (size_t i = 0; i < spans.size(); i++) {
+        const llama_tokenizer_trace_span& s = spans[i];
+        // Timestamps are microseconds; keep nanosecond precision as decimals
+        fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"llama_tokenizer\",\"ph\":\"X\","
+                   "\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"pid\":1,\"tid\":%u,\"args\":{\"size\":%llu}}",
+                i == 0 ? "" : ",", phase_names[s.phase],
+                (unsigned long long)(s.start_ns / 1000), (unsigned)(s.start_ns % 1000),
+                (unsigned long long)(s.duration_ns / 1000), (unsigned)(s.duration_ns % 1000),
+                s.thread_id, (unsigned long long)s.size);
+    }
+    fprintf(f, "\n]}\n");
+    if (fclose(f) != 0) {
+        return -1;
+    }
+    return (int32_t)std::min<size_t>(spans.size(), INT32_MAX);
+}
+
+} // namespace ltok
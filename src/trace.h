@@ -0,0 +1,78 @@
+#ifndef LLAMA_TOKENIZER_TRACE_H
+#define LLAMA_TOKENIZER_TRACE_H
+
+#include "llama_tokenizer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+// Set to 0 by -DLLAMA_TOKENIZER_TRACE=OFF
+#ifndef LLAMA_TOKENIZER_TRACE
+#define LLAMA_TOKENIZER_TRACE 1
+#endif
+
+namespace ltok {
+
+// True while a trace callback or the recorder is installed
+extern std::atomic<bool> trace_active;
+
+uint64_t trace_now_ns();
+
+// Deliver one finished span to the callback and the recorder
+void trace_emit(llama_tokenizer_trace_phase phase, uint64_t start_ns, uint64_t size);
+
+// Back the process-wide trace functions of the C API; safe while other
+// threads emit spans
+void trace_set_callback(llama_tokenizer_trace_fn fn, void* user_data);
+bool trace_start(size_t capacity);
+void trace_stop();
+int32_t trace_dump(const char* path);
+
+/**
+ * Timed span of one phase, emitted by end() or on scope exit
+ *
+ * While tracing is off, construction is one relaxed load and a branch
+ * predicted not taken, and nothing else runs; with -DLLAMA_TOKENIZER_TRACE=OFF
+ * the class is empty and every use compiles away.
+ */
+class trace_span {
+public:
+    trace_span(llama_tokenizer_trace_phase phase, uint64_t size) {
+#if LLAMA_TOKENIZER_TRACE
+        if (__builtin_expect(trace_active.load(std::memory_order_relaxed), 0)) {
+            this->phase = phase;
+            this->size = size;
+            start_ns = trace_now_ns();
+        }
+#else
+        (void)phase, (void)size;
+#endif
+    }
+
+    ~trace_span() { end(); }
+
+    trace_span(const trace_span&) = delete;
+    trace_span& operator=(const trace_span&) = delete;
+
+    void end() {
+#if LLAMA_TOKENIZER_TRACE
+        if (start_ns != 0) {
+            trace_emit(phase, start_ns, size);
+            start_ns = 0;
+        }
+#endif
+    }
+
+private:
+#if LLAMA_TOKENIZER_TRACE
+    uint64_t start_ns = 0;
+    uint64_t size = 0;
+    llama_tokenizer_trace_phase phase = LLAMA_TOKENIZER_TRACE_TOKENIZE;
+#endif
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_TRACE_H
@@ -0,0 +1,370 @@
+#include "ugm_tokenizer.h"
+#include "scratch.h"
+#include "trace.h"
+
+#include <float.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace ltok {
+
+// U+2581 (Lower One Eighth Block), SentencePiece's escaped space
+static const char escaped_space[] = "\xE2\x96\x81";
+
+// Penalty applied below the lowest piece score for unknown characters
+static const float unknown_token_score_penalty = 10.0f;
+
+static inline size_t utf8_len(char c) {
+    static const size_t lookup[] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 4 };
+    return lookup[(uint8_t)c >> 4];
+}
+
+// Accessors for the packed XCDA nodes of a precompiled charsmap
+static inline uint32_t xcda_base(uint32_t node) {
+    return (node >> 10) << ((node & (1U << 9)) >> 6);
+}
+static inline uint32_t xcda_lcheck(uint32_t node) {
+    return node & ((1U << 31) | 0xff);
+}
+static inline bool xcda_is_leaf(uint32_t node) {
+    return (node >> 8) & 1;
+}
+static inline uint32_t xcda_value(uint32_t node) {
+    return node & ((1U << 31) - 1);
+}
+
+ugm_tokenizer::ugm_tokenizer(const llama_vocab* vocab, const vocab_metadata& meta)
+    : unk_id(meta.unk_id),
+      add_space_prefix(meta.add_space_prefix),
+      remove_extra_whitespaces(meta.remove_extra_whitespaces) {
+    // First four bytes hold the size of the XCDA blob, followed by the
+    // blob and then the replacement strings
+    const std::vector<char>& charsmap = meta.precompiled_charsmap;
+    if (charsmap.size() > sizeof(uint32_t)) {
+        uint32_t xcda_blob_size;
+        memcpy(&xcda_blob_size, charsmap.data(), sizeof(xcda_blob_size));
+        if ((size_t)xcda_blob_size + sizeof(uint32_t) < charsmap.size()) {
+            xcda.resize(xcda_blob_size / sizeof(uint32_t));
+            memcpy(xcda.data(), charsmap.data() + sizeof(uint32_t), xcda.size() * sizeof(uint32_t));
+            replacements.assign(charsmap.begin() + sizeof(uint32_t) + xcda_blob_size, charsmap.end());
+            replacements.push_back('\0');
+        }
+    }
+
+    const int32_t n_tokens = llama_vocab_n_tokens(vocab);
+    std::vector<std::pair<std::string, int32_t>> matchable;
+    std::vector<std::pair<std::string, int32_t>> user_defined;
+    scores.resize(n_tokens);
+
+    float min_score = FLT_MAX;
+    for (llama_token id = 0; id < n_tokens; id++) {
+        const uint32_t attr = llama_vocab_get_attr(vocab, id);
+        const char* text = llama_vocab_get_text(vocab, id);
+        const float score = llama_vocab_get_score(vocab, id);
+
+        // User-defined pieces score 0 so they win over normal pieces
+        // (whose scores are log probabilities)
+        scores[id] = (attr & LLAMA_TOKEN_ATTR_USER_DEFINED) ? 0.0f : score;
+
+        if (attr & LLAMA_TOKEN_ATTR_NORMAL) {
+            min_score = std::min(min_score, score);
+        }
+        if (!text || !text[0]) {
+            continue;
+        }
+        if (attr & (LLAMA_TOKEN_ATTR_NORMAL | LLAMA_TOKEN_ATTR_USER_DEFINED | LLAMA_TOKEN_ATTR_UNUSED)) {
+            matchable.emplace_back(text, id);
+        }
+        if (attr & LLAMA_TOKEN_ATTR_USER_DEFINED) {
+            user_defined.emplace_back(text, id);
+        }
+    }
+    unknown_token_score = min_score - unknown_token_score_penalty;
+
+    token_matcher.build(std::move(matchable));
+    user_defined_matcher.build(std::move(user_defined));
+
+    build_flat_table();
+}
+
+// True if a charsmap key continues past key, so the longest match at key
+// depends on the bytes that follow it
+bool ugm_tokenizer::charsmap_extends(const char* key, size_t len) const {
+    if (xcda.empty()) {
+        return false;
+    }
+    uint32_t node_index = xcda_base(xcda[0]);
+    for (size_t i = 0; i < len; i++) {
+        const unsigned char c = key[i];
+        if (c == 0) {
+            return false;
+        }
+        node_index ^= c;
+        if (node_index >= xcda.size() || xcda_lcheck(xcda[node_index]) != c) {
+            return false;
+        }
+        node_index ^= xcda_base(xcda[node_index]);
+        if (node_index >= xcda.size()) {
+            return false;
+        }
+    }
+    for (uint32_t c = 1; c < 256; c++) {
+        const uint32_t child = node_index ^ c;
+        if (child < xcda.size() && xcda_lcheck(xcda[child]) == c) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ugm_tokenizer::build_flat_table() {
+    flat.resize(flat_limit);
+    for (uint32_t cpt = 0; cpt < flat_limit; cpt++) {
+        char key[2];
+        size_t key_len;
+        if (cpt < 0x80) {
+            key[0] = (char)cpt;
+            key_len = 1;
+        } else {
+            key[0] = (char)(0xC0 | (cpt >> 6));
+            key[1] = (char)(0x80 | (cpt & 0x3F));
+            key_len = 2;
+        }
+
+        flat_entry& entry = flat[cpt];
+        entry = { 0, 0, 0, FLAT_GENERIC };
+        if (user_defined_matcher.child(double_array_trie::ROOT, (unsigned char)key[0]) >= 0 ||
+            charsmap_extends(key, key_len)) {
+            continue;
+        }
+
+        // Nothing can follow the character in a match, so the generic walk
+        // over the character alone gives its result in any context
+        const normalization_result res = normalize_prefix(key, key_len, 0);
+        entry.length = (uint32_t)res.normalized_len;
+        entry.consumed = (uint8_t)res.consumed_input;
+        if (res.normalized == key) {
+            entry.kind = FLAT_COPY;
+        } else {
+            entry.kind = FLAT_REPLACE;
+            entry.offset = (uint32_t)(res.normalized - replacements.data());
+        }
+    }
+
+    for (uint32_t c = 0; c < 128; c++) {
+        ascii_plain[c] = c != ' ' && flat[c].kind == FLAT_COPY;
+    }
+}
+
+inline const ugm_tokenizer::flat_entry* ugm_tokenizer::flat_lookup(const char* input, size_t len, size_t offset) const {
+    const unsigned char c = input[offset];
+    if (c < 0x80) {
+        return &flat[c];
+    }
+    if (c >= 0xC2 && c < 0xE0 && offset + 1 < len) {
+        return &flat[((c & 0x1F) << 6) | ((unsigned char)input[offset + 1] & 0x3F)];
+    }
+    return nullptr;
+}
+
+ugm_tokenizer::normalization_result ugm_tokenizer::normalize_prefix(const char* input, size_t len, size_t offset) const {
+    if (offset == len) {
+        return { input + offset, 0, 0 };
+    }
+
+    // User-defined pieces pass through unnormalized. Like llama.cpp this
+    // takes the deepest trie match, whether or not it ends on a piece.
+    if (!user_defined_matcher.empty()) {
+        int32_t node = double_array_trie::ROOT;
+        size_t depth = 0;
+        while (offset + depth < len) {
+            node = user_defined_matcher.child(node, (unsigned char)input[offset + depth]);
+            if (node < 0) {
+                break;
+            }
+            depth++;
+        }
+        if (depth > 0) {
+            return { input + offset, depth, depth };
+        }
+    }
+
+    size_t longest_prefix_length = 0;
+    size_t longest_prefix_offset = 0;
+
+    // Longest charsmap match; BASE[s] ^ c gives the child of s on byte c
+    if (!xcda.empty()) {
+        uint32_t node_index = xcda_base(xcda[0]);
+        for (size_t prefix_offset = offset; prefix_offset < len; prefix_offset++) {
+            const unsigned char c = input[prefix_offset];
+            if (c == 0) {
+                break;
+            }
+            node_index ^= c;
+            if (node_index >= xcda.size() || xcda_lcheck(xcda[node_index]) != c) {
+                break;
+            }
+            const bool is_leaf = xcda_is_leaf(xcda[node_index]);
+            node_index ^= xcda_base(xcda[node_index]);
+            if (node_index >= xcda.size()) {
+                break;
+            }
+            if (is_leaf) {
+                longest_prefix_length = prefix_offset - offset + 1;
+                longest_prefix_offset = xcda_value(xcda[node_index]);
+            }
+        }
+    }
+
+    if (longest_prefix_length > 0 && longest_prefix_offset < replacements.size()) {
+        const char* replacement = replacements.data() + longest_prefix_offset;
+        return { replacement, strlen(replacement), longest_prefix_length };
+    }
+
+    // Input is well-formed UTF-8, so the next character passes through as is
+    const size_t n = std::min(utf8_len(input[offset]), len - offset);
+    return { input + offset, n, n };
+}
+
+void ugm_tokenizer::normalize(const char* text, size_t len, std::string& out) const {
+    out.clear();
+    out.reserve(len * 3);
+
+    // llama.cpp always escapes whitespace and never treats it as a suffix
+    const bool shall_prepend_space = add_space_prefix;
+    const bool shall_merge_spaces = remove_extra_whitespaces;
+
+    bool is_space_prepended = false;
+    bool processing_non_ws = false;
+
+    for (size_t offset = 0; offset < len;) {
+        // Runs of plain ASCII copy straight through
+        if ((unsigned char)text[offset] < 0x80 && ascii_plain[(unsigned char)text[offset]]) {
+            size_t end = offset + 1;
+            while (end < len && (unsigned char)text[end] < 0x80 && ascii_plain[(unsigned char)text[end]]) {
+                end++;
+            }
+            if (!processing_non_ws) {
+                processing_non_ws = true;
+                if ((shall_prepend_space && !is_space_prepended) || shall_merge_spaces) {
+                    out.append(escaped_space, 3);
+                    is_space_prepended = true;
+                }
+            }
+            out.append(text + offset, end - offset);
+            offset = end;
+            continue;
+        }
+
+        normalization_result res;
+        const flat_entry* entry = flat_lookup(text, len, offset);
+        if (entry && entry->kind == FLAT_COPY) {
+            res = { text + offset, entry->length, entry->consumed };
+        } else if (entry && entry->kind == FLAT_REPLACE) {
+            res = { replacements.data() + entry->offset, entry->length, entry->consumed };
+        } else {
+            res = normalize_prefix(text, len, offset);
+        }
+        for (size_t i = 0; i < res.normalized_len; i++) {
+            const char c = res.normalized[i];
+            if (c != ' ') {
+                if (!processing_non_ws) {
+                    processing_non_ws = true;
+                    if ((shall_prepend_space && !is_space_prepended) || shall_merge_spaces) {
+                        out.append(escaped_space, 3);
+                        is_space_prepended = true;
+                    }
+                }
+                out.push_back(c);
+            } else {
+                processing_non_ws = false;
+                if (!shall_merge_spaces) {
+                    out.append(escaped_space, 3);
+                }
+            }
+        }
+        offset += res.consumed_input;
+    }
+}
+
+namespace {
+
+struct best_tokenization {
+    llama_token token_id;
+    size_t input_offset;
+    double score_sum;
+};
+
+} // namespace
+
+bool ugm_tokenizer::tokenize(const char* text, size_t len, std::vector<llama_token>& out) const {
+    // Per-thread scratch, reused across calls
+    thread_local std::string normalized;
+    thread_local std::vector<best_tokenization> results;
+
+    trace_span pre_span(LLAMA_TOKENIZER_TRACE_PRE_TOKENIZE, len);
+    normalize(text, len, normalized);
+    pre_span.end();
+    const size_t input_len = normalized.size();
+    if (input_len == 0) {
+        return true;
+    }
+    trace_span model_span(LLAMA_TOKENIZER_TRACE_MODEL, input_len);
+
+    // Scores are rounded through float exactly as llama.cpp stores them
+    results.assign(input_len + 1, { unk_id, 0, -DBL_MAX });
+    results[0] = { unk_id, 0, 0 };
+
+    for (size_t input_offset = 0; input_offset < input_len;) {
+        const size_t n_utf8_code_units = std::min(utf8_len(normalized[input_offset]), input_len - input_offset);
+        const double current_score = results[input_offset].score_sum;
+        bool single_codepoint_token_found = false;
+
+        token_matcher.prefixes(normalized.data() + input_offset, input_len - input_offset,
+            [&](int32_t token_id, size_t length) {
+                if (length == n_utf8_code_units) {
+                    single_codepoint_token_found = true;
+                }
+                const double challenger_score = current_score + (double)scores[token_id];
+                best_tokenization& champ = results[input_offset + length];
+                if (challenger_score > champ.score_sum) {
+                    champ = { token_id, input_offset, (float)challenger_score };
+                }
+            });
+
+        // No piece covers this whole character: use the unknown token
+        if (!single_codepoint_token_found) {
+            const double challenger_score = current_score + unknown_token_score;
+            best_tokenization& champ = results[input_offset + n_utf8_code_units];
+            if (challenger_score > champ.score_sum) {
+                champ = { unk_id, input_offset, (float)challenger_score };
+            }
+        }
+
+        input_offset += n_utf8_code_units;
+    }
+
+    // Backtrack, merging runs of unknown tokens into one
+    const size_t out_size = out.size();
+    bool is_prev_unknown = false;
+    for (size_t offset = input_len;;) {
+        const best_tokenization& t = results[offset];
+        const bool is_unknown = t.token_id == unk_id;
+        if (!(is_prev_unknown && is_unknown)) {
+            out.push_back(t.token_id);
+        }
+        if (t.input_offset == 0) {
+            break;
+        }
+        is_prev_unknown = is_unknown;
+        offset = t.input_offset;
+    }
+    std::reverse(out.begin() + out_size, out.end());
+
+    scratch_trim(normalized);
+    scratch_trim(results);
+    return true;
+}
+
+} // namespace ltok
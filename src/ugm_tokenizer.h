@@ -0,0 +1,74 @@
+#ifndef LLAMA_TOKENIZER_UGM_TOKENIZER_H
+#define LLAMA_TOKENIZER_UGM_TOKENIZER_H
+
+#include "double_array_trie.h"
+#include "native_tokenizer.h"
+#include "vocab_metadata.h"
+
+#include <string>
+
+namespace ltok {
+
+/**
+ * SentencePiece unigram (LLAMA_VOCAB_TYPE_UGM, T5-style)
+ *
+ * Port of llama.cpp's llm_tokenizer_ugm: precompiled-charsmap
+ * normalization followed by a Viterbi search over all pieces. Lattice
+ * edges come from a single double-array trie walk per position.
+ *
+ * Characters below U+0800 (ASCII and the common Latin, Greek and Cyrillic
+ * blocks) are normalized through a flattened table computed from the
+ * charsmap at construction; only characters that can start a longer
+ * charsmap match or a user-defined piece take the generic walk.
+ */
+class ugm_tokenizer final : public native_tokenizer {
+public:
+    ugm_tokenizer(const llama_vocab* vocab, const vocab_metadata& meta);
+
+    bool tokenize(const char* text, size_t len, std::vector<llama_token>& out) const override;
+
+private:
+    struct normalization_result {
+        const char* normalized;
+        size_t normalized_len;
+        size_t consumed_input;
+    };
+
+    // Charsmap result for one character, precomputed for code points
+    // below flat_limit
+    enum flat_kind : uint8_t {
+        FLAT_GENERIC,  // result depends on what follows: use normalize_prefix()
+        FLAT_COPY,     // character passes through unchanged
+        FLAT_REPLACE,  // character maps to replacements[offset..offset+length)
+    };
+    struct flat_entry {
+        uint32_t offset;
+        uint32_t length;
+        uint8_t consumed;
+        flat_kind kind;
+    };
+    static constexpr uint32_t flat_limit = 0x800;
+
+    void build_flat_table();
+    bool charsmap_extends(const char* key, size_t len) const;
+    const flat_entry* flat_lookup(const char* input, size_t len, size_t offset) const;
+
+    void normalize(const char* text, size_t len, std::string& out) const;
+    normalization_result normalize_prefix(const char* input, size_t len, size_t offset) const;
+
+    double_array_trie token_matcher;         // normal, user-defined and unused pieces
+    double_array_trie user_defined_matcher;  // user-defined pieces, passed through unnormalized
+    std::vector<float> scores;               // user-defined pieces score 0
+    std::vector<uint32_t> xcda;              // charsmap: XOR-compressed compact double array
+    std::vector<char> replacements;          // charsmap: NUL-terminated replacement strings
+    std::vector<flat_entry> flat;            // charsmap results below flat_limit
+    bool ascii_plain[128];                   // ASCII bytes that copy through and are not ' '
+    llama_token unk_id;
+    float unknown_token_score;
+    bool add_space_prefix;
+    bool remove_extra_whitespaces;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_UGM_TOKENIZER_H
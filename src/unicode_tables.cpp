@@ -0,0 +1,79 @@
+#include "unicode_tables.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace ltok {
+
+namespace {
+
+struct unicode_flag_range {
+    uint32_t first;  // flags hold up to the next range's first
+    uint8_t flags;
+};
+
+struct unicode_mapping {
+    uint32_t from;
+    uint32_t to;
+};
+
+struct unicode_nfd_range {
+    uint32_t first;
+    uint32_t last;
+    uint32_t nfd;
+};
+
+#include "unicode_tables.inc"
+
+} // namespace
+
+const char* unicode_tables_version() {
+    return generated_unicode_version;
+}
+
+uint8_t unicode_flags(uint32_t cpt) {
+    const auto it = std::upper_bound(std::begin(generated_flag_ranges), std::end(generated_flag_ranges), cpt,
+        [](uint32_t c, const unicode_flag_range& range) { return c < range.first; });
+    return (it == std::begin(generated_flag_ranges)) ? 0 : std::prev(it)->flags;
+}
+
+uint32_t unicode_nfd_first(uint32_t cpt) {
+    const auto it = std::upper_bound(std::begin(generated_nfd_ranges), std::end(generated_nfd_ranges), cpt,
+        [](uint32_t c, const unicode_nfd_range& range) { return c < range.first; });
+    if (it == std::begin(generated_nfd_ranges)) {
+        return cpt;
+    }
+    const unicode_nfd_range& range = *std::prev(it);
+    return (cpt <= range.last) ? range.nfd : cpt;
+}
+
+uint32_t unicode_lowercase(uint32_t cpt) {
+    const auto it = std::lower_bound(std::begin(generated_lowercase), std::end(generated_lowercase), cpt,
+        [](const unicode_mapping& mapping, uint32_t c) { return mapping.from < c; });
+    return (it != std::end(generated_lowercase) && it->from == cpt) ? it->to : cpt;
+}
+
+uint8_t unicode_to_utf8(uint32_t cpt, char out[4]) {
+    if (cpt < 0x80) {
+        out[0] = (char)cpt;
+        return 1;
+    }
+    if (cpt < 0x800) {
+        out[0] = (char)(0xC0 | (cpt >> 6));
+        out[1] = (char)(0x80 | (cpt & 0x3F));
+        return 2;
+    }
+    if (cpt < 0x10000) {
+        out[0] = (char)(0xE0 | (cpt >> 12));
+        out[1] = (char)(0x80 | ((cpt >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cpt & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cpt >> 18));
+    out[1] = (char)(0x80 | ((cpt >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cpt >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cpt & 0x3F));
+    return 4;
+}
+
+} // namespace ltok
@@ -0,0 +1,40 @@
+#ifndef LLAMA_TOKENIZER_UNICODE_TABLES_H
+#define LLAMA_TOKENIZER_UNICODE_TABLES_H
+
+#include <stdint.h>
+
+namespace ltok {
+
+/**
+ * Unicode properties the WordPiece kernel normalizes with
+ *
+ * Vendored so the wrapper needs nothing from llama.cpp beyond llama.h:
+ * src/unicode_tables.inc is generated by scripts/gen_unicode_tables.py
+ * with the same derivation as llama.cpp's own tables. A llama.cpp built
+ * from another Unicode version can disagree; the create-time comparison
+ * then keeps the handle on llama.cpp.
+ */
+enum unicode_flag : uint8_t {
+    UNICODE_CONTROL     = 1,  // general category Cc, Cf, Co or Cs
+    UNICODE_PUNCTUATION = 2,  // P*
+    UNICODE_SYMBOL      = 4,  // S*
+    UNICODE_WHITESPACE  = 8,  // White_Space property
+};
+
+// Unicode version the tables were generated from
+const char* unicode_tables_version();
+
+uint8_t unicode_flags(uint32_t cpt);
+
+// First code point of the canonical decomposition, else cpt
+uint32_t unicode_nfd_first(uint32_t cpt);
+
+// Simple lowercase mapping, else cpt
+uint32_t unicode_lowercase(uint32_t cpt);
+
+// Encode cpt (at most U+10FFFF) as UTF-8 into out; returns the length
+uint8_t unicode_to_utf8(uint32_t cpt, char out[4]);
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_UNICODE_TABLES_H
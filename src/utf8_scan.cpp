@@ -0,0 +1,142 @@
+#include "utf8_scan.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LTOK_UTF8_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LTOK_UTF8_NEON 1
+#endif
+
+namespace ltok {
+
+static inline unsigned ctz32(uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctz(x);
+#else
+    unsigned n = 0;
+    while (!(x & 1u)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+size_t utf8_ascii_prefix(const char* text, size_t len) {
+    const unsigned char* p = (const unsigned char*)text;
+    size_t i = 0;
+
+#if defined(LTOK_UTF8_SSE2)
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(p + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(chunk);
+        if (mask) {
+            return i + ctz32(mask);
+        }
+    }
+#elif defined(LTOK_UTF8_NEON)
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t chunk = vld1q_u8(p + i);
+        if (vmaxvq_u8(chunk) >= 0x80) {
+            break;
+        }
+    }
+#endif
+
+    // Word-at-a-time for the tail (and for targets without SIMD)
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        if (word & 0x8080808080808080ULL) {
+            break;
+        }
+    }
+    while (i < len && p[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+size_t utf8_sequence_len(const char* text, size_t len, size_t* invalid_len) {
+    const unsigned char* p = (const unsigned char*)text;
+    size_t need;
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xBF;
+
+    const unsigned char c = p[0];
+    if (c < 0x80) {
+        return 1;
+    } else if (c >= 0xC2 && c <= 0xDF) {
+        need = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        need = 3;
+        if (c == 0xE0) lo = 0xA0;  // overlong
+        if (c == 0xED) hi = 0x9F;  // surrogates
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        need = 4;
+        if (c == 0xF0) lo = 0x90;  // overlong
+        if (c == 0xF4) hi = 0x8F;  // above U+10FFFF
+    } else {
+        if (invalid_len) *invalid_len = 1;
+        return 0;
+    }
+
+    // Only the first continuation byte has a restricted range
+    size_t i = 1;
+    for (; i < need && i < len; i++) {
+        if (p[i] < lo || p[i] > hi) {
+            break;
+        }
+        lo = 0x80;
+        hi = 0xBF;
+    }
+    if (i == need) {
+        return need;
+    }
+    if (invalid_len) *invalid_len = i;
+    return 0;
+}
+
+utf8_scan_result utf8_scan(const char* text, size_t len) {
+    utf8_scan_result res = { 0, 0 };
+    size_t i = 0;
+    while (i < len) {
+        size_t run = utf8_ascii_prefix(text + i, len - i);
+        i += run;
+        res.n_ascii += run;
+        if (i == len) {
+            break;
+        }
+        size_t seq = utf8_sequence_len(text + i, len - i, NULL);
+        if (seq == 0) {
+            break;
+        }
+        i += seq;
+    }
+    res.valid_len = i;
+    return res;
+}
+
+void utf8_sanitize(const char* text, size_t len, std::string& out) {
+    static const char replacement[] = "\xEF\xBF\xBD";  // U+FFFD
+    out.reserve(out.size() + len + 8);
+    size_t i = 0;
+    while (i < len) {
+        size_t run = utf8_scan(text + i, len - i).valid_len;
+        out.append(text + i, run);
+        i += run;
+        if (i == len) {
+            break;
+        }
+        size_t bad = 1;
+        utf8_sequence_len(text + i, len - i, &bad);
+        out.append(replacement, 3);
+        i += bad;
+    }
+}
+
+} // namespace ltok
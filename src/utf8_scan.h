@@ -0,0 +1,42 @@
+#ifndef LLAMA_TOKENIZER_UTF8_SCAN_H
+#define LLAMA_TOKENIZER_UTF8_SCAN_H
+
+#include <stddef.h>
+#include <string>
+
+namespace ltok {
+
+/**
+ * Result of a UTF-8 pre-scan
+ */
+struct utf8_scan_result {
+    size_t valid_len;  // length of the longest valid UTF-8 prefix
+    size_t n_ascii;    // number of ASCII bytes within the valid prefix
+};
+
+/**
+ * Count the leading ASCII bytes of text (vectorized where available)
+ */
+size_t utf8_ascii_prefix(const char* text, size_t len);
+
+/**
+ * Validate text as UTF-8, skipping ASCII runs in bulk
+ * Overlong encodings, surrogates and code points above U+10FFFF are invalid
+ */
+utf8_scan_result utf8_scan(const char* text, size_t len);
+
+/**
+ * Length of the valid UTF-8 sequence starting at text, or 0 if invalid
+ * Invalid sequences span their maximal invalid subpart (at least one byte),
+ * which is returned through invalid_len when non-NULL
+ */
+size_t utf8_sequence_len(const char* text, size_t len, size_t* invalid_len);
+
+/**
+ * Append text to out, replacing each maximal invalid subpart with U+FFFD
+ */
+void utf8_sanitize(const char* text, size_t len, std::string& out);
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_UTF8_SCAN_H
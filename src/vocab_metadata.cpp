@@ -0,0 +1,65 @@
+#include "vocab_metadata.h"
+#include "gguf.h"
+
+namespace ltok {
+
+static bool get_bool(const gguf_context* ctx, const char* key, bool fallback) {
+    const int64_t id = gguf_find_key(ctx, key);
+    if (id < 0 || gguf_get_kv_type(ctx, id) != GGUF_TYPE_BOOL) {
+        return fallback;
+    }
+    return gguf_get_val_bool(ctx, id);
+}
+
+static llama_token get_token_id(const gguf_context* ctx, const char* key, llama_token fallback) {
+    const int64_t id = gguf_find_key(ctx, key);
+    if (id < 0 || gguf_get_kv_type(ctx, id) != GGUF_TYPE_UINT32) {
+        return fallback;
+    }
+    return (llama_token)gguf_get_val_u32(ctx, id);
+}
+
+bool read_vocab_metadata(const char* model_path, enum llama_vocab_type type, vocab_metadata& out) {
+    gguf_init_params params = { /*no_alloc =*/ true, /*ctx =*/ nullptr };
+    gguf_context* ctx = gguf_init_from_file(model_path, params);
+    if (!ctx) {
+        return false;
+    }
+
+    // Defaults mirror llama_vocab::load()
+    bool default_add_space_prefix = false;
+    llama_token default_unk = LLAMA_TOKEN_NULL;
+    switch (type) {
+        case LLAMA_VOCAB_TYPE_SPM:
+            default_add_space_prefix = true;
+            default_unk = 0;
+            break;
+        case LLAMA_VOCAB_TYPE_UGM:
+            default_unk = 2;
+            break;
+        case LLAMA_VOCAB_TYPE_WPM:
+            default_unk = 100;
+            break;
+        default:
+            break;
+    }
+
+    out.add_space_prefix = get_bool(ctx, "tokenizer.ggml.add_space_prefix", default_add_space_prefix);
+    out.remove_extra_whitespaces = get_bool(ctx, "tokenizer.ggml.remove_extra_whitespaces", false);
+    out.unk_id = get_token_id(ctx, "tokenizer.ggml.unknown_token_id", default_unk);
+
+    out.precompiled_charsmap.clear();
+    const int64_t charsmap_id = gguf_find_key(ctx, "tokenizer.ggml.precompiled_charsmap");
+    if (charsmap_id >= 0 && gguf_get_kv_type(ctx, charsmap_id) == GGUF_TYPE_ARRAY) {
+        const gguf_type elem_type = gguf_get_arr_type(ctx, charsmap_id);
+        if (elem_type == GGUF_TYPE_INT8 || elem_type == GGUF_TYPE_UINT8) {
+            const char* data = (const char*)gguf_get_arr_data(ctx, charsmap_id);
+            out.precompiled_charsmap.assign(data, data + gguf_get_arr_n(ctx, charsmap_id));
+        }
+    }
+
+    gguf_free(ctx);
+    return true;
+}
+
+} // namespace ltok
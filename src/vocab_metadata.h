@@ -0,0 +1,31 @@
+#ifndef LLAMA_TOKENIZER_VOCAB_METADATA_H
+#define LLAMA_TOKENIZER_VOCAB_METADATA_H
+
+#include "llama.h"
+
+#include <vector>
+
+namespace ltok {
+
+/**
+ * Tokenizer settings that llama.cpp keeps private to its vocab
+ *
+ * Read straight from the GGUF metadata, with llama.cpp's defaults
+ * applied for keys the file does not set.
+ */
+struct vocab_metadata {
+    bool add_space_prefix = false;
+    bool remove_extra_whitespaces = false;
+    llama_token unk_id = LLAMA_TOKEN_NULL;
+    std::vector<char> precompiled_charsmap;
+};
+
+/**
+ * Read the metadata for a vocab of the given type. Returns false if the
+ * file cannot be parsed.
+ */
+bool read_vocab_metadata(const char* model_path, enum llama_vocab_type type, vocab_metadata& out);
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_VOCAB_METADATA_H
@@ -0,0 +1,229 @@
+#include "vocab_translator.h"
+#include "scratch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+namespace ltok {
+
+namespace {
+
+bool is_space(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// A cut may go before this piece: a space, then a non-space
+bool starts_with_word(const char* piece, size_t len) {
+    return len >= 2 && piece[0] == ' ' && !is_space((unsigned char)piece[1]);
+}
+
+// Whether tokenizing text puts a space before it, as SPM-style vocabs
+// with a space prefix do (and detokenizing drops it again)
+bool inserts_space(const llama_tokenizer_t* tokenizer) {
+    llama_token tokens[8];
+    const int32_t n = llama_tokenizer_tokenize(tokenizer, "a", 1, tokens, 8, false, false);
+    std::string text;
+    for (int32_t i = 0; i < n; i++) {
+        char piece[64];
+        const int32_t len = llama_tokenizer_token_to_piece(tokenizer, tokens[i], piece, sizeof(piece));
+        if (len > 0) {
+            text.append(piece, (size_t)len);
+        }
+    }
+    return text == " a";
+}
+
+} // namespace
+
+bool vocab_translator::build(const llama_tokenizer_t* from, const piece_index& from_pieces,
+                             const llama_tokenizer_t* target, const llama_vocab* target_vocab, thread_pool* pool) {
+    to = target;
+    pieces = &from_pieces;
+    from_inserts_space = inserts_space(from);
+    to_inserts_space = inserts_space(to);
+    const int32_t n_from = llama_tokenizer_vocab_size(from);
+    if (n_from < 0) {
+        return false;
+    }
+    const size_t n = (size_t)n_from;
+    const size_t skip = to_inserts_space ? 1 : 0;
+
+    try {
+        starts_word.assign(n, 0);
+        offsets.assign(n + 1, 0);
+        to_special.clear();
+        if (to_inserts_space) {
+            // Tokens split out of text even without parse_special
+            to_special.resize((size_t)std::max<int32_t>(llama_vocab_n_tokens(target_vocab), 0));
+            for (size_t id = 0; id < to_special.size(); id++) {
+                to_special[id] = (llama_vocab_get_attr(target_vocab, (llama_token)id) & LLAMA_TOKEN_ATTR_USER_DEFINED) != 0;
+            }
+        }
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+
+    // Count the target tokens of every word piece, then tokenize each
+    // into its slot of one array
+    std::atomic<bool> failed(false);
+    const auto count = [&](size_t begin, size_t end) {
+        for (size_t id = begin; id < end; id++) {
+            size_t len;
+            const char* piece = pieces->piece((llama_token)id, len);
+            if (!starts_with_word(piece, len)) {
+                continue;
+            }
+            starts_word[id] = 1;
+            const int32_t n_tokens = llama_tokenizer_tokenize(to, piece + skip, (int32_t)(len - skip), NULL, 0,
+                                                              false, false);
+            if (n_tokens < 0) {
+                failed.store(true, std::memory_order_relaxed);
+            } else {
+                offsets[id + 1] = (uint32_t)n_tokens;
+            }
+        }
+    };
+    const auto fill = [&](size_t begin, size_t end) {
+        for (size_t id = begin; id < end; id++) {
+            if (!starts_word[id]) {
+                continue;
+            }
+            size_t len;
+            const char* piece = pieces->piece((llama_token)id, len);
+            const int32_t capacity = (int32_t)(offsets[id + 1] - offsets[id]);
+            if (llama_tokenizer_tokenize(to, piece + skip, (int32_t)(len - skip), ids.data() + offsets[id], capacity,
+                                         false, false) != capacity) {
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    const size_t grain = 256;
+    if (pool) {
+        pool->parallel_for(n, grain, count);
+    } else {
+        count(0, n);
+    }
+    uint64_t total = 0;
+    for (size_t id = 0; id < n; id++) {
+        total += offsets[id + 1];
+        offsets[id + 1] = (uint32_t)total;
+    }
+    if (failed.load() || total > UINT32_MAX) {
+        return false;
+    }
+    try {
+        ids.resize((size_t)total);
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    if (pool) {
+        pool->parallel_for(n, grain, fill);
+    } else {
+        fill(0, n);
+    }
+    return !failed.load();
+}
+
+bool vocab_translator::tokenize_piece(const char* text, size_t len, bool text_start,
+                                      std::vector<llama_token>& out) const {
+    if (!text_start && to_inserts_space && len > 0 && text[0] == ' ') {
+        text++;
+        len--;
+    }
+    if (len == 0) {
+        return true;
+    }
+    if (len > (size_t)INT32_MAX - 16) {
+        return false;
+    }
+    const size_t old = out.size();
+    size_t capacity = len + 16;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        out.resize(old + capacity);
+        const int32_t n = llama_tokenizer_tokenize(to, text, (int32_t)len, out.data() + old, (int32_t)capacity,
+                                                   false, false);
+        if (n >= 0) {
+            out.resize(old + (size_t)n);
+            return true;
+        }
+        if ((size_t)-(int64_t)n <= capacity) {
+            break;  // an error, not a short buffer
+        }
+        capacity = (size_t)-(int64_t)n;
+    }
+    out.resize(old);
+    return false;
+}
+
+bool vocab_translator::translate(const llama_token* tokens, size_t n_tokens, bool continuation,
+                                 std::vector<llama_token>& out) const {
+    thread_local std::string segment;
+    thread_local std::string previous;  // text of the segment flushed last
+    segment.clear();
+    previous.clear();
+    size_t segment_tokens = 0;
+    llama_token last = 0;
+    bool text_start = !continuation;
+    bool previous_text_start = false;
+    size_t previous_begin = out.size();
+    bool strip_space = !continuation && from_inserts_space;
+    bool ok = true;
+
+    const auto flush = [&] {
+        size_t begin = out.size();
+        if (segment_tokens == 1 && !text_start && starts_word[(size_t)last]) {
+            out.insert(out.end(), ids.begin() + offsets[(size_t)last], ids.begin() + offsets[(size_t)last + 1]);
+        } else {
+            ok = tokenize_piece(segment.data(), segment.size(), text_start, out);
+        }
+        // A target that inserts a space also inserts one after a token it
+        // splits out of the text, and keeps none before one, so a cut
+        // next to such a token does not hold: tokenize both sides as one
+        if (ok && !to_special.empty() && begin > previous_begin &&
+            (to_special[(size_t)out[begin - 1]] || (out.size() > begin && to_special[(size_t)out[begin]]))) {
+            out.resize(previous_begin);
+            previous.append(segment);
+            ok = tokenize_piece(previous.data(), previous.size(), previous_text_start, out);
+            begin = previous_begin;
+            text_start = previous_text_start;
+        } else {
+            previous.swap(segment);
+        }
+        previous_begin = begin;
+        previous_text_start = text_start;
+        segment.clear();
+        segment_tokens = 0;
+        text_start = false;
+    };
+
+    for (size_t i = 0; i < n_tokens && ok; i++) {
+        size_t len;
+        const char* piece = pieces->piece(tokens[i], len);
+        if (strip_space && len > 0 && piece[0] == ' ') {
+            // Detokenizing drops the space this vocab put before the text,
+            // from the first token only
+            piece++;
+            len--;
+        }
+        strip_space = false;
+        if (len == 0) {
+            continue;
+        }
+        if (!segment.empty() && starts_with_word(piece, len) && !is_space((unsigned char)segment.back())) {
+            flush();
+        }
+        segment.append(piece, len);
+        segment_tokens++;
+        last = tokens[i];
+    }
+    if (ok && !segment.empty()) {
+        flush();
+    }
+    scratch_trim(segment);
+    scratch_trim(previous);
+    return ok;
+}
+
+} // namespace ltok
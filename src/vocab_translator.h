@@ -0,0 +1,64 @@
+#ifndef LLAMA_TOKENIZER_VOCAB_TRANSLATOR_H
+#define LLAMA_TOKENIZER_VOCAB_TRANSLATOR_H
+
+#include "llama_tokenizer.h"
+#include "piece_index.h"
+#include "threadpool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace ltok {
+
+/**
+ * Token translation from one vocab to another without a full round trip
+ *
+ * The text of the source tokens is cut where a space follows a non-space
+ * and precedes a non-space: the pre-tokenizers of the supported vocab
+ * types all start a new pre-token there, so the target tokenizes each
+ * side independently. A piece of text that is one source token is
+ * looked up in a table of its target tokens built up front; only pieces
+ * spanning several tokens (words split across them, runs of punctuation
+ * or newlines) are tokenized. When the target inserts a space before
+ * the text it tokenizes, the space a piece starts with is left to it,
+ * and pieces next to a user-defined token are tokenized together.
+ * Immutable after build(); both tokenizers and the piece index must
+ * outlive it.
+ */
+class vocab_translator {
+public:
+    // to_vocab is to's vocab; pool may be null. False when a tokenize
+    // call fails or memory runs out
+    bool build(const llama_tokenizer_t* from, const piece_index& from_pieces, const llama_tokenizer_t* to,
+               const llama_vocab* to_vocab, thread_pool* pool);
+
+    size_t from_vocab_size() const { return starts_word.size(); }
+
+    /**
+     * Append the target tokens of the text of tokens, as tokenizing the
+     * source detokenization would give them. With continuation the
+     * tokens continue earlier text (and should start a word) rather
+     * than begin it. Ids must be valid; false when tokenizing fails.
+     */
+    bool translate(const llama_token* tokens, size_t n_tokens, bool continuation,
+                   std::vector<llama_token>& out) const;
+
+private:
+    bool tokenize_piece(const char* text, size_t len, bool text_start, std::vector<llama_token>& out) const;
+
+    const llama_tokenizer_t* to = nullptr;
+    const piece_index* pieces = nullptr;
+    bool from_inserts_space = false;  // detokenizing drops the first space
+    bool to_inserts_space = false;    // tokenizing adds a first space
+    std::vector<uint8_t> starts_word;  // per source token: piece is ' ' then a non-space
+    std::vector<uint8_t> to_special;   // per target token, when to_inserts_space: split out of text
+    std::vector<uint32_t> offsets;     // target tokens of source token a: ids[offsets[a], offsets[a + 1])
+    std::vector<llama_token> ids;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_VOCAB_TRANSLATOR_H
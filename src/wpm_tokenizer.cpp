@@ -0,0 +1,163 @@
+#include "wpm_tokenizer.h"
+#include "scratch.h"
+#include "trace.h"
+#include "unicode_tables.h"
+
+#include <utility>
+
+namespace ltok {
+
+// U+2581 (Lower One Eighth Block); word-initial pieces carry it in GGUF
+// WordPiece vocabs in place of the missing "##" continuation marker
+static const char escaped_space[] = "\xE2\x96\x81";
+
+// CJK ideographs, which BERT splits into single-character words
+static bool is_chinese_char(uint32_t cpt) {
+    return (cpt >= 0x04E00 && cpt <= 0x09FFF) ||
+           (cpt >= 0x03400 && cpt <= 0x04DBF) ||
+           (cpt >= 0x20000 && cpt <= 0x2A6DF) ||
+           (cpt >= 0x2A700 && cpt <= 0x2B73F) ||
+           (cpt >= 0x2B740 && cpt <= 0x2B81F) ||
+           (cpt >= 0x2B920 && cpt <= 0x2CEAF) ||  // matches llama.cpp and HF, not 0x2B820
+           (cpt >= 0x0F900 && cpt <= 0x0FAFF) ||
+           (cpt >= 0x2F800 && cpt <= 0x2FA1F);
+}
+
+wpm_tokenizer::wpm_tokenizer(const llama_vocab* vocab, const vocab_metadata& meta)
+    : unk_id(meta.unk_id) {
+    const int32_t n_tokens = llama_vocab_n_tokens(vocab);
+
+    std::vector<std::pair<std::string, int32_t>> entries;
+    entries.reserve(n_tokens);
+    for (llama_token id = 0; id < n_tokens; id++) {
+        const char* text = llama_vocab_get_text(vocab, id);
+        if (text && text[0]) {
+            entries.emplace_back(text, id);
+        }
+    }
+    pieces.build(std::move(entries));
+
+    table.resize(table_limit);
+    for (uint32_t cpt = 0; cpt < table_limit; cpt++) {
+        table[cpt] = classify(cpt);
+    }
+}
+
+// Same decisions, in the same order, as llama.cpp's WPM preprocess()
+wpm_tokenizer::char_info wpm_tokenizer::classify(uint32_t cpt) {
+    char_info info = { CHAR_SKIP, 0, { 0, 0, 0, 0 } };
+
+    const uint32_t nfd = unicode_nfd_first(cpt);
+    const uint8_t flags = unicode_flags(nfd);
+    if (flags & UNICODE_WHITESPACE) {
+        info.cls = CHAR_SPACE;
+        return info;
+    }
+    if (nfd == 0 || nfd == 0xFFFD || (flags & UNICODE_CONTROL)) {
+        return info;
+    }
+
+    info.len = unicode_to_utf8(unicode_lowercase(nfd), info.utf8);
+    info.cls = ((flags & UNICODE_PUNCTUATION) || (nfd < 0x7F && (flags & UNICODE_SYMBOL)) || is_chinese_char(nfd))
+        ? CHAR_SPLIT : CHAR_WORD;
+    return info;
+}
+
+// Greedy longest match over "▁" + word; a word with any unmatched
+// position becomes a single unknown token
+void wpm_tokenizer::tokenize_word(const std::string& word, std::vector<llama_token>& out) const {
+    const size_t out_size = out.size();
+    for (size_t i = 0; i < word.size();) {
+        int32_t match = double_array_trie::NO_VALUE;
+        size_t match_len = 0;
+        pieces.prefixes(word.data() + i, word.size() - i, [&](int32_t id, size_t length) {
+            match = id;
+            match_len = length;
+        });
+        if (match == double_array_trie::NO_VALUE) {
+            out.resize(out_size);
+            break;
+        }
+        out.push_back(match);
+        i += match_len;
+    }
+    if (out.size() == out_size) {
+        out.push_back(unk_id);
+    }
+}
+
+bool wpm_tokenizer::tokenize(const char* text, size_t len, std::vector<llama_token>& out) const {
+    // Words are split and matched in one pass, so both are one model span
+    trace_span span(LLAMA_TOKENIZER_TRACE_MODEL, len);
+    const size_t out_size = out.size();
+
+    // The current word, always starting with the escaped space; per-thread
+    // so steady-state calls do not allocate
+    thread_local std::string word;
+    word.assign(escaped_space, 3);
+
+    auto finish_word = [&]() {
+        if (word.size() > 3) {
+            tokenize_word(word, out);
+            word.resize(3);
+        }
+    };
+
+    for (size_t offset = 0; offset < len;) {
+        const unsigned char c = text[offset];
+        const char_info* info;
+        char_info decoded;
+        if (c < 0x80) {
+            info = &table[c];
+            offset++;
+        } else {
+            uint32_t cpt;
+            size_t n;
+            if (c < 0xE0) {
+                cpt = c & 0x1F;
+                n = 2;
+            } else if (c < 0xF0) {
+                cpt = c & 0x0F;
+                n = 3;
+            } else {
+                cpt = c & 0x07;
+                n = 4;
+            }
+            if (offset + n > len) {
+                out.resize(out_size);
+                return false;
+            }
+            for (size_t i = 1; i < n; i++) {
+                cpt = (cpt << 6) | ((unsigned char)text[offset + i] & 0x3F);
+            }
+            offset += n;
+            if (cpt < table_limit) {
+                info = &table[cpt];
+            } else {
+                decoded = classify(cpt);
+                info = &decoded;
+            }
+        }
+
+        switch (info->cls) {
+            case CHAR_WORD:
+                word.append(info->utf8, info->len);
+                break;
+            case CHAR_SPACE:
+                finish_word();
+                break;
+            case CHAR_SKIP:
+                break;
+            case CHAR_SPLIT:
+                finish_word();
+                word.append(info->utf8, info->len);
+                finish_word();
+                break;
+        }
+    }
+    finish_word();
+    scratch_trim(word);
+    return true;
+}
+
+} // namespace ltok
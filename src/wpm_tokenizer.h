@@ -0,0 +1,54 @@
+#ifndef LLAMA_TOKENIZER_WPM_TOKENIZER_H
+#define LLAMA_TOKENIZER_WPM_TOKENIZER_H
+
+#include "double_array_trie.h"
+#include "native_tokenizer.h"
+#include "vocab_metadata.h"
+
+#include <string>
+
+namespace ltok {
+
+/**
+ * WordPiece (LLAMA_VOCAB_TYPE_WPM, BERT-style)
+ *
+ * Port of llama.cpp's llm_tokenizer_wpm: accent stripping, lowercasing and
+ * punctuation splitting, then a greedy longest match per word. Characters
+ * below U+0800 are normalized through a table built at construction from
+ * the vendored Unicode tables (unicode_tables.h), and each match is one
+ * double-array trie walk instead of a hash lookup per candidate length.
+ */
+class wpm_tokenizer final : public native_tokenizer {
+public:
+    wpm_tokenizer(const llama_vocab* vocab, const vocab_metadata& meta);
+
+    bool tokenize(const char* text, size_t len, std::vector<llama_token>& out) const override;
+
+private:
+    // How a character affects word splitting
+    enum char_class : uint8_t {
+        CHAR_WORD,   // appended to the current word
+        CHAR_SPACE,  // ends the current word
+        CHAR_SKIP,   // dropped (NUL, U+FFFD, controls)
+        CHAR_SPLIT,  // punctuation and CJK: a word of its own
+    };
+
+    // Class and normalized (accent-stripped, lowercased) UTF-8 form
+    struct char_info {
+        char_class cls;
+        uint8_t len;
+        char utf8[4];
+    };
+    static constexpr uint32_t table_limit = 0x800;
+
+    static char_info classify(uint32_t cpt);
+    void tokenize_word(const std::string& word, std::vector<llama_token>& out) const;
+
+    std::vector<char_info> table;  // classify() results below table_limit
+    double_array_trie pieces;      // every token's text, last id wins
+    llama_token unk_id;
+};
+
+} // namespace ltok
+
+#endif // LLAMA_TOKENIZER_WPM_TOKENIZER_H
@@ -95,6 +95,237 @@ else
 fi
 echo ""
 
+echo "=========================================="
+echo "Running: UTF-8 Validation Test"
+echo "=========================================="
+if "$BUILD_DIR/test_utf8_validation" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ UTF-8 validation test passed${NC}"
+else
+    echo -e "${RED}✗ UTF-8 validation test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Thread Safety Test"
+echo "=========================================="
+if "$BUILD_DIR/test_thread_safety" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Thread safety test passed${NC}"
+else
+    echo -e "${RED}✗ Thread safety test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Thread Pool Test"
+echo "=========================================="
+if "$BUILD_DIR/test_threadpool" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Thread pool test passed${NC}"
+else
+    echo -e "${RED}✗ Thread pool test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Request Ring Test"
+echo "=========================================="
+if "$BUILD_DIR/test_ring" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Request ring test passed${NC}"
+else
+    echo -e "${RED}✗ Request ring test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Allocation Test"
+echo "=========================================="
+if "$BUILD_DIR/test_allocations" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Allocation test passed${NC}"
+else
+    echo -e "${RED}✗ Allocation test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Stats Test"
+echo "=========================================="
+if "$BUILD_DIR/test_stats" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Stats test passed${NC}"
+else
+    echo -e "${RED}✗ Stats test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Trace Test"
+echo "=========================================="
+if "$BUILD_DIR/test_trace" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Trace test passed${NC}"
+else
+    echo -e "${RED}✗ Trace test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Log Test"
+echo "=========================================="
+if "$BUILD_DIR/test_log" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Log test passed${NC}"
+else
+    echo -e "${RED}✗ Log test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Estimate Test"
+echo "=========================================="
+if "$BUILD_DIR/test_estimate" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Estimate test passed${NC}"
+else
+    echo -e "${RED}✗ Estimate test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: CSR Batch Test"
+echo "=========================================="
+if "$BUILD_DIR/test_csr" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ CSR batch test passed${NC}"
+else
+    echo -e "${RED}✗ CSR batch test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Padded Batch Test"
+echo "=========================================="
+if "$BUILD_DIR/test_padded" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Padded batch test passed${NC}"
+else
+    echo -e "${RED}✗ Padded batch test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Sequence Packer Test"
+echo "=========================================="
+if "$BUILD_DIR/test_packer" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Sequence packer test passed${NC}"
+else
+    echo -e "${RED}✗ Sequence packer test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Chat Tokenization Test"
+echo "=========================================="
+if "$BUILD_DIR/test_chat" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Chat tokenization test passed${NC}"
+else
+    echo -e "${RED}✗ Chat tokenization test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: FIM Prompt Test"
+echo "=========================================="
+if "$BUILD_DIR/test_fim" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ FIM prompt test passed${NC}"
+else
+    echo -e "${RED}✗ FIM prompt test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Token Healing Test"
+echo "=========================================="
+if "$BUILD_DIR/test_heal" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Token healing test passed${NC}"
+else
+    echo -e "${RED}✗ Token healing test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Grammar Test"
+echo "=========================================="
+if "$BUILD_DIR/test_grammar" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Grammar test passed${NC}"
+else
+    echo -e "${RED}✗ Grammar test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Stop Test"
+echo "=========================================="
+if "$BUILD_DIR/test_stop" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Stop test passed${NC}"
+else
+    echo -e "${RED}✗ Stop test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Translate Test"
+echo "=========================================="
+if "$BUILD_DIR/test_translate" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Translation test passed${NC}"
+else
+    echo -e "${RED}✗ Translation test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Count Multi Test"
+echo "=========================================="
+if "$BUILD_DIR/test_count_multi" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Multi-tokenizer count test passed${NC}"
+else
+    echo -e "${RED}✗ Multi-tokenizer count test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Special Tokens Test"
+echo "=========================================="
+if "$BUILD_DIR/test_special_tokens" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Special token partition test passed${NC}"
+else
+    echo -e "${RED}✗ Special token partition test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
+echo "=========================================="
+echo "Running: Native Kernels Test"
+echo "=========================================="
+if "$BUILD_DIR/test_native_kernels" "$MODEL_PATH"; then
+    echo -e "${GREEN}✓ Native kernel parity test passed${NC}"
+else
+    echo -e "${RED}✗ Native kernel parity test failed${NC}"
+    FAILED=1
+fi
+echo ""
+
 # Summary
 echo "=========================================="
 if [ $FAILED -eq 0 ]; then
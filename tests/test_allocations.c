@@ -0,0 +1,210 @@
+#include "llama_tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#define TEST_PASS(msg) printf(ANSI_COLOR_GREEN "✓ PASS" ANSI_COLOR_RESET ": %s\n", msg)
+#define TEST_FAIL(msg) printf(ANSI_COLOR_RED "✗ FAIL" ANSI_COLOR_RESET ": %s\n", msg)
+
+#define MAX_TOKENS 4096
+#define ROUNDS 50
+
+int test_count = 0;
+int pass_count = 0;
+int fail_count = 0;
+
+#ifdef __GLIBC__
+// Count heap calls by interposing the allocator for the whole process
+// (the executable is linked with exported symbols so the library's and
+// libstdc++'s calls resolve here). Only the thread running the test
+// counts, and only between counting_begin() and counting_end().
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+static _Thread_local int counting = 0;
+static _Thread_local long n_allocations = 0;
+
+void* malloc(size_t size) {
+    if (counting) {
+        n_allocations++;
+    }
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+    if (counting) {
+        n_allocations++;
+    }
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    if (counting) {
+        n_allocations++;
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+static void counting_begin(void) {
+    n_allocations = 0;
+    counting = 1;
+}
+
+static long counting_end(void) {
+    counting = 0;
+    return n_allocations;
+}
+#endif
+
+static const char* const texts[] = {
+    "Hello world",
+    "",
+    " ",
+    "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs.",
+    "for (int i = 0; i < n; ++i) { sum += a[i] * b[i]; }\n",
+    "multiple   spaces\tand\ttabs\n\nand newlines\r\n",
+    "caf\xC3\xA9 na\xC3\xAFve r\xC3\xA9sum\xC3\xA9 \xC3\x80\xC3\x89\xC3\x8E",
+    "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87\xE7\xAB\xA0 \xED\x95\x9C\xEA\xB5\xAD\xEC\x96\xB4",
+    "\xF0\x9F\x98\x80\xF0\x9F\x91\x8D \xE2\x80\x94 \xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82",
+    "invalid \xFF\xFE utf-8 \xC3 in the middle",
+};
+#define N_TEXTS (sizeof(texts) / sizeof(texts[0]))
+
+static llama_token tokens[MAX_TOKENS];
+static char long_text[8 * 1024];  // keeps every scratch buffer under the retain limit
+
+// Every flag combination and both output modes, once per text
+static void tokenize_all(const llama_tokenizer_t* tokenizer) {
+    for (int flags = 0; flags < 4; flags++) {
+        const bool add_special = (flags & 1) != 0;
+        const bool parse_special = (flags & 2) != 0;
+        for (size_t i = 0; i < N_TEXTS; i++) {
+            const int32_t len = (int32_t)strlen(texts[i]);
+            llama_tokenizer_tokenize(tokenizer, texts[i], len, tokens, MAX_TOKENS, add_special, parse_special);
+            llama_tokenizer_tokenize(tokenizer, texts[i], len, NULL, 0, add_special, parse_special);
+        }
+        // Special-token text, whether or not the vocab parses it
+        const char* eos = llama_tokenizer_token_get_text(tokenizer, llama_tokenizer_token_eos(tokenizer));
+        if (eos) {
+            char special_text[256];
+            int n = snprintf(special_text, sizeof(special_text), "before %s after", eos);
+            if (n > 0 && n < (int)sizeof(special_text)) {
+                llama_tokenizer_tokenize(tokenizer, special_text, n, tokens, MAX_TOKENS, add_special, parse_special);
+            }
+        }
+        llama_tokenizer_tokenize(tokenizer, long_text, (int32_t)strlen(long_text), NULL, 0, add_special, parse_special);
+    }
+}
+
+void test_steady_state(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Steady-State Allocations ---\n");
+
+    // Warm up: thread-local buffers grow to the largest input seen
+    tokenize_all(tokenizer);
+
+#ifdef __GLIBC__
+    test_count++;
+    counting_begin();
+    for (int round = 0; round < ROUNDS; round++) {
+        tokenize_all(tokenizer);
+    }
+    const long n = counting_end();
+
+    char msg[160];
+    if (!llama_tokenizer_uses_native_kernel(tokenizer)) {
+        snprintf(msg, sizeof(msg), "Vocab uses llama.cpp (%ld allocations over %d rounds, not enforced)", n, ROUNDS);
+        TEST_PASS(msg);
+        pass_count++;
+    } else if (n == 0) {
+        snprintf(msg, sizeof(msg), "No heap allocations over %d warm rounds", ROUNDS);
+        TEST_PASS(msg);
+        pass_count++;
+    } else {
+        snprintf(msg, sizeof(msg), "Expected no heap allocations over %d warm rounds, saw %ld", ROUNDS, n);
+        TEST_FAIL(msg);
+        fail_count++;
+    }
+#else
+    printf("SKIP: allocation counting needs glibc\n");
+#endif
+}
+
+void test_results_unchanged(const llama_tokenizer_t* tokenizer) {
+    test_count++;
+    printf("\n--- Test: Scratch Reuse Keeps Results ---\n");
+
+    // Tokenizing a long input in between must not disturb short ones
+    llama_token first[MAX_TOKENS];
+    const int32_t len = (int32_t)strlen(texts[3]);
+    int32_t n_first = llama_tokenizer_tokenize(tokenizer, texts[3], len, first, MAX_TOKENS, true, false);
+    llama_tokenizer_tokenize(tokenizer, long_text, (int32_t)strlen(long_text), NULL, 0, true, false);
+    int32_t n_second = llama_tokenizer_tokenize(tokenizer, texts[3], len, tokens, MAX_TOKENS, true, false);
+
+    if (n_first > 0 && n_first == n_second && memcmp(first, tokens, n_first * sizeof(llama_token)) == 0) {
+        TEST_PASS("Same tokens before and after a large input");
+        pass_count++;
+    } else {
+        TEST_FAIL("Tokens should not change after a large input");
+        fail_count++;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Allocation Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", argv[1]);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+    printf("Native kernel: %s\n", llama_tokenizer_uses_native_kernel(tokenizer) ? "yes" : "no");
+
+    size_t pos = 0;
+    while (pos + 128 < sizeof(long_text)) {
+        pos += (size_t)snprintf(long_text + pos, sizeof(long_text) - pos, "%s ", texts[(pos / 7) % N_TEXTS]);
+    }
+
+    test_steady_state(tokenizer);
+    test_results_unchanged(tokenizer);
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
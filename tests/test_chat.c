@@ -0,0 +1,235 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 8192
+#define MAX_TEXT 65536
+
+static llama_token chat_tokens[MAX_TOKENS];
+static llama_token expected[MAX_TOKENS];
+static char text[MAX_TEXT];
+
+// Tokenize the rendered prompt the way a caller would without the fused call
+static int32_t reference_tokens(llama_tokenizer_t* tokenizer, const llama_tokenizer_chat_message* messages,
+                                int32_t n, const llama_tokenizer_chat_params* p) {
+    const int32_t len = llama_tokenizer_apply_chat_template(tokenizer, messages, n, p, text, MAX_TEXT);
+    if (len < 0) {
+        return -1;
+    }
+    return llama_tokenizer_tokenize(tokenizer, text, len, expected, MAX_TOKENS, p->add_special, true);
+}
+
+static int same_tokens(int32_t n_chat, int32_t n_expected) {
+    return n_chat > 0 && n_chat == n_expected &&
+           memcmp(chat_tokens, expected, (size_t)n_chat * sizeof(llama_token)) == 0;
+}
+
+static int count_token(const llama_token* tokens, int32_t n, llama_token token) {
+    int count = 0;
+    for (int32_t i = 0; i < n; i++) {
+        count += tokens[i] == token;
+    }
+    return count;
+}
+
+static const llama_tokenizer_chat_message conversation[] = {
+    { "system", "You are a helpful assistant. Answer briefly." },
+    { "user", "What is the capital of France?" },
+    { "assistant", "Paris." },
+    { "user", "And of Japan? Ünïcödé テキスト, code: for (i = 0; i < n; i++) {}" },
+    { "assistant", "Tokyo." },
+    { "user", "Thanks!\n\nOne more:   what about Peru?  " },
+};
+#define N_CONVERSATION ((int32_t)(sizeof(conversation) / sizeof(conversation[0])))
+
+void test_matches_rendered_prompt(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Matches Rendered Prompt ---\n");
+
+    static const char* templates[] = { "chatml", "gemma" };
+    int ok = 1;
+    for (int t = 0; t < 2; t++) {
+        llama_tokenizer_chat_params p = llama_tokenizer_chat_default_params();
+        p.chat_template = templates[t];
+        for (int special = 0; special < 2; special++) {
+            p.add_special = special;
+            const int32_t n = llama_tokenizer_tokenize_chat(tokenizer, conversation, N_CONVERSATION, &p, NULL,
+                                                            chat_tokens, MAX_TOKENS);
+            ok = ok && same_tokens(n, reference_tokens(tokenizer, conversation, N_CONVERSATION, &p));
+        }
+    }
+    check(ok, "Tokens equal tokenizing the rendered prompt (chatml and gemma)",
+          "Fused tokens differ from the rendered prompt's");
+
+    // gemma trims contents; the rendered text shows it
+    llama_tokenizer_chat_params p = llama_tokenizer_chat_default_params();
+    p.chat_template = "gemma";
+    const int32_t len = llama_tokenizer_apply_chat_template(tokenizer, conversation, N_CONVERSATION, &p, text, MAX_TEXT);
+    check(len > 0 && strstr(text, "what about Peru?<") != NULL && strstr(text, "Peru?  ") == NULL,
+          "Contents the template trims are trimmed",
+          "Trimming template rendered wrongly");
+
+    p.chat_template = "chatml";
+    const int32_t n_count = llama_tokenizer_tokenize_chat(tokenizer, conversation, N_CONVERSATION, &p, NULL, NULL, 0);
+    const int32_t n_small = llama_tokenizer_tokenize_chat(tokenizer, conversation, N_CONVERSATION, &p, NULL,
+                                                          chat_tokens, 4);
+    const int32_t text_len = llama_tokenizer_apply_chat_template(tokenizer, conversation, N_CONVERSATION, &p, NULL, 0);
+    const int32_t text_small = llama_tokenizer_apply_chat_template(tokenizer, conversation, N_CONVERSATION, &p, text, 4);
+    check(n_count > 4 && n_small == -n_count && text_len > 4 && text_small == -text_len,
+          "NULL output counts and a short buffer returns the negative size",
+          "Count or short-buffer results are wrong");
+}
+
+void test_content_specials(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Special Tokens In Content ---\n");
+
+    const llama_token eos = llama_tokenizer_token_eos(tokenizer);
+    const char* eos_text = eos >= 0 ? llama_tokenizer_token_get_text(tokenizer, eos) : NULL;
+    if (!eos_text) {
+        check(1, "No EOS text to inject (skipped)", "");
+        return;
+    }
+    char injected[256];
+    snprintf(injected, sizeof(injected), "stop here%snow", eos_text);
+    const llama_tokenizer_chat_message plain[] = { { "user", "stop herenow" } };
+    const llama_tokenizer_chat_message attack[] = { { "user", injected } };
+
+    llama_tokenizer_chat_params p = llama_tokenizer_chat_default_params();
+    p.chat_template = "chatml";
+    const int32_t n_plain = llama_tokenizer_tokenize_chat(tokenizer, plain, 1, &p, NULL, expected, MAX_TOKENS);
+    const int32_t n_attack = llama_tokenizer_tokenize_chat(tokenizer, attack, 1, &p, NULL, chat_tokens, MAX_TOKENS);
+    check(n_plain > 0 && n_attack > 0 &&
+              count_token(chat_tokens, n_attack, eos) == count_token(expected, n_plain, eos),
+          "A control token's text in content stays text",
+          "Content injected a control token");
+
+    const int plain_eos = count_token(expected, n_plain, eos);
+    p.parse_special_content = true;
+    const int32_t n_parsed = llama_tokenizer_tokenize_chat(tokenizer, attack, 1, &p, NULL, chat_tokens, MAX_TOKENS);
+    const int expect_extra = llama_tokenizer_is_control(tokenizer, eos) ? 1 : 0;
+    check(n_parsed > 0 && same_tokens(n_parsed, reference_tokens(tokenizer, attack, 1, &p)) &&
+              count_token(chat_tokens, n_parsed, eos) == plain_eos + expect_extra,
+          "parse_special_content parses it like the rendered prompt",
+          "parse_special_content result is wrong");
+}
+
+void test_prefix_cache(llama_tokenizer_t* tokenizer, const char* model_path) {
+    printf("\n--- Test: Prefix Cache ---\n");
+
+    llama_tokenizer_chat_params p = llama_tokenizer_chat_default_params();
+    p.chat_template = "chatml";
+    llama_tokenizer_chat_cache_t* cache = llama_tokenizer_chat_cache_create(tokenizer);
+    if (!cache) {
+        check(0, "", "Failed to create a chat cache");
+        return;
+    }
+
+    // Tokens are reused up to the last special token both prompts share,
+    // so there is nothing to reuse unless the ChatML markers are special
+    llama_token marker[4];
+    const int special_markers = llama_tokenizer_tokenize(tokenizer, "<|im_start|>", 12, marker, 4, false, true) == 1;
+
+    // Each turn adds messages; the cached result must equal a fresh one
+    int ok = 1;
+    int reused_growing = 1;
+    for (int32_t n = 2; n <= N_CONVERSATION; n += 2) {
+        const int32_t n_cached = llama_tokenizer_tokenize_chat(tokenizer, conversation, n, &p, cache,
+                                                               chat_tokens, MAX_TOKENS);
+        const int32_t n_fresh = llama_tokenizer_tokenize_chat(tokenizer, conversation, n, &p, NULL,
+                                                              expected, MAX_TOKENS);
+        ok = ok && same_tokens(n_cached, n_fresh);
+        const int32_t reused = llama_tokenizer_chat_cache_reused(cache);
+        reused_growing = reused_growing &&
+                         (n == 2 || !special_markers ? reused == 0 : reused > 0 && reused < n_cached);
+    }
+    check(ok, "Cached results equal uncached ones turn after turn", "Cached tokens differ");
+    check(reused_growing, "Earlier turns are reused when the template's markers are special tokens",
+          "Cache reuse is wrong");
+
+    // An edit in the first message leaves little to reuse but stays correct
+    llama_tokenizer_chat_message edited[N_CONVERSATION];
+    memcpy(edited, conversation, sizeof(edited));
+    edited[0].content = "You are a terse assistant.";
+    const int32_t n_cached = llama_tokenizer_tokenize_chat(tokenizer, edited, N_CONVERSATION, &p, cache,
+                                                           chat_tokens, MAX_TOKENS);
+    const int32_t n_fresh = llama_tokenizer_tokenize_chat(tokenizer, edited, N_CONVERSATION, &p, NULL,
+                                                          expected, MAX_TOKENS);
+    check(same_tokens(n_cached, n_fresh) && llama_tokenizer_chat_cache_reused(cache) < 8,
+          "An edited first message is tokenized again",
+          "Edited conversation is wrong");
+
+    llama_tokenizer_t* other = llama_tokenizer_create(model_path);
+    check(other && llama_tokenizer_tokenize_chat(other, conversation, 2, &p, cache, chat_tokens, MAX_TOKENS) == -1,
+          "A cache is rejected by another tokenizer",
+          "Cache accepted by another tokenizer");
+    llama_tokenizer_destroy(other);
+    llama_tokenizer_chat_cache_free(cache);
+}
+
+void test_invalid_arguments(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Invalid Arguments ---\n");
+
+    llama_tokenizer_chat_params p = llama_tokenizer_chat_default_params();
+    p.chat_template = "chatml";
+    const llama_tokenizer_chat_message no_role[] = { { NULL, "hi" } };
+    const llama_tokenizer_chat_message no_content[] = { { "user", NULL } };
+    check(llama_tokenizer_tokenize_chat(NULL, conversation, 1, &p, NULL, chat_tokens, MAX_TOKENS) == -1 &&
+              llama_tokenizer_tokenize_chat(tokenizer, NULL, 1, &p, NULL, chat_tokens, MAX_TOKENS) == -1 &&
+              llama_tokenizer_tokenize_chat(tokenizer, conversation, -1, &p, NULL, chat_tokens, MAX_TOKENS) == -1 &&
+              llama_tokenizer_tokenize_chat(tokenizer, no_role, 1, &p, NULL, chat_tokens, MAX_TOKENS) == -1 &&
+              llama_tokenizer_apply_chat_template(tokenizer, no_content, 1, &p, text, MAX_TEXT) == -1 &&
+              llama_tokenizer_chat_cache_create(NULL) == NULL && llama_tokenizer_chat_cache_reused(NULL) == -1,
+          "NULL tokenizer, messages, role or content and negative counts return -1",
+          "Invalid arguments accepted");
+
+    p.chat_template = "no-such-template";
+    check(llama_tokenizer_tokenize_chat(tokenizer, conversation, 1, &p, NULL, chat_tokens, MAX_TOKENS) == -1,
+          "An unsupported template returns -1",
+          "Unsupported template accepted");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Chat Tokenization Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        return 1;
+    }
+
+    test_matches_rendered_prompt(tokenizer);
+    test_content_specials(tokenizer);
+    test_prefix_cache(tokenizer, argv[1]);
+    test_invalid_arguments(tokenizer);
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
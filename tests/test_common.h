@@ -0,0 +1,29 @@
+#ifndef LLAMA_TOKENIZER_TEST_COMMON_H
+#define LLAMA_TOKENIZER_TEST_COMMON_H
+
+#include <stdio.h>
+
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#define TEST_PASS(msg) printf(ANSI_COLOR_GREEN "✓ PASS" ANSI_COLOR_RESET ": %s\n", msg)
+#define TEST_FAIL(msg) printf(ANSI_COLOR_RED "✗ FAIL" ANSI_COLOR_RESET ": %s\n", msg)
+
+static int test_count = 0;
+static int pass_count = 0;
+static int fail_count = 0;
+
+// Count one test and print whichever message applies
+static void check(int ok, const char* pass_msg, const char* fail_msg) {
+    test_count++;
+    if (ok) {
+        TEST_PASS(pass_msg);
+        pass_count++;
+    } else {
+        TEST_FAIL(fail_msg);
+        fail_count++;
+    }
+}
+
+#endif // LLAMA_TOKENIZER_TEST_COMMON_H
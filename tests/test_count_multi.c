@@ -0,0 +1,144 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_HANDLES 8
+#define LONG_TEXT 65536
+
+// Counts equal one llama_tokenizer_tokenize() count per handle
+static int counts_match(const llama_tokenizer_t* const* handles, int32_t n_handles, llama_tokenizer_threadpool_t* pool,
+                        const char* text, int32_t text_len, bool add_special, bool parse_special) {
+    int32_t counts[MAX_HANDLES];
+    memset(counts, 0, sizeof(counts));
+    if (llama_tokenizer_count_multi(handles, n_handles, pool, text, text_len, counts, add_special, parse_special) != 0) {
+        return 0;
+    }
+    for (int32_t i = 0; i < n_handles; i++) {
+        const int32_t expected = llama_tokenizer_tokenize(handles[i], text, text_len, NULL, 0, add_special, parse_special);
+        if (counts[i] != expected || expected < 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void test_counts(const llama_tokenizer_t* const* handles, int32_t n_handles) {
+    printf("\n--- Test: Counts Under Each Tokenizer ---\n");
+
+    llama_tokenizer_threadpool_t* pool = llama_tokenizer_threadpool_create(NULL);
+    const char* short_text = "Route this request to the cheapest model that fits. <|user|> ok";
+
+    // Long enough to be fanned out to the pool
+    static char long_text[LONG_TEXT];
+    const char* words[] = { "model ", "router ", "Ünïcödé ", "中文 ", "🚀 ", "123 ", "\n", "<|user|>" };
+    srand(50);
+    int32_t long_len = 0;
+    while (long_len < LONG_TEXT - 16) {
+        const char* word = words[rand() % 8];
+        memcpy(long_text + long_len, word, strlen(word));
+        long_len += (int32_t)strlen(word);
+    }
+
+    int all_match = 1;
+    for (int flags = 0; flags < 4; flags++) {
+        const bool add_special = (flags & 1) != 0;
+        const bool parse_special = (flags & 2) != 0;
+        all_match &= counts_match(handles, n_handles, NULL, short_text, (int32_t)strlen(short_text), add_special,
+                                  parse_special);
+        all_match &= counts_match(handles, n_handles, pool, short_text, (int32_t)strlen(short_text), add_special,
+                                  parse_special);
+        all_match &= counts_match(handles, n_handles, pool, long_text, long_len, add_special, parse_special);
+        all_match &= counts_match(handles, n_handles, NULL, long_text, long_len, add_special, parse_special);
+    }
+    check(all_match, "Each count equals tokenizing with that handle, with and without a pool",
+          "A fan-out count differs from its handle's count");
+
+    // Invalid UTF-8 is replaced once and counted as tokenize() counts it
+    long_text[100] = (char)0xC3;
+    long_text[101] = (char)0x28;
+    long_text[long_len - 1] = (char)0xE2;
+    check(counts_match(handles, n_handles, pool, long_text, long_len, false, false) &&
+              counts_match(handles, n_handles, NULL, "bad \xff\xfe bytes", 12, true, false),
+          "Invalid UTF-8 is counted as llama_tokenizer_tokenize() counts it",
+          "Invalid UTF-8 counted differently");
+
+    check(counts_match(handles, n_handles, pool, "", 0, false, false) &&
+              counts_match(handles, n_handles, pool, "", 0, true, false) &&
+              counts_match(handles, 1, pool, short_text, (int32_t)strlen(short_text), false, false),
+          "Empty text and a single handle are counted",
+          "Empty text or single handle counted wrongly");
+
+    llama_tokenizer_threadpool_destroy(pool);
+}
+
+void test_invalid(const llama_tokenizer_t* const* handles, int32_t n_handles) {
+    printf("\n--- Test: Invalid Arguments ---\n");
+
+    int32_t counts[MAX_HANDLES];
+    const llama_tokenizer_t* with_null[2] = { handles[0], NULL };
+    check(llama_tokenizer_count_multi(NULL, 1, NULL, "text", 4, counts, false, false) == -1 &&
+              llama_tokenizer_count_multi(handles, n_handles, NULL, "text", 4, NULL, false, false) == -1 &&
+              llama_tokenizer_count_multi(handles, n_handles, NULL, NULL, 4, counts, false, false) == -1 &&
+              llama_tokenizer_count_multi(handles, n_handles, NULL, "text", -1, counts, false, false) == -1 &&
+              llama_tokenizer_count_multi(handles, -1, NULL, "text", 4, counts, false, false) == -1 &&
+              llama_tokenizer_count_multi(with_null, 2, NULL, "text", 4, counts, false, false) == -1 &&
+              llama_tokenizer_count_multi(NULL, 0, NULL, "text", 4, NULL, false, false) == 0,
+          "Invalid arguments are rejected, no handles is a no-op",
+          "Invalid fan-out arguments were accepted");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model.gguf> [more-models.gguf...]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Multi-Tokenizer Count Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    // Models given, else the first one loaded several times
+    llama_tokenizer_t* handles[MAX_HANDLES];
+    int32_t n_handles = 0;
+    for (int i = 1; i < argc && n_handles < MAX_HANDLES; i++) {
+        handles[n_handles++] = llama_tokenizer_create(argv[i]);
+    }
+    while (n_handles < 4) {
+        handles[n_handles++] = llama_tokenizer_create(argv[1]);
+    }
+    for (int32_t i = 0; i < n_handles; i++) {
+        if (!handles[i]) {
+            fprintf(stderr, "Failed to create tokenizer\n");
+            return 1;
+        }
+    }
+
+    test_counts((const llama_tokenizer_t* const*)handles, n_handles);
+    test_invalid((const llama_tokenizer_t* const*)handles, n_handles);
+
+    for (int32_t i = 0; i < n_handles; i++) {
+        llama_tokenizer_destroy(handles[i]);
+    }
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
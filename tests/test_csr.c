@@ -0,0 +1,247 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_TEXTS 1000
+
+static const char* phrases[] = {
+    "Hello world",
+    "",
+    "The quick brown fox jumps over the lazy dog.",
+    "Ünïcödé テキスト текст",
+    "for (int i = 0; i < n; i++) { sum += i; }",
+    "a",
+    "1234567890 3.14159",
+};
+
+static char* texts[N_TEXTS];
+static int32_t text_lens[N_TEXTS];
+
+// Text i repeats one phrase i % 13 times, so lengths vary across chunks
+static int make_texts(void) {
+    const int n_phrases = (int)(sizeof(phrases) / sizeof(phrases[0]));
+    for (int i = 0; i < N_TEXTS; i++) {
+        const char* phrase = phrases[i % n_phrases];
+        const size_t len = strlen(phrase);
+        const int repeat = i % 13;
+        texts[i] = malloc(len * (size_t)repeat + 1);
+        if (!texts[i]) {
+            return 0;
+        }
+        for (int r = 0; r < repeat; r++) {
+            memcpy(texts[i] + len * (size_t)r, phrase, len);
+        }
+        text_lens[i] = (int32_t)(len * (size_t)repeat);
+        texts[i][text_lens[i]] = '\0';
+    }
+    return 1;
+}
+
+// Compare a CSR result against tokenizing each text on its own
+static int matches_single_calls(llama_tokenizer_t* tokenizer, const llama_tokenizer_csr_view* view,
+                                const char* const* batch_texts, int32_t n_texts) {
+    if (view->n_texts != n_texts || view->offsets[0] != 0 || view->offsets[n_texts] != view->n_tokens) {
+        return 0;
+    }
+    llama_token buffer[4096];
+    for (int32_t i = 0; i < n_texts; i++) {
+        const int32_t n = llama_tokenizer_tokenize(tokenizer, batch_texts[i], text_lens[i], buffer, 4096, true, false);
+        const int64_t begin = view->offsets[i];
+        const int64_t end = view->offsets[i + 1];
+        if (n < 0 || end - begin != n || memcmp(buffer, view->tokens + begin, (size_t)n * sizeof(llama_token)) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void test_layout(llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    printf("\n--- Test: CSR Layout ---\n");
+
+    llama_tokenizer_csr_t* serial = llama_tokenizer_tokenize_batch_csr(
+        tokenizer, NULL, (const char* const*)texts, text_lens, N_TEXTS, true, false);
+    llama_tokenizer_csr_t* parallel = llama_tokenizer_tokenize_batch_csr(
+        tokenizer, pool, (const char* const*)texts, text_lens, N_TEXTS, true, false);
+    llama_tokenizer_csr_view a;
+    llama_tokenizer_csr_view b;
+    const int got = serial && parallel && llama_tokenizer_csr_get(serial, &a) && llama_tokenizer_csr_get(parallel, &b);
+    check(got, "Batch results created", "Batch result creation failed");
+    if (!got) {
+        llama_tokenizer_csr_free(serial);
+        llama_tokenizer_csr_free(parallel);
+        return;
+    }
+
+    check(matches_single_calls(tokenizer, &a, (const char* const*)texts, N_TEXTS),
+          "Serial offsets and tokens match single calls",
+          "Serial result differs from single calls");
+    check(matches_single_calls(tokenizer, &b, (const char* const*)texts, N_TEXTS),
+          "Pooled offsets and tokens match single calls",
+          "Pooled result differs from single calls");
+    check(a.validity == NULL && a.n_failed == 0 && b.validity == NULL && b.n_failed == 0,
+          "No validity bitmap when every text tokenizes",
+          "Unexpected null texts");
+    check(((uintptr_t)b.tokens % 64) == 0 && ((uintptr_t)b.offsets % 64) == 0,
+          "Buffers are 64-byte aligned",
+          "Buffers are not 64-byte aligned");
+
+    llama_tokenizer_csr_free(serial);
+    llama_tokenizer_csr_free(parallel);
+}
+
+void test_failed_texts(llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    printf("\n--- Test: Failed Texts ---\n");
+
+    // A NULL text fails on its own and becomes a null entry
+    const char* batch_texts[N_TEXTS];
+    for (int i = 0; i < N_TEXTS; i++) {
+        batch_texts[i] = i % 100 == 7 ? NULL : texts[i];
+    }
+    llama_tokenizer_csr_t* csr = llama_tokenizer_tokenize_batch_csr(
+        tokenizer, pool, batch_texts, text_lens, N_TEXTS, true, false);
+    llama_tokenizer_csr_view view;
+    if (!csr || !llama_tokenizer_csr_get(csr, &view)) {
+        check(0, "", "Batch with failed texts was rejected");
+        llama_tokenizer_csr_free(csr);
+        return;
+    }
+
+    int bits_ok = view.validity != NULL && view.n_failed == N_TEXTS / 100;
+    for (int i = 0; bits_ok && i < N_TEXTS; i++) {
+        const int valid = (view.validity[i / 8] >> (i % 8)) & 1;
+        const int empty = view.offsets[i + 1] == view.offsets[i];
+        if (valid != (batch_texts[i] != NULL) || (!valid && !empty)) {
+            bits_ok = 0;
+        }
+    }
+    check(bits_ok, "Failed texts are empty and marked null", "Validity bitmap is wrong");
+
+    llama_tokenizer_csr_free(csr);
+}
+
+void test_arrow_export(llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    printf("\n--- Test: Arrow Export ---\n");
+
+    llama_tokenizer_csr_t* csr = llama_tokenizer_tokenize_batch_csr(
+        tokenizer, pool, (const char* const*)texts, text_lens, N_TEXTS, true, false);
+    llama_tokenizer_csr_view view;
+    struct ArrowArray array;
+    struct ArrowSchema schema;
+    if (!csr || !llama_tokenizer_csr_get(csr, &view) || !llama_tokenizer_csr_export_arrow(csr, &array, &schema)) {
+        check(0, "", "Export failed");
+        llama_tokenizer_csr_free(csr);
+        return;
+    }
+
+    check(strcmp(schema.format, "+L") == 0 && schema.n_children == 1 &&
+              strcmp(schema.children[0]->format, "i") == 0 && (schema.flags & ARROW_FLAG_NULLABLE),
+          "Schema is a nullable LargeList<Int32>",
+          "Unexpected schema");
+    check(array.length == N_TEXTS && array.null_count == 0 && array.n_buffers == 2 && array.n_children == 1 &&
+              array.buffers[1] == view.offsets && array.children[0]->length == view.n_tokens &&
+              array.children[0]->buffers[1] == view.tokens,
+          "Array points at the CSR buffers without copying",
+          "Array does not match the CSR buffers");
+
+    // The array keeps the buffers alive after the handle is gone; move the
+    // child out the way a consumer may, and release it last
+    const int64_t last_offset = view.offsets[N_TEXTS];
+    llama_tokenizer_csr_free(csr);
+    struct ArrowArray child = *array.children[0];
+    array.children[0]->release = NULL;
+    const int64_t* offsets = (const int64_t*)array.buffers[1];
+    const int still_valid = offsets[N_TEXTS] == last_offset && child.length == last_offset;
+    array.release(&array);
+    const llama_token* tokens = (const llama_token*)child.buffers[1];
+    volatile llama_token sink = child.length > 0 ? tokens[child.length - 1] : 0;
+    (void)sink;
+    child.release(&child);
+    schema.release(&schema);
+    check(still_valid && array.release == NULL && child.release == NULL && schema.release == NULL,
+          "Exported structs outlive the handle and release cleanly",
+          "Export lifetime or release is wrong");
+}
+
+void test_edge_cases(llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    printf("\n--- Test: Edge Cases ---\n");
+
+    llama_tokenizer_csr_t* empty = llama_tokenizer_tokenize_batch_csr(tokenizer, pool, NULL, NULL, 0, true, false);
+    llama_tokenizer_csr_view view;
+    struct ArrowArray array;
+    check(empty && llama_tokenizer_csr_get(empty, &view) && view.n_texts == 0 && view.n_tokens == 0 &&
+              view.offsets[0] == 0 && view.tokens != NULL && llama_tokenizer_csr_export_arrow(empty, &array, NULL),
+          "Empty batch gives one offset and non-null buffers",
+          "Empty batch handled wrong");
+    if (empty) {
+        array.release(&array);
+    }
+    llama_tokenizer_csr_free(empty);
+
+    check(llama_tokenizer_tokenize_batch_csr(NULL, pool, (const char* const*)texts, text_lens, 1, true, false) == NULL &&
+              llama_tokenizer_tokenize_batch_csr(tokenizer, pool, NULL, text_lens, 1, true, false) == NULL &&
+              llama_tokenizer_tokenize_batch_csr(tokenizer, pool, (const char* const*)texts, text_lens, -1, true, false) == NULL,
+          "Invalid arguments return NULL",
+          "Invalid arguments accepted");
+    check(!llama_tokenizer_csr_get(NULL, &view) && !llama_tokenizer_csr_export_arrow(NULL, &array, NULL),
+          "NULL handle rejected",
+          "NULL handle accepted");
+    llama_tokenizer_csr_free(NULL);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== CSR Batch Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        return 1;
+    }
+    llama_tokenizer_threadpool_params params = llama_tokenizer_threadpool_default_params();
+    params.n_threads = 4;
+    llama_tokenizer_threadpool_t* pool = llama_tokenizer_threadpool_create(&params);
+    if (!pool || !make_texts()) {
+        fprintf(stderr, "Setup failed\n");
+        return 1;
+    }
+
+    test_layout(tokenizer, pool);
+    test_failed_texts(tokenizer, pool);
+    test_arrow_export(tokenizer, pool);
+    test_edge_cases(tokenizer, pool);
+
+    for (int i = 0; i < N_TEXTS; i++) {
+        free(texts[i]);
+    }
+    llama_tokenizer_threadpool_destroy(pool);
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
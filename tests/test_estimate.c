@@ -0,0 +1,165 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Ordinary text of the kinds the estimate is meant for; none of it is
+// part of the calibration corpus
+static const char* samples[] = {
+    "Admission control needs a token count before the request is accepted, "
+    "so the estimate has to be cheap compared to tokenizing the input.",
+    "Der Zug nach München fährt um halb neun vom Gleis drei ab.",
+    "Москва — столица России, крупнейший по численности населения город страны.",
+    "東京は日本の首都であり、世界有数の大都市である。",
+    "for (size_t i = 0; i < n; ++i) { total += values[i] * weights[i]; }",
+    "{\"id\": 4182, \"name\": \"sensor-7\", \"readings\": [21.5, 21.7, 22.0]}",
+    "Release 3.14.2 fixed 27 bugs; see https://example.com/changes#v3-14-2.",
+    "Ça coûte 12,50 € — c'est très raisonnable pour un déjeuner à Paris.",
+};
+
+static int32_t exact_count(llama_tokenizer_t* tokenizer, const char* text, int32_t len, bool add_special) {
+    return llama_tokenizer_tokenize(tokenizer, text, len, NULL, 0, add_special, false);
+}
+
+void test_bounds(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Exact Count Within Bounds ---\n");
+
+    const int n_samples = (int)(sizeof(samples) / sizeof(samples[0]));
+    int within = 0;
+    int close = 0;
+    for (int i = 0; i < n_samples; i++) {
+        const int32_t len = (int32_t)strlen(samples[i]);
+        int32_t lower = -1;
+        int32_t upper = -1;
+        const int32_t estimate = llama_tokenizer_estimate_count(tokenizer, samples[i], len, false, &lower, &upper);
+        const int32_t exact = exact_count(tokenizer, samples[i], len, false);
+        printf("  sample %d: estimate %d [%d, %d], exact %d\n", i, estimate, lower, upper, exact);
+        if (lower <= estimate && estimate <= upper && lower <= exact && exact <= upper) {
+            within++;
+        }
+        // Loose: a quarter of the count, or a few tokens for short texts
+        const int32_t diff = estimate > exact ? estimate - exact : exact - estimate;
+        if (diff <= exact / 4 + 3) {
+            close++;
+        }
+    }
+    check(within == n_samples, "Exact counts fall within the bounds", "Exact count outside the bounds");
+    check(close == n_samples, "Estimates are close to exact counts", "Estimate far from the exact count");
+}
+
+void test_long_text(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Long Text ---\n");
+
+    // Many samples back to back: the error should not grow with length
+    size_t total = 0;
+    for (int r = 0; r < 64; r++) {
+        for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+            total += strlen(samples[i]) + 1;
+        }
+    }
+    char* text = malloc(total + 1);
+    if (!text) {
+        check(0, "", "Allocation failed");
+        return;
+    }
+    size_t pos = 0;
+    for (int r = 0; r < 64; r++) {
+        for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+            const size_t len = strlen(samples[i]);
+            memcpy(text + pos, samples[i], len);
+            text[pos + len] = '\n';
+            pos += len + 1;
+        }
+    }
+    text[pos] = '\0';
+
+    int32_t lower = -1;
+    int32_t upper = -1;
+    const int32_t estimate = llama_tokenizer_estimate_count(tokenizer, text, (int32_t)pos, false, &lower, &upper);
+    const int32_t exact = exact_count(tokenizer, text, (int32_t)pos, false);
+    printf("  %zu bytes: estimate %d [%d, %d], exact %d\n", pos, estimate, lower, upper, exact);
+    check(lower <= exact && exact <= upper, "Long text count within the bounds", "Long text count outside the bounds");
+
+    // A long whitespace run, which normalizing vocabs fold into few tokens
+    memset(text, ' ', 4096);
+    llama_tokenizer_estimate_count(tokenizer, text, 4096, false, &lower, NULL);
+    const int32_t run_exact = exact_count(tokenizer, text, 4096, false);
+    printf("  4096 spaces: lower %d, exact %d\n", lower, run_exact);
+    check(lower <= run_exact, "A folded whitespace run is not floored above its count",
+          "Lower bound of a whitespace run exceeds its count");
+    free(text);
+}
+
+void test_special_and_empty(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Special Tokens And Empty Text ---\n");
+
+    int32_t lower = -1;
+    int32_t upper = -1;
+    const int32_t empty = llama_tokenizer_estimate_count(tokenizer, "", 0, false, &lower, &upper);
+    check(empty == 0 && lower == 0 && upper == 0, "Empty text estimates to zero", "Empty text estimate is not zero");
+
+    const int32_t n_affix = exact_count(tokenizer, "", 0, true);
+    const int32_t len = (int32_t)strlen(samples[0]);
+    const int32_t plain = llama_tokenizer_estimate_count(tokenizer, samples[0], len, false, NULL, NULL);
+    const int32_t with_special = llama_tokenizer_estimate_count(tokenizer, samples[0], len, true, &lower, &upper);
+    check(with_special == plain + n_affix && lower <= with_special && with_special <= upper,
+          "add_special adds the BOS/EOS tokens",
+          "add_special estimate does not match");
+}
+
+void test_invalid_arguments(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Invalid Arguments ---\n");
+
+    check(llama_tokenizer_estimate_count(NULL, "abc", 3, false, NULL, NULL) == -1,
+          "NULL tokenizer returns -1", "NULL tokenizer accepted");
+    check(llama_tokenizer_estimate_count(tokenizer, NULL, 3, false, NULL, NULL) == -1,
+          "NULL text returns -1", "NULL text accepted");
+    check(llama_tokenizer_estimate_count(tokenizer, "abc", -1, false, NULL, NULL) == -1,
+          "Negative length returns -1", "Negative length accepted");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Estimate Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        return 1;
+    }
+
+    test_bounds(tokenizer);
+    test_long_text(tokenizer);
+    test_special_and_empty(tokenizer);
+    test_invalid_arguments(tokenizer);
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
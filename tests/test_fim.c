@@ -0,0 +1,195 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 65536
+#define MAX_TEXT 65536
+#define BUDGET 512
+
+static llama_token fim_tokens[MAX_TOKENS];
+static llama_token prefix_full[MAX_TOKENS];
+static llama_token suffix_full[MAX_TOKENS];
+static char source[MAX_TEXT];
+
+// A source file of about MAX_TEXT / 2 bytes with varied lines
+static size_t build_source(void) {
+    size_t len = 0;
+    for (int i = 0; len + 256 < MAX_TEXT / 2; i++) {
+        len += (size_t)snprintf(source + len, MAX_TEXT - len,
+                                "static int step_%d(int x) {\n"
+                                "    // scale by %d; ünïcödé コメント\n"
+                                "    return x * %d + (x >> %d);\n"
+                                "}\n\n",
+                                i, i % 7 + 2, i % 7 + 2, i % 5);
+    }
+    return len;
+}
+
+static int same(const llama_token* a, const llama_token* b, int32_t n) {
+    return n >= 0 && memcmp(a, b, (size_t)n * sizeof(llama_token)) == 0;
+}
+
+// Check the layout of a FIM result against the sides tokenized whole
+static int check_layout(llama_tokenizer_t* tokenizer, int32_t n, const llama_tokenizer_fim_info* info,
+                        int32_t n_prefix_full, int32_t n_suffix_full, int suffix_first) {
+    const int32_t n_bos = llama_tokenizer_should_add_bos(tokenizer) ? 1 : 0;
+    const int32_t np = info->n_prefix_tokens;
+    const int32_t ns = info->n_suffix_tokens;
+    if (n != n_bos + 3 + np + ns || np > n_prefix_full || ns > n_suffix_full) {
+        return 0;
+    }
+    const llama_token* p = fim_tokens + n_bos + 1 + (suffix_first ? ns + 1 : 0);
+    const llama_token* s = fim_tokens + n_bos + 1 + (suffix_first ? 0 : np + 1);
+    return (!n_bos || fim_tokens[0] == llama_tokenizer_token_bos(tokenizer)) &&
+           p[-1] == llama_tokenizer_token_fim_pre(tokenizer) &&
+           s[-1] == llama_tokenizer_token_fim_suf(tokenizer) &&
+           fim_tokens[n - 1] == llama_tokenizer_token_fim_mid(tokenizer) &&
+           same(p, prefix_full + (n_prefix_full - np), np) &&
+           same(s, suffix_full, ns) &&
+           info->prefix_truncated == (np < n_prefix_full) &&
+           info->suffix_truncated == (ns < n_suffix_full);
+}
+
+void test_fits_whole(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Short Sides Kept Whole ---\n");
+
+    const char* prefix = "def add(a, b):\n    return ";
+    const char* suffix = "\n\nprint(add(1, 2))\n";
+    const int32_t np = llama_tokenizer_tokenize(tokenizer, prefix, (int32_t)strlen(prefix), prefix_full,
+                                                MAX_TOKENS, false, false);
+    const int32_t ns = llama_tokenizer_tokenize(tokenizer, suffix, (int32_t)strlen(suffix), suffix_full,
+                                                MAX_TOKENS, false, false);
+
+    llama_tokenizer_fim_info info;
+    int32_t n_psm = 0;
+    int ok = 1;
+    for (int suffix_first = 0; suffix_first < 2; suffix_first++) {
+        llama_tokenizer_fim_params p = llama_tokenizer_fim_default_params();
+        p.suffix_first = suffix_first;
+        const int32_t n = llama_tokenizer_tokenize_fim(tokenizer, prefix, (int32_t)strlen(prefix), suffix,
+                                                       (int32_t)strlen(suffix), &p, fim_tokens, BUDGET, &info);
+        ok = ok && check_layout(tokenizer, n, &info, np, ns, suffix_first) &&
+             info.n_prefix_tokens == np && info.n_suffix_tokens == ns;
+        n_psm = suffix_first ? n_psm : n;
+    }
+    check(ok, "Both sides fit: PSM and SPM hold every token",
+          "Short FIM prompt is wrong");
+
+    const int32_t n_count = llama_tokenizer_tokenize_fim(tokenizer, prefix, (int32_t)strlen(prefix), suffix,
+                                                         (int32_t)strlen(suffix), NULL, NULL, BUDGET, NULL);
+    const int32_t n_empty = llama_tokenizer_tokenize_fim(tokenizer, "", 0, NULL, 0, NULL, fim_tokens, BUDGET, &info);
+    check(n_count == n_psm && n_empty == (llama_tokenizer_should_add_bos(tokenizer) ? 4 : 3),
+          "NULL output counts and empty sides leave only the special tokens",
+          "Count or empty-side result is wrong");
+}
+
+void test_truncation(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Truncation At The Budget ---\n");
+
+    const size_t len = build_source();
+    const size_t cursor = len / 2 + 3;  // inside a line
+    const char* prefix = source;
+    const char* suffix = source + cursor;
+    const int32_t prefix_len = (int32_t)cursor;
+    const int32_t suffix_len = (int32_t)(len - cursor);
+    const int32_t np = llama_tokenizer_tokenize(tokenizer, prefix, prefix_len, prefix_full, MAX_TOKENS, false, false);
+    const int32_t ns = llama_tokenizer_tokenize(tokenizer, suffix, suffix_len, suffix_full, MAX_TOKENS, false, false);
+    const int32_t n_bos = llama_tokenizer_should_add_bos(tokenizer) ? 1 : 0;
+    const int32_t available = BUDGET - n_bos - 3;
+
+    llama_tokenizer_fim_info info;
+    int32_t n = llama_tokenizer_tokenize_fim(tokenizer, prefix, prefix_len, suffix, suffix_len, NULL,
+                                             fim_tokens, BUDGET, &info);
+    check(np > BUDGET && ns > BUDGET && n == BUDGET && check_layout(tokenizer, n, &info, np, ns, 0) &&
+              info.n_suffix_tokens == available / 4,
+          "Both sides cut to the budget: prefix tail and suffix head, a quarter for the suffix",
+          "Truncated FIM prompt is wrong");
+
+    // A short side leaves its share to the other
+    n = llama_tokenizer_tokenize_fim(tokenizer, prefix, prefix_len, "}\n", 2, NULL, fim_tokens, BUDGET, &info);
+    const int32_t n_short = llama_tokenizer_tokenize(tokenizer, "}\n", 2, suffix_full, MAX_TOKENS, false, false);
+    const int short_suffix_ok = n == BUDGET && info.n_suffix_tokens == n_short && !info.suffix_truncated;
+    llama_tokenizer_tokenize(tokenizer, suffix, suffix_len, suffix_full, MAX_TOKENS, false, false);
+    n = llama_tokenizer_tokenize_fim(tokenizer, "x = ", 4, suffix, suffix_len, NULL, fim_tokens, BUDGET, &info);
+    check(short_suffix_ok && n == BUDGET && !info.prefix_truncated && info.suffix_truncated &&
+              info.n_suffix_tokens > available / 2 && same(fim_tokens + n - 1 - info.n_suffix_tokens,
+                                                           suffix_full, info.n_suffix_tokens),
+          "A short side leaves the rest of the budget to the other",
+          "Unused share was not passed on");
+
+    // Whole budget to one side
+    llama_tokenizer_fim_params p = llama_tokenizer_fim_default_params();
+    p.suffix_share = 1.0f;
+    p.suffix_first = true;
+    n = llama_tokenizer_tokenize_fim(tokenizer, prefix, prefix_len, suffix, suffix_len, &p, fim_tokens, BUDGET, &info);
+    check(n == BUDGET && info.n_prefix_tokens == 0 && info.n_suffix_tokens == available &&
+              check_layout(tokenizer, n, &info, np, ns, 1),
+          "suffix_share 1 gives the suffix the whole budget in SPM order",
+          "suffix_share 1 result is wrong");
+}
+
+void test_invalid_arguments(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Invalid Arguments ---\n");
+
+    llama_tokenizer_fim_params p = llama_tokenizer_fim_default_params();
+    p.suffix_share = 1.5f;
+    check(llama_tokenizer_tokenize_fim(NULL, "a", 1, "b", 1, NULL, fim_tokens, BUDGET, NULL) == -1 &&
+              llama_tokenizer_tokenize_fim(tokenizer, NULL, 1, "b", 1, NULL, fim_tokens, BUDGET, NULL) == -1 &&
+              llama_tokenizer_tokenize_fim(tokenizer, "a", -1, "b", 1, NULL, fim_tokens, BUDGET, NULL) == -1 &&
+              llama_tokenizer_tokenize_fim(tokenizer, "a", 1, "b", 1, &p, fim_tokens, BUDGET, NULL) == -1 &&
+              llama_tokenizer_tokenize_fim(tokenizer, "a", 1, "b", 1, NULL, fim_tokens, 2, NULL) == -1,
+          "Bad arguments, a bad share and a budget below the special tokens return -1",
+          "Invalid arguments were accepted");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model.gguf>\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== FIM Prompt Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        return 1;
+    }
+
+    if (llama_tokenizer_token_fim_pre(tokenizer) < 0 || llama_tokenizer_token_fim_suf(tokenizer) < 0 ||
+        llama_tokenizer_token_fim_mid(tokenizer) < 0) {
+        check(llama_tokenizer_tokenize_fim(tokenizer, "a", 1, "b", 1, NULL, fim_tokens, BUDGET, NULL) == -1,
+              "A vocab without FIM tokens returns -1 (other tests skipped)",
+              "FIM prompt built without FIM tokens");
+    } else {
+        test_fits_whole(tokenizer);
+        test_truncation(tokenizer);
+        test_invalid_arguments(tokenizer);
+    }
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
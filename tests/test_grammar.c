@@ -0,0 +1,329 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 1024
+#define MAX_CANDIDATES 4096
+
+static llama_token path[MAX_TOKENS];
+static llama_token candidates[MAX_CANDIDATES];
+
+static int allowed(const llama_tokenizer_grammar_t* grammar, int32_t state, llama_token token) {
+    const uint64_t* mask = llama_tokenizer_grammar_mask(grammar, state);
+    return mask && ((mask[token / 64] >> (token % 64)) & 1);
+}
+
+// Tokens spelling text exactly: the longest piece at each position
+static int32_t spell(llama_tokenizer_t* tokenizer, const char* text) {
+    const int32_t len = (int32_t)strlen(text);
+    int32_t n = 0;
+    for (int32_t pos = 0; pos < len && n < MAX_TOKENS;) {
+        const int32_t n_candidates = llama_tokenizer_tokens_prefix_of(tokenizer, text + pos, len - pos,
+                                                                      candidates, MAX_CANDIDATES);
+        if (n_candidates <= 0) {
+            return -1;
+        }
+        const llama_token longest = candidates[n_candidates - 1];
+        char piece[256];
+        const int32_t piece_len = llama_tokenizer_token_to_piece(tokenizer, longest, piece, sizeof(piece));
+        if (piece_len <= 0) {
+            return -1;
+        }
+        path[n++] = longest;
+        pos += piece_len;
+    }
+    return n;
+}
+
+// Walk text through the grammar, checking each token against its mask;
+// returns the final state, or -1 once a token is refused
+static int32_t walk(llama_tokenizer_t* tokenizer, const llama_tokenizer_grammar_t* grammar, const char* text) {
+    const int32_t n = spell(tokenizer, text);
+    int32_t state = n >= 0 ? 0 : -1;
+    for (int32_t i = 0; i < n && state >= 0; i++) {
+        const int32_t next = llama_tokenizer_grammar_advance(grammar, state, path[i]);
+        if ((next >= 0) != allowed(grammar, state, path[i])) {
+            return -2;  // mask and advance disagree
+        }
+        state = next;
+    }
+    return state;
+}
+
+static int matches(llama_tokenizer_t* tokenizer, const llama_tokenizer_grammar_t* grammar, const char* text) {
+    const int32_t state = walk(tokenizer, grammar, text);
+    return state >= 0 && llama_tokenizer_grammar_is_accepting(grammar, state);
+}
+
+// Every bit of every mask agrees with llama_tokenizer_grammar_advance()
+static int masks_agree(llama_tokenizer_t* tokenizer, const llama_tokenizer_grammar_t* grammar) {
+    const int32_t n_vocab = llama_tokenizer_vocab_size(tokenizer);
+    const int32_t n_states = llama_tokenizer_grammar_n_states(grammar);
+    for (int32_t state = 0; state < n_states && state < 64; state++) {
+        for (llama_token token = 0; token < n_vocab; token++) {
+            if ((llama_tokenizer_grammar_advance(grammar, state, token) >= 0) != allowed(grammar, state, token)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+void test_regex(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Regex Grammar ---\n");
+
+    const char* pattern = "[0-9]{3}-[0-9]{4}( ext\\. [0-9]+)?";
+    char error[256] = "";
+    llama_tokenizer_grammar_t* grammar = llama_tokenizer_grammar_from_regex(tokenizer, pattern, (int32_t)strlen(pattern),
+                                                                            NULL, NULL, error, sizeof(error));
+    if (!grammar) {
+        printf("  error: %s\n", error);
+        check(0, "", "Regex grammar failed to compile");
+        return;
+    }
+
+    check(matches(tokenizer, grammar, "555-1234") && matches(tokenizer, grammar, "555-1234 ext. 42") &&
+              !matches(tokenizer, grammar, "555-123") && walk(tokenizer, grammar, "55a") == -1 &&
+              walk(tokenizer, grammar, "555-1234 ext. x") == -1,
+          "Matching text walks to an accepting state, other text is refused",
+          "Regex grammar accepted or refused the wrong text");
+
+    const llama_token eos = llama_tokenizer_token_eos(tokenizer);
+    const int32_t end = walk(tokenizer, grammar, "555-1234");
+    check(eos < 0 || (allowed(grammar, end, eos) && !allowed(grammar, 0, eos) &&
+                      llama_tokenizer_grammar_advance(grammar, end, eos) == end),
+          "End of generation is allowed only once the text is complete",
+          "EOS allowed in the wrong states");
+
+    check(masks_agree(tokenizer, grammar), "Every mask bit agrees with advance()",
+          "A mask disagrees with advance()");
+    llama_tokenizer_grammar_free(grammar);
+}
+
+void test_json_schema(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: JSON Schema Grammar ---\n");
+
+    const char* schema =
+        "{\"type\": \"object\", \"properties\": {"
+        "\"name\": {\"type\": \"string\", \"maxLength\": 16},"
+        "\"age\": {\"type\": \"integer\"},"
+        "\"tags\": {\"type\": \"array\", \"items\": {\"enum\": [\"red\", \"green\"]}, \"maxItems\": 2}},"
+        "\"required\": [\"name\", \"age\"]}";
+    char error[256] = "";
+    llama_tokenizer_threadpool_t* pool = llama_tokenizer_threadpool_create(NULL);
+    llama_tokenizer_grammar_t* grammar = llama_tokenizer_grammar_from_json_schema(
+        tokenizer, schema, (int32_t)strlen(schema), NULL, NULL, error, sizeof(error));
+    llama_tokenizer_grammar_t* pooled = llama_tokenizer_grammar_from_json_schema(
+        tokenizer, schema, (int32_t)strlen(schema), NULL, pool, NULL, 0);
+    if (!grammar || !pooled) {
+        printf("  error: %s\n", error);
+        check(0, "", "JSON schema grammar failed to compile");
+        llama_tokenizer_grammar_free(grammar);
+        llama_tokenizer_grammar_free(pooled);
+        llama_tokenizer_threadpool_destroy(pool);
+        return;
+    }
+
+    check(matches(tokenizer, grammar, "{\"name\":\"Ada\",\"age\":36}") &&
+              matches(tokenizer, grammar, "{\"name\": \"Ünïcödé\", \"age\": -1, \"tags\": [\"red\", \"green\"]}") &&
+              !matches(tokenizer, grammar, "{\"name\":\"Ada\"}") &&
+              !matches(tokenizer, grammar, "{\"name\":\"Ada\",\"age\":\"36\"}") &&
+              !matches(tokenizer, grammar, "{\"name\":\"Ada\",\"age\":1,\"tags\":[\"blue\"]}") &&
+              !matches(tokenizer, grammar, "{\"age\":36,\"name\":\"Ada\"}"),
+          "Documents the schema allows are accepted, others refused",
+          "JSON schema grammar accepted or refused the wrong document");
+
+    const int32_t n_states = llama_tokenizer_grammar_n_states(grammar);
+    const int32_t n_words = llama_tokenizer_grammar_mask_words(grammar);
+    int same = n_states == llama_tokenizer_grammar_n_states(pooled) &&
+               n_words == (llama_tokenizer_vocab_size(tokenizer) + 63) / 64;
+    for (int32_t state = 0; same && state < n_states; state++) {
+        same = memcmp(llama_tokenizer_grammar_mask(grammar, state), llama_tokenizer_grammar_mask(pooled, state),
+                      (size_t)n_words * sizeof(uint64_t)) == 0;
+    }
+    check(same, "Masks filled on a thread pool equal serial ones", "Pooled masks differ");
+
+    llama_tokenizer_grammar_free(grammar);
+    llama_tokenizer_grammar_free(pooled);
+    llama_tokenizer_threadpool_destroy(pool);
+
+    // '.' and classes in a pattern match decoded characters, so a quote,
+    // backslash or control character may only appear as its escape
+    const char* pattern_schema = "{\"type\": \"string\", \"pattern\": \"^a.*[^x]$\"}";
+    llama_tokenizer_grammar_t* pattern = llama_tokenizer_grammar_from_json_schema(
+        tokenizer, pattern_schema, (int32_t)strlen(pattern_schema), NULL, NULL, error, sizeof(error));
+    check(pattern && matches(tokenizer, pattern, "\"abc\"") &&
+              matches(tokenizer, pattern, "\"a\\\"b\\\\\\t\\u001F\"") &&
+              !matches(tokenizer, pattern, "\"a\"b\"") &&
+              !matches(tokenizer, pattern, "\"a\\\"") &&
+              !matches(tokenizer, pattern, "\"ab\\\"") &&
+              !matches(tokenizer, pattern, "\"a\tb\""),
+          "A string pattern admits escapes, never a raw quote, backslash or control",
+          "A string pattern let a raw quote, backslash or control through");
+    llama_tokenizer_grammar_free(pattern);
+
+    // Length bounds count code points: a surrogate pair escape is one
+    const char* length_schema = "{\"type\": \"string\", \"minLength\": 2, \"maxLength\": 2}";
+    llama_tokenizer_grammar_t* length = llama_tokenizer_grammar_from_json_schema(
+        tokenizer, length_schema, (int32_t)strlen(length_schema), NULL, NULL, error, sizeof(error));
+    check(length && matches(tokenizer, length, "\"\\ud83d\\ude00x\"") &&
+              matches(tokenizer, length, "\"\\u00e9\xC3\xA9\"") &&
+              !matches(tokenizer, length, "\"\\ud83d\\ude00\"") &&
+              !matches(tokenizer, length, "\"\\ud83dx\""),
+          "Length bounds count a surrogate pair escape as one character",
+          "Length bounds counted a surrogate pair escape as two characters");
+    llama_tokenizer_grammar_free(length);
+
+    // '.' stops at every ECMA-262 line terminator, not just \n
+    const char* dot_schema = "{\"type\": \"string\", \"pattern\": \"^a.b$\"}";
+    llama_tokenizer_grammar_t* dot = llama_tokenizer_grammar_from_json_schema(
+        tokenizer, dot_schema, (int32_t)strlen(dot_schema), NULL, NULL, error, sizeof(error));
+    check(dot && matches(tokenizer, dot, "\"a\\tb\"") && matches(tokenizer, dot, "\"a\xE2\x80\xA6" "b\"") &&
+              !matches(tokenizer, dot, "\"a\\rb\"") && !matches(tokenizer, dot, "\"a\\nb\"") &&
+              !matches(tokenizer, dot, "\"a\xE2\x80\xA8" "b\"") &&
+              !matches(tokenizer, dot, "\"a\xE2\x80\xA9" "b\""),
+          "'.' in a pattern refuses \\r, \\n, U+2028 and U+2029",
+          "'.' in a pattern matched a line terminator");
+    llama_tokenizer_grammar_free(dot);
+}
+
+void test_errors(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Errors ---\n");
+
+    char error[256] = "";
+    const llama_tokenizer_grammar_t* bad_regex = llama_tokenizer_grammar_from_regex(tokenizer, "(ab", 3, NULL, NULL,
+                                                                                    error, sizeof(error));
+    const int regex_reported = bad_regex == NULL && error[0] != 0;
+
+    const char* ref_schema = "{\"$ref\": \"#/definitions/node\"}";
+    error[0] = 0;
+    const llama_tokenizer_grammar_t* bad_schema = llama_tokenizer_grammar_from_json_schema(
+        tokenizer, ref_schema, (int32_t)strlen(ref_schema), NULL, NULL, error, sizeof(error));
+    check(regex_reported && bad_schema == NULL && strstr(error, "$ref") != NULL,
+          "A malformed regex and an unsupported schema fail with a message",
+          "Bad grammar accepted or not reported");
+
+    // Stacked quantifiers would nest without bound; a long run of them
+    // must fail cleanly rather than recurse off the stack
+    const size_t n_stacked = 200000;
+    char* stacked = malloc(n_stacked + 2);
+    int stacked_rejected = 0;
+    if (stacked) {
+        stacked[0] = 'a';
+        memset(stacked + 1, '?', n_stacked);
+        stacked[n_stacked + 1] = 0;
+        error[0] = 0;
+        stacked_rejected = llama_tokenizer_grammar_from_regex(tokenizer, stacked, (int32_t)(n_stacked + 1), NULL, NULL,
+                                                              error, sizeof(error)) == NULL &&
+                           strstr(error, "multiple repeat") != NULL &&
+                           llama_tokenizer_grammar_from_regex(tokenizer, "a**", 3, NULL, NULL, NULL, 0) == NULL &&
+                           llama_tokenizer_grammar_from_regex(tokenizer, "a+{2}", 5, NULL, NULL, NULL, 0) == NULL;
+        free(stacked);
+    }
+    llama_tokenizer_grammar_t* lazy = llama_tokenizer_grammar_from_regex(tokenizer, "a*?b{1,2}?c{", 12, NULL, NULL,
+                                                                         NULL, 0);
+    check(stacked_rejected && lazy != NULL,
+          "Stacked quantifiers are refused as a multiple repeat, lazy ones accepted",
+          "Stacked quantifiers accepted or lazy quantifiers refused");
+    llama_tokenizer_grammar_free(lazy);
+
+    // Combinations that would otherwise compile looser than the schema
+    const char* const loose_schemas[] = {
+        "{\"anyOf\": [{\"type\": \"integer\"}], \"oneOf\": [{\"type\": \"string\"}]}",
+        "{\"const\": 5, \"type\": \"string\"}",
+        "{\"enum\": [1, 2], \"type\": \"string\"}",
+        "{\"type\": \"object\", \"properties\": {}, \"additionalProperties\": {\"type\": \"string\"}}",
+        "{\"type\": \"object\", \"properties\": {}, \"additionalProperties\": true}",
+        "{\"oneOf\": [{\"type\": \"integer\"}, {\"type\": \"number\"}]}",
+        "{\"oneOf\": [{\"enum\": [1, 2]}, {\"const\": 2.0}]}",
+        "{\"oneOf\": [{\"const\": {\"a\": 1, \"b\": 2}}, {\"const\": {\"b\": 2, \"a\": 1}}]}",
+    };
+    int loose_rejected = 1;
+    for (size_t i = 0; i < sizeof(loose_schemas) / sizeof(loose_schemas[0]); i++) {
+        loose_rejected &= llama_tokenizer_grammar_from_json_schema(tokenizer, loose_schemas[i],
+                                                                   (int32_t)strlen(loose_schemas[i]), NULL, NULL,
+                                                                   NULL, 0) == NULL;
+    }
+    const char* closed = "{\"type\": \"object\", \"properties\": {}, \"additionalProperties\": false}";
+    llama_tokenizer_grammar_t* closed_grammar = llama_tokenizer_grammar_from_json_schema(
+        tokenizer, closed, (int32_t)strlen(closed), NULL, NULL, NULL, 0);
+    check(loose_rejected && closed_grammar != NULL,
+          "anyOf with oneOf, keywords next to const/enum, open additionalProperties and overlapping oneOf are rejected",
+          "A schema combination that would be compiled looser was accepted");
+    llama_tokenizer_grammar_free(closed_grammar);
+
+    // oneOf whose branches cannot both match is an alternation
+    const char* one_of = "{\"oneOf\": [{\"type\": \"string\"}, {\"type\": \"integer\"}, {\"enum\": [true, null]}]}";
+    llama_tokenizer_grammar_t* one_of_grammar = llama_tokenizer_grammar_from_json_schema(
+        tokenizer, one_of, (int32_t)strlen(one_of), NULL, NULL, NULL, 0);
+    check(one_of_grammar && matches(tokenizer, one_of_grammar, "1") && matches(tokenizer, one_of_grammar, "\"a\"") &&
+              matches(tokenizer, one_of_grammar, "null") && !matches(tokenizer, one_of_grammar, "false"),
+          "oneOf with disjoint branches compiles",
+          "oneOf with disjoint branches failed to compile or matched wrongly");
+    llama_tokenizer_grammar_free(one_of_grammar);
+
+    llama_tokenizer_grammar_params params = llama_tokenizer_grammar_default_params();
+    params.max_states = 4;
+    check(llama_tokenizer_grammar_from_regex(tokenizer, "[0-9]{8}", 8, &params, NULL, NULL, 0) == NULL &&
+              llama_tokenizer_grammar_from_regex(NULL, "a", 1, NULL, NULL, NULL, 0) == NULL &&
+              llama_tokenizer_grammar_from_regex(tokenizer, NULL, 1, NULL, NULL, NULL, 0) == NULL &&
+              llama_tokenizer_grammar_n_states(NULL) == -1 &&
+              llama_tokenizer_grammar_mask(NULL, 0) == NULL &&
+              llama_tokenizer_grammar_advance(NULL, 0, 0) == -1,
+          "Too many states and invalid arguments are rejected",
+          "Invalid grammar arguments were accepted");
+
+    llama_tokenizer_grammar_t* grammar = llama_tokenizer_grammar_from_regex(tokenizer, "a", 1, NULL, NULL, NULL, 0);
+    check(grammar && llama_tokenizer_grammar_mask(grammar, -1) == NULL &&
+              llama_tokenizer_grammar_mask(grammar, llama_tokenizer_grammar_n_states(grammar)) == NULL &&
+              llama_tokenizer_grammar_advance(grammar, 0, -1) == -1 &&
+              llama_tokenizer_grammar_advance(grammar, 0, llama_tokenizer_vocab_size(tokenizer)) == -1,
+          "Out-of-range states and tokens are rejected",
+          "Out-of-range state or token accepted");
+    llama_tokenizer_grammar_free(grammar);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model.gguf>\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Constrained Decoding Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        return 1;
+    }
+
+    test_regex(tokenizer);
+    test_json_schema(tokenizer);
+    test_errors(tokenizer);
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
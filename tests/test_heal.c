@@ -0,0 +1,213 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 256
+#define MAX_PIECE 256
+
+// Every token's piece, read through llama_tokenizer_token_to_piece()
+static int32_t n_vocab = 0;
+static char* piece_text = NULL;
+static int32_t* piece_len = NULL;
+
+// Token lists as 0/1 per vocab id
+static unsigned char* got_set = NULL;
+static unsigned char* want_set = NULL;
+static llama_token* found = NULL;
+
+static const char* piece_of(llama_token id) {
+    return piece_text + (size_t)id * MAX_PIECE;
+}
+
+static int load_pieces(llama_tokenizer_t* tokenizer) {
+    n_vocab = llama_tokenizer_vocab_size(tokenizer);
+    if (n_vocab <= 0) {
+        return 0;
+    }
+    piece_text = malloc((size_t)n_vocab * MAX_PIECE);
+    piece_len = malloc((size_t)n_vocab * sizeof(int32_t));
+    got_set = malloc((size_t)n_vocab);
+    want_set = malloc((size_t)n_vocab);
+    found = malloc((size_t)n_vocab * sizeof(llama_token));
+    if (!piece_text || !piece_len || !got_set || !want_set || !found) {
+        return 0;
+    }
+    for (llama_token id = 0; id < n_vocab; id++) {
+        const int32_t n = llama_tokenizer_token_to_piece(tokenizer, id, piece_text + (size_t)id * MAX_PIECE, MAX_PIECE);
+        piece_len[id] = n > 0 ? n : 0;
+    }
+    return 1;
+}
+
+static int starts_with(const char* s, int32_t s_len, const char* prefix, int32_t prefix_len) {
+    return s_len >= prefix_len && memcmp(s, prefix, (size_t)prefix_len) == 0;
+}
+
+// Tokens found must be exactly the tokens the brute-force scan wants, once each
+static int same_set(int32_t n_found) {
+    if (n_found < 0) {
+        return 0;
+    }
+    memset(got_set, 0, (size_t)n_vocab);
+    for (int32_t i = 0; i < n_found; i++) {
+        if (found[i] < 0 || found[i] >= n_vocab || got_set[found[i]]) {
+            return 0;
+        }
+        got_set[found[i]] = 1;
+    }
+    return memcmp(got_set, want_set, (size_t)n_vocab) == 0;
+}
+
+static void want_with_prefix(const char* text, int32_t len) {
+    for (llama_token id = 0; id < n_vocab; id++) {
+        want_set[id] = piece_len[id] > 0 && starts_with(piece_of(id), piece_len[id], text, len);
+    }
+}
+
+static void want_prefix_of(const char* text, int32_t len, int proper) {
+    for (llama_token id = 0; id < n_vocab; id++) {
+        want_set[id] = piece_len[id] > 0 && (!proper || piece_len[id] < len) &&
+                       starts_with(text, len, piece_of(id), piece_len[id]);
+    }
+}
+
+static const char* probes[] = { "", " ", "th", " the", "\n", "<", "http:", "zzqqxj", "ünï" };
+#define N_PROBES ((int)(sizeof(probes) / sizeof(probes[0])))
+
+void test_lookups(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Piece Lookups ---\n");
+
+    int ok = 1;
+    for (int i = 0; i < N_PROBES; i++) {
+        const int32_t len = (int32_t)strlen(probes[i]);
+        want_with_prefix(probes[i], len);
+        ok = ok && same_set(llama_tokenizer_tokens_with_prefix(tokenizer, probes[i], len, found, n_vocab));
+    }
+    check(ok, "tokens_with_prefix equals a scan of every piece",
+          "tokens_with_prefix differs from the scan");
+
+    ok = 1;
+    int shortest_first = 1;
+    for (int i = 0; i < N_PROBES; i++) {
+        const int32_t len = (int32_t)strlen(probes[i]);
+        want_prefix_of(probes[i], len, 0);
+        const int32_t n = llama_tokenizer_tokens_prefix_of(tokenizer, probes[i], len, found, n_vocab);
+        ok = ok && same_set(n);
+        for (int32_t k = 1; k < n; k++) {
+            shortest_first = shortest_first && piece_len[found[k - 1]] <= piece_len[found[k]];
+        }
+    }
+    check(ok && shortest_first, "tokens_prefix_of equals a scan of every piece, shortest first",
+          "tokens_prefix_of differs from the scan");
+
+    const int32_t n_all = llama_tokenizer_tokens_with_prefix(tokenizer, "", 0, NULL, 0);
+    const int32_t n_small = llama_tokenizer_tokens_with_prefix(tokenizer, "", 0, found, 1);
+    check(n_all > 1 && n_small == -n_all,
+          "NULL output counts and a short buffer returns the negative size",
+          "Count or short-buffer results are wrong");
+}
+
+void test_heal(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Healing ---\n");
+
+    static const char* prompts[] = { "The link is http:", "int main() {\n    return", "Hello, wor" };
+    llama_token prompt[MAX_TOKENS];
+    char removed[MAX_TOKENS * MAX_PIECE];
+    int ok = 1;
+    for (int i = 0; i < 3; i++) {
+        const int32_t n_prompt = llama_tokenizer_tokenize(tokenizer, prompts[i], (int32_t)strlen(prompts[i]),
+                                                          prompt, MAX_TOKENS, false, false);
+        for (int32_t n_back = 1; n_back <= 3 && n_back <= n_prompt; n_back++) {
+            int32_t kept = -1;
+            const int32_t n = llama_tokenizer_heal_tokens(tokenizer, prompt, n_prompt, n_back, &kept,
+                                                          found, n_vocab);
+            int32_t len = 0;
+            for (int32_t k = n_prompt - n_back; k < n_prompt; k++) {
+                memcpy(removed + len, piece_of(prompt[k]), (size_t)piece_len[prompt[k]]);
+                len += piece_len[prompt[k]];
+            }
+            want_prefix_of(removed, len, 1);
+            for (llama_token id = 0; id < n_vocab; id++) {
+                want_set[id] |= piece_len[id] > 0 && starts_with(piece_of(id), piece_len[id], removed, len);
+            }
+            ok = ok && kept == n_prompt - n_back && same_set(n) && got_set[prompt[n_prompt - n_back]];
+        }
+    }
+    check(ok, "Backed-off tokens allow exactly the pieces that render the removed text again",
+          "Healing allowed the wrong tokens");
+
+    // Backing off stops at a token without a piece, such as BOS
+    const int32_t n_prompt = llama_tokenizer_tokenize(tokenizer, "Hi", 2, prompt, MAX_TOKENS, true, false);
+    const llama_token bos = llama_tokenizer_token_bos(tokenizer);
+    if (n_prompt > 1 && prompt[0] == bos && piece_len[bos] == 0) {
+        int32_t kept = -1;
+        const int32_t n = llama_tokenizer_heal_tokens(tokenizer, prompt, n_prompt, n_prompt, &kept, NULL, 0);
+        check(n > 0 && kept == 1, "Backing off stops at BOS", "Backed off over BOS");
+    } else {
+        check(1, "No empty-piece BOS in front (skipped)", "");
+    }
+
+    int32_t kept = -1;
+    const llama_token bad[] = { 1, n_vocab };
+    check(llama_tokenizer_heal_tokens(NULL, prompt, 1, 1, &kept, found, n_vocab) == -1 &&
+              llama_tokenizer_heal_tokens(tokenizer, NULL, 1, 1, &kept, found, n_vocab) == -1 &&
+              llama_tokenizer_heal_tokens(tokenizer, prompt, 1, -1, &kept, found, n_vocab) == -1 &&
+              llama_tokenizer_heal_tokens(tokenizer, bad, 2, 1, &kept, found, n_vocab) == -1 &&
+              llama_tokenizer_tokens_with_prefix(tokenizer, NULL, 1, found, n_vocab) == -1 &&
+              llama_tokenizer_tokens_prefix_of(tokenizer, "a", -1, found, n_vocab) == -1,
+          "Invalid arguments and out-of-range tokens return -1",
+          "Invalid arguments were accepted");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model.gguf>\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Token Healing Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        return 1;
+    }
+
+    if (!load_pieces(tokenizer)) {
+        check(0, "", "Failed to read the vocab");
+    } else {
+        test_lookups(tokenizer);
+        test_heal(tokenizer);
+    }
+
+    free(piece_text);
+    free(piece_len);
+    free(got_set);
+    free(want_set);
+    free(found);
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
@@ -0,0 +1,150 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* model_path = NULL;
+
+// What the callback saw; read only after the delivering thread is done
+static int n_messages = 0;
+static int n_by_level[LLAMA_TOKENIZER_LOG_CONT + 1];
+static int n_off_main_thread = 0;
+static pthread_t main_thread;
+
+// While set, the callback blocks so the async queue fills up
+static atomic_int hold;
+
+static void on_log(llama_tokenizer_log_level level, const char* text, void* user_data) {
+    (void)text;
+    (void)user_data;
+    while (atomic_load(&hold)) {
+    }
+    n_messages++;
+    if (level >= 0 && level <= LLAMA_TOKENIZER_LOG_CONT) {
+        n_by_level[level]++;
+    }
+    if (!pthread_equal(pthread_self(), main_thread)) {
+        n_off_main_thread++;
+    }
+}
+
+static void reset_seen(void) {
+    n_messages = 0;
+    memset(n_by_level, 0, sizeof(n_by_level));
+    n_off_main_thread = 0;
+}
+
+// Load the model once at the given level and return the messages delivered
+static int load_at_level(llama_tokenizer_log_level level) {
+    reset_seen();
+    llama_tokenizer_set_log_level(level);
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(model_path);
+    llama_tokenizer_destroy(tokenizer);
+    return n_messages;
+}
+
+void test_level_filter(void) {
+    printf("\n--- Test: Level Filter ---\n");
+
+    const int n_debug = load_at_level(LLAMA_TOKENIZER_LOG_DEBUG);
+    const int n_info = load_at_level(LLAMA_TOKENIZER_LOG_INFO);
+    const int debug_at_info = n_by_level[LLAMA_TOKENIZER_LOG_DEBUG];
+    load_at_level(LLAMA_TOKENIZER_LOG_WARN);
+    const int below_warn = n_by_level[LLAMA_TOKENIZER_LOG_DEBUG] + n_by_level[LLAMA_TOKENIZER_LOG_INFO];
+    const int n_none = load_at_level(LLAMA_TOKENIZER_LOG_NONE);
+
+    check(n_debug > 0 && n_debug >= n_info,
+          "Model load logs at debug level, fewer at info",
+          "Expected load messages at debug level");
+    check(debug_at_info == 0 && below_warn == 0,
+          "Messages below the level are dropped",
+          "Messages below the level were delivered");
+    check(n_none == 0, "Nothing delivered at level NONE", "Messages delivered at level NONE");
+}
+
+void test_async_delivery(void) {
+    printf("\n--- Test: Async Delivery ---\n");
+
+    const int n_sync = load_at_level(LLAMA_TOKENIZER_LOG_DEBUG);
+    const uint64_t dropped_before = llama_tokenizer_log_dropped();
+
+    check(llama_tokenizer_log_async_start(0), "Async sink started", "Async sink failed to start");
+    reset_seen();
+    llama_tokenizer_destroy(llama_tokenizer_create(model_path));
+    llama_tokenizer_log_async_stop();
+
+    check(n_messages == n_sync && llama_tokenizer_log_dropped() == dropped_before,
+          "Every message delivered once the sink stops",
+          "Async sink lost or duplicated messages");
+    check(n_messages > 0 && n_off_main_thread == n_messages,
+          "Messages delivered on the sink thread",
+          "Messages delivered on the logging thread");
+}
+
+void test_full_queue_drops(void) {
+    printf("\n--- Test: Full Queue Drops ---\n");
+
+    const int n_sync = load_at_level(LLAMA_TOKENIZER_LOG_DEBUG);
+    const uint64_t dropped_before = llama_tokenizer_log_dropped();
+
+    // With delivery blocked the two slots fill and the rest is dropped;
+    // create must still return
+    llama_tokenizer_log_async_start(2);
+    atomic_store(&hold, 1);
+    reset_seen();
+    for (int i = 0; i < 2; i++) {
+        llama_tokenizer_destroy(llama_tokenizer_create(model_path));
+    }
+    atomic_store(&hold, 0);
+    llama_tokenizer_log_async_stop();
+
+    const uint64_t dropped = llama_tokenizer_log_dropped() - dropped_before;
+    check(dropped > 0, "Full queue drops instead of blocking", "Expected dropped messages");
+    check((uint64_t)n_messages + dropped == 2 * (uint64_t)n_sync,
+          "Delivered plus dropped accounts for every message",
+          "Delivered and dropped counts do not add up");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Log Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    model_path = argv[1];
+    main_thread = pthread_self();
+    llama_tokenizer_set_log_callback(on_log, NULL);
+    llama_tokenizer_init();
+
+    test_level_filter();
+    test_async_delivery();
+    test_full_queue_drops();
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_set_log_callback(NULL, NULL);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
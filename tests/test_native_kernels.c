@@ -0,0 +1,255 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS (1 << 20)  // byte-level vocabs, invalid bytes tripled by U+FFFD
+#define MAX_TEXT (1 << 18)
+#define ROUNDS 2000
+
+static const char* const texts[] = {
+    "Hello world",
+    "",
+    " ",
+    "   leading and trailing   ",
+    "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs.",
+    "for (int i = 0; i < n; ++i) { sum += a[i] * b[i]; }\n",
+    "def f(x):\n    return {'key': [x, None, True]}\n",
+    "multiple   spaces\tand\ttabs\n\nand newlines\r\n",
+    "1234567890 3.14159 -42 1e-9 0x7fffffff",
+    "caf\xC3\xA9 na\xC3\xAFve r\xC3\xA9sum\xC3\xA9 cafe\xCC\x81",
+    "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87\xE7\xAB\xA0 \xED\x95\x9C\xEA\xB5\xAD\xEC\x96\xB4",
+    "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 \xCE\x93\xCE\xB5\xCE\xB9\xCE\xAC \xD9\x85\xD8\xB1\xD8\xAD\xD8\xA8\xD8\xA7",
+    "\xF0\x9F\x98\x80\xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD \xF0\x9F\xA6\x80 \xE2\x80\x8B\xE2\x80\x94\xE2\x80\xA6",
+    // Rare enough to need byte fallback in most vocabs
+    "\xF0\x90\x8C\xB0\xF0\x90\x8C\xB1 \xE1\x9A\xA0\xE1\x9A\xA2 \xEA\x99\xAE \xEE\x80\x80 \xF3\xB0\x80\x80",
+    "\xF0\xA0\x80\x80\xF0\xA0\x80\x81 \xE2\xBF\xB0 \xF0\x9F\x80\x84 \xE1\x8E\xA0\xE1\x8E\xA1",
+    "control\x01" "chars\x7f and\x0bvertical\x0ctabs",
+    // Invalid UTF-8: stray continuation, truncated sequences, overlong form
+    "invalid \xFF\xFE utf-8 \xC3 in the middle",
+    "\x80\x80 starts with continuation bytes",
+    "truncated at the end \xE2\x82",
+    "overlong \xC0\xAF and surrogate \xED\xA0\x80 forms",
+};
+#define N_TEXTS (sizeof(texts) / sizeof(texts[0]))
+
+static llama_token expected[MAX_TOKENS];
+static llama_token actual[MAX_TOKENS];
+static char text[MAX_TEXT];
+
+// Whether the wrapper agrees with llama.cpp on s for every flag combination
+static int matches_llama(const llama_tokenizer_t* tokenizer, const char* s, int32_t len) {
+    for (int flags = 0; flags < 4; flags++) {
+        const bool add_special = (flags & 1) != 0;
+        const bool parse_special = (flags & 2) != 0;
+        const int32_t n_expected = llama_tokenizer_tokenize_reference(tokenizer, s, len, expected, MAX_TOKENS,
+                                                                      add_special, parse_special);
+        const int32_t n_actual = llama_tokenizer_tokenize(tokenizer, s, len, actual, MAX_TOKENS, add_special,
+                                                          parse_special);
+        if (n_expected < 0 || n_actual != n_expected ||
+            memcmp(actual, expected, (size_t)n_expected * sizeof(llama_token)) != 0) {
+            printf("  mismatch (add_special=%d parse_special=%d, %d bytes): \"%.*s\"\n", add_special,
+                   parse_special, (int)len, len > 80 ? 80 : (int)len, s);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Append one UTF-8 encoded code point
+static int32_t append_code_point(int32_t len, uint32_t cp) {
+    if (len + 4 >= MAX_TEXT) {
+        return len;
+    }
+    if (cp < 0x80) {
+        text[len++] = (char)cp;
+    } else if (cp < 0x800) {
+        text[len++] = (char)(0xC0 | (cp >> 6));
+        text[len++] = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        text[len++] = (char)(0xE0 | (cp >> 12));
+        text[len++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        text[len++] = (char)(0x80 | (cp & 0x3F));
+    } else {
+        text[len++] = (char)(0xF0 | (cp >> 18));
+        text[len++] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        text[len++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        text[len++] = (char)(0x80 | (cp & 0x3F));
+    }
+    return len;
+}
+
+// A code point from a mix of common and rare ranges, so that some need
+// byte fallback; surrogates excluded
+static uint32_t random_code_point(void) {
+    static const uint32_t ranges[][2] = {
+        { 0x20, 0x7E }, { 0x20, 0x7E }, { 0x20, 0x7E }, { 0x09, 0x0D },
+        { 0xA0, 0x24F }, { 0x300, 0x36F }, { 0x370, 0x4FF }, { 0x590, 0x6FF },
+        { 0x900, 0x97F }, { 0x1100, 0x11FF }, { 0x2000, 0x206F }, { 0x3000, 0x30FF },
+        { 0x4E00, 0x9FFF }, { 0xAC00, 0xD7A3 }, { 0xE000, 0xF8FF }, { 0xFF00, 0xFFEF },
+        { 0x10000, 0x1034F }, { 0x1F300, 0x1FAFF }, { 0x20000, 0x2A6DF }, { 0xF0000, 0xFFFFD },
+    };
+    const int r = rand() % (int)(sizeof(ranges) / sizeof(ranges[0]));
+    return ranges[r][0] + (uint32_t)rand() % (ranges[r][1] - ranges[r][0] + 1);
+}
+
+void test_corpus(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Corpus Matches llama.cpp ---\n");
+
+    int all_match = 1;
+    for (size_t i = 0; i < N_TEXTS && all_match; i++) {
+        all_match = matches_llama(tokenizer, texts[i], (int32_t)strlen(texts[i]));
+    }
+    check(all_match, "Corpus, including invalid UTF-8 and byte fallback, matches llama.cpp",
+          "A corpus text differs from llama.cpp");
+}
+
+void test_random(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Random Text Matches llama.cpp ---\n");
+
+    srand(28);
+    int all_match = 1;
+    for (int round = 0; round < ROUNDS && all_match; round++) {
+        int32_t len = 0;
+        const int n = 1 + rand() % 48;
+        for (int i = 0; i < n; i++) {
+            len = append_code_point(len, random_code_point());
+        }
+        all_match = matches_llama(tokenizer, text, len);
+    }
+    check(all_match, "Random code points from common and rare ranges match llama.cpp",
+          "Random code points differ from llama.cpp");
+
+    // Arbitrary bytes, so invalid sequences land anywhere
+    int bytes_match = 1;
+    for (int round = 0; round < ROUNDS && bytes_match; round++) {
+        const int32_t len = 1 + rand() % 64;
+        for (int32_t i = 0; i < len; i++) {
+            text[i] = (char)(rand() % 4 == 0 ? rand() % 256 : 0x20 + rand() % 0x5F);
+        }
+        bytes_match = matches_llama(tokenizer, text, len);
+    }
+    check(bytes_match, "Random bytes match llama.cpp", "Random bytes differ from llama.cpp");
+}
+
+// Inputs that WordPiece (accent stripping, lowercasing, punctuation and
+// CJK splitting) and unigram charsmaps (compatibility forms, whitespace
+// folding) normalize
+static const char* const normalization_texts[] = {
+    "\xC3\x80\xC3\x89\xC3\x8E\xC3\x95\xC3\x9C \xC3\xA0\xC3\xA9\xC3\xAE\xC3\xB5\xC3\xBC \xC3\x87" "a \xC3\x91" "o",
+    "e\xCC\x81 a\xCC\x8A o\xCC\x88\xCC\x81 \xCC\x81 alone",
+    "MiXeD CaSe \xCE\xA3\xCE\x99\xCE\xA3\xCE\xA5\xCE\xA6\xCE\x9F\xCE\xA3 \xC4\xB0stanbul \xC3\x9F \xE1\xBA\x9E",
+    "\xEF\xBC\xA1\xEF\xBC\xA2\xEF\xBC\xA3\xEF\xBD\x84\xEF\xBD\x85 \xEF\xBC\x91\xEF\xBC\x92\xEF\xBC\x93\xEF\xBC\x81\xEF\xBC\x9F",
+    "\xEF\xAC\x81nance \xEF\xAC\x82ow \xE2\x91\xA0\xE2\x91\xA1 \xE3\x8D\xBF \xE2\x84\xA2 \xC2\xBD \xC2\xB2",
+    "no\xC2\xA0" "break\xE2\x80\x89thin\xE3\x80\x80ideographic\xE2\x80\x8Bzero\xC2\xAD" "soft",
+    "many     spaces \t\t tabs\n\n\nnewlines \r\n crlf   ",
+    "\xE4\xBD\xA0\xE5\xA5\xBD\xEF\xBC\x8C\xE4\xB8\x96\xE7\x95\x8C\xE3\x80\x82 \xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF",
+    "\xED\x95\x9C\xEA\xB8\x80 \xE1\x84\x92\xE1\x85\xA1\xE1\x86\xAB",
+    "punct!?.,;:'\"()[]{} mid-word_under$sign+plus<less>|pipe~tilde`tick^caret",
+    "\xE2\x80\x94" "dash\xE2\x80\x93" "en\xE2\x80\xA6" "ellipsis\xC2\xAB\xC2\xBB\xE2\x80\x9Cquotes\xE2\x80\x9D \xC2\xA9\xC2\xAE \xE2\x82\xAC",
+    "control\x01\x02\x1f" "chars\x7f \xC2\x85next\xE2\x80\xA8line\xE2\x80\xA9para \xEF\xBF\xBD",
+};
+#define N_NORMALIZATION_TEXTS (sizeof(normalization_texts) / sizeof(normalization_texts[0]))
+
+void test_normalization(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Normalization Matches llama.cpp ---\n");
+
+    int all_match = 1;
+    for (size_t i = 0; i < N_NORMALIZATION_TEXTS && all_match; i++) {
+        all_match = matches_llama(tokenizer, normalization_texts[i], (int32_t)strlen(normalization_texts[i]));
+    }
+    check(all_match, "Accents, case, compatibility forms and whitespace runs match llama.cpp",
+          "A normalization text differs from llama.cpp");
+
+    // Every BMP character on its own and inside a word, a block at a time
+    int sweep_match = 1;
+    for (uint32_t first = 0x80; first < 0x10000 && sweep_match; first += 0x400) {
+        int32_t len = 0;
+        for (uint32_t cpt = first; cpt < first + 0x400; cpt++) {
+            if (cpt >= 0xD800 && cpt <= 0xDFFF) {
+                continue;
+            }
+            len = append_code_point(len, cpt);
+            len = append_code_point(len, ' ');
+            len = append_code_point(len, 'a');
+            len = append_code_point(len, cpt);
+            len = append_code_point(len, 'b');
+            len = append_code_point(len, ' ');
+        }
+        sweep_match = matches_llama(tokenizer, text, len);
+    }
+    check(sweep_match, "Every BMP character, alone and inside a word, matches llama.cpp",
+          "A BMP character normalizes differently from llama.cpp");
+}
+
+void test_long_input(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Long Input Matches llama.cpp ---\n");
+
+    // Well past every per-thread scratch retain limit
+    int32_t len = 0;
+    srand(2028);
+    while (len + 256 < MAX_TEXT) {
+        if (rand() % 4 == 0) {
+            len = append_code_point(len, random_code_point());
+        } else {
+            const char* s = texts[rand() % N_TEXTS];
+            const size_t n = strlen(s);
+            memcpy(text + len, s, n);
+            len += (int32_t)n;
+        }
+    }
+    check(matches_llama(tokenizer, text, len), "A long mixed input matches llama.cpp",
+          "A long input differs from llama.cpp");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path> [more-models...]\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/spm.gguf /path/to/ugm.gguf /path/to/wpm.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Native Kernel Test Suite ===\n");
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    // Each model in turn, so one run can cover SentencePiece, unigram and
+    // WordPiece vocabs
+    for (int m = 1; m < argc; m++) {
+        printf("\nModel: %s\n", argv[m]);
+        llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[m]);
+        if (!tokenizer) {
+            fprintf(stderr, "Failed to create tokenizer from: %s\n", argv[m]);
+            llama_tokenizer_free_backend();
+            return 1;
+        }
+        printf("Native kernel: %s\n", llama_tokenizer_uses_native_kernel(tokenizer) ? "yes" : "no");
+
+        test_corpus(tokenizer);
+        test_random(tokenizer);
+        test_normalization(tokenizer);
+        test_long_input(tokenizer);
+
+        llama_tokenizer_destroy(tokenizer);
+    }
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
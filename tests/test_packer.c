@@ -0,0 +1,453 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_DOCS 500
+#define SEQ_LEN 64
+#define SHARD_SEQUENCES 40
+#define PREFIX "test_packer_out"
+#define MAX_SHARDS 64
+
+#ifdef __GLIBC__
+// Fail heap calls of one size on this thread by interposing the allocator
+// (the executable is linked with exported symbols so the library's and
+// libstdc++'s calls resolve here)
+extern void* __libc_malloc(size_t size);
+
+static _Thread_local size_t failing_size = 0;
+
+void* malloc(size_t size) {
+    if (failing_size != 0 && size == failing_size) {
+        return NULL;
+    }
+    return __libc_malloc(size);
+}
+#endif
+
+static const char* phrases[] = {
+    "Hello world. ",
+    "The quick brown fox jumps over the lazy dog. ",
+    "Ünïcödé テキスト текст ",
+    "for (int i = 0; i < n; i++) { sum += i; } ",
+    "a",
+};
+
+static char* texts[N_DOCS];
+static int32_t text_lens[N_DOCS];
+
+// One shard read back from disk
+typedef struct {
+    llama_tokenizer_pack_index_header header;
+    uint64_t* sequence_segments;
+    llama_tokenizer_pack_segment* segments;
+    llama_token* tokens;        // widened to llama_token
+    size_t n_tokens;
+} shard;
+
+// Document i repeats one phrase i % 13 times, so some are empty and some
+// span several sequences
+static int make_texts(void) {
+    const int n_phrases = (int)(sizeof(phrases) / sizeof(phrases[0]));
+    for (int i = 0; i < N_DOCS; i++) {
+        const char* phrase = phrases[i % n_phrases];
+        const size_t len = strlen(phrase);
+        const int repeat = i % 13;
+        texts[i] = malloc(len * (size_t)repeat + 1);
+        if (!texts[i]) {
+            return 0;
+        }
+        for (int r = 0; r < repeat; r++) {
+            memcpy(texts[i] + len * (size_t)r, phrase, len);
+        }
+        text_lens[i] = (int32_t)(len * (size_t)repeat);
+        texts[i][text_lens[i]] = '\0';
+    }
+    return 1;
+}
+
+static void shard_path(char* out, size_t size, int index, const char* extension) {
+    snprintf(out, size, "%s-%05d.%s", PREFIX, index, extension);
+}
+
+static void remove_shards(void) {
+    char path[256];
+    for (int s = 0; s < MAX_SHARDS; s++) {
+        shard_path(path, sizeof(path), s, "bin");
+        remove(path);
+        shard_path(path, sizeof(path), s, "idx");
+        remove(path);
+    }
+}
+
+static void free_shard(shard* s) {
+    free(s->sequence_segments);
+    free(s->segments);
+    free(s->tokens);
+    memset(s, 0, sizeof(*s));
+}
+
+static void* read_all(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    const long end = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    void* data = malloc(end > 0 ? (size_t)end : 1);
+    if (data && fread(data, 1, (size_t)end, f) != (size_t)end) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = (size_t)end;
+    return data;
+}
+
+// Load shard index; 0 if it is missing or inconsistent with its .bin
+static int load_shard(int index, shard* s) {
+    char path[256];
+    size_t idx_size = 0;
+    size_t bin_size = 0;
+    memset(s, 0, sizeof(*s));
+    shard_path(path, sizeof(path), index, "idx");
+    unsigned char* idx = read_all(path, &idx_size);
+    shard_path(path, sizeof(path), index, "bin");
+    unsigned char* bin = read_all(path, &bin_size);
+    int ok = idx && bin && idx_size >= sizeof(s->header);
+    if (ok) {
+        memcpy(&s->header, idx, sizeof(s->header));
+        const llama_tokenizer_pack_index_header* h = &s->header;
+        const size_t offsets_size = (size_t)(h->n_sequences + 1) * sizeof(uint64_t);
+        const size_t segments_size = (size_t)h->n_segments * sizeof(llama_tokenizer_pack_segment);
+        ok = memcmp(h->magic, LLAMA_TOKENIZER_PACK_MAGIC, 8) == 0 && h->version == 1 &&
+             (h->token_bytes == 2 || h->token_bytes == 4) &&
+             idx_size == sizeof(*h) + offsets_size + segments_size &&
+             bin_size == (size_t)h->n_sequences * h->seq_len * h->token_bytes;
+        if (ok) {
+            s->sequence_segments = malloc(offsets_size);
+            s->segments = malloc(segments_size + 1);
+            s->n_tokens = bin_size / h->token_bytes;
+            s->tokens = malloc(s->n_tokens * sizeof(llama_token) + 1);
+            ok = s->sequence_segments && s->segments && s->tokens;
+        }
+        if (ok) {
+            memcpy(s->sequence_segments, idx + sizeof(*h), offsets_size);
+            memcpy(s->segments, idx + sizeof(*h) + offsets_size, segments_size);
+            for (size_t i = 0; i < s->n_tokens; i++) {
+                if (h->token_bytes == 2) {
+                    uint16_t t;
+                    memcpy(&t, bin + i * 2, 2);
+                    s->tokens[i] = t;
+                } else {
+                    memcpy(&s->tokens[i], bin + i * 4, 4);
+                }
+            }
+        }
+    }
+    free(idx);
+    free(bin);
+    if (!ok) {
+        free_shard(s);
+    }
+    return ok;
+}
+
+// Tokens of document i as packed: BOS + tokens + separator
+static int32_t packed_doc(llama_tokenizer_t* tokenizer, int64_t i, llama_token separator, llama_token* out) {
+    int32_t n = 0;
+    if (llama_tokenizer_should_add_bos(tokenizer)) {
+        out[n++] = llama_tokenizer_token_bos(tokenizer);
+    }
+    n += llama_tokenizer_tokenize(tokenizer, texts[i], text_lens[i], out + n, 4000, false, false);
+    if (separator >= 0) {
+        out[n++] = separator;
+    }
+    return n;
+}
+
+// Rebuild every document from the segments of all shards: documents come
+// in order, segments tile each sequence from position 0 and hold the
+// document's tokens, and only the end of the last sequence is padding
+static int shards_match(llama_tokenizer_t* tokenizer, int n_shards, llama_token separator, llama_token pad) {
+    llama_token doc[4096];
+    int64_t doc_id = -1;
+    int64_t doc_pos = 0;
+    int32_t doc_len = 0;
+    int ok = 1;
+
+    for (int k = 0; ok && k < n_shards; k++) {
+        shard s;
+        if (!load_shard(k, &s)) {
+            return 0;
+        }
+        ok = s.header.seq_len == SEQ_LEN && s.sequence_segments[0] == 0 &&
+             s.sequence_segments[s.header.n_sequences] == s.header.n_segments &&
+             (k + 1 == n_shards || s.header.n_sequences == SHARD_SEQUENCES);
+        for (uint64_t q = 0; ok && q < s.header.n_sequences; q++) {
+            const llama_token* sequence = s.tokens + q * SEQ_LEN;
+            int32_t position = 0;
+            for (uint64_t g = s.sequence_segments[q]; ok && g < s.sequence_segments[q + 1]; g++) {
+                const llama_tokenizer_pack_segment* seg = &s.segments[g];
+                if (seg->doc_offset == 0) {
+                    // The previous document must be complete
+                    ok = seg->doc_id == doc_id + 1 && doc_pos == doc_len && seg->doc_id < N_DOCS;
+                    if (ok) {
+                        doc_id = seg->doc_id;
+                        doc_pos = 0;
+                        doc_len = packed_doc(tokenizer, doc_id, separator, doc);
+                    }
+                } else {
+                    ok = seg->doc_id == doc_id && seg->doc_offset == doc_pos;
+                }
+                ok = ok && seg->start == position && seg->length > 0 && seg->start + seg->length <= SEQ_LEN &&
+                     doc_pos + seg->length <= doc_len &&
+                     memcmp(sequence + seg->start, doc + doc_pos, (size_t)seg->length * sizeof(llama_token)) == 0;
+                position += seg->length;
+                doc_pos += seg->length;
+            }
+            if (ok && position < SEQ_LEN) {
+                ok = k + 1 == n_shards && q + 1 == s.header.n_sequences;
+                for (int32_t c = position; ok && c < SEQ_LEN; c++) {
+                    ok = sequence[c] == pad;
+                }
+            }
+        }
+        free_shard(&s);
+    }
+    return ok && doc_id == N_DOCS - 1 && doc_pos == doc_len;
+}
+
+static int pack_all(llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool,
+                    const llama_tokenizer_packer_params* p, int batch, llama_tokenizer_packer_stats* stats) {
+    llama_tokenizer_packer_t* packer = llama_tokenizer_packer_create(tokenizer, pool, PREFIX, p);
+    if (!packer) {
+        return 0;
+    }
+    int ok = 1;
+    for (int i = 0; ok && i < N_DOCS; i += batch) {
+        const int n = N_DOCS - i < batch ? N_DOCS - i : batch;
+        ok = llama_tokenizer_packer_add(packer, (const char* const*)texts + i, text_lens + i, n) == 0;
+    }
+    ok = llama_tokenizer_packer_finish(packer) == 0 && ok;
+    ok = llama_tokenizer_packer_get_stats(packer, stats) && ok;
+    llama_tokenizer_packer_destroy(packer);
+    return ok;
+}
+
+void test_round_trip(llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    printf("\n--- Test: Round Trip ---\n");
+
+    llama_tokenizer_packer_params p = llama_tokenizer_packer_default_params();
+    p.seq_len = SEQ_LEN;
+    p.shard_sequences = SHARD_SEQUENCES;
+    p.separator = 7;
+    p.pad_token = 3;
+    llama_tokenizer_packer_stats stats;
+    remove_shards();
+    const int packed = pack_all(tokenizer, pool, &p, 64, &stats);
+    const llama_token separator = llama_tokenizer_should_add_eos(tokenizer) ? llama_tokenizer_token_eos(tokenizer) : 7;
+    const int n_shards = (int)stats.shards;
+
+    check(packed && stats.documents == N_DOCS && stats.failed == 0 &&
+              (stats.tokens + stats.padding) == stats.sequences * SEQ_LEN && stats.padding < SEQ_LEN &&
+              stats.shards == (stats.sequences + SHARD_SEQUENCES - 1) / SHARD_SEQUENCES && n_shards > 1,
+          "Stats add up and shards rotate every shard_sequences",
+          "Packing stats are wrong");
+    check(packed && n_shards <= MAX_SHARDS && shards_match(tokenizer, n_shards, separator, 3),
+          "Segments rebuild every document with BOS and separator",
+          "Packed tokens or index do not match the documents");
+
+    shard s;
+    const int loaded = load_shard(0, &s);
+    check(loaded && s.header.token_bytes == (llama_tokenizer_vocab_size(tokenizer) <= 65536 ? 2u : 4u),
+          "Token width is chosen from the vocab size",
+          "Unexpected token width");
+    if (loaded) {
+        free_shard(&s);
+    }
+    remove_shards();
+}
+
+void test_options(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Options ---\n");
+
+    // Four-byte tokens, no separator, last sequence dropped, packed on the calling thread
+    llama_tokenizer_packer_params p = llama_tokenizer_packer_default_params();
+    p.seq_len = SEQ_LEN;
+    p.shard_sequences = SHARD_SEQUENCES;
+    p.token_bytes = 4;
+    p.add_separator = false;
+    p.drop_partial = true;
+    llama_tokenizer_packer_stats stats;
+    remove_shards();
+    const int packed = pack_all(tokenizer, NULL, &p, 1000, &stats);
+    shard s;
+    const int loaded = packed && load_shard(0, &s);
+    const llama_token separator = llama_tokenizer_should_add_eos(tokenizer) ? llama_tokenizer_token_eos(tokenizer) : -1;
+    check(loaded && s.header.token_bytes == 4 && stats.padding == 0 && stats.tokens == stats.sequences * SEQ_LEN,
+          "Four-byte tokens and drop_partial leave only full sequences",
+          "Options were not applied");
+    if (loaded) {
+        free_shard(&s);
+    }
+
+    // Segments of the kept sequences still match their documents
+    int prefix_ok = packed;
+    for (int k = 0; prefix_ok && k < (int)stats.shards; k++) {
+        prefix_ok = load_shard(k, &s);
+        for (uint64_t q = 0; prefix_ok && q < s.header.n_sequences; q++) {
+            for (uint64_t g = s.sequence_segments[q]; prefix_ok && g < s.sequence_segments[q + 1]; g++) {
+                const llama_tokenizer_pack_segment* seg = &s.segments[g];
+                llama_token doc[4096];
+                const int32_t n = packed_doc(tokenizer, seg->doc_id, separator, doc);
+                prefix_ok = seg->doc_offset + seg->length <= n &&
+                            memcmp(s.tokens + q * SEQ_LEN + seg->start, doc + seg->doc_offset,
+                                   (size_t)seg->length * sizeof(llama_token)) == 0;
+            }
+        }
+        free_shard(&s);
+    }
+    check(prefix_ok, "Segments match their documents without separators", "Segments without separators are wrong");
+    remove_shards();
+}
+
+void test_write_failure(llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    printf("\n--- Test: Write Failure ---\n");
+
+    llama_tokenizer_packer_params p = llama_tokenizer_packer_default_params();
+    p.seq_len = SEQ_LEN;
+    llama_tokenizer_packer_t* packer = llama_tokenizer_packer_create(tokenizer, pool, "no_such_dir_ltok/shard", &p);
+    int reported = packer != NULL;
+    if (packer) {
+        llama_tokenizer_packer_add(packer, (const char* const*)texts, text_lens, N_DOCS);
+        reported = llama_tokenizer_packer_finish(packer) == -1 &&
+                   llama_tokenizer_packer_add(packer, (const char* const*)texts, text_lens, 1) == -1;
+        llama_tokenizer_packer_destroy(packer);
+    }
+    check(reported, "A failed write is reported by finish and later adds fail", "Write failure not reported");
+}
+
+#ifdef __GLIBC__
+void test_out_of_memory(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Out Of Memory ---\n");
+
+    // Odd sizes so the chunk is the only allocation of its size: the first
+    // full chunk needs a new buffer, which fails
+    llama_tokenizer_packer_params p = llama_tokenizer_packer_default_params();
+    p.seq_len = 61;
+    p.shard_sequences = 7;
+    p.token_bytes = 4;
+    remove_shards();
+    llama_tokenizer_packer_t* packer = llama_tokenizer_packer_create(tokenizer, NULL, PREFIX, &p);
+    int reported = packer != NULL;
+    if (packer) {
+        failing_size = (size_t)(p.seq_len * p.shard_sequences * p.token_bytes);
+        const int32_t first = llama_tokenizer_packer_add(packer, (const char* const*)texts, text_lens, N_DOCS);
+        failing_size = 0;
+        reported = first == -1 &&
+                   llama_tokenizer_packer_add(packer, (const char* const*)texts, text_lens, N_DOCS) == -1 &&
+                   llama_tokenizer_packer_finish(packer) == -1;
+        llama_tokenizer_packer_destroy(packer);
+    }
+    check(reported, "A failed allocation is reported and later calls fail", "Allocation failure not reported");
+    remove_shards();
+}
+#endif
+
+void test_invalid_arguments(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Invalid Arguments ---\n");
+
+    llama_tokenizer_packer_params p = llama_tokenizer_packer_default_params();
+    llama_tokenizer_packer_params bad_len = p;
+    bad_len.seq_len = 0;
+    llama_tokenizer_packer_params bad_width = p;
+    bad_width.token_bytes = 3;
+    check(llama_tokenizer_packer_create(NULL, NULL, PREFIX, &p) == NULL &&
+              llama_tokenizer_packer_create(tokenizer, NULL, NULL, &p) == NULL &&
+              llama_tokenizer_packer_create(tokenizer, NULL, PREFIX, &bad_len) == NULL &&
+              llama_tokenizer_packer_create(tokenizer, NULL, PREFIX, &bad_width) == NULL,
+          "NULL tokenizer or prefix and bad parameters are rejected",
+          "Invalid packer parameters accepted");
+
+    // Ids that do not fit the 16-bit token width
+    llama_tokenizer_packer_params wide_pad = p;
+    wide_pad.token_bytes = 2;
+    wide_pad.pad_token = 70000;
+    llama_tokenizer_packer_params wide_separator = p;
+    wide_separator.token_bytes = 2;
+    wide_separator.separator = 70000;
+    check(llama_tokenizer_packer_create(tokenizer, NULL, PREFIX, &wide_pad) == NULL &&
+              (llama_tokenizer_should_add_eos(tokenizer) ||
+               llama_tokenizer_packer_create(tokenizer, NULL, PREFIX, &wide_separator) == NULL),
+          "Pad and separator ids wider than 16 bits are rejected for 2-byte tokens",
+          "A pad or separator id wider than 16 bits was accepted for 2-byte tokens");
+
+    llama_tokenizer_packer_stats stats;
+    check(llama_tokenizer_packer_add(NULL, (const char* const*)texts, text_lens, 1) == -1 &&
+              llama_tokenizer_packer_finish(NULL) == -1 && !llama_tokenizer_packer_get_stats(NULL, &stats),
+          "NULL packer returns -1 or false",
+          "NULL packer accepted");
+    remove_shards();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Sequence Packer Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        return 1;
+    }
+    llama_tokenizer_threadpool_params params = llama_tokenizer_threadpool_default_params();
+    params.n_threads = 4;
+    llama_tokenizer_threadpool_t* pool = llama_tokenizer_threadpool_create(&params);
+    if (!pool || !make_texts()) {
+        fprintf(stderr, "Setup failed\n");
+        return 1;
+    }
+
+    test_round_trip(tokenizer, pool);
+    test_options(tokenizer);
+    test_write_failure(tokenizer, pool);
+#ifdef __GLIBC__
+    test_out_of_memory(tokenizer);
+#endif
+    test_invalid_arguments(tokenizer);
+
+    for (int i = 0; i < N_DOCS; i++) {
+        free(texts[i]);
+    }
+    llama_tokenizer_threadpool_destroy(pool);
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
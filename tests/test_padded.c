@@ -0,0 +1,233 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_TEXTS 300
+#define MAX_LEN 48
+
+static const char* phrases[] = {
+    "Hello world",
+    "",
+    "The quick brown fox jumps over the lazy dog. ",
+    "Ünïcödé テキスト текст ",
+    "for (int i = 0; i < n; i++) { sum += i; } ",
+    "a",
+};
+
+static char* texts[N_TEXTS];
+static int32_t text_lens[N_TEXTS];
+
+static llama_token matrix[N_TEXTS * MAX_LEN];
+static uint8_t mask[N_TEXTS * MAX_LEN];
+static int32_t lengths[N_TEXTS];
+static int32_t row_order[N_TEXTS];
+
+// Text i repeats one phrase i % 7 times; many are longer than MAX_LEN tokens
+static int make_texts(void) {
+    const int n_phrases = (int)(sizeof(phrases) / sizeof(phrases[0]));
+    for (int i = 0; i < N_TEXTS; i++) {
+        const char* phrase = phrases[i % n_phrases];
+        const size_t len = strlen(phrase);
+        const int repeat = i % 7;
+        texts[i] = malloc(len * (size_t)repeat + 1);
+        if (!texts[i]) {
+            return 0;
+        }
+        for (int r = 0; r < repeat; r++) {
+            memcpy(texts[i] + len * (size_t)r, phrase, len);
+        }
+        text_lens[i] = (int32_t)(len * (size_t)repeat);
+        texts[i][text_lens[i]] = '\0';
+    }
+    return 1;
+}
+
+// Check every row against a single tokenize call: the leading tokens
+// match, a truncated row keeps the closing EOS, and padding and mask
+// agree with the row length
+static int rows_match(llama_tokenizer_t* tokenizer, const llama_tokenizer_pad_params* p, int32_t width,
+                      const int32_t* order) {
+    const llama_token pad = llama_tokenizer_token_pad(tokenizer) >= 0 ? llama_tokenizer_token_pad(tokenizer)
+                          : llama_tokenizer_token_eos(tokenizer) >= 0 ? llama_tokenizer_token_eos(tokenizer) : 0;
+    const llama_token eos = llama_tokenizer_token_eos(tokenizer);
+    llama_token full[8192];
+    for (int r = 0; r < N_TEXTS; r++) {
+        const int i = order ? order[r] : r;
+        const int32_t n = llama_tokenizer_tokenize(tokenizer, texts[i], text_lens[i], full, 8192, p->add_special, false);
+        const int32_t len = lengths[r];
+        if (n < 0 || len != (n < p->max_len ? n : p->max_len) || len > width) {
+            return 0;
+        }
+        const llama_token* row = matrix + (size_t)r * (size_t)width;
+        const uint8_t* row_mask = mask + (size_t)r * (size_t)width;
+        const int32_t first = p->pad_left ? width - len : 0;
+        const int32_t compare = n > len ? len - 2 : len;
+        if (memcmp(row + first, full, (size_t)compare * sizeof(llama_token)) != 0) {
+            return 0;
+        }
+        if (n > len && p->add_special && llama_tokenizer_should_add_eos(tokenizer) && row[first + len - 1] != eos) {
+            return 0;
+        }
+        for (int32_t c = 0; c < width; c++) {
+            const int is_token = c >= first && c < first + len;
+            if (row_mask[c] != is_token || (!is_token && row[c] != pad)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+void test_right_and_left(llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    printf("\n--- Test: Right And Left Padding ---\n");
+
+    llama_tokenizer_pad_params p = llama_tokenizer_pad_default_params();
+    p.max_len = MAX_LEN;
+
+    int32_t width = llama_tokenizer_tokenize_padded(tokenizer, pool, (const char* const*)texts, text_lens, N_TEXTS,
+                                                    &p, matrix, mask, lengths, NULL);
+    check(width == MAX_LEN && rows_match(tokenizer, &p, width, NULL),
+          "Right-padded rows, truncation and mask are correct",
+          "Right-padded matrix is wrong");
+
+    p.pad_left = true;
+    width = llama_tokenizer_tokenize_padded(tokenizer, NULL, (const char* const*)texts, text_lens, N_TEXTS,
+                                            &p, matrix, mask, lengths, NULL);
+    check(width == MAX_LEN && rows_match(tokenizer, &p, width, NULL),
+          "Left-padded rows on the calling thread are correct",
+          "Left-padded matrix is wrong");
+}
+
+void test_pad_to_longest(llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    printf("\n--- Test: Pad To Longest ---\n");
+
+    // Only the short texts, so the longest row is under MAX_LEN
+    const char* short_texts[N_TEXTS];
+    int32_t short_lens[N_TEXTS];
+    for (int i = 0; i < N_TEXTS; i++) {
+        short_texts[i] = texts[i];
+        short_lens[i] = text_lens[i] < 12 ? text_lens[i] : 12;
+    }
+    llama_tokenizer_pad_params p = llama_tokenizer_pad_default_params();
+    p.max_len = MAX_LEN;
+    p.pad_to_longest = true;
+    const int32_t width = llama_tokenizer_tokenize_padded(tokenizer, pool, short_texts, short_lens, N_TEXTS,
+                                                          &p, matrix, mask, lengths, NULL);
+    int32_t longest = 0;
+    for (int i = 0; i < N_TEXTS; i++) {
+        longest = lengths[i] > longest ? lengths[i] : longest;
+    }
+    int rows_ok = width == longest && width < MAX_LEN;
+    llama_token row[MAX_LEN];
+    for (int i = 0; rows_ok && i < N_TEXTS; i++) {
+        const int32_t n = llama_tokenizer_tokenize(tokenizer, short_texts[i], short_lens[i], row, MAX_LEN, true, false);
+        if (n != lengths[i] || memcmp(matrix + (size_t)i * (size_t)width, row, (size_t)n * sizeof(llama_token)) != 0) {
+            rows_ok = 0;
+        }
+    }
+    check(rows_ok, "Row stride narrows to the longest row", "Narrowed matrix is wrong");
+}
+
+void test_sort_by_length(llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    printf("\n--- Test: Sort By Length ---\n");
+
+    llama_tokenizer_pad_params p = llama_tokenizer_pad_default_params();
+    p.max_len = MAX_LEN;
+    p.sort_by_length = true;
+    const int32_t width = llama_tokenizer_tokenize_padded(tokenizer, pool, (const char* const*)texts, text_lens,
+                                                          N_TEXTS, &p, matrix, mask, lengths, row_order);
+
+    int sorted = width == MAX_LEN;
+    int seen[N_TEXTS] = {0};
+    for (int r = 0; sorted && r < N_TEXTS; r++) {
+        if (row_order[r] < 0 || row_order[r] >= N_TEXTS || seen[row_order[r]]++ ||
+            (r > 0 && lengths[r] > lengths[r - 1])) {
+            sorted = 0;
+        }
+    }
+    check(sorted, "Rows are longest first and row_order is a permutation", "Rows are not sorted by length");
+    check(sorted && rows_match(tokenizer, &p, width, row_order),
+          "Each sorted row holds the text row_order names",
+          "Sorted rows do not match their texts");
+}
+
+void test_invalid_arguments(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Invalid Arguments ---\n");
+
+    llama_tokenizer_pad_params p = llama_tokenizer_pad_default_params();
+    p.max_len = MAX_LEN;
+    const char* with_null[2] = {"ok", NULL};
+    const int32_t lens[2] = {2, 0};
+    check(llama_tokenizer_tokenize_padded(NULL, NULL, with_null, lens, 1, &p, matrix, NULL, NULL, NULL) == -1 &&
+              llama_tokenizer_tokenize_padded(tokenizer, NULL, with_null, lens, 2, &p, matrix, NULL, NULL, NULL) == -1 &&
+              llama_tokenizer_tokenize_padded(tokenizer, NULL, with_null, lens, 1, &p, NULL, NULL, NULL, NULL) == -1,
+          "NULL tokenizer, text or matrix returns -1",
+          "Invalid arguments accepted");
+
+    p.sort_by_length = true;
+    const int no_order = llama_tokenizer_tokenize_padded(tokenizer, NULL, with_null, lens, 1, &p, matrix, NULL, NULL, NULL);
+    p.sort_by_length = false;
+    p.max_len = 0;
+    const int no_columns = llama_tokenizer_tokenize_padded(tokenizer, NULL, with_null, lens, 1, &p, matrix, NULL, NULL, NULL);
+    check(no_order == -1 && no_columns == -1,
+          "Sorting without row_order and zero columns return -1",
+          "Invalid layout accepted");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Padded Batch Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        return 1;
+    }
+    llama_tokenizer_threadpool_params params = llama_tokenizer_threadpool_default_params();
+    params.n_threads = 4;
+    llama_tokenizer_threadpool_t* pool = llama_tokenizer_threadpool_create(&params);
+    if (!pool || !make_texts()) {
+        fprintf(stderr, "Setup failed\n");
+        return 1;
+    }
+
+    test_right_and_left(tokenizer, pool);
+    test_pad_to_longest(tokenizer, pool);
+    test_sort_by_length(tokenizer, pool);
+    test_invalid_arguments(tokenizer);
+
+    for (int i = 0; i < N_TEXTS; i++) {
+        free(texts[i]);
+    }
+    llama_tokenizer_threadpool_destroy(pool);
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
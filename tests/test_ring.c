@@ -0,0 +1,325 @@
+#include "llama_tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#define TEST_PASS(msg) printf(ANSI_COLOR_GREEN "✓ PASS" ANSI_COLOR_RESET ": %s\n", msg)
+#define TEST_FAIL(msg) printf(ANSI_COLOR_RED "✗ FAIL" ANSI_COLOR_RESET ": %s\n", msg)
+
+#define N_REQUESTS 600
+#define MAX_TOKENS 128
+#define MAX_TEXT 256
+
+int test_count = 0;
+int pass_count = 0;
+int fail_count = 0;
+
+static char texts[N_REQUESTS][MAX_TEXT];
+static int32_t text_lens[N_REQUESTS];
+
+static llama_token expected_tokens[N_REQUESTS][MAX_TOKENS];
+static int32_t expected_counts[N_REQUESTS];
+static int32_t expected_text_lens[N_REQUESTS];
+
+static llama_token out_tokens[N_REQUESTS][MAX_TOKENS];
+static char out_text[N_REQUESTS][MAX_TEXT * 2];
+
+static void report(int ok, const char* pass_msg, const char* fail_msg) {
+    test_count++;
+    if (ok) {
+        TEST_PASS(pass_msg);
+        pass_count++;
+    } else {
+        TEST_FAIL(fail_msg);
+        fail_count++;
+    }
+}
+
+static void build_requests(const llama_tokenizer_t* tokenizer) {
+    static const char* const words[] = {
+        "alpha", "beta", "gamma", "delta", "caf\xC3\xA9", "\xE6\x97\xA5\xE6\x9C\xAC", "42", "foo_bar", "!", "\n",
+    };
+    for (int i = 0; i < N_REQUESTS; i++) {
+        size_t len = 0;
+        int n_words = (i * 5) % 30;
+        for (int w = 0; w < n_words && len + 16 < MAX_TEXT; w++) {
+            len += (size_t)snprintf(texts[i] + len, MAX_TEXT - len, "%s ", words[(i + w) % 10]);
+        }
+        texts[i][len] = '\0';
+        text_lens[i] = (int32_t)len;
+
+        expected_counts[i] = llama_tokenizer_tokenize(tokenizer, texts[i], text_lens[i], expected_tokens[i],
+                                                      MAX_TOKENS, true, false);
+        expected_text_lens[i] = llama_tokenizer_detokenize(tokenizer, expected_tokens[i],
+                                                           expected_counts[i] > 0 ? expected_counts[i] : 0,
+                                                           NULL, 0, true, false);
+    }
+}
+
+// Request i: tokenize, count or detokenize text i depending on i % 3
+static llama_tokenizer_sqe make_sqe(int i) {
+    llama_tokenizer_sqe sqe;
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.user_data = (uint64_t)i;
+    switch (i % 3) {
+        case 0:
+            sqe.op = LLAMA_TOKENIZER_OP_TOKENIZE;
+            sqe.flags = LLAMA_TOKENIZER_RING_ADD_SPECIAL;
+            sqe.input = texts[i];
+            sqe.input_len = text_lens[i];
+            sqe.output = out_tokens[i];
+            sqe.output_cap = MAX_TOKENS;
+            break;
+        case 1:
+            sqe.op = LLAMA_TOKENIZER_OP_COUNT;
+            sqe.flags = LLAMA_TOKENIZER_RING_ADD_SPECIAL;
+            sqe.input = texts[i];
+            sqe.input_len = text_lens[i];
+            break;
+        default:
+            sqe.op = LLAMA_TOKENIZER_OP_DETOKENIZE;
+            sqe.flags = LLAMA_TOKENIZER_RING_REMOVE_SPECIAL;
+            sqe.input = expected_tokens[i];
+            sqe.input_len = expected_counts[i] > 0 ? expected_counts[i] : 0;
+            sqe.output = out_text[i];
+            sqe.output_cap = MAX_TEXT * 2;
+            break;
+    }
+    return sqe;
+}
+
+static int check_cqe(const llama_tokenizer_cqe* cqe, int expected_index) {
+    int i = (int)cqe->user_data;
+    if (i != expected_index) {
+        return 0;
+    }
+    switch (i % 3) {
+        case 0:
+            return cqe->result == expected_counts[i] &&
+                   (cqe->result <= 0 ||
+                    memcmp(out_tokens[i], expected_tokens[i], cqe->result * sizeof(llama_token)) == 0);
+        case 1:
+            return cqe->result == expected_counts[i];
+        default:
+            return cqe->result == expected_text_lens[i];
+    }
+}
+
+// Submit every request through the API, reaping as we go; the SQ is much
+// smaller than the request count so this also exercises backpressure
+static int run_requests(llama_tokenizer_ring_t* ring) {
+    memset(out_tokens, 0, sizeof(out_tokens));
+    int submitted = 0;
+    int reaped = 0;
+    llama_tokenizer_cqe cqes[64];
+    while (reaped < N_REQUESTS) {
+        while (submitted < N_REQUESTS) {
+            llama_tokenizer_sqe sqe = make_sqe(submitted);
+            int32_t n = llama_tokenizer_ring_submit(ring, &sqe, 1);
+            if (n < 0) {
+                return 0;
+            }
+            if (n == 0) {
+                break;
+            }
+            submitted++;
+        }
+        if (llama_tokenizer_ring_wait(ring, 1, 5000) < 1) {
+            return 0;
+        }
+        int32_t n = llama_tokenizer_ring_reap(ring, cqes, 64);
+        for (int32_t k = 0; k < n; k++) {
+            if (!check_cqe(&cqes[k], reaped)) {
+                return 0;
+            }
+            reaped++;
+        }
+    }
+    return llama_tokenizer_ring_reap(ring, cqes, 64) == 0;
+}
+
+// Same through the shared ring memory, with one enter() per batch
+static int run_requests_shared(llama_tokenizer_ring_t* ring) {
+    llama_tokenizer_ring_info info;
+    if (!llama_tokenizer_ring_get_info(ring, &info)) {
+        return 0;
+    }
+    memset(out_tokens, 0, sizeof(out_tokens));
+    int submitted = 0;
+    int reaped = 0;
+    while (reaped < N_REQUESTS) {
+        uint32_t tail = __atomic_load_n(info.sq_tail, __ATOMIC_RELAXED);
+        uint32_t sq_head = __atomic_load_n(info.sq_head, __ATOMIC_ACQUIRE);
+        while (submitted < N_REQUESTS && tail - sq_head <= info.sq_mask) {
+            info.sqes[tail & info.sq_mask] = make_sqe(submitted++);
+            tail++;
+        }
+        __atomic_store_n(info.sq_tail, tail, __ATOMIC_RELEASE);
+        llama_tokenizer_ring_enter(ring);
+
+        if (llama_tokenizer_ring_wait(ring, 1, 5000) < 1) {
+            return 0;
+        }
+        uint32_t head = __atomic_load_n(info.cq_head, __ATOMIC_RELAXED);
+        uint32_t cq_tail = __atomic_load_n(info.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != cq_tail; head++) {
+            if (!check_cqe(&info.cqes[head & info.cq_mask], reaped++)) {
+                return 0;
+            }
+        }
+        __atomic_store_n(info.cq_head, head, __ATOMIC_RELEASE);
+        llama_tokenizer_ring_enter(ring);
+    }
+    return 1;
+}
+
+void test_ring(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Request Ring ---\n");
+
+    llama_tokenizer_ring_t* ring = llama_tokenizer_ring_create(tokenizer, NULL, 16);
+    report(ring != NULL, "Ring created without a pool", "Ring should be created without a pool");
+    if (ring) {
+        report(run_requests(ring), "Mixed requests complete in order (no pool)",
+               "Mixed requests should complete in order (no pool)");
+        llama_tokenizer_ring_destroy(ring);
+    }
+
+    llama_tokenizer_threadpool_params params = llama_tokenizer_threadpool_default_params();
+    params.n_threads = 4;
+    llama_tokenizer_threadpool_t* pool = llama_tokenizer_threadpool_create(&params);
+    ring = pool ? llama_tokenizer_ring_create(tokenizer, pool, 100) : NULL;
+    report(ring != NULL, "Ring created on a 4-worker pool", "Ring should be created on a 4-worker pool");
+    if (ring) {
+        llama_tokenizer_ring_info info;
+        report(llama_tokenizer_ring_get_info(ring, &info) && info.sq_mask == 127 && info.cq_mask == 255,
+               "SQ rounded up to 128 entries, CQ twice that",
+               "SQ should round up to 128 entries, CQ twice that");
+
+        report(run_requests(ring), "Mixed requests complete in order (pool)",
+               "Mixed requests should complete in order (pool)");
+        report(run_requests_shared(ring), "Shared ring memory submission and reaping",
+               "Shared ring memory submission and reaping should work");
+        report(llama_tokenizer_ring_wait(ring, 1, 10) == 0, "Wait times out on an idle ring",
+               "Wait should time out on an idle ring");
+
+#ifdef __linux__
+        int fd = llama_tokenizer_ring_eventfd(ring);
+        int ok = fd >= 0;
+        if (ok) {
+            uint64_t drained;
+            while (read(fd, &drained, sizeof(drained)) > 0) {
+            }
+            llama_tokenizer_sqe sqe = make_sqe(1);
+            ok = llama_tokenizer_ring_submit(ring, &sqe, 1) == 1;
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            ok = ok && poll(&pfd, 1, 5000) == 1 && (pfd.revents & POLLIN);
+            uint64_t count = 0;
+            ok = ok && read(fd, &count, sizeof(count)) == sizeof(count) && count == 1;
+            llama_tokenizer_cqe cqe;
+            ok = ok && llama_tokenizer_ring_reap(ring, &cqe, 1) == 1 && check_cqe(&cqe, 1);
+        }
+        report(ok, "Eventfd signals completions", "Eventfd should signal completions");
+#endif
+
+        // Unknown ops complete with an error instead of stalling the ring
+        llama_tokenizer_sqe bad;
+        memset(&bad, 0, sizeof(bad));
+        bad.user_data = 7;
+        bad.op = 99;
+        llama_tokenizer_cqe cqe;
+        int ok_bad = llama_tokenizer_ring_submit(ring, &bad, 1) == 1 &&
+                     llama_tokenizer_ring_wait(ring, 1, 5000) == 1 &&
+                     llama_tokenizer_ring_reap(ring, &cqe, 1) == 1 &&
+                     cqe.user_data == 7 && cqe.result < 0;
+        report(ok_bad, "Unknown op completes with an error", "Unknown op should complete with an error");
+
+        // Destroy with work still queued
+        for (int i = 0; i < 100; i++) {
+            llama_tokenizer_sqe sqe = make_sqe(i);
+            llama_tokenizer_ring_submit(ring, &sqe, 1);
+        }
+        llama_tokenizer_ring_destroy(ring);
+    }
+    llama_tokenizer_threadpool_destroy(pool);
+}
+
+void test_invalid_args(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Invalid Ring Arguments ---\n");
+
+    llama_tokenizer_ring_t* ring = llama_tokenizer_ring_create(tokenizer, NULL, 4);
+    llama_tokenizer_sqe sqe = make_sqe(0);
+    llama_tokenizer_cqe cqe;
+    llama_tokenizer_ring_info info;
+    int ok = ring != NULL &&
+             llama_tokenizer_ring_create(NULL, NULL, 4) == NULL &&
+             llama_tokenizer_ring_create(tokenizer, NULL, 0) == NULL &&
+             llama_tokenizer_ring_submit(NULL, &sqe, 1) < 0 &&
+             llama_tokenizer_ring_submit(ring, NULL, 1) < 0 &&
+             llama_tokenizer_ring_submit(ring, &sqe, -1) < 0 &&
+             llama_tokenizer_ring_submit(ring, NULL, 0) == 0 &&
+             llama_tokenizer_ring_reap(NULL, &cqe, 1) < 0 &&
+             llama_tokenizer_ring_reap(ring, NULL, 1) < 0 &&
+             llama_tokenizer_ring_wait(NULL, 1, 0) < 0 &&
+             llama_tokenizer_ring_eventfd(NULL) < 0 &&
+             !llama_tokenizer_ring_get_info(NULL, &info) &&
+             !llama_tokenizer_ring_get_info(ring, NULL);
+    llama_tokenizer_ring_enter(NULL);
+    llama_tokenizer_ring_destroy(NULL);
+    llama_tokenizer_ring_destroy(ring);
+    report(ok, "Invalid arguments are rejected", "Invalid arguments should be rejected");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Request Ring Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", argv[1]);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+
+    build_requests(tokenizer);
+
+    test_ring(tokenizer);
+    test_invalid_args(tokenizer);
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
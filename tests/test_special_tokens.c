@@ -0,0 +1,214 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 4096
+#define MAX_TEXT 8192
+#define MAX_SPECIALS 256
+#define ROUNDS 3000
+
+static llama_token expected[MAX_TOKENS];
+static llama_token actual[MAX_TOKENS];
+static char text[MAX_TEXT];
+
+static const char* specials[MAX_SPECIALS];
+static int n_specials = 0;
+
+// Control tokens, and tokens whose text looks like markup (user-defined
+// tokens such as <|im_start|> or [INST] usually do)
+static void collect_specials(const llama_tokenizer_t* tokenizer) {
+    const int32_t n_vocab = llama_tokenizer_vocab_size(tokenizer);
+    for (int pass = 0; pass < 2; pass++) {
+        for (llama_token id = 0; id < n_vocab && n_specials < MAX_SPECIALS; id++) {
+            const char* piece = llama_tokenizer_token_get_text(tokenizer, id);
+            if (!piece || strlen(piece) < 2) {
+                continue;
+            }
+            const int control = llama_tokenizer_is_control(tokenizer, id);
+            if ((pass == 0 && control) || (pass == 1 && !control && strpbrk(piece, "<>[]|"))) {
+                specials[n_specials++] = piece;
+            }
+        }
+    }
+}
+
+// Whether the wrapper agrees with llama.cpp on text for every flag combination
+static int matches_llama(const llama_tokenizer_t* tokenizer, const char* s, int32_t len) {
+    for (int flags = 0; flags < 4; flags++) {
+        const bool add_special = (flags & 1) != 0;
+        const bool parse_special = (flags & 2) != 0;
+        const int32_t n_expected = llama_tokenizer_tokenize_reference(tokenizer, s, len, expected, MAX_TOKENS,
+                                                                      add_special, parse_special);
+        const int32_t n_actual = llama_tokenizer_tokenize(tokenizer, s, len, actual, MAX_TOKENS, add_special,
+                                                          parse_special);
+        if (n_expected < 0 || n_actual != n_expected ||
+            memcmp(actual, expected, (size_t)n_expected * sizeof(llama_token)) != 0) {
+            printf("  mismatch (add_special=%d parse_special=%d): \"%.*s\"\n", add_special, parse_special,
+                   (int)len, s);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int32_t append(int32_t len, const char* s, size_t n) {
+    if (len + n >= MAX_TEXT) {
+        return len;
+    }
+    memcpy(text + len, s, n);
+    return len + (int32_t)n;
+}
+
+void test_placements(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Special Tokens in Context ---\n");
+
+    // Alone, and with whitespace on either side for LSTRIP/RSTRIP tokens
+    int all_match = 1;
+    for (int i = 0; i < n_specials && all_match; i++) {
+        const char* contexts[][2] = { { "", "" }, { "a ", " b" }, { "  \n", "\t  " }, { "x", "y" }, { " ", "" } };
+        for (size_t c = 0; c < sizeof(contexts) / sizeof(contexts[0]) && all_match; c++) {
+            int32_t len = append(0, contexts[c][0], strlen(contexts[c][0]));
+            len = append(len, specials[i], strlen(specials[i]));
+            len = append(len, contexts[c][1], strlen(contexts[c][1]));
+            all_match = matches_llama(tokenizer, text, len);
+        }
+    }
+    check(all_match, "Each special token matches llama.cpp alone and between whitespace",
+          "A special token in context differs from llama.cpp");
+
+    // Back to back, sharing bytes, and cut short
+    int adjacent_match = 1;
+    for (int i = 0; i < n_specials && adjacent_match; i++) {
+        const size_t len_i = strlen(specials[i]);
+        for (int j = 0; j < n_specials && j < 32 && adjacent_match; j++) {
+            const size_t len_j = strlen(specials[j]);
+            int32_t len = append(0, specials[i], len_i);
+            len = append(len, specials[j], len_j);
+            adjacent_match = matches_llama(tokenizer, text, len);
+
+            // The tail of one overlapping the head of the other
+            len = append(0, specials[i], len_i - 1);
+            len = append(len, specials[j], len_j);
+            adjacent_match &= matches_llama(tokenizer, text, len);
+            len = append(0, specials[i], len_i);
+            len = append(len, specials[j] + 1, len_j - 1);
+            adjacent_match &= matches_llama(tokenizer, text, len);
+        }
+    }
+    check(adjacent_match, "Adjacent and overlapping special tokens match llama.cpp",
+          "Adjacent or overlapping special tokens differ from llama.cpp");
+}
+
+void test_random(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Random Mixes ---\n");
+
+    const char* fillers[] = { " ", "  ", "\n", "\t", "hello", "a b", "\xC3\xA9", "\xFF", "<", "|>", "]" };
+    const int n_fillers = (int)(sizeof(fillers) / sizeof(fillers[0]));
+
+    srand(27);
+    int all_match = 1;
+    for (int round = 0; round < ROUNDS && all_match; round++) {
+        int32_t len = 0;
+        const int n_pieces = 1 + rand() % 10;
+        for (int p = 0; p < n_pieces; p++) {
+            const int kind = rand() % 3;
+            if (kind == 0 && n_specials > 0) {
+                const char* s = specials[rand() % n_specials];
+                len = append(len, s, strlen(s));
+            } else if (kind == 1 && n_specials > 0) {
+                // Part of a special token
+                const char* s = specials[rand() % n_specials];
+                const size_t n = strlen(s);
+                const size_t start = (size_t)rand() % n;
+                len = append(len, s + start, 1 + (size_t)rand() % (n - start));
+            } else {
+                const char* s = fillers[rand() % n_fillers];
+                len = append(len, s, strlen(s));
+            }
+        }
+        all_match = matches_llama(tokenizer, text, len);
+    }
+    check(all_match, "Random mixes of special tokens, fragments and text match llama.cpp",
+          "A random mix differs from llama.cpp");
+}
+
+void test_short_buffer(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Buffer Too Small ---\n");
+
+    // Text with special tokens between raw fragments, so every kind of
+    // output is pending when the buffer runs out
+    int32_t len = append(0, "Hello ", 6);
+    for (int i = 0; i < n_specials && i < 4; i++) {
+        len = append(len, specials[i], strlen(specials[i]));
+        len = append(len, " world ", 7);
+    }
+
+    int untouched = 1;
+    for (int flags = 0; flags < 4; flags++) {
+        const bool add_special = (flags & 1) != 0;
+        const bool parse_special = (flags & 2) != 0;
+        const int32_t needed = llama_tokenizer_tokenize(tokenizer, text, len, NULL, 0, add_special, parse_special);
+        for (int32_t room = 0; room < needed; room++) {
+            for (int32_t i = 0; i < needed; i++) {
+                actual[i] = -7;
+            }
+            const int32_t result = llama_tokenizer_tokenize(tokenizer, text, len, actual, room, add_special,
+                                                            parse_special);
+            untouched &= result == -needed;
+            for (int32_t i = 0; i < needed; i++) {
+                untouched &= actual[i] == -7;
+            }
+        }
+    }
+    check(untouched, "A buffer that is too small is left untouched, as llama.cpp leaves it",
+          "Tokens were written to a buffer that was too small");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model.gguf>\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Special Token Partition Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+
+    collect_specials(tokenizer);
+    printf("Special tokens: %d\n", n_specials);
+
+    test_placements(tokenizer);
+    test_random(tokenizer);
+    test_short_buffer(tokenizer);
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
@@ -0,0 +1,193 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 1024
+#define N_THREADS 8
+#define CALLS_PER_THREAD 2000
+
+static const char* const text = "The quick brown fox jumps over the lazy dog.";
+
+static uint64_t histogram_total(const llama_tokenizer_entry_stats* e) {
+    uint64_t total = 0;
+    for (int b = 0; b < LLAMA_TOKENIZER_STATS_HISTOGRAM_BUCKETS; b++) {
+        total += e->latency_histogram[b];
+    }
+    return total;
+}
+
+void test_tokenize_counters(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Tokenize Counters ---\n");
+
+    llama_token tokens[MAX_TOKENS];
+    const int32_t len = (int32_t)strlen(text);
+    llama_tokenizer_reset_stats(tokenizer);
+
+    // One count-only call, one fill call, one call with a buffer too small
+    int32_t n = llama_tokenizer_tokenize(tokenizer, text, len, NULL, 0, false, false);
+    int32_t n_fill = llama_tokenizer_tokenize(tokenizer, text, len, tokens, MAX_TOKENS, false, false);
+    int32_t n_small = llama_tokenizer_tokenize(tokenizer, text, len, tokens, 1, false, false);
+    // Invalid arguments are not counted
+    llama_tokenizer_tokenize(tokenizer, NULL, 5, tokens, MAX_TOKENS, false, false);
+
+    llama_tokenizer_stats stats;
+    if (!llama_tokenizer_get_stats(tokenizer, &stats)) {
+        test_count++;
+        printf("SKIP: library built without stats\n");
+        pass_count++;
+        return;
+    }
+    const llama_tokenizer_entry_stats* e = &stats.entries[LLAMA_TOKENIZER_STATS_TOKENIZE];
+
+    check(e->calls == 3 && e->count_only_calls == 1 && e->fill_calls == 2,
+          "Calls split into count-only and fill",
+          "Expected 3 calls: 1 count-only, 2 fill");
+    check(n > 1 && n_small < 0 && e->buffer_too_small == 1,
+          "Buffer-too-small result counted",
+          "Expected one buffer-too-small call");
+    check(e->input == 3 * (uint64_t)len && e->output == (uint64_t)n + (uint64_t)n_fill,
+          "Input bytes and output tokens summed",
+          "Input bytes or output tokens do not match the calls");
+    check(histogram_total(e) == e->calls && e->total_ns > 0,
+          "Latency histogram covers every call",
+          "Histogram total should equal the call count");
+}
+
+void test_other_entry_points(const llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    printf("\n--- Test: Other Entry Points ---\n");
+
+    llama_token tokens[MAX_TOKENS];
+    char out[4096];
+    const int32_t len = (int32_t)strlen(text);
+    int32_t n = llama_tokenizer_tokenize(tokenizer, text, len, tokens, MAX_TOKENS, false, false);
+    llama_tokenizer_reset_stats(tokenizer);
+
+    int32_t n_bytes = llama_tokenizer_detokenize(tokenizer, tokens, n, out, sizeof(out), false, false);
+    char piece[64];
+    int32_t n_piece = llama_tokenizer_token_to_piece(tokenizer, tokens[0], piece, sizeof(piece));
+
+    const char* texts[4] = { text, text, "", "a" };
+    int32_t lens[4] = { len, len, 0, 1 };
+    int32_t counts[4];
+    llama_tokenizer_tokenize_batch(tokenizer, pool, texts, lens, 4, NULL, NULL, counts, false, false);
+
+    llama_tokenizer_stats stats;
+    if (!llama_tokenizer_get_stats(tokenizer, &stats)) {
+        return;
+    }
+    const llama_tokenizer_entry_stats* detok = &stats.entries[LLAMA_TOKENIZER_STATS_DETOKENIZE];
+    const llama_tokenizer_entry_stats* piece_stats = &stats.entries[LLAMA_TOKENIZER_STATS_TOKEN_TO_PIECE];
+    const llama_tokenizer_entry_stats* batch = &stats.entries[LLAMA_TOKENIZER_STATS_TOKENIZE_BATCH];
+    const llama_tokenizer_entry_stats* tok = &stats.entries[LLAMA_TOKENIZER_STATS_TOKENIZE];
+
+    check(detok->calls == 1 && detok->input == (uint64_t)n && detok->output == (uint64_t)n_bytes,
+          "Detokenize: tokens in, bytes out",
+          "Detokenize counters do not match the call");
+    check(piece_stats->calls == 1 && piece_stats->output == (uint64_t)n_piece,
+          "Token to piece counted",
+          "Token to piece counters do not match the call");
+    check(batch->calls == 1 && batch->input == 4 && batch->count_only_calls == 1 && tok->calls == 4,
+          "Batch counted once, its texts as tokenize calls",
+          "Expected 1 batch call covering 4 tokenize calls");
+}
+
+void test_reset(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Reset ---\n");
+
+    llama_tokenizer_tokenize(tokenizer, text, (int32_t)strlen(text), NULL, 0, true, true);
+    llama_tokenizer_reset_stats(tokenizer);
+
+    llama_tokenizer_stats stats;
+    static const llama_tokenizer_stats zero;
+    if (!llama_tokenizer_get_stats(tokenizer, &stats)) {
+        return;
+    }
+    check(memcmp(&stats, &zero, sizeof(stats)) == 0,
+          "All counters zero after reset",
+          "Counters should be zero after reset");
+}
+
+static void* worker_main(void* arg) {
+    const llama_tokenizer_t* tokenizer = (const llama_tokenizer_t*)arg;
+    const int32_t len = (int32_t)strlen(text);
+    for (int i = 0; i < CALLS_PER_THREAD; i++) {
+        llama_tokenizer_tokenize(tokenizer, text, len, NULL, 0, false, false);
+    }
+    return NULL;
+}
+
+void test_concurrent_counting(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Concurrent Counting ---\n");
+
+    llama_tokenizer_reset_stats(tokenizer);
+
+    pthread_t threads[N_THREADS];
+    for (int t = 0; t < N_THREADS; t++) {
+        pthread_create(&threads[t], NULL, worker_main, (void*)tokenizer);
+    }
+    for (int t = 0; t < N_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    llama_tokenizer_stats stats;
+    if (!llama_tokenizer_get_stats(tokenizer, &stats)) {
+        return;
+    }
+    const llama_tokenizer_entry_stats* e = &stats.entries[LLAMA_TOKENIZER_STATS_TOKENIZE];
+    const uint64_t expected = (uint64_t)N_THREADS * CALLS_PER_THREAD;
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%llu calls from %d threads, none lost", (unsigned long long)e->calls, N_THREADS);
+    check(e->calls == expected && histogram_total(e) == expected, msg,
+          "Concurrent calls should all be counted");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Stats Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", argv[1]);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+    llama_tokenizer_threadpool_t* pool = llama_tokenizer_threadpool_create(NULL);
+
+    test_tokenize_counters(tokenizer);
+    test_other_entry_points(tokenizer, pool);
+    test_reset(tokenizer);
+    test_concurrent_counting(tokenizer);
+
+    llama_tokenizer_threadpool_destroy(pool);
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
@@ -0,0 +1,259 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 1024
+#define MAX_CANDIDATES 4096
+
+static llama_token path[MAX_TOKENS];
+static int64_t path_start[MAX_TOKENS + 1];
+static llama_token candidates[MAX_CANDIDATES];
+
+// Tokens spelling text exactly, the longest piece at each position, with
+// each token's start offset
+static int32_t spell(llama_tokenizer_t* tokenizer, const char* text, int32_t len) {
+    int32_t n = 0;
+    int32_t pos = 0;
+    while (pos < len && n < MAX_TOKENS) {
+        const int32_t n_candidates = llama_tokenizer_tokens_prefix_of(tokenizer, text + pos, len - pos,
+                                                                      candidates, MAX_CANDIDATES);
+        if (n_candidates <= 0) {
+            return -1;
+        }
+        const llama_token longest = candidates[n_candidates - 1];
+        char piece[256];
+        const int32_t piece_len = llama_tokenizer_token_to_piece(tokenizer, longest, piece, sizeof(piece));
+        if (piece_len <= 0) {
+            return -1;
+        }
+        path_start[n] = pos;
+        path[n++] = longest;
+        pos += piece_len;
+    }
+    path_start[n] = pos;
+    return n;
+}
+
+// Earliest-ending occurrence of any stop, the longest among those ending
+// at the same byte; returns the stop index with its start, or -1
+static int32_t first_stop(const char* text, int32_t len, const char* const* stops, int32_t n_stops, int64_t* start) {
+    for (int32_t end = 1; end <= len; end++) {
+        int32_t best = -1;
+        for (int32_t i = 0; i < n_stops; i++) {
+            const int32_t stop_len = (int32_t)strlen(stops[i]);
+            if (stop_len > 0 && stop_len <= end && memcmp(text + end - stop_len, stops[i], stop_len) == 0 &&
+                (best < 0 || stop_len > (int32_t)strlen(stops[best]))) {
+                best = i;
+            }
+        }
+        if (best >= 0) {
+            *start = end - (int64_t)strlen(stops[best]);
+            return best;
+        }
+    }
+    return -1;
+}
+
+// Feed text one token at a time and compare against a plain scan
+static int matches_scan(llama_tokenizer_t* tokenizer, const llama_tokenizer_stops_t* stops,
+                        const char* const* strings, int32_t n_strings, const char* text) {
+    const int32_t len = (int32_t)strlen(text);
+    const int32_t n = spell(tokenizer, text, len);
+    llama_tokenizer_stop_stream_t* stream = llama_tokenizer_stop_stream_create(stops);
+    if (n < 0 || !stream) {
+        llama_tokenizer_stop_stream_free(stream);
+        return 0;
+    }
+
+    llama_tokenizer_stop_match match;
+    int32_t stopped_at = -1;
+    for (int32_t i = 0; i < n && stopped_at < 0; i++) {
+        if (llama_tokenizer_stop_stream_feed(stream, &path[i], 1, &match) == 1) {
+            stopped_at = i;
+        }
+    }
+    llama_tokenizer_stop_stream_free(stream);
+
+    int64_t start = 0;
+    const int32_t expected = first_stop(text, len, strings, n_strings, &start);
+    if (expected < 0) {
+        return stopped_at < 0;
+    }
+    const int64_t end = start + (int64_t)strlen(strings[expected]);
+    return stopped_at >= 0 && match.stop_index == expected && match.byte_offset == start &&
+           path_start[stopped_at] < end && end <= path_start[stopped_at + 1] &&
+           path_start[match.token_index] + match.token_offset == start &&
+           start < path_start[match.token_index + 1];
+}
+
+void test_stop_strings(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Stop Strings ---\n");
+
+    const char* strings[] = { "\n\nUser:", "###", "END", "abcd", "bc" };
+    const int32_t lens[] = { 7, 3, 3, 4, 2 };
+    llama_tokenizer_stops_t* stops = llama_tokenizer_stops_create(tokenizer, strings, lens, 5, NULL, 0, NULL);
+    if (!stops) {
+        check(0, "", "Failed to create stop set");
+        return;
+    }
+
+    check(matches_scan(tokenizer, stops, strings, 5, "Sure, here it is.\n\nUser: thanks") &&
+              matches_scan(tokenizer, stops, strings, 5, "one ## two #### three") &&
+              matches_scan(tokenizer, stops, strings, 5, "the ENDing") &&
+              matches_scan(tokenizer, stops, strings, 5, "no stop here at all\n\nUse"),
+          "Stops spanning tokens are found where a scan of the text finds them",
+          "Stop string missed or misplaced");
+
+    check(matches_scan(tokenizer, stops, strings, 5, "xabcd"),
+          "The match ending first wins over a longer one ending later",
+          "Wrong stop chosen among overlapping matches");
+
+    // Random texts over a few bytes, so matches often overlap and span tokens
+    srand(48);
+    const char alphabet[] = "abcd#EN \n";
+    int all_match = 1;
+    for (int round = 0; round < 300 && all_match; round++) {
+        char text[64];
+        const int len = 1 + rand() % 60;
+        for (int i = 0; i < len; i++) {
+            text[i] = alphabet[rand() % (sizeof(alphabet) - 1)];
+        }
+        text[len] = 0;
+        all_match = matches_scan(tokenizer, stops, strings, 5, text);
+    }
+    check(all_match, "Random streams agree with a scan of the text", "Random stream disagrees with scan");
+
+    // A whole batch stops at the same token as one at a time, and the
+    // rest can be fed on
+    const char* text = "a ### b ### c";
+    const int32_t n = spell(tokenizer, text, (int32_t)strlen(text));
+    llama_tokenizer_stop_stream_t* stream = llama_tokenizer_stop_stream_create(stops);
+    llama_tokenizer_stop_match first, second;
+    const int32_t consumed = llama_tokenizer_stop_stream_feed(stream, path, n, &first);
+    const int32_t rest = consumed > 0 ? llama_tokenizer_stop_stream_feed(stream, path + consumed, n - consumed, &second) : 0;
+    check(consumed > 0 && first.byte_offset == 2 && path_start[consumed] >= 5 && path_start[consumed - 1] < 5 &&
+              rest > 0 && second.byte_offset == 8,
+          "A batch stops at the completing token and feeding the rest finds the next stop",
+          "Batch feed stopped at the wrong token");
+
+    llama_tokenizer_stop_stream_reset(stream);
+    const int32_t n_partial = spell(tokenizer, "done\n\nUs", 8);
+    const int32_t none = llama_tokenizer_stop_stream_feed(stream, path, n_partial, NULL);
+    check(none == 0 && llama_tokenizer_stop_stream_pending(stream) == 4,
+          "The partly matched tail is reported as pending",
+          "Pending bytes wrong");
+
+    llama_tokenizer_stop_stream_free(stream);
+    llama_tokenizer_stops_free(stops);
+}
+
+void test_stop_tokens(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Stop Tokens ---\n");
+
+    const llama_token eos = llama_tokenizer_token_eos(tokenizer);
+    const int32_t n = spell(tokenizer, "xyz", 3);
+    if (eos < 0 || n <= 0) {
+        check(0, "", "No end-of-sentence token or pieces");
+        return;
+    }
+    const llama_token stop_token = path[n - 1];
+    llama_token stream_tokens[MAX_TOKENS + 1];
+    memcpy(stream_tokens, path, (size_t)n * sizeof(llama_token));
+    stream_tokens[n] = eos;
+
+    llama_tokenizer_stops_t* eog = llama_tokenizer_stops_create(tokenizer, NULL, NULL, 0, NULL, 0, NULL);
+    llama_tokenizer_stops_params params = llama_tokenizer_stops_default_params();
+    params.stop_on_eog = false;
+    llama_tokenizer_stops_t* by_id = llama_tokenizer_stops_create(tokenizer, NULL, NULL, 0, &stop_token, 1, &params);
+    llama_tokenizer_stop_stream_t* a = llama_tokenizer_stop_stream_create(eog);
+    llama_tokenizer_stop_stream_t* b = llama_tokenizer_stop_stream_create(by_id);
+    llama_tokenizer_stop_stream_t* c = llama_tokenizer_stop_stream_create(by_id);
+
+    llama_tokenizer_stop_match match_a, match_b;
+    const int32_t consumed_a = llama_tokenizer_stop_stream_feed(a, stream_tokens, n + 1, &match_a);
+    const int32_t consumed_b = llama_tokenizer_stop_stream_feed(b, stream_tokens, n + 1, &match_b);
+    check(consumed_a == n + 1 && match_a.stop_index == -1 && match_a.token_index == n && match_a.byte_offset == 3 &&
+              consumed_b == n && match_b.stop_index == -1 && match_b.token_index == n - 1 &&
+              match_b.byte_offset == path_start[n - 1] &&
+              llama_tokenizer_stop_stream_feed(c, &eos, 1, NULL) == 0,
+          "End-of-generation and listed tokens stop by id",
+          "Stop token missed or misplaced");
+
+    llama_tokenizer_stop_stream_free(a);
+    llama_tokenizer_stop_stream_free(b);
+    llama_tokenizer_stop_stream_free(c);
+    llama_tokenizer_stops_free(eog);
+    llama_tokenizer_stops_free(by_id);
+}
+
+void test_invalid(llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Invalid Arguments ---\n");
+
+    const char* strings[] = { "stop" };
+    const int32_t lens[] = { 4 };
+    const int32_t bad_lens[] = { -1 };
+    const llama_token bad_token = llama_tokenizer_vocab_size(tokenizer);
+    llama_tokenizer_stops_t* stops = llama_tokenizer_stops_create(tokenizer, strings, lens, 1, NULL, 0, NULL);
+    llama_tokenizer_stop_stream_t* stream = llama_tokenizer_stop_stream_create(stops);
+
+    check(llama_tokenizer_stops_create(NULL, strings, lens, 1, NULL, 0, NULL) == NULL &&
+              llama_tokenizer_stops_create(tokenizer, strings, NULL, 1, NULL, 0, NULL) == NULL &&
+              llama_tokenizer_stops_create(tokenizer, strings, bad_lens, 1, NULL, 0, NULL) == NULL &&
+              llama_tokenizer_stops_create(tokenizer, NULL, NULL, 0, &bad_token, 1, NULL) == NULL &&
+              llama_tokenizer_stop_stream_create(NULL) == NULL &&
+              llama_tokenizer_stop_stream_feed(stream, &bad_token, 1, NULL) == -1 &&
+              llama_tokenizer_stop_stream_feed(stream, NULL, 1, NULL) == -1 &&
+              llama_tokenizer_stop_stream_feed(NULL, NULL, 0, NULL) == -1 &&
+              llama_tokenizer_stop_stream_feed(stream, NULL, 0, NULL) == 0 &&
+              llama_tokenizer_stop_stream_pending(NULL) == -1,
+          "Invalid arguments are rejected",
+          "Invalid stop arguments were accepted");
+
+    llama_tokenizer_stop_stream_free(stream);
+    llama_tokenizer_stops_free(stops);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model.gguf>\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Stop Sequence Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        return 1;
+    }
+
+    test_stop_strings(tokenizer);
+    test_stop_tokens(tokenizer);
+    test_invalid(tokenizer);
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
@@ -0,0 +1,251 @@
+#include "llama_tokenizer.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#define TEST_PASS(msg) printf(ANSI_COLOR_GREEN "✓ PASS" ANSI_COLOR_RESET ": %s\n", msg)
+#define TEST_FAIL(msg) printf(ANSI_COLOR_RED "✗ FAIL" ANSI_COLOR_RESET ": %s\n", msg)
+
+#define DEFAULT_THREADS 8
+#define MAX_THREADS 256
+#define ITERATIONS 500
+#define MAX_TOKENS 2048
+#define MAX_TEXT 2048
+
+int test_count = 0;
+int pass_count = 0;
+int fail_count = 0;
+
+#define N_TEXTS 8
+static char texts[N_TEXTS][MAX_TEXT];
+
+// Results computed single-threaded, per text and [add_special][parse_special]
+typedef struct {
+    int32_t n_tokens[2][2];
+    llama_token tokens[2][2][MAX_TOKENS];
+    int32_t n_text;
+    char text[MAX_TEXT];
+} reference;
+
+static reference refs[N_TEXTS];
+
+typedef struct {
+    llama_token bos;
+    llama_token eos;
+    int32_t vocab_size;
+    char bos_piece[64];
+    int32_t bos_piece_len;
+} metadata;
+
+static metadata ref_meta;
+
+typedef struct {
+    const llama_tokenizer_t* tokenizer;
+    int thread_id;
+    int mismatches;
+} worker;
+
+static void build_texts(const llama_tokenizer_t* tokenizer) {
+    const char* bos_text = llama_tokenizer_token_get_text(tokenizer, llama_tokenizer_token_bos(tokenizer));
+    const char* eos_text = llama_tokenizer_token_get_text(tokenizer, llama_tokenizer_token_eos(tokenizer));
+    if (!bos_text) {
+        bos_text = "";
+    }
+    if (!eos_text) {
+        eos_text = "";
+    }
+
+    snprintf(texts[0], MAX_TEXT, "Hello, world!");
+    snprintf(texts[1], MAX_TEXT, "The quick brown fox jumps over the lazy dog.");
+    snprintf(texts[2], MAX_TEXT, "%s system prompt %s user turn %s", bos_text, eos_text, bos_text);
+    snprintf(texts[3], MAX_TEXT, "caf\xC3\xA9 \xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E \xF0\x9F\x98\x80 invalid:\xFF\xFE end");
+    snprintf(texts[4], MAX_TEXT, "for (int i = 0; i < n; ++i) {\n    sum += a[i];\n}\n");
+    snprintf(texts[5], MAX_TEXT, "%s", "");
+    snprintf(texts[6], MAX_TEXT, "   leading and trailing whitespace   \t\n");
+
+    // A longer text so some calls overlap for a while
+    size_t len = 0;
+    while (len + 64 < MAX_TEXT) {
+        len += (size_t)snprintf(texts[7] + len, MAX_TEXT - len, "Sentence %zu of a longer document. ", len);
+    }
+}
+
+static void read_metadata(const llama_tokenizer_t* tokenizer, metadata* meta) {
+    memset(meta, 0, sizeof(*meta));
+    meta->bos = llama_tokenizer_token_bos(tokenizer);
+    meta->eos = llama_tokenizer_token_eos(tokenizer);
+    meta->vocab_size = llama_tokenizer_vocab_size(tokenizer);
+    meta->bos_piece_len = llama_tokenizer_token_to_piece(tokenizer, meta->bos, meta->bos_piece,
+                                                         (int32_t)sizeof(meta->bos_piece));
+}
+
+static int build_references(const llama_tokenizer_t* tokenizer) {
+    for (int t = 0; t < N_TEXTS; t++) {
+        const int32_t len = (int32_t)strlen(texts[t]);
+        for (int add = 0; add <= 1; add++) {
+            for (int parse = 0; parse <= 1; parse++) {
+                int32_t n = llama_tokenizer_tokenize(tokenizer, texts[t], len, refs[t].tokens[add][parse],
+                                                     MAX_TOKENS, add, parse);
+                if (n < 0) {
+                    fprintf(stderr, "Reference tokenization failed for text %d (%d)\n", t, n);
+                    return 0;
+                }
+                refs[t].n_tokens[add][parse] = n;
+            }
+        }
+        refs[t].n_text = llama_tokenizer_detokenize(tokenizer, refs[t].tokens[0][1], refs[t].n_tokens[0][1],
+                                                    refs[t].text, MAX_TEXT, false, true);
+        if (refs[t].n_text < 0) {
+            fprintf(stderr, "Reference detokenization failed for text %d\n", t);
+            return 0;
+        }
+    }
+    read_metadata(tokenizer, &ref_meta);
+    return 1;
+}
+
+static void* worker_main(void* arg) {
+    worker* w = (worker*)arg;
+    llama_token tokens[MAX_TOKENS];
+    char text[MAX_TEXT];
+
+    for (int iter = 0; iter < ITERATIONS; iter++) {
+        // Each thread walks the texts in its own order so different calls overlap
+        const int t = (iter + w->thread_id) % N_TEXTS;
+        const int add = (iter / N_TEXTS) & 1;
+        const int parse = (iter / (2 * N_TEXTS) + w->thread_id) & 1;
+        const int32_t len = (int32_t)strlen(texts[t]);
+        const int32_t expected = refs[t].n_tokens[add][parse];
+
+        int32_t count = llama_tokenizer_tokenize(w->tokenizer, texts[t], len, NULL, 0, add, parse);
+        if (count != expected) {
+            w->mismatches++;
+        }
+
+        int32_t n = llama_tokenizer_tokenize(w->tokenizer, texts[t], len, tokens, MAX_TOKENS, add, parse);
+        if (n != expected || memcmp(tokens, refs[t].tokens[add][parse], n * sizeof(llama_token)) != 0) {
+            w->mismatches++;
+        }
+
+        // Too-small buffer path
+        if (expected > 1) {
+            int32_t small = llama_tokenizer_tokenize(w->tokenizer, texts[t], len, tokens, 1, add, parse);
+            if (small != -expected) {
+                w->mismatches++;
+            }
+        }
+
+        int32_t n_text = llama_tokenizer_detokenize(w->tokenizer, refs[t].tokens[0][1], refs[t].n_tokens[0][1],
+                                                    text, MAX_TEXT, false, true);
+        if (n_text != refs[t].n_text || memcmp(text, refs[t].text, n_text) != 0) {
+            w->mismatches++;
+        }
+
+        metadata meta;
+        read_metadata(w->tokenizer, &meta);
+        if (meta.bos != ref_meta.bos || meta.eos != ref_meta.eos || meta.vocab_size != ref_meta.vocab_size ||
+            meta.bos_piece_len != ref_meta.bos_piece_len ||
+            (meta.bos_piece_len > 0 && memcmp(meta.bos_piece, ref_meta.bos_piece, meta.bos_piece_len) != 0)) {
+            w->mismatches++;
+        }
+    }
+    return NULL;
+}
+
+void test_shared_handle(const llama_tokenizer_t* tokenizer, int n_threads) {
+    test_count++;
+    printf("\n--- Test: One Handle Shared By %d Threads ---\n", n_threads);
+
+    pthread_t threads[MAX_THREADS];
+    worker workers[MAX_THREADS];
+    int started = 0;
+
+    for (int i = 0; i < n_threads; i++) {
+        workers[i].tokenizer = tokenizer;
+        workers[i].thread_id = i;
+        workers[i].mismatches = 0;
+        if (pthread_create(&threads[i], NULL, worker_main, &workers[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        mismatches += workers[i].mismatches;
+    }
+
+    if (started != n_threads) {
+        TEST_FAIL("Could not start all threads");
+        fail_count++;
+    } else if (mismatches == 0) {
+        TEST_PASS("Concurrent results match single-threaded results");
+        pass_count++;
+    } else {
+        TEST_FAIL("Concurrent results differ from single-threaded results");
+        printf("  Mismatches: %d\n", mismatches);
+        fail_count++;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path> [n_threads]\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf 16\n", argv[0]);
+        return 1;
+    }
+
+    int n_threads = (argc > 2) ? atoi(argv[2]) : DEFAULT_THREADS;
+    if (n_threads < 1 || n_threads > MAX_THREADS) {
+        n_threads = DEFAULT_THREADS;
+    }
+
+    printf("=== Thread Safety Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", argv[1]);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+
+    build_texts(tokenizer);
+    if (!build_references(tokenizer)) {
+        llama_tokenizer_destroy(tokenizer);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+
+    test_shared_handle(tokenizer, 2);
+    test_shared_handle(tokenizer, n_threads);
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
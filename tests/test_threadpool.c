@@ -0,0 +1,260 @@
+#include "llama_tokenizer.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#define TEST_PASS(msg) printf(ANSI_COLOR_GREEN "✓ PASS" ANSI_COLOR_RESET ": %s\n", msg)
+#define TEST_FAIL(msg) printf(ANSI_COLOR_RED "✗ FAIL" ANSI_COLOR_RESET ": %s\n", msg)
+
+#define N_TEXTS 1000
+#define MAX_TOKENS 128
+#define MAX_TEXT 256
+
+int test_count = 0;
+int pass_count = 0;
+int fail_count = 0;
+
+static char text_storage[N_TEXTS][MAX_TEXT];
+static const char* texts[N_TEXTS];
+static int32_t text_lens[N_TEXTS];
+
+static llama_token expected_tokens[N_TEXTS][MAX_TOKENS];
+static int32_t expected_counts[N_TEXTS];
+
+static llama_token batch_storage[N_TEXTS][MAX_TOKENS];
+static llama_token* batch_tokens[N_TEXTS];
+static int32_t batch_caps[N_TEXTS];
+static int32_t batch_counts[N_TEXTS];
+
+static void build_texts(void) {
+    static const char* const words[] = {
+        "alpha", "beta", "gamma", "delta", "caf\xC3\xA9", "\xE6\x97\xA5\xE6\x9C\xAC", "42", "foo_bar", "!", "\n",
+    };
+    for (int i = 0; i < N_TEXTS; i++) {
+        // Lengths vary from empty to a few dozen words so tasks are uneven
+        size_t len = 0;
+        int n_words = (i * 7) % 40;
+        for (int w = 0; w < n_words && len + 16 < MAX_TEXT; w++) {
+            len += (size_t)snprintf(text_storage[i] + len, MAX_TEXT - len, "%s ", words[(i + w * 3) % 10]);
+        }
+        text_storage[i][len] = '\0';
+        texts[i] = text_storage[i];
+        text_lens[i] = (int32_t)len;
+        batch_tokens[i] = batch_storage[i];
+        batch_caps[i] = MAX_TOKENS;
+    }
+}
+
+static void build_expected(const llama_tokenizer_t* tokenizer) {
+    for (int i = 0; i < N_TEXTS; i++) {
+        expected_counts[i] = llama_tokenizer_tokenize(tokenizer, texts[i], text_lens[i], expected_tokens[i],
+                                                      MAX_TOKENS, true, false);
+    }
+}
+
+static int check_batch(const llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    memset(batch_counts, 0, sizeof(batch_counts));
+    memset(batch_storage, 0, sizeof(batch_storage));
+    if (llama_tokenizer_tokenize_batch(tokenizer, pool, texts, text_lens, N_TEXTS, batch_tokens, batch_caps,
+                                       batch_counts, true, false) != 0) {
+        return 0;
+    }
+    for (int i = 0; i < N_TEXTS; i++) {
+        if (batch_counts[i] != expected_counts[i]) {
+            return 0;
+        }
+        if (expected_counts[i] > 0 &&
+            memcmp(batch_storage[i], expected_tokens[i], expected_counts[i] * sizeof(llama_token)) != 0) {
+            return 0;
+        }
+    }
+
+    // Count-only mode
+    memset(batch_counts, 0, sizeof(batch_counts));
+    if (llama_tokenizer_tokenize_batch(tokenizer, pool, texts, text_lens, N_TEXTS, NULL, NULL,
+                                       batch_counts, true, false) != 0) {
+        return 0;
+    }
+    for (int i = 0; i < N_TEXTS; i++) {
+        if (batch_counts[i] != expected_counts[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void run_case(const char* name, const llama_tokenizer_t* tokenizer, llama_tokenizer_threadpool_t* pool) {
+    test_count++;
+    if (check_batch(tokenizer, pool)) {
+        TEST_PASS(name);
+        pass_count++;
+    } else {
+        TEST_FAIL(name);
+        fail_count++;
+    }
+}
+
+// External executor: one detached thread per task
+typedef struct {
+    llama_tokenizer_task_fn fn;
+    void* arg;
+} executor_task;
+
+static void* executor_thread(void* arg) {
+    executor_task* task = (executor_task*)arg;
+    task->fn(task->arg);
+    free(task);
+    return NULL;
+}
+
+static int executor_calls = 0;
+static pthread_mutex_t executor_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void thread_executor(llama_tokenizer_task_fn task, void* arg, void* user_data) {
+    (void)user_data;
+    pthread_mutex_lock(&executor_mutex);
+    executor_calls++;
+    pthread_mutex_unlock(&executor_mutex);
+
+    executor_task* packed = malloc(sizeof(executor_task));
+    packed->fn = task;
+    packed->arg = arg;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, executor_thread, packed) == 0) {
+        pthread_detach(thread);
+    } else {
+        free(packed);
+        task(arg);
+    }
+}
+
+void test_batch(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Batch Tokenization ---\n");
+
+    run_case("No pool (calling thread only)", tokenizer, NULL);
+
+    llama_tokenizer_threadpool_params params = llama_tokenizer_threadpool_default_params();
+    params.n_threads = 4;
+    llama_tokenizer_threadpool_t* pool = llama_tokenizer_threadpool_create(&params);
+    test_count++;
+    if (pool && llama_tokenizer_threadpool_n_threads(pool) == 4) {
+        TEST_PASS("Pool created with 4 workers");
+        pass_count++;
+    } else {
+        TEST_FAIL("Pool should be created with 4 workers");
+        fail_count++;
+    }
+    if (pool) {
+        run_case("4-worker pool", tokenizer, pool);
+        run_case("4-worker pool, reused", tokenizer, pool);
+        llama_tokenizer_threadpool_destroy(pool);
+    }
+
+    int32_t cpus[1] = { 0 };
+    params = llama_tokenizer_threadpool_default_params();
+    params.n_threads = 2;
+    params.cpus = cpus;
+    params.n_cpus = 1;
+    pool = llama_tokenizer_threadpool_create(&params);
+    if (pool) {
+        run_case("Pool pinned to CPU 0", tokenizer, pool);
+        llama_tokenizer_threadpool_destroy(pool);
+    }
+
+    params = llama_tokenizer_threadpool_default_params();
+    params.n_threads = 2;
+    params.numa_node = 0;
+    pool = llama_tokenizer_threadpool_create(&params);
+    if (pool) {
+        run_case("Pool on NUMA node 0", tokenizer, pool);
+        llama_tokenizer_threadpool_destroy(pool);
+    }
+
+    params = llama_tokenizer_threadpool_default_params();
+    params.n_threads = 3;
+    params.executor = thread_executor;
+    pool = llama_tokenizer_threadpool_create(&params);
+    if (pool) {
+        run_case("External executor", tokenizer, pool);
+        llama_tokenizer_threadpool_destroy(pool);
+    }
+    test_count++;
+    if (executor_calls > 0) {
+        TEST_PASS("External executor received tasks");
+        pass_count++;
+    } else {
+        TEST_FAIL("External executor should receive tasks");
+        fail_count++;
+    }
+}
+
+void test_invalid_args(const llama_tokenizer_t* tokenizer) {
+    test_count++;
+    printf("\n--- Test: Invalid Batch Arguments ---\n");
+
+    int32_t count = 0;
+    int ok = llama_tokenizer_tokenize_batch(NULL, NULL, texts, text_lens, 1, NULL, NULL, &count, false, false) < 0 &&
+             llama_tokenizer_tokenize_batch(tokenizer, NULL, NULL, text_lens, 1, NULL, NULL, &count, false, false) < 0 &&
+             llama_tokenizer_tokenize_batch(tokenizer, NULL, texts, text_lens, -1, NULL, NULL, &count, false, false) < 0 &&
+             llama_tokenizer_tokenize_batch(tokenizer, NULL, texts, text_lens, 1, batch_tokens, NULL, &count, false, false) < 0 &&
+             llama_tokenizer_tokenize_batch(tokenizer, NULL, NULL, NULL, 0, NULL, NULL, NULL, false, false) == 0;
+    if (ok) {
+        TEST_PASS("Invalid arguments are rejected, empty batch succeeds");
+        pass_count++;
+    } else {
+        TEST_FAIL("Invalid arguments should be rejected, empty batch should succeed");
+        fail_count++;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Thread Pool Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", argv[1]);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+
+    build_texts();
+    build_expected(tokenizer);
+
+    test_batch(tokenizer);
+    test_invalid_args(tokenizer);
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
@@ -0,0 +1,271 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 1024
+#define MAX_SPANS 256
+
+static const char* const text = "The quick brown fox jumps over the lazy dog.";
+
+// Spans seen by the callback; every call in this test is on the main thread
+static llama_tokenizer_trace_span seen[MAX_SPANS];
+static int n_seen = 0;
+
+static void on_span(const llama_tokenizer_trace_span* span, void* user_data) {
+    (*(int*)user_data)++;
+    if (n_seen < MAX_SPANS) {
+        seen[n_seen++] = *span;
+    }
+}
+
+static const llama_tokenizer_trace_span* find_phase(llama_tokenizer_trace_phase phase) {
+    for (int i = 0; i < n_seen; i++) {
+        if (seen[i].phase == phase) {
+            return &seen[i];
+        }
+    }
+    return NULL;
+}
+
+static int contains(const llama_tokenizer_trace_span* outer, const llama_tokenizer_trace_span* inner) {
+    return inner->start_ns >= outer->start_ns &&
+           inner->start_ns + inner->duration_ns <= outer->start_ns + outer->duration_ns;
+}
+
+static int count_occurrences(const char* haystack, const char* needle) {
+    int n = 0;
+    for (const char* p = strstr(haystack, needle); p; p = strstr(p + 1, needle)) {
+        n++;
+    }
+    return n;
+}
+
+static char* read_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* data = (char*)malloc((size_t)size + 1);
+    size_t n = fread(data, 1, (size_t)size, f);
+    data[n] = '\0';
+    fclose(f);
+    return data;
+}
+
+void test_create_phases(void) {
+    printf("\n--- Test: Create Phases ---\n");
+
+    const llama_tokenizer_trace_span* create = find_phase(LLAMA_TOKENIZER_TRACE_CREATE);
+    const llama_tokenizer_trace_span* load = find_phase(LLAMA_TOKENIZER_TRACE_MODEL_LOAD);
+    const llama_tokenizer_trace_span* build = find_phase(LLAMA_TOKENIZER_TRACE_KERNEL_BUILD);
+
+    check(create && load && build,
+          "Create, model load and kernel build spans emitted",
+          "Missing a create-time span");
+    check(create && load && build && contains(create, load) && contains(create, build) &&
+          load->start_ns + load->duration_ns <= build->start_ns,
+          "Load then build, both inside create",
+          "Create-time spans are not nested in order");
+}
+
+void test_tokenize_phases(const llama_tokenizer_t* tokenizer) {
+    printf("\n--- Test: Tokenize Phases ---\n");
+
+    llama_token tokens[MAX_TOKENS];
+    char out[4096];
+    n_seen = 0;
+    int32_t n = llama_tokenizer_tokenize(tokenizer, text, (int32_t)strlen(text), tokens, MAX_TOKENS, false, true);
+    llama_tokenizer_detokenize(tokenizer, tokens, n, out, sizeof(out), false, false);
+
+    const llama_tokenizer_trace_span* tok = find_phase(LLAMA_TOKENIZER_TRACE_TOKENIZE);
+    const llama_tokenizer_trace_span* partition = find_phase(LLAMA_TOKENIZER_TRACE_SPECIAL_PARTITION);
+    const llama_tokenizer_trace_span* model = find_phase(LLAMA_TOKENIZER_TRACE_MODEL);
+    const llama_tokenizer_trace_span* llama = find_phase(LLAMA_TOKENIZER_TRACE_LLAMA_CPP);
+    const llama_tokenizer_trace_span* detok = find_phase(LLAMA_TOKENIZER_TRACE_DETOKENIZE);
+
+    check(tok && tok->size == strlen(text) && tok->thread_id > 0,
+          "Tokenize span carries the text size",
+          "Missing or wrong tokenize span");
+    check(tok && partition && contains(tok, partition),
+          "Special-token partitioning traced inside tokenize",
+          "Missing partition span inside tokenize");
+    check(tok && (model || llama) && contains(tok, model ? model : llama),
+          "Kernel or llama.cpp span traced inside tokenize",
+          "Missing model span inside tokenize");
+    check(detok && detok->size == (uint64_t)n,
+          "Detokenize span carries the token count",
+          "Missing or wrong detokenize span");
+}
+
+void test_dump(const char* path, int callback_calls) {
+    printf("\n--- Test: Chrome Trace Dump ---\n");
+
+    int32_t n = llama_tokenizer_trace_dump(path);
+    char* json = read_file(path);
+    check(n > 0 && n == callback_calls,
+          "Recorder holds every span the callback saw",
+          "Recorded span count differs from the callback's");
+    check(json && strncmp(json, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 39) == 0 &&
+          count_occurrences(json, "\"ph\":\"X\"") == n &&
+          strstr(json, "\"name\":\"tokenize\"") && strstr(json, "\"name\":\"create\""),
+          "One complete event per span in trace event JSON",
+          "Dump is not the expected trace event JSON");
+    free(json);
+}
+
+void test_overwrite_and_stop(const llama_tokenizer_t* tokenizer, const char* path) {
+    printf("\n--- Test: Overwrite and Stop ---\n");
+
+    const int32_t len = (int32_t)strlen(text);
+    check(llama_tokenizer_trace_start(4), "Recorder restarted with 4 slots", "Restart failed");
+    for (int i = 0; i < 16; i++) {
+        llama_tokenizer_tokenize(tokenizer, text, len, NULL, 0, false, false);
+    }
+    int32_t n_full = llama_tokenizer_trace_dump(path);
+
+    llama_tokenizer_set_trace_callback(NULL, NULL);
+    llama_tokenizer_trace_stop();
+    n_seen = 0;
+    llama_tokenizer_tokenize(tokenizer, text, len, NULL, 0, false, false);
+    int32_t n_stopped = llama_tokenizer_trace_dump(path);
+
+    check(n_full == 4, "Full recorder keeps only the newest spans", "Expected exactly 4 spans");
+    check(n_stopped == 4 && n_seen == 0,
+          "Nothing traced after stop, recording still dumpable",
+          "Spans recorded or delivered after stop");
+}
+
+// A callback target that must not be called once it has been replaced
+typedef struct {
+    atomic_int calls;
+    atomic_int retired;
+    atomic_int late_calls;
+} live_sink;
+
+static atomic_int workers_running;
+
+static void on_live_span(const llama_tokenizer_trace_span* span, void* user_data) {
+    live_sink* sink = (live_sink*)user_data;
+    (void)span;
+    atomic_fetch_add(&sink->calls, 1);
+    if (atomic_load(&sink->retired)) {
+        atomic_fetch_add(&sink->late_calls, 1);
+    }
+}
+
+static void* tokenize_until_stopped(void* arg) {
+    const llama_tokenizer_t* tokenizer = (const llama_tokenizer_t*)arg;
+    const int32_t len = (int32_t)strlen(text);
+    while (atomic_load(&workers_running)) {
+        llama_tokenizer_tokenize(tokenizer, text, len, NULL, 0, false, false);
+    }
+    return NULL;
+}
+
+void test_switching_while_running(const llama_tokenizer_t* tokenizer, const char* path) {
+    printf("\n--- Test: Switching While Calls Run ---\n");
+
+    enum { n_workers = 4, n_rounds = 200 };
+    static live_sink sinks[2];
+    pthread_t workers[n_workers];
+    int n_started = 0;
+    atomic_store(&workers_running, 1);
+    for (int i = 0; i < n_workers; i++) {
+        n_started += pthread_create(&workers[i], NULL, tokenize_until_stopped, (void*)tokenizer) == 0;
+    }
+
+    // Rings are replaced and callbacks swapped under the workers' feet
+    int started = 1;
+    for (int round = 0; round < n_rounds; round++) {
+        live_sink* sink = &sinks[round % 2];
+        atomic_store(&sink->retired, 0);
+        llama_tokenizer_set_trace_callback(on_live_span, sink);
+        started &= llama_tokenizer_trace_start((size_t)(8 + round % 8));
+        if (round % 4 == 0) {
+            llama_tokenizer_trace_dump(path);
+        }
+        if (round % 2 == 0) {
+            llama_tokenizer_trace_stop();
+        }
+        llama_tokenizer_set_trace_callback(NULL, NULL);
+        atomic_store(&sink->retired, 1);
+    }
+    llama_tokenizer_trace_stop();
+
+    atomic_store(&workers_running, 0);
+    for (int i = 0; i < n_started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    const int calls = atomic_load(&sinks[0].calls) + atomic_load(&sinks[1].calls);
+    const int late = atomic_load(&sinks[0].late_calls) + atomic_load(&sinks[1].late_calls);
+    printf("  %d callback calls, %d after removal\n", calls, late);
+    check(n_started == n_workers && started && calls > 0 && late == 0,
+          "Start, stop and callback changes are safe while other threads tokenize",
+          "Tracing changes while calls run failed or reached a removed callback");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Trace Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    if (!llama_tokenizer_trace_start(0)) {
+        printf("SKIP: library built without tracing\n");
+        llama_tokenizer_free_backend();
+        return 0;
+    }
+    int callback_calls = 0;
+    llama_tokenizer_set_trace_callback(on_span, &callback_calls);
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", argv[1]);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+
+    // Written to the working directory, removed at the end
+    const char* path = "test_trace.json";
+
+    test_create_phases();
+    test_tokenize_phases(tokenizer);
+    test_dump(path, callback_calls);
+    test_overwrite_and_stop(tokenizer, path);
+    test_switching_while_running(tokenizer, path);
+
+    remove(path);
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
@@ -0,0 +1,193 @@
+#include "llama_tokenizer.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 4096
+#define MAX_TEXT 16384
+
+static llama_token source[MAX_TOKENS];
+static llama_token expected[MAX_TOKENS];
+static llama_token translated[MAX_TOKENS];
+static char text[MAX_TEXT];
+
+static const char* samples[] = {
+    "The quick brown fox jumps over the lazy dog.",
+    "  leading spaces, trailing spaces  ",
+    "def add(a, b):\n    return a + b\n\n\nprint(add(1, 2))",
+    "Ünïcödé wörds, 中文字符 and emoji 🚀 mixed in",
+    "numbers 12345 and 3.14159, punctuation!?... done",
+    "tabs\tand\nnewlines\r\nmixed   with    runs of spaces",
+};
+static const int n_samples = sizeof(samples) / sizeof(samples[0]);
+
+// Target tokens of the source tokens by a full detokenize-then-tokenize
+static int32_t round_trip(llama_tokenizer_t* from, llama_tokenizer_t* to, const llama_token* tokens, int32_t n) {
+    const int32_t len = llama_tokenizer_detokenize(from, tokens, n, text, MAX_TEXT, false, false);
+    return len < 0 ? -1 : llama_tokenizer_tokenize(to, text, len, expected, MAX_TOKENS, false, false);
+}
+
+static int same(const llama_token* a, int32_t n_a, const llama_token* b, int32_t n_b) {
+    return n_a == n_b && n_a >= 0 && memcmp(a, b, (size_t)n_a * sizeof(llama_token)) == 0;
+}
+
+void test_round_trip(llama_tokenizer_t* from, llama_tokenizer_t* to) {
+    printf("\n--- Test: Translation Matches Round Trip ---\n");
+
+    llama_tokenizer_threadpool_t* pool = llama_tokenizer_threadpool_create(NULL);
+    llama_tokenizer_translator_t* translator = llama_tokenizer_translator_create(from, to, NULL);
+    llama_tokenizer_translator_t* pooled = llama_tokenizer_translator_create(from, to, pool);
+    if (!translator || !pooled) {
+        check(0, "", "Failed to create translator");
+        llama_tokenizer_translator_free(translator);
+        llama_tokenizer_translator_free(pooled);
+        llama_tokenizer_threadpool_destroy(pool);
+        return;
+    }
+
+    int all_match = 1;
+    int pooled_match = 1;
+    for (int i = 0; i < n_samples; i++) {
+        const int32_t n = llama_tokenizer_tokenize(from, samples[i], (int32_t)strlen(samples[i]), source, MAX_TOKENS,
+                                                   false, false);
+        const int32_t n_expected = round_trip(from, to, source, n);
+        const int32_t n_translated = llama_tokenizer_translate(translator, source, n, false, translated, MAX_TOKENS);
+        all_match &= same(translated, n_translated, expected, n_expected);
+        pooled_match &= llama_tokenizer_translate(pooled, source, n, false, translated, MAX_TOKENS) == n_translated &&
+                        same(translated, n_translated, expected, n_expected);
+    }
+    check(all_match, "Translated tokens equal detokenizing and tokenizing again",
+          "Translation differs from the round trip");
+    check(pooled_match, "A table built on a thread pool translates the same",
+          "Pooled translator differs");
+
+    // Arbitrary token sequences, not only ones the tokenizer produces
+    srand(49);
+    const int32_t n_vocab = llama_tokenizer_vocab_size(from);
+    int random_match = 1;
+    for (int round = 0; round < 200 && random_match; round++) {
+        const int32_t n = 1 + rand() % 64;
+        for (int32_t i = 0; i < n; i++) {
+            source[i] = (llama_token)(rand() % n_vocab);
+        }
+        const int32_t n_expected = round_trip(from, to, source, n);
+        const int32_t n_translated = llama_tokenizer_translate(translator, source, n, false, translated, MAX_TOKENS);
+        random_match = same(translated, n_translated, expected, n_expected);
+    }
+    check(random_match, "Random token sequences translate as their round trip",
+          "Random sequence differs from the round trip");
+
+    llama_tokenizer_translator_free(translator);
+    llama_tokenizer_translator_free(pooled);
+    llama_tokenizer_threadpool_destroy(pool);
+}
+
+void test_continuation(llama_tokenizer_t* from, llama_tokenizer_t* to) {
+    printf("\n--- Test: Incremental Translation ---\n");
+
+    llama_tokenizer_translator_t* translator = llama_tokenizer_translator_create(from, to, NULL);
+    const char* sample = "one two three four five six seven eight nine ten";
+    const int32_t n = llama_tokenizer_tokenize(from, sample, (int32_t)strlen(sample), source, MAX_TOKENS, false, false);
+    const int32_t n_all = llama_tokenizer_translate(translator, source, n, false, expected, MAX_TOKENS);
+
+    // Split where the token after "five" starts " six"
+    int32_t split = -1;
+    int32_t offset = 0;
+    for (int32_t i = 0; i < n && split < 0; i++) {
+        char piece[64];
+        const int32_t len = llama_tokenizer_token_to_piece(from, source[i], piece, sizeof(piece));
+        if (len > 0 && piece[0] == ' ' && offset >= 4 && memcmp(text + offset - 4, "five", 4) == 0) {
+            split = i;
+        }
+        if (len > 0 && offset + len < MAX_TEXT) {
+            memcpy(text + offset, piece, (size_t)len);
+            offset += len;
+        }
+    }
+    if (split < 0) {
+        check(0, "", "No token starts with the space before \"six\"");
+        llama_tokenizer_translator_free(translator);
+        return;
+    }
+
+    const int32_t n_head = llama_tokenizer_translate(translator, source, split, false, translated, MAX_TOKENS);
+    const int32_t n_tail = n_head < 0 ? -1 :
+        llama_tokenizer_translate(translator, source + split, n - split, true, translated + n_head, MAX_TOKENS - n_head);
+    check(n_tail >= 0 && same(translated, n_head + n_tail, expected, n_all),
+          "Translating a continuation from a word start appends to the earlier translation",
+          "Continuation translation differs");
+    llama_tokenizer_translator_free(translator);
+}
+
+void test_buffers(llama_tokenizer_t* from, llama_tokenizer_t* to) {
+    printf("\n--- Test: Buffers and Invalid Arguments ---\n");
+
+    llama_tokenizer_translator_t* translator = llama_tokenizer_translator_create(from, to, NULL);
+    const int32_t n = llama_tokenizer_tokenize(from, samples[0], (int32_t)strlen(samples[0]), source, MAX_TOKENS,
+                                               false, false);
+    const int32_t needed = llama_tokenizer_translate(translator, source, n, false, NULL, 0);
+    check(needed > 0 && llama_tokenizer_translate(translator, source, n, false, translated, needed - 1) == -needed &&
+              llama_tokenizer_translate(translator, source, n, false, translated, needed) == needed &&
+              llama_tokenizer_translate(translator, source, 0, false, translated, MAX_TOKENS) == 0,
+          "NULL output counts, a short buffer returns the negative size",
+          "Buffer semantics wrong");
+
+    const llama_token bad = llama_tokenizer_vocab_size(from);
+    check(llama_tokenizer_translator_create(NULL, to, NULL) == NULL &&
+              llama_tokenizer_translator_create(from, NULL, NULL) == NULL &&
+              llama_tokenizer_translate(NULL, source, n, false, NULL, 0) == -1 &&
+              llama_tokenizer_translate(translator, NULL, 1, false, NULL, 0) == -1 &&
+              llama_tokenizer_translate(translator, &bad, 1, false, NULL, 0) == -1 &&
+              llama_tokenizer_translate(translator, source, -1, false, NULL, 0) == -1,
+          "Invalid arguments are rejected",
+          "Invalid translation arguments were accepted");
+    llama_tokenizer_translator_free(translator);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model.gguf> [target-model.gguf]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Vocab Translation Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    llama_tokenizer_set_log_level(LLAMA_TOKENIZER_LOG_NONE);
+    llama_tokenizer_init();
+
+    // Without a second model, translate between two handles on one vocab
+    llama_tokenizer_t* from = llama_tokenizer_create(argv[1]);
+    llama_tokenizer_t* to = llama_tokenizer_create(argc > 2 ? argv[2] : argv[1]);
+    if (!from || !to) {
+        fprintf(stderr, "Failed to create tokenizer\n");
+        return 1;
+    }
+
+    test_round_trip(from, to);
+    test_round_trip(to, from);
+    test_continuation(from, to);
+    test_buffers(from, to);
+
+    llama_tokenizer_destroy(from);
+    llama_tokenizer_destroy(to);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}
@@ -0,0 +1,161 @@
+#include "llama_tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#define TEST_PASS(msg) printf(ANSI_COLOR_GREEN "✓ PASS" ANSI_COLOR_RESET ": %s\n", msg)
+#define TEST_FAIL(msg) printf(ANSI_COLOR_RED "✗ FAIL" ANSI_COLOR_RESET ": %s\n", msg)
+
+int test_count = 0;
+int pass_count = 0;
+int fail_count = 0;
+
+typedef struct {
+    const char* name;
+    const char* text;
+    int32_t text_len;
+    int32_t expected_offset;  // -1 if valid
+} utf8_case;
+
+void test_validate(void) {
+    printf("\n--- Test: UTF-8 Validation ---\n");
+
+    static const utf8_case cases[] = {
+        { "empty",                 "",                               0, -1 },
+        { "ascii",                 "Hello, world!",                 13, -1 },
+        { "long ascii run",        "0123456789abcdef0123456789abcdef0123", 36, -1 },
+        { "two-byte",              "caf\xC3\xA9",                    5, -1 },
+        { "three-byte",            "\xE2\x96\x81x",                  4, -1 },
+        { "four-byte",             "\xF0\x9F\x98\x80",               4, -1 },
+        { "max code point",        "\xF4\x8F\xBF\xBF",               4, -1 },
+        { "lone continuation",     "ab\x80",                         3,  2 },
+        { "overlong two-byte",     "\xC0\xAF",                       2,  0 },
+        { "overlong three-byte",   "\xE0\x80\xAF",                   3,  0 },
+        { "surrogate",             "x\xED\xA0\x80",                  4,  1 },
+        { "above U+10FFFF",        "\xF4\x90\x80\x80",               4,  0 },
+        { "truncated at end",      "0123456789abcdef0123\xE2\x96",  22, 20 },
+        { "invalid after run",     "0123456789abcdef0123456789\xFF", 27, 26 },
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        test_count++;
+        int32_t offset = 12345;
+        bool valid = llama_tokenizer_validate_utf8(cases[i].text, cases[i].text_len, &offset);
+        bool expected_valid = cases[i].expected_offset < 0;
+
+        if (valid == expected_valid && offset == cases[i].expected_offset) {
+            TEST_PASS(cases[i].name);
+            pass_count++;
+        } else {
+            TEST_FAIL(cases[i].name);
+            printf("  Expected offset %d, got %d (valid=%d)\n", cases[i].expected_offset, offset, valid);
+            fail_count++;
+        }
+    }
+
+    test_count++;
+    if (!llama_tokenizer_validate_utf8(NULL, 0, NULL)) {
+        TEST_PASS("NULL text is rejected");
+        pass_count++;
+    } else {
+        TEST_FAIL("NULL text should be rejected");
+        fail_count++;
+    }
+}
+
+void test_invalid_tokenizes_as_replacement(llama_tokenizer_t* tokenizer) {
+    test_count++;
+    printf("\n--- Test: Invalid UTF-8 Tokenizes As U+FFFD ---\n");
+
+    const char* invalid = "abc\xFF" "def\xE2\x96";
+    const char* replaced = "abc\xEF\xBF\xBD" "def\xEF\xBF\xBD";
+
+    int32_t n_invalid = llama_tokenizer_tokenize(tokenizer, invalid, (int32_t)strlen(invalid), NULL, 0, false, false);
+    int32_t n_replaced = llama_tokenizer_tokenize(tokenizer, replaced, (int32_t)strlen(replaced), NULL, 0, false, false);
+
+    if (n_invalid <= 0 || n_invalid != n_replaced) {
+        TEST_FAIL("Invalid input count should match replaced input count");
+        printf("  Invalid: %d, Replaced: %d\n", n_invalid, n_replaced);
+        fail_count++;
+        return;
+    }
+
+    llama_token* a = malloc(n_invalid * sizeof(llama_token));
+    llama_token* b = malloc(n_replaced * sizeof(llama_token));
+    llama_tokenizer_tokenize(tokenizer, invalid, (int32_t)strlen(invalid), a, n_invalid, false, false);
+    llama_tokenizer_tokenize(tokenizer, replaced, (int32_t)strlen(replaced), b, n_replaced, false, false);
+
+    if (memcmp(a, b, n_invalid * sizeof(llama_token)) == 0) {
+        TEST_PASS("Invalid sequences are tokenized as U+FFFD");
+        pass_count++;
+    } else {
+        TEST_FAIL("Invalid sequences should be tokenized as U+FFFD");
+        fail_count++;
+    }
+
+    free(a);
+    free(b);
+}
+
+void test_negative_length(llama_tokenizer_t* tokenizer) {
+    test_count++;
+    printf("\n--- Test: Negative Text Length ---\n");
+
+    int32_t result = llama_tokenizer_tokenize(tokenizer, "abc", -1, NULL, 0, false, false);
+    if (result < 0) {
+        TEST_PASS("Negative text length returns error");
+        pass_count++;
+    } else {
+        TEST_FAIL("Negative text length should return error");
+        fail_count++;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+        fprintf(stderr, "Example: %s /path/to/model.gguf\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== UTF-8 Validation Test Suite ===\n");
+    printf("Model: %s\n", argv[1]);
+
+    test_validate();
+
+    llama_tokenizer_init();
+
+    llama_tokenizer_t* tokenizer = llama_tokenizer_create(argv[1]);
+    if (!tokenizer) {
+        fprintf(stderr, "Failed to create tokenizer from: %s\n", argv[1]);
+        llama_tokenizer_free_backend();
+        return 1;
+    }
+
+    test_invalid_tokenizes_as_replacement(tokenizer);
+    test_negative_length(tokenizer);
+
+    llama_tokenizer_destroy(tokenizer);
+    llama_tokenizer_free_backend();
+
+    printf("\n=== Test Summary ===\n");
+    printf("Total tests: %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed: %d" ANSI_COLOR_RESET "\n", pass_count);
+    if (fail_count > 0) {
+        printf(ANSI_COLOR_RED "Failed: %d" ANSI_COLOR_RESET "\n", fail_count);
+    } else {
+        printf("Failed: %d\n", fail_count);
+    }
+
+    if (fail_count == 0) {
+        printf("\n" ANSI_COLOR_GREEN "✓ ALL TESTS PASSED!" ANSI_COLOR_RESET "\n");
+        return 0;
+    } else {
+        printf("\n" ANSI_COLOR_RED "✗ SOME TESTS FAILED" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+}